@@ -0,0 +1,106 @@
+/**
+ * @file Allocations.cpp
+ * @brief Replaces the global allocation functions with counting ones, so
+ *        benchmarks can report heap allocations per operation.
+ */
+
+#include "Benchmark.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> allocationCount{0};
+
+void *allocate(const std::size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  if (void *memory = std::malloc(size != 0 ? size : 1)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void *allocateAligned(const std::size_t size, const std::align_val_t align) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  const auto alignment = static_cast<std::size_t>(align);
+  // aligned_alloc() wants a size that is a multiple of the alignment.
+  const std::size_t rounded =
+      (std::max<std::size_t>(size, 1) + alignment - 1) & ~(alignment - 1);
+  if (void *memory = std::aligned_alloc(alignment, rounded)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+} // namespace
+
+namespace Jetpack::Bench {
+
+uint64_t getAllocationCount() {
+  return allocationCount.load(std::memory_order_relaxed);
+}
+
+void forgetAllocations(const uint64_t count) {
+  allocationCount.fetch_sub(count, std::memory_order_relaxed);
+}
+
+} // namespace Jetpack::Bench
+
+void *operator new(const std::size_t size) { return allocate(size); }
+
+void *operator new[](const std::size_t size) { return allocate(size); }
+
+void *operator new(const std::size_t size, const std::align_val_t align) {
+  return allocateAligned(size, align);
+}
+
+void *operator new[](const std::size_t size, const std::align_val_t align) {
+  return allocateAligned(size, align);
+}
+
+void *operator new(const std::size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return allocate(size);
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+
+void *operator new[](const std::size_t size,
+                     const std::nothrow_t &) noexcept {
+  try {
+    return allocate(size);
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+
+void operator delete[](void *memory) noexcept { std::free(memory); }
+
+void operator delete(void *memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void *memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void *memory, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void *memory, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void *memory, std::size_t, std::align_val_t) noexcept {
+  std::free(memory);
+}
@@ -0,0 +1,86 @@
+/**
+ * @file Benchmark.cpp
+ * @brief Implements the benchmark runner and its JSON report.
+ */
+
+#include "Benchmark.hpp"
+#include <algorithm>
+#include <format>
+
+namespace Jetpack::Bench {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/** Upper bound on the operations of one timed run. */
+constexpr uint64_t MAX_OPERATIONS = uint64_t{1} << 32;
+
+/** @return The text as a JSON string literal. */
+std::string quote(const std::string &text) {
+  std::string quoted = "\"";
+  for (const char c : text) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+    }
+    quoted += c;
+  }
+  return quoted + '"';
+}
+
+} // namespace
+
+Result run(const Benchmark &benchmark,
+           const std::chrono::duration<double> minTime) {
+  const Body body = benchmark.setup();
+  body(1);
+
+  uint64_t operations = 1;
+  while (true) {
+    const uint64_t allocationsBefore = getAllocationCount();
+    const auto start = Clock::now();
+    body(operations);
+    const std::chrono::duration<double> elapsed = Clock::now() - start;
+    const uint64_t allocations = getAllocationCount() - allocationsBefore;
+
+    if (elapsed >= minTime || operations >= MAX_OPERATIONS) {
+      const auto count = static_cast<double>(operations);
+      return {&benchmark, operations, elapsed.count() * 1e9 / count,
+              static_cast<double>(allocations) / count, allocations};
+    }
+
+    // Aim a little past minTime, growing at most tenfold per attempt.
+    const double scale =
+        elapsed.count() > 0.0 ? minTime / elapsed * 1.2 : 10.0;
+    operations = std::min(
+        MAX_OPERATIONS,
+        std::max(operations + 1,
+                 static_cast<uint64_t>(static_cast<double>(operations) *
+                                       std::min(scale, 10.0))));
+  }
+}
+
+void writeJson(std::ostream &output, const std::vector<Result> &results) {
+  output << "{\n  \"benchmarks\": [";
+  for (size_t i = 0; i < results.size(); i++) {
+    const Result &result = results[i];
+    output << (i == 0 ? "\n" : ",\n");
+    output << std::format("    {{\"name\": {}, \"parameters\": {{",
+                          quote(result.benchmark->name));
+
+    const Parameters &parameters = result.benchmark->parameters;
+    for (size_t j = 0; j < parameters.size(); j++) {
+      output << std::format("{}{}: {}", j == 0 ? "" : ", ",
+                            quote(parameters[j].first), parameters[j].second);
+    }
+    output << std::format("}}, \"operations\": {}, \"ns_per_op\": {:.3f}, "
+                          "\"allocations_per_op\": {:.3f}, "
+                          "\"steady_state\": {}}}",
+                          result.operations, result.nanosecondsPerOperation,
+                          result.allocationsPerOperation,
+                          result.benchmark->steadyState);
+  }
+  output << "\n  ]\n}\n";
+}
+
+} // namespace Jetpack::Bench
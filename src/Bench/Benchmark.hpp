@@ -0,0 +1,152 @@
+/**
+ * @file Benchmark.hpp
+ * @brief Declaration of the micro-benchmark registry, runner and JSON
+ *        report.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Jetpack::Bench {
+
+/** Named integer parameters of a benchmark, e.g. {"players", 64}. */
+using Parameters = std::vector<std::pair<std::string, int64_t>>;
+
+/** Performs a number of operations of a benchmark, back to back. */
+using Body = std::function<void(uint64_t operations)>;
+
+/**
+ * @struct Benchmark
+ * @brief One benchmark at one set of parameters.
+ *
+ * The setup runs once, untimed, and returns the body; whatever the body
+ * captures is reused across every timed run. A steady-state benchmark
+ * covers a path that must not touch the heap once warmed up, and fails
+ * the suite if its timed run allocates.
+ */
+struct Benchmark {
+  std::string name;
+  Parameters parameters;
+  std::function<Body()> setup;
+  bool steadyState;
+};
+
+/**
+ * @struct Result
+ * @brief Measurements of one benchmark.
+ */
+struct Result {
+  const Benchmark *benchmark;
+  uint64_t operations;
+  double nanosecondsPerOperation;
+  /** Heap allocations per operation in the timed run. */
+  double allocationsPerOperation;
+  /** Heap allocations of the whole timed run. */
+  uint64_t allocations;
+};
+
+/**
+ * @class Registry
+ * @brief Every benchmark of the suite, in registration order.
+ */
+class Registry {
+public:
+  /**
+   * @param name       Benchmark name, "area/what".
+   * @param parameters Parameters it runs with.
+   * @param setup      Builds the state and returns the body.
+   */
+  void add(std::string name, Parameters parameters,
+           std::function<Body()> setup) {
+    m_benchmarks.push_back(
+        {std::move(name), std::move(parameters), std::move(setup), false});
+  }
+
+  /**
+   * @brief Registers a benchmark whose body must not allocate after its
+   *        warm-up operation.
+   * @param name       Benchmark name, "area/what".
+   * @param parameters Parameters it runs with.
+   * @param setup      Builds the state and returns the body.
+   */
+  void addSteadyState(std::string name, Parameters parameters,
+                      std::function<Body()> setup) {
+    m_benchmarks.push_back(
+        {std::move(name), std::move(parameters), std::move(setup), true});
+  }
+
+  /** @return Every registered benchmark. */
+  [[nodiscard]] const std::vector<Benchmark> &getBenchmarks() const {
+    return m_benchmarks;
+  }
+
+private:
+  std::vector<Benchmark> m_benchmarks;
+};
+
+/**
+ * @brief Runs a benchmark with enough operations to last minTime.
+ * @param benchmark Benchmark to run.
+ * @param minTime   Shortest acceptable timed run.
+ * @return Its measurements.
+ */
+[[nodiscard]] Result run(const Benchmark &benchmark,
+                         std::chrono::duration<double> minTime);
+
+/**
+ * @brief Writes results as one JSON document.
+ * @param output  Destination stream.
+ * @param results Results to write.
+ */
+void writeJson(std::ostream &output, const std::vector<Result> &results);
+
+/** @return Heap allocations made by the process so far. */
+[[nodiscard]] uint64_t getAllocationCount();
+
+/**
+ * @brief Takes allocations back out of getAllocationCount().
+ * @param count Allocations to forget.
+ */
+void forgetAllocations(uint64_t count);
+
+/**
+ * @class UncountedScope
+ * @brief Leaves the allocations made during its lifetime out of the
+ *        count, for setup a body repeats now and then, such as starting a
+ *        new match once the last one is over.
+ */
+class UncountedScope {
+public:
+  UncountedScope() : m_start(getAllocationCount()) {}
+  ~UncountedScope() { forgetAllocations(getAllocationCount() - m_start); }
+
+  UncountedScope(const UncountedScope &) = delete;
+  UncountedScope &operator=(const UncountedScope &) = delete;
+
+private:
+  uint64_t m_start;
+};
+
+/** @brief Registers the server-side benchmarks: protocol, physics, maps. */
+void registerServerBenchmarks(Registry &registry);
+
+/** @brief Registers the client-side benchmarks: parsing, GameData. */
+void registerClientBenchmarks(Registry &registry);
+
+/**
+ * @brief Keeps the compiler from discarding a value it can see is
+ *        unused.
+ * @param value Result of the measured work.
+ */
+template <typename T> inline void doNotOptimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace Jetpack::Bench
@@ -0,0 +1,352 @@
+/**
+ * @file ClientBenchmarks.cpp
+ * @brief Benchmarks of the client hot paths: packet framing, receiving
+ *        and decoding state updates, and GameData snapshot handoff.
+ */
+
+#include "../Client/GameData.hpp"
+#include "../Client/GameView.hpp"
+#include "../Client/NetworkClient.hpp"
+#include "../Shared/Exceptions.hpp"
+#include "../Shared/PacketWriter.hpp"
+#include "Benchmark.hpp"
+#include <arpa/inet.h>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace Jetpack::Bench {
+
+namespace {
+
+/** Player counts of the benchmarks that scale with the room. */
+constexpr std::array<int, 4> PLAYER_COUNTS = {2, 16, 64, 255};
+
+/** Columns the display shows at most, as GameDisplay::MAX_VIEW_COLUMNS. */
+constexpr int VIEW_COLUMNS = 128;
+
+constexpr int MAP_HEIGHT = 10;
+
+/** Bytes written to the loopback socket before the client reads them. */
+constexpr size_t RECEIVE_BATCH_BYTES = 16 * 1024;
+
+/** @return Players spread over the map, half of them jetpacking. */
+std::vector<Shared::Protocol::Player> makePlayers(const int count) {
+  std::vector<Shared::Protocol::Player> players;
+  for (int i = 0; i < count; i++) {
+    Shared::Protocol::Player &player = players.emplace_back(-1, i + 1);
+    player.setState(Shared::Protocol::PlayerState::PLAYING);
+    player.setPosition(1.0f + i * 0.37f, static_cast<float>(i % MAP_HEIGHT));
+    player.setJetpacking(i % 2 == 0);
+  }
+  return players;
+}
+
+/**
+ * @brief Serializes a GAME_STATE_UPDATE the way Broadcaster does.
+ * @param playerCount Players in the update.
+ * @param tick        Moves the players, so updates differ.
+ * @return The packet.
+ */
+std::vector<std::byte> makeStateUpdate(const int playerCount,
+                                       const int tick) {
+  std::vector<std::byte> bytes(2 + static_cast<size_t>(playerCount) * 10);
+  Shared::Protocol::PacketWriter packet(
+      bytes, Shared::Protocol::PacketType::GAME_STATE_UPDATE,
+      bytes.size() - 1);
+  packet.addByte(static_cast<uint8_t>(playerCount));
+  for (int i = 0; i < playerCount; i++) {
+    packet.addByte(static_cast<uint8_t>(i + 1));
+    packet.addByte(
+        static_cast<uint8_t>(Shared::Protocol::PlayerState::PLAYING));
+    packet.addShort(static_cast<uint16_t>(100 + i * 37 + tick * 5));
+    packet.addShort(static_cast<uint16_t>((i + tick) % MAP_HEIGHT * 100));
+    packet.addShort(static_cast<uint16_t>(tick / 10));
+    packet.addByte(static_cast<uint8_t>((i + tick) % 2));
+    packet.addByte(0);
+  }
+  return bytes;
+}
+
+/** @return A whole map with a coin every few cells. */
+Shared::Protocol::GameMap makeMap(const int width) {
+  Shared::Protocol::GameMap map;
+  map.resize(width, MAP_HEIGHT);
+  for (int y = 0; y < MAP_HEIGHT; y++) {
+    for (int x = 0; x < width; x++) {
+      if ((x * 7 + y * 3) % 11 == 0) {
+        map.tiles[map.getIndex(x, y)] = Shared::Protocol::TileType::COIN;
+      }
+    }
+  }
+  return map;
+}
+
+/**
+ * @class GameDataView
+ * @brief GameView that forwards to GameData, as GameDisplay does, minus
+ *        the rendering.
+ */
+class GameDataView : public Client::GameView {
+public:
+  void updateMap(const Shared::Protocol::GameMap &map) override {
+    m_gameData.updateMap(map);
+  }
+  void startMapStream(const int width, const int height,
+                      const int chunkColumns) override {
+    m_gameData.startMapStream(width, height, chunkColumns);
+  }
+  void addMapChunk(const int firstColumn,
+                   Shared::Protocol::GameMap columns) override {
+    m_gameData.addMapChunk(firstColumn, std::move(columns));
+  }
+  void updateGameState(
+      const std::vector<Shared::Protocol::Player> &players) override {
+    m_gameData.updatePlayers(players);
+  }
+  void updateLocalPlayer(const Shared::Protocol::Player &player) override {
+    m_gameData.updateLocalPlayer(player);
+  }
+  void handleCoinCollected(const int, const int x, const int y,
+                           const int coinState) override {
+    m_gameData.updateCoinStates(x, y, coinState);
+  }
+  void handlePlayerDeath(const int playerId) override {
+    m_gameData.updatePlayerState(playerId,
+                                 Shared::Protocol::PlayerState::DEAD);
+  }
+  void handleGameOver(const int winnerId) override {
+    m_gameData.updateGameOver(winnerId);
+  }
+  [[nodiscard]] bool isJetpackActive() const override { return false; }
+
+private:
+  Client::GameData m_gameData;
+};
+
+/**
+ * @class LoopbackServer
+ * @brief A NetworkClient connected to a listening socket of our own, so
+ *        the benchmark can feed it bytes through the real receive path.
+ */
+class LoopbackServer {
+public:
+  LoopbackServer() {
+    const int listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (listener < 0 ||
+        bind(listener, reinterpret_cast<sockaddr *>(&address), length) < 0 ||
+        listen(listener, 1) < 0 ||
+        getsockname(listener, reinterpret_cast<sockaddr *>(&address),
+                    &length) < 0) {
+      if (listener >= 0) {
+        close(listener);
+      }
+      throw Shared::Exceptions::SocketException(
+          "Failed to open the loopback listener");
+    }
+
+    m_client = std::make_unique<Client::NetworkClient>(
+        ntohs(address.sin_port), "127.0.0.1", false);
+    m_client->setView(std::make_shared<GameDataView>());
+    if (!m_client->connectToServer()) {
+      close(listener);
+      throw Shared::Exceptions::SocketException(
+          "Failed to connect to the loopback listener");
+    }
+    m_server = accept(listener, nullptr, nullptr);
+    close(listener);
+    if (m_server < 0) {
+      throw Shared::Exceptions::SocketException(
+          "Failed to accept the loopback client");
+    }
+  }
+
+  ~LoopbackServer() {
+    if (m_server >= 0) {
+      close(m_server);
+    }
+  }
+
+  LoopbackServer(const LoopbackServer &) = delete;
+  LoopbackServer &operator=(const LoopbackServer &) = delete;
+
+  /**
+   * @brief Sends bytes to the client and lets it process all of them.
+   * @param bytes Whole packets.
+   */
+  void deliver(const std::vector<std::byte> &bytes) {
+    size_t sent = 0;
+    while (sent < bytes.size()) {
+      const ssize_t written =
+          send(m_server, bytes.data() + sent, bytes.size() - sent, 0);
+      if (written <= 0) {
+        throw Shared::Exceptions::SocketException(
+            "Failed to write to the loopback client");
+      }
+      sent += static_cast<size_t>(written);
+    }
+
+    const uint64_t expected = m_client->getBytesReceived() + bytes.size();
+    while (m_client->getBytesReceived() < expected) {
+      if (!m_client->receiveFromServer()) {
+        throw Shared::Exceptions::SocketException(
+            "Loopback client dropped the connection");
+      }
+    }
+  }
+
+private:
+  std::unique_ptr<Client::NetworkClient> m_client;
+  int m_server = -1;
+};
+
+void registerFramingBenchmarks(Registry &registry) {
+  for (const int playerCount : PLAYER_COUNTS) {
+    registry.add(
+        "protocol/frame_scan", {{"players", playerCount}},
+        [playerCount]() -> Body {
+          auto stream = std::make_shared<std::vector<std::byte>>();
+          constexpr int packetCount = 64;
+          for (int tick = 0; tick < packetCount; tick++) {
+            const std::vector<std::byte> packet =
+                makeStateUpdate(playerCount, tick);
+            stream->insert(stream->end(), packet.begin(), packet.end());
+          }
+
+          return [stream](const uint64_t operations) {
+            size_t offset = 0;
+            size_t total = 0;
+            for (uint64_t i = 0; i < operations; i++) {
+              if (offset == stream->size()) {
+                offset = 0;
+              }
+              const size_t size = Shared::Protocol::getPacketSize(
+                  stream->data() + offset, stream->size() - offset);
+              total += size;
+              offset += size;
+            }
+            doNotOptimize(total);
+          };
+        });
+  }
+}
+
+void registerReceiveBenchmarks(Registry &registry) {
+  for (const int playerCount : PLAYER_COUNTS) {
+    registry.add(
+        "client/receive_state", {{"players", playerCount}},
+        [playerCount]() -> Body {
+          auto server = std::make_shared<LoopbackServer>();
+          const size_t packetSize = 2 + static_cast<size_t>(playerCount) * 10;
+          const size_t packetsPerBatch =
+              std::max<size_t>(1, RECEIVE_BATCH_BYTES / packetSize);
+
+          auto batch = std::make_shared<std::vector<std::byte>>();
+          for (size_t tick = 0; tick < packetsPerBatch; tick++) {
+            const std::vector<std::byte> packet =
+                makeStateUpdate(playerCount, static_cast<int>(tick));
+            batch->insert(batch->end(), packet.begin(), packet.end());
+          }
+          auto partial = std::make_shared<std::vector<std::byte>>();
+
+          // One operation is one packet received, decoded and published.
+          return [server, batch, partial, packetSize,
+                  packetsPerBatch](const uint64_t operations) {
+            uint64_t done = 0;
+            while (done + packetsPerBatch <= operations) {
+              server->deliver(*batch);
+              done += packetsPerBatch;
+            }
+            if (done < operations) {
+              partial->assign(batch->begin(),
+                              batch->begin() + static_cast<std::ptrdiff_t>(
+                                                   (operations - done) *
+                                                   packetSize));
+              server->deliver(*partial);
+            }
+          };
+        });
+  }
+}
+
+void registerGameDataBenchmarks(Registry &registry) {
+  for (const int playerCount : PLAYER_COUNTS) {
+    registry.add(
+        "client/snapshot_publish", {{"players", playerCount}},
+        [playerCount]() -> Body {
+          auto gameData = std::make_shared<Client::GameData>();
+          auto players =
+              std::make_shared<std::vector<Shared::Protocol::Player>>(
+                  makePlayers(playerCount));
+          gameData->updatePlayers(*players);
+
+          return [gameData, players](const uint64_t operations) {
+            for (uint64_t i = 0; i < operations; i++) {
+              for (Shared::Protocol::Player &player : *players) {
+                const Shared::Protocol::Position position =
+                    player.getPosition();
+                player.setPosition(position.x + 0.05f, position.y);
+              }
+              gameData->updatePlayers(*players);
+            }
+          };
+        });
+  }
+
+  for (const int width : {256, 4096, 65535}) {
+    for (const int playerCount : {2, 64}) {
+      registry.add(
+          "client/snapshot_read", {{"width", width}, {"players", playerCount}},
+          [width, playerCount]() -> Body {
+            auto gameData = std::make_shared<Client::GameData>();
+            gameData->updateMap(makeMap(width));
+            gameData->updatePlayers(makePlayers(playerCount));
+            gameData->updatePlayers(makePlayers(playerCount));
+
+            // One operation is what the renderer reads for one frame.
+            return [gameData, width](const uint64_t operations) {
+              size_t total = 0;
+              for (uint64_t i = 0; i < operations; i++) {
+                const Client::GameFrame &frame = gameData->acquireFrame();
+                const auto now = Client::GameFrame::Clock::now();
+                for (const Shared::Protocol::Player &player : frame.players) {
+                  const Shared::Protocol::Position position =
+                      frame.getRenderPosition(player, 1, now);
+                  total += static_cast<size_t>(position.x);
+                }
+
+                const int first = static_cast<int>(i % static_cast<uint64_t>(
+                    std::max(1, width - VIEW_COLUMNS)));
+                const int last = std::min(width, first + VIEW_COLUMNS);
+                for (int y = 0; y < frame.map->getHeight(); y++) {
+                  for (int x = first; x < last; x++) {
+                    total += static_cast<size_t>(frame.map->getTileAt(x, y));
+                    total +=
+                        static_cast<size_t>(frame.map->getCoinStateAt(x, y));
+                  }
+                }
+              }
+              doNotOptimize(total);
+            };
+          });
+    }
+  }
+}
+
+} // namespace
+
+void registerClientBenchmarks(Registry &registry) {
+  registerFramingBenchmarks(registry);
+  registerReceiveBenchmarks(registry);
+  registerGameDataBenchmarks(registry);
+}
+
+} // namespace Jetpack::Bench
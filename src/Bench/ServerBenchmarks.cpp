@@ -0,0 +1,535 @@
+/**
+ * @file ServerBenchmarks.cpp
+ * @brief Benchmarks of the server hot paths: state packet building,
+ *        physics, collision sweeps, map loading and whole match ticks.
+ */
+
+#include "../Server/Broadcaster.hpp"
+#include "../Server/Match.hpp"
+#include "../Server/SendQueue.hpp"
+#include "../Shared/Exceptions.hpp"
+#include "../Shared/Physics.hpp"
+#include "Benchmark.hpp"
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Jetpack::Bench {
+
+namespace {
+
+/** Map sizes, in columns, every map benchmark runs with. */
+constexpr std::array<int, 3> MAP_WIDTHS = {256, 4096, 65535};
+
+/** Player counts of the benchmarks that scale with the room. */
+constexpr std::array<int, 4> PLAYER_COUNTS = {2, 16, 64, 255};
+
+/** Frames per flush of the send queue benchmark. */
+constexpr std::array<int, 3> FRAME_COUNTS = {1, 16, 64};
+
+/** Height of every generated map, the same as the shipped one. */
+constexpr int MAP_HEIGHT = 10;
+
+/**
+ * @class ScratchDirectory
+ * @brief Temporary directory for generated maps, removed at exit.
+ */
+class ScratchDirectory {
+public:
+  ScratchDirectory()
+      : m_path(std::filesystem::temp_directory_path() /
+               std::format("jetpack_bench_{}", getpid())) {
+    std::filesystem::create_directories(m_path);
+  }
+
+  ~ScratchDirectory() {
+    std::error_code error;
+    std::filesystem::remove_all(m_path, error);
+  }
+
+  ScratchDirectory(const ScratchDirectory &) = delete;
+  ScratchDirectory &operator=(const ScratchDirectory &) = delete;
+
+  [[nodiscard]] const std::filesystem::path &get() const { return m_path; }
+
+private:
+  std::filesystem::path m_path;
+};
+
+/**
+ * @brief Writes a text map, unless already written.
+ * @param width    Map width in tiles.
+ * @param zappers  Whether to scatter electric squares among the coins.
+ * @return Path of the map.
+ */
+std::filesystem::path writeTextMap(const int width, const bool zappers) {
+  static const ScratchDirectory directory;
+  const std::filesystem::path path =
+      directory.get() / std::format("map{}{}.txt", width, zappers ? "z" : "");
+  if (std::filesystem::exists(path)) {
+    return path;
+  }
+
+  std::ofstream file(path);
+  for (int y = 0; y < MAP_HEIGHT; y++) {
+    std::string row(static_cast<size_t>(width), '_');
+    for (int x = 0; x < width; x++) {
+      if ((x * 7 + y * 3) % 11 == 0) {
+        row[static_cast<size_t>(x)] = 'c';
+      } else if (zappers && (x * 5 + y) % 23 == 0) {
+        row[static_cast<size_t>(x)] = 'e';
+      }
+    }
+    file << row << '\n';
+  }
+  return path;
+}
+
+/**
+ * @class CountingSink
+ * @brief PacketSink that drops frames after counting them, and remembers
+ *        the last delta sent to each client so it can be acknowledged.
+ */
+class CountingSink : public Server::PacketSink {
+public:
+  void queueFrame(const int clientSocket,
+                  const Shared::Protocol::Frame &frame) override {
+    m_bytes += frame.size();
+    const auto type =
+        static_cast<Shared::Protocol::PacketType>(frame.data()[0]);
+    if (frame.size() >= 3 &&
+        (type == Shared::Protocol::PacketType::GAME_STATE_DELTA ||
+         type == Shared::Protocol::PacketType::GAME_STATE_PACKED)) {
+      m_lastDeltas[clientSocket] =
+          std::to_integer<int>(frame.data()[1]) |
+          std::to_integer<int>(frame.data()[2]) << 8;
+    }
+  }
+
+  Shared::Arena &getFrameArena() override { return m_arena; }
+
+  /** @brief Ends a loop iteration, like a worker after flushing. */
+  void flush() { m_arena.reset(); }
+
+  /** @return Bytes queued so far. */
+  [[nodiscard]] uint64_t getBytes() const { return m_bytes; }
+
+  /** @return Sequence of the last delta sent to each client. */
+  [[nodiscard]] const std::unordered_map<int, int> &getLastDeltas() const {
+    return m_lastDeltas;
+  }
+
+private:
+  Shared::Arena m_arena;
+  uint64_t m_bytes = 0;
+  std::unordered_map<int, int> m_lastDeltas;
+};
+
+/** @return A STATE_ACK for a delta sequence, as Match receives it. */
+std::array<uint8_t, 3> makeStateAck(const int sequence) {
+  return {static_cast<uint8_t>(Shared::Protocol::PacketType::STATE_ACK),
+          static_cast<uint8_t>(sequence & 0xFF),
+          static_cast<uint8_t>(sequence >> 8)};
+}
+
+/** @return Players spread over the map, half of them jetpacking. */
+std::vector<Shared::Protocol::Player> makePlayers(const int count) {
+  std::vector<Shared::Protocol::Player> players;
+  for (int i = 0; i < count; i++) {
+    Shared::Protocol::Player &player = players.emplace_back(i + 1, i + 1);
+    player.setState(Shared::Protocol::PlayerState::PLAYING);
+    player.setPosition(1.0f + i * 0.37f, static_cast<float>(i % MAP_HEIGHT));
+    player.setVelocityY((i % 5 - 2) * 0.01f);
+    player.setJetpacking(i % 2 == 0);
+  }
+  return players;
+}
+
+void registerBroadcastBenchmarks(Registry &registry) {
+  for (const int playerCount : PLAYER_COUNTS) {
+    // Full updates, GAME_STATE_DELTA, then GAME_STATE_PACKED.
+    for (const auto &encoding : std::array<std::pair<int, int>, 3>{
+             {{0, 0}, {1, 0}, {1, 1}}}) {
+      const int delta = encoding.first;
+      const int packed = encoding.second;
+      registry.addSteadyState(
+          "protocol/broadcast_state",
+          {{"players", playerCount}, {"delta", delta}, {"packed", packed}},
+          [playerCount, delta, packed]() -> Body {
+            struct State {
+              CountingSink sink;
+              std::unordered_map<int, Shared::Protocol::Player> players;
+              std::vector<int> spectators;
+              Server::Broadcaster broadcaster{sink, players, spectators};
+            };
+            auto state = std::make_shared<State>();
+            state->broadcaster.reserve(static_cast<size_t>(playerCount),
+                                       static_cast<size_t>(playerCount));
+            for (Shared::Protocol::Player &player : makePlayers(playerCount)) {
+              state->players.emplace(player.getClientSocket(), player);
+              if (delta != 0) {
+                state->broadcaster.enableDeltaState(player.getClientSocket());
+              }
+              if (packed != 0) {
+                state->broadcaster.enablePackedState(
+                    player.getClientSocket());
+              }
+            }
+
+            return [state](const uint64_t operations) {
+              for (uint64_t i = 0; i < operations; i++) {
+                for (auto &[_, player] : state->players) {
+                  Shared::Physics::step(player, MAP_HEIGHT);
+                }
+                state->broadcaster.broadcastGameState();
+                for (const auto &[socket, sequence] :
+                     state->sink.getLastDeltas()) {
+                  state->broadcaster.acknowledgeState(
+                      socket, static_cast<uint16_t>(sequence));
+                }
+                state->sink.flush();
+              }
+              doNotOptimize(state->sink.getBytes());
+            };
+          });
+    }
+  }
+}
+
+void registerFrameBenchmarks(Registry &registry) {
+  for (const int playerCount : PLAYER_COUNTS) {
+    registry.addSteadyState(
+        "protocol/frame_build", {{"players", playerCount}},
+        [playerCount]() -> Body {
+          auto arena = std::make_shared<Shared::Arena>();
+          return [arena, playerCount](const uint64_t operations) {
+            size_t bytes = 0;
+            for (uint64_t i = 0; i < operations; i++) {
+              Shared::Protocol::FrameBuilder packet(
+                  *arena, Shared::Protocol::PacketType::GAME_STATE_UPDATE,
+                  1 + static_cast<size_t>(playerCount) *
+                          Server::Broadcaster::PLAYER_STATE_SIZE);
+              packet.addByte(static_cast<uint8_t>(playerCount));
+              for (int player = 0; player < playerCount; player++) {
+                packet.addByte(static_cast<uint8_t>(player));
+                packet.addByte(static_cast<uint8_t>(i));
+                packet.addShort(static_cast<uint16_t>(player * 3));
+                packet.addShort(static_cast<uint16_t>(i));
+                packet.addInt(static_cast<uint32_t>(player));
+              }
+              bytes += packet.finish().size();
+              arena->reset();
+            }
+            doNotOptimize(bytes);
+          };
+        });
+  }
+
+  for (const int frameCount : FRAME_COUNTS) {
+    registry.addSteadyState(
+        "protocol/send_queue_flush", {{"frames", frameCount}},
+        [frameCount]() -> Body {
+          /** A socket pair whose far end is drained after each flush. */
+          struct State {
+            std::array<int, 2> sockets{-1, -1};
+            Shared::Arena arena;
+            Server::SendQueue queue;
+            std::array<std::byte, 64 * 1024> drain{};
+
+            State() {
+              if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0,
+                             sockets.data()) < 0) {
+                throw Shared::Exceptions::SocketException(
+                    "Failed to open the send queue socket pair");
+              }
+            }
+            ~State() {
+              close(sockets[0]);
+              close(sockets[1]);
+            }
+            State(const State &) = delete;
+            State &operator=(const State &) = delete;
+          };
+          auto state = std::make_shared<State>();
+
+          return [state, frameCount](const uint64_t operations) {
+            for (uint64_t i = 0; i < operations; i++) {
+              for (int frame = 0; frame < frameCount; frame++) {
+                Shared::Protocol::FrameBuilder packet(
+                    state->arena,
+                    Shared::Protocol::PacketType::GAME_STATE_DELTA, 16);
+                for (int field = 0; field < 4; field++) {
+                  packet.addInt(static_cast<uint32_t>(i + field));
+                }
+                state->queue.push(packet.finish());
+              }
+              while (state->queue.flush(state->sockets[0]) ==
+                     Server::SendQueue::FlushResult::PENDING) {
+                state->queue.detachFrames();
+                while (read(state->sockets[1], state->drain.data(),
+                            state->drain.size()) > 0) {
+                }
+              }
+              while (read(state->sockets[1], state->drain.data(),
+                          state->drain.size()) > 0) {
+              }
+              state->arena.reset();
+            }
+            doNotOptimize(state->queue.getPendingBytes());
+          };
+        });
+  }
+}
+
+void registerPhysicsBenchmarks(Registry &registry) {
+  for (const int playerCount : PLAYER_COUNTS) {
+    registry.add("physics/step_players", {{"players", playerCount}},
+                 [playerCount]() -> Body {
+                   auto players = std::make_shared<
+                       std::vector<Shared::Protocol::Player>>(
+                       makePlayers(playerCount));
+                   return [players](const uint64_t operations) {
+                     for (uint64_t i = 0; i < operations; i++) {
+                       for (Shared::Protocol::Player &player : *players) {
+                         Shared::Physics::step(player, MAP_HEIGHT);
+                       }
+                     }
+                     doNotOptimize(players->front().getPosition());
+                   };
+                 });
+
+    registry.add("physics/step_batch", {{"players", playerCount}},
+                 [playerCount]() -> Body {
+                   auto batch = std::make_shared<Shared::PlayerBatch>();
+                   for (const auto &player : makePlayers(playerCount)) {
+                     batch->add(player);
+                   }
+                   return [batch](const uint64_t operations) {
+                     for (uint64_t i = 0; i < operations; i++) {
+                       Shared::Physics::step(*batch, MAP_HEIGHT);
+                     }
+                     doNotOptimize(batch->y.front());
+                   };
+                 });
+
+    // Steps random players both ways and fails the suite unless the batch
+    // kernels land bit for bit where the scalar step does.
+    registry.add(
+        "physics/batch_vs_scalar", {{"players", playerCount}},
+        [playerCount]() -> Body {
+          struct State {
+            std::vector<Shared::Protocol::Player> players;
+            Shared::PlayerBatch batch;
+            std::mt19937 random{42};
+          };
+          auto state = std::make_shared<State>();
+          state->players = makePlayers(playerCount);
+          state->batch.reserve(state->players.size());
+
+          return [state](const uint64_t operations) {
+            // Reaches past both bounds and both velocity clamps.
+            std::uniform_real_distribution<float> position(-1.0f,
+                                                           MAP_HEIGHT + 1.0f);
+            std::uniform_real_distribution<float> velocity(-0.1f, 0.1f);
+            std::bernoulli_distribution jetpacking(0.5);
+
+            for (uint64_t i = 0; i < operations; i++) {
+              state->batch.clear();
+              for (Shared::Protocol::Player &player : state->players) {
+                player.setPosition(position(state->random) * 100.0f,
+                                   position(state->random));
+                player.setVelocityY(velocity(state->random));
+                player.setJetpacking(jetpacking(state->random));
+                state->batch.add(player);
+              }
+
+              Shared::Physics::step(state->batch, MAP_HEIGHT);
+              for (size_t lane = 0; lane < state->players.size(); lane++) {
+                Shared::Protocol::Player &player = state->players[lane];
+                Shared::Physics::step(player, MAP_HEIGHT);
+                if (std::bit_cast<uint32_t>(player.getPosition().x) !=
+                        std::bit_cast<uint32_t>(state->batch.x[lane]) ||
+                    std::bit_cast<uint32_t>(player.getPosition().y) !=
+                        std::bit_cast<uint32_t>(state->batch.y[lane]) ||
+                    std::bit_cast<uint32_t>(player.getVelocityY()) !=
+                        std::bit_cast<uint32_t>(
+                            state->batch.velocityY[lane])) {
+                  throw Shared::Exceptions::Exception(std::format(
+                      "physics/batch_vs_scalar: lane {} stepped to "
+                      "({}, {}, {}) instead of ({}, {}, {})",
+                      lane, state->batch.x[lane], state->batch.y[lane],
+                      state->batch.velocityY[lane], player.getPosition().x,
+                      player.getPosition().y, player.getVelocityY()));
+                }
+              }
+            }
+            doNotOptimize(state->batch.y.front());
+          };
+        });
+  }
+}
+
+void registerCollisionBenchmarks(Registry &registry) {
+  for (const int width : MAP_WIDTHS) {
+    for (const int playerCount : {2, 64}) {
+      registry.add(
+          "collision/sweep", {{"width", width}, {"players", playerCount}},
+          [width, playerCount]() -> Body {
+            const std::shared_ptr<const Server::MapImage> image =
+                Server::MapImage::load(writeTextMap(width, true));
+            auto hits = std::make_shared<std::vector<
+                Server::CollisionIndex::Hit>>();
+            hits->reserve(16);
+
+            return [image, hits, width,
+                    playerCount](const uint64_t operations) {
+              const Server::CollisionIndex &index =
+                  image->getCollisionIndex();
+              size_t total = 0;
+              for (uint64_t i = 0; i < operations; i++) {
+                // Walk the players along the whole map, one tick apart.
+                const float x =
+                    static_cast<float>(i % static_cast<uint64_t>(width * 20)) *
+                    0.05f;
+                for (int p = 0; p < playerCount; p++) {
+                  const float y = static_cast<float>(p % MAP_HEIGHT) + 0.5f;
+                  index.sweep({x, y}, {x + 0.05f, y + 0.05f}, {0.0f, 0.0f},
+                              *hits);
+                  total += hits->size();
+                }
+              }
+              doNotOptimize(total);
+            };
+          });
+    }
+  }
+}
+
+void registerMapBenchmarks(Registry &registry) {
+  for (const int width : MAP_WIDTHS) {
+    registry.add("map/compile", {{"width", width}}, [width]() -> Body {
+      const std::filesystem::path source = writeTextMap(width, true);
+      const std::filesystem::path output =
+          source.string() + ".compiled" + Server::MapImage::CACHE_SUFFIX;
+      return [source, output](const uint64_t operations) {
+        for (uint64_t i = 0; i < operations; i++) {
+          Server::MapImage::compile(source, output);
+        }
+      };
+    });
+
+    registry.add("map/load_cached", {{"width", width}}, [width]() -> Body {
+      const std::filesystem::path source = writeTextMap(width, true);
+      doNotOptimize(Server::MapImage::load(source));
+      return [source](const uint64_t operations) {
+        for (uint64_t i = 0; i < operations; i++) {
+          doNotOptimize(Server::MapImage::load(source)->getCoinCount());
+        }
+      };
+    });
+  }
+}
+
+void registerMatchBenchmarks(Registry &registry) {
+  constexpr uint8_t allCapabilities =
+      Shared::Protocol::CAPABILITY_DELTA_STATE |
+      Shared::Protocol::CAPABILITY_INPUT_SEQUENCE |
+      Shared::Protocol::CAPABILITY_MAP_STREAMING;
+
+  for (const int width : MAP_WIDTHS) {
+    for (const uint8_t capabilities :
+         {uint8_t{0}, allCapabilities,
+          static_cast<uint8_t>(allCapabilities |
+                               Shared::Protocol::CAPABILITY_PACKED_STATE)}) {
+      registry.addSteadyState(
+          "match/tick", {{"width", width}, {"capabilities", capabilities}},
+          [width, capabilities]() -> Body {
+            struct State {
+              std::shared_ptr<const Server::MapImage> image;
+              CountingSink sink;
+              std::unique_ptr<Server::Match> match;
+              uint16_t inputSequence = 0;
+              uint64_t tick = 0;
+            };
+            auto state = std::make_shared<State>();
+            state->image = Server::MapImage::load(writeTextMap(width, false));
+
+            const auto startMatch = [state, capabilities]() {
+              state->match = std::make_unique<Server::Match>(
+                  0, state->image, state->sink, false);
+              for (const int socket : {1, 2}) {
+                state->match->addPlayer(socket);
+                state->match->handleConnectRequest(socket, capabilities);
+              }
+              state->sink.flush();
+            };
+            startMatch();
+
+            return [state, capabilities,
+                    startMatch](const uint64_t operations) {
+              const bool sequenced =
+                  (capabilities &
+                   Shared::Protocol::CAPABILITY_INPUT_SEQUENCE) != 0;
+              for (uint64_t i = 0; i < operations; i++) {
+                if (state->match->isOver()) {
+                  // A new match is setup, not part of the tick.
+                  const UncountedScope uncounted;
+                  startMatch();
+                }
+
+                // Hold the jetpack a third of the time, like the bots.
+                const bool jetpack = state->tick++ % 60 < 20;
+                state->inputSequence++;
+                const std::array<uint8_t, 4> input = {
+                    static_cast<uint8_t>(
+                        Shared::Protocol::PacketType::PLAYER_INPUT),
+                    static_cast<uint8_t>(
+                        (sequenced ? Shared::Protocol::InputFlag::SEQUENCED
+                                   : 0) |
+                        (jetpack ? Shared::Protocol::InputFlag::JETPACK : 0)),
+                    static_cast<uint8_t>(state->inputSequence & 0xFF),
+                    static_cast<uint8_t>(state->inputSequence >> 8)};
+                for (const int socket : {1, 2}) {
+                  state->match->handlePlayerInput(socket, input.data(),
+                                                  sequenced ? 4 : 2);
+                }
+
+                state->match->update();
+                for (const auto &[socket, sequence] :
+                     state->sink.getLastDeltas()) {
+                  const std::array<uint8_t, 3> ack = makeStateAck(sequence);
+                  state->match->handleStateAck(socket, ack.data(),
+                                               ack.size());
+                }
+                state->sink.flush();
+              }
+              doNotOptimize(state->sink.getBytes());
+            };
+          });
+    }
+  }
+}
+
+} // namespace
+
+void registerServerBenchmarks(Registry &registry) {
+  registerBroadcastBenchmarks(registry);
+  registerFrameBenchmarks(registry);
+  registerPhysicsBenchmarks(registry);
+  registerCollisionBenchmarks(registry);
+  registerMapBenchmarks(registry);
+  registerMatchBenchmarks(registry);
+}
+
+} // namespace Jetpack::Bench
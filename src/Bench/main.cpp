@@ -0,0 +1,108 @@
+/**
+ * @file main.cpp
+ * @brief Entry point for the Jetpack micro-benchmark suite.
+ */
+
+#include "Benchmark.hpp"
+#include <chrono>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+void printUsage(const std::string &programName) {
+  std::cerr << std::format(
+      "Usage: {} [-o <file.json>] [-f <name filter>] [-t <seconds>]\n",
+      programName);
+}
+
+struct BenchOptions {
+  std::string outputPath;
+  std::string filter;
+  std::chrono::duration<double> minTime{0.2};
+};
+
+std::optional<BenchOptions> parseCommandLine(const int argc, char *argv[]) {
+  BenchOptions options;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+
+    if (arg == "-o" && i + 1 < argc) {
+      options.outputPath = argv[++i];
+    } else if (arg == "-f" && i + 1 < argc) {
+      options.filter = argv[++i];
+    } else if (arg == "-t" && i + 1 < argc) {
+      try {
+        options.minTime = std::chrono::duration<double>(std::stod(argv[++i]));
+      } catch (const std::exception &e) {
+        std::cerr << std::format("Error parsing duration: {}\n", e.what());
+        return std::nullopt;
+      }
+    } else {
+      printUsage(argv[0]);
+      return std::nullopt;
+    }
+  }
+
+  return options;
+}
+
+int main(const int argc, char *argv[]) {
+  auto options = parseCommandLine(argc, argv);
+  if (!options) {
+    return 1;
+  }
+
+  Jetpack::Bench::Registry registry;
+  Jetpack::Bench::registerServerBenchmarks(registry);
+  Jetpack::Bench::registerClientBenchmarks(registry);
+
+  std::vector<Jetpack::Bench::Result> results;
+  bool allocated = false;
+  try {
+    for (const Jetpack::Bench::Benchmark &benchmark :
+         registry.getBenchmarks()) {
+      if (benchmark.name.find(options->filter) == std::string::npos) {
+        continue;
+      }
+
+      const Jetpack::Bench::Result &result = results.emplace_back(
+          Jetpack::Bench::run(benchmark, options->minTime));
+
+      std::string parameters;
+      for (const auto &[name, value] : benchmark.parameters) {
+        parameters += std::format(" {}={}", name, value);
+      }
+      std::cerr << std::format(
+          "{:<26}{:<28}{:>14.1f} ns/op {:>8.2f} allocs/op\n", benchmark.name,
+          parameters, result.nanosecondsPerOperation,
+          result.allocationsPerOperation);
+      if (benchmark.steadyState && result.allocations > 0) {
+        std::cerr << std::format(
+            "Error: {}{} allocated {} times after warm-up\n", benchmark.name,
+            parameters, result.allocations);
+        allocated = true;
+      }
+    }
+  } catch (const std::exception &e) {
+    std::cerr << std::format("Error: {}\n", e.what());
+    return 1;
+  }
+
+  if (options->outputPath.empty()) {
+    Jetpack::Bench::writeJson(std::cout, results);
+    return allocated ? 1 : 0;
+  }
+
+  std::ofstream output(options->outputPath);
+  Jetpack::Bench::writeJson(output, results);
+  if (!output) {
+    std::cerr << std::format("Error: cannot write {}\n", options->outputPath);
+    return 1;
+  }
+  return allocated ? 1 : 0;
+}
@@ -1,70 +1,364 @@
 /**
  * @file GameData.hpp
- * @brief Thread-safe container for client-side game state data.
+ * @brief Client-side game state, published by the network thread and read
+ *        by the render thread without locks.
  */
 
 #pragma once
 
 #include "../Shared/Protocol.hpp"
-#include <mutex>
+#include "TripleBuffer.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <utility>
 #include <vector>
 
 namespace Jetpack::Client {
 
+/**
+ * @class MapChunk
+ * @brief Whole columns of the map, received in one piece.
+ *
+ * The layout never changes once received, so map states share chunks by
+ * pointer instead of copying them. Coin states are the only part that
+ * changes during a game; they are atomics the network thread updates in
+ * place.
+ */
+class MapChunk {
+public:
+  /**
+   * @brief Takes ownership of received columns.
+   * @param firstColumn Map column of the chunk's first column.
+   * @param columns     Layout and initial coin states of the columns, as a
+   *                    map as wide as the chunk.
+   */
+  MapChunk(const int firstColumn, Shared::Protocol::GameMap columns)
+      : m_firstColumn(firstColumn), m_columns(std::move(columns)),
+        m_coinStates(std::make_unique<std::atomic<uint8_t>[]>(
+            m_columns.getCellCount())) {
+    for (size_t i = 0; i < m_columns.coinStates.size(); i++) {
+      m_coinStates[i].store(static_cast<uint8_t>(m_columns.coinStates[i]),
+                            std::memory_order_relaxed);
+    }
+  }
+
+  /** @return Map column of the chunk's first column. */
+  [[nodiscard]] int getFirstColumn() const { return m_firstColumn; }
+
+  /** @return True if the chunk holds map column x. */
+  [[nodiscard]] bool contains(const int x) const {
+    return x >= m_firstColumn && x - m_firstColumn < m_columns.width;
+  }
+
+  /**
+   * @param x Map column index
+   * @param y Row index
+   * @return TileType at the given cell, EMPTY if out of bounds.
+   */
+  [[nodiscard]] Shared::Protocol::TileType getTileAt(const int x,
+                                                     const int y) const {
+    return m_columns.getTileAt(x - m_firstColumn, y);
+  }
+
+  /**
+   * @param x Map column index
+   * @param y Row index
+   * @return CoinState at the given cell, AVAILABLE if out of bounds.
+   */
+  [[nodiscard]] Shared::Protocol::CoinState getCoinStateAt(const int x,
+                                                           const int y) const {
+    if (!m_columns.isValidPosition(x - m_firstColumn, y)) {
+      return Shared::Protocol::CoinState::AVAILABLE;
+    }
+    return static_cast<Shared::Protocol::CoinState>(
+        m_coinStates[m_columns.getIndex(x - m_firstColumn, y)].load(
+            std::memory_order_relaxed));
+  }
+
+  /**
+   * @brief Updates the state of a specific coin; network thread only.
+   * @param x Map column of the coin.
+   * @param y Row of the coin.
+   * @param coinState New state value for the coin.
+   */
+  void setCoinState(const int x, const int y,
+                    const Shared::Protocol::CoinState coinState) {
+    if (m_columns.isValidPosition(x - m_firstColumn, y)) {
+      m_coinStates[m_columns.getIndex(x - m_firstColumn, y)].store(
+          static_cast<uint8_t>(coinState), std::memory_order_relaxed);
+    }
+  }
+
+private:
+  const int m_firstColumn;
+  const Shared::Protocol::GameMap m_columns;
+  std::unique_ptr<std::atomic<uint8_t>[]> m_coinStates;
+};
+
+/**
+ * @class MapState
+ * @brief The part of the map the client holds, shared by every frame.
+ *
+ * A map received whole as MAP_DATA is a single chunk. A streamed map
+ * starts empty and gains a chunk with each MAP_CHUNK; chunks live in a
+ * ring of slots spanning RESIDENT_COLUMNS, so each arrival evicts the
+ * chunk that far behind it. Cells of chunks not held read as EMPTY.
+ */
+class MapState {
+public:
+  /**
+   * Columns kept resident; must exceed what the server streams ahead of
+   * the player plus what the camera shows behind it.
+   */
+  static constexpr int RESIDENT_COLUMNS = 512;
+
+  /**
+   * @brief Holds a map received whole.
+   * @param map Layout and initial coin states from MAP_DATA.
+   */
+  explicit MapState(Shared::Protocol::GameMap map)
+      : m_width(map.width), m_height(map.height),
+        m_chunkColumns(std::max(map.width, 1)), m_chunks(1) {
+    m_chunks[0] = std::make_shared<MapChunk>(0, std::move(map));
+  }
+
+  /**
+   * @brief Starts a streamed map with no chunk received yet.
+   * @param width        Map width from MAP_INFO.
+   * @param height       Map height from MAP_INFO.
+   * @param chunkColumns Columns per chunk from MAP_INFO.
+   */
+  MapState(const int width, const int height, const int chunkColumns)
+      : m_width(width), m_height(height),
+        m_chunkColumns(std::max(chunkColumns, 1)),
+        m_chunks((RESIDENT_COLUMNS + m_chunkColumns - 1) / m_chunkColumns + 1) {
+  }
+
+  /**
+   * @brief Makes the state that also holds a newly received chunk.
+   * @param chunk Chunk aligned on the chunk width.
+   * @return A copy of this state with the chunk in its slot.
+   */
+  [[nodiscard]] std::shared_ptr<MapState>
+  withChunk(std::shared_ptr<MapChunk> chunk) const {
+    auto next = std::make_shared<MapState>(*this);
+    next->m_chunks[getSlot(chunk->getFirstColumn())] = std::move(chunk);
+    return next;
+  }
+
+  /** @return Map width in tiles. */
+  [[nodiscard]] int getWidth() const { return m_width; }
+
+  /** @return Map height in tiles. */
+  [[nodiscard]] int getHeight() const { return m_height; }
+
+  /**
+   * @brief Get the tile at a position; a coin collected by both players
+   *        reads as EMPTY.
+   * @param x Column index
+   * @param y Row index
+   * @return TileType at the given cell, EMPTY if out of bounds or not held.
+   */
+  [[nodiscard]] Shared::Protocol::TileType getTileAt(const int x,
+                                                     const int y) const {
+    const MapChunk *chunk = findChunk(x);
+    if (chunk == nullptr) {
+      return Shared::Protocol::TileType::EMPTY;
+    }
+
+    const Shared::Protocol::TileType tile = chunk->getTileAt(x, y);
+    if (tile == Shared::Protocol::TileType::COIN &&
+        chunk->getCoinStateAt(x, y) ==
+            Shared::Protocol::CoinState::COLLECTED_BOTH) {
+      return Shared::Protocol::TileType::EMPTY;
+    }
+    return tile;
+  }
+
+  /**
+   * @brief Get the current state of a coin.
+   * @param x Column index
+   * @param y Row index
+   * @return CoinState at the given cell, AVAILABLE if out of bounds or not
+   *         held.
+   */
+  [[nodiscard]] Shared::Protocol::CoinState getCoinStateAt(const int x,
+                                                           const int y) const {
+    const MapChunk *chunk = findChunk(x);
+    return chunk != nullptr ? chunk->getCoinStateAt(x, y)
+                            : Shared::Protocol::CoinState::AVAILABLE;
+  }
+
+  /**
+   * @brief Updates the state of a specific coin; network thread only.
+   *
+   * Coins of chunks not held are skipped: a chunk sent later already
+   * carries its current coin states.
+   *
+   * @param x X-coordinate of the coin.
+   * @param y Y-coordinate of the coin.
+   * @param coinState New state value for the coin.
+   */
+  void setCoinState(const int x, const int y,
+                    const Shared::Protocol::CoinState coinState) {
+    MapChunk *chunk = findChunk(x);
+    if (chunk != nullptr) {
+      chunk->setCoinState(x, y, coinState);
+    }
+  }
+
+private:
+  /** @return Slot of the chunk holding map column x. */
+  [[nodiscard]] size_t getSlot(const int x) const {
+    return static_cast<size_t>(x / m_chunkColumns) % m_chunks.size();
+  }
+
+  /** @return The held chunk with map column x, or nullptr. */
+  [[nodiscard]] MapChunk *findChunk(const int x) const {
+    if (x < 0 || x >= m_width) {
+      return nullptr;
+    }
+    const std::shared_ptr<MapChunk> &chunk = m_chunks[getSlot(x)];
+    return chunk && chunk->contains(x) ? chunk.get() : nullptr;
+  }
+
+  int m_width;
+  int m_height;
+  int m_chunkColumns;
+  std::vector<std::shared_ptr<MapChunk>> m_chunks;
+};
+
+/**
+ * @struct GameFrame
+ * @brief Everything the renderer needs for one frame, as last published.
+ */
+struct GameFrame {
+  using Clock = std::chrono::steady_clock;
+
+  /** Shared with every other frame; null until the map arrives. */
+  std::shared_ptr<const MapState> map;
+  std::vector<Shared::Protocol::Player> players;
+  /** Drawn positions of the players when the latest snapshot arrived. */
+  std::vector<Shared::Protocol::Player> previousPlayers;
+  Clock::time_point lastSnapshotTime;
+  Clock::duration snapshotInterval{};
+  bool gameOver = false;
+  int winnerId = -1;
+
+  /** Moves longer than this (in cells) are teleports and are not eased. */
+  static constexpr float SNAP_DISTANCE = 1.0f;
+
+  /**
+   * @brief Get where a player should be drawn now.
+   *
+   * Remote players glide from where they were drawn when the latest
+   * snapshot arrived to that snapshot, over one snapshot interval; the
+   * local player is returned as is, since it is predicted.
+   *
+   * @param player        Player from this frame.
+   * @param localPlayerId ID of the local player.
+   * @param now           Time to evaluate the blend at.
+   * @return The position to draw.
+   */
+  [[nodiscard]] Shared::Protocol::Position
+  getRenderPosition(const Shared::Protocol::Player &player,
+                    const int localPlayerId,
+                    const Clock::time_point now) const {
+    const Shared::Protocol::Position to = player.getPosition();
+    if (player.getId() == localPlayerId ||
+        snapshotInterval <= Clock::duration::zero()) {
+      return to;
+    }
+
+    const auto previous = std::ranges::find_if(
+        previousPlayers,
+        [&player](const auto &p) { return p.getId() == player.getId(); });
+    if (previous == previousPlayers.end()) {
+      return to;
+    }
+
+    const Shared::Protocol::Position from = previous->getPosition();
+    if (std::abs(to.x - from.x) > SNAP_DISTANCE ||
+        std::abs(to.y - from.y) > SNAP_DISTANCE) {
+      return to;
+    }
+
+    const float alpha = std::clamp(
+        std::chrono::duration<float>(now - lastSnapshotTime).count() /
+            std::chrono::duration<float>(snapshotInterval).count(),
+        0.0f, 1.0f);
+    return {from.x + (to.x - from.x) * alpha,
+            from.y + (to.y - from.y) * alpha};
+  }
+};
+
 /**
  * @class GameData
- * @brief Manages and synchronizes access to game state data on the client.
- * 
- * GameData provides thread-safe access to the game map, coin states, player
- * information, and game state. It serves as a central data repository that
- * can be safely accessed from both the rendering thread and the network thread.
+ * @brief Hands client game state from the network thread to the renderer.
+ *
+ * The network thread is the only writer: it edits a private working
+ * frame and publishes a copy of it through a triple buffer after each
+ * change. The render thread acquires the latest frame once per frame
+ * without locking and reads it in place. The map is never copied: frames
+ * share its chunks, and coin pickups update their atomic coin states
+ * directly.
  */
 class GameData {
 public:
+  /** Columns whose coin changes share one revision counter. */
+  static constexpr int COIN_REVISION_COLUMNS = 16;
+
   /** @brief Default constructor. */
   GameData() = default;
 
   /**
-   * @brief Get a copy of the current game map.
-   * @return The game map containing level layout information.
+   * @brief Picks up the latest published frame; render thread only.
+   * @return The frame, valid until the next call.
    */
-  Shared::Protocol::GameMap getMap() const {
-    std::lock_guard lock(m_dataMutex);
-    return m_map;
-  }
+  const GameFrame &acquireFrame() { return m_frames.acquire(); }
 
   /**
    * @brief Updates the game map with new data from the server.
    * @param map New map to store locally.
-   * 
-   * Also initializes/resizes the coin state tracking matrix to match
-   * the map dimensions and copies any provided coin states.
    */
   void updateMap(const Shared::Protocol::GameMap &map) {
-    std::lock_guard lock(m_dataMutex);
-    m_map = map;
-
-    m_coinStates.resize(
-        map.height,
-        std::vector(map.width,
-                    static_cast<int>(Shared::Protocol::CoinState::AVAILABLE)));
-
-    if (!map.coinStates.empty()) {
-      for (int y = 0; y < map.height; y++) {
-        for (int x = 0; x < map.width; x++) {
-          m_coinStates[y][x] = static_cast<int>(map.coinStates[y][x]);
-        }
-      }
-    }
+    m_map = std::make_shared<MapState>(map);
+    m_working.map = m_map;
+    publish();
   }
 
   /**
-   * @brief Get a copy of the current coin states.
-   * @return 2D vector containing the state of each coin in the map.
+   * @brief Starts a streamed map, empty until its chunks arrive.
+   * @param width        Map width in tiles.
+   * @param height       Map height in tiles.
+   * @param chunkColumns Columns per chunk.
    */
-  std::vector<std::vector<int>> getCoinStates() const {
-    std::lock_guard lock(m_dataMutex);
-    return m_coinStates;
+  void startMapStream(int width, int height, int chunkColumns) {
+    m_map = std::make_shared<MapState>(width, height, chunkColumns);
+    m_working.map = m_map;
+    publish();
+  }
+
+  /**
+   * @brief Adds a streamed chunk, evicting the one it replaces.
+   * @param firstColumn Map column of the chunk's first column.
+   * @param columns     The chunk's columns, as a map as wide as the chunk.
+   *
+   * Frames already handed out keep the state they were published with.
+   */
+  void addMapChunk(int firstColumn, Shared::Protocol::GameMap columns) {
+    if (!m_map) {
+      return;
+    }
+    m_map = m_map->withChunk(
+        std::make_shared<MapChunk>(firstColumn, std::move(columns)));
+    m_working.map = m_map;
+    publish();
   }
 
   /**
@@ -72,38 +366,74 @@ public:
    * @param x X-coordinate of the coin.
    * @param y Y-coordinate of the coin.
    * @param coinState New state value for the coin.
-   * 
-   * If the coin is now fully collected (by both players), also
-   * updates the map tile to be empty.
+   *
+   * Takes effect in every frame at once, since frames share the map.
    */
   void updateCoinStates(int x, int y, int coinState) {
-    std::lock_guard lock(m_dataMutex);
-    if (x >= 0 && x < m_map.width && y >= 0 && y < m_map.height) {
-      m_coinStates[y][x] = coinState;
-
-      if (coinState ==
-          static_cast<int>(Shared::Protocol::CoinState::COLLECTED_BOTH)) {
-        m_map.tiles[y][x] = Shared::Protocol::TileType::EMPTY;
-      }
+    if (m_map) {
+      m_map->setCoinState(x, y,
+                          static_cast<Shared::Protocol::CoinState>(coinState));
+      m_coinRevisions[getCoinRevisionSlot(x)].fetch_add(
+          1, std::memory_order_release);
     }
   }
 
   /**
-   * @brief Get a copy of the current player list.
-   * @return Vector of all players in the game.
+   * @brief Get a counter bumped after every coin state change in the
+   *        COIN_REVISION_COLUMNS columns around a column, so the renderer
+   *        can tell when what it built from them is stale.
+   *
+   * Column groups far apart share a counter: a change may also mark
+   * another group stale, never the reverse.
+   *
+   * @param column Map column.
+   * @return The current revision.
    */
-  std::vector<Shared::Protocol::Player> getPlayers() const {
-    std::lock_guard lock(m_dataMutex);
-    return m_players;
+  uint32_t getCoinRevision(const int column) const {
+    return m_coinRevisions[getCoinRevisionSlot(column)].load(
+        std::memory_order_acquire);
   }
 
   /**
    * @brief Updates the entire player list.
    * @param players New player list from the server.
+   *
+   * Remote players start interpolating from their currently drawn
+   * position towards the new one.
    */
   void updatePlayers(const std::vector<Shared::Protocol::Player> &players) {
-    std::lock_guard lock(m_dataMutex);
-    m_players = players;
+    const GameFrame::Clock::time_point now = GameFrame::Clock::now();
+    const int localPlayerId = getLocalPlayerId();
+
+    m_drawnPlayers = m_working.players;
+    for (auto &player : m_drawnPlayers) {
+      const Shared::Protocol::Position drawn =
+          m_working.getRenderPosition(player, localPlayerId, now);
+      player.setPosition(drawn.x, drawn.y);
+    }
+    std::swap(m_working.previousPlayers, m_drawnPlayers);
+    m_working.players = players;
+
+    m_working.snapshotInterval = std::clamp<GameFrame::Clock::duration>(
+        now - m_working.lastSnapshotTime, MIN_SNAPSHOT_INTERVAL,
+        MAX_SNAPSHOT_INTERVAL);
+    m_working.lastSnapshotTime = now;
+    publish();
+  }
+
+  /**
+   * @brief Replaces the local player's record with a predicted one,
+   *        leaving remote players and their interpolation untouched.
+   * @param player Predicted local player.
+   */
+  void updateLocalPlayer(const Shared::Protocol::Player &player) {
+    for (auto &existing : m_working.players) {
+      if (existing.getId() == player.getId()) {
+        existing = player;
+        publish();
+        break;
+      }
+    }
   }
 
   /**
@@ -112,10 +442,10 @@ public:
    * @param state New state for the player.
    */
   void updatePlayerState(int playerId, Shared::Protocol::PlayerState state) {
-    std::lock_guard lock(m_dataMutex);
-    for (auto &player : m_players) {
+    for (auto &player : m_working.players) {
       if (player.getId() == playerId) {
         player.setState(state);
+        publish();
         break;
       }
     }
@@ -126,8 +456,7 @@ public:
    * @return The player ID assigned to this client.
    */
   int getLocalPlayerId() const {
-    std::lock_guard lock(m_dataMutex);
-    return m_localPlayerId;
+    return m_localPlayerId.load(std::memory_order_relaxed);
   }
 
   /**
@@ -135,26 +464,7 @@ public:
    * @param id Player ID assigned by the server.
    */
   void setLocalPlayerId(int id) {
-    std::lock_guard lock(m_dataMutex);
-    m_localPlayerId = id;
-  }
-
-  /**
-   * @brief Check if the game is over.
-   * @return True if the game has ended, false otherwise.
-   */
-  bool isGameOver() const {
-    std::lock_guard lock(m_dataMutex);
-    return m_gameOver;
-  }
-
-  /**
-   * @brief Get the ID of the winning player.
-   * @return ID of the winner, or -1 if there is no winner.
-   */
-  int getWinnerId() const {
-    std::lock_guard lock(m_dataMutex);
-    return m_winnerId;
+    m_localPlayerId.store(id, std::memory_order_relaxed);
   }
 
   /**
@@ -162,19 +472,38 @@ public:
    * @param winnerId ID of the winning player, or -1 if no winner.
    */
   void updateGameOver(int winnerId) {
-    std::lock_guard lock(m_dataMutex);
-    m_gameOver = true;
-    m_winnerId = winnerId;
+    m_working.gameOver = true;
+    m_working.winnerId = winnerId;
+    publish();
   }
 
 private:
-  mutable std::mutex m_dataMutex;
-  Shared::Protocol::GameMap m_map;
-  std::vector<std::vector<int>> m_coinStates;
-  std::vector<Shared::Protocol::Player> m_players;
-  int m_localPlayerId = 1;
-  bool m_gameOver = false;
-  int m_winnerId = -1;
+  /** Bounds on the measured time between two snapshots. */
+  static constexpr GameFrame::Clock::duration MIN_SNAPSHOT_INTERVAL =
+      std::chrono::milliseconds(1);
+  static constexpr GameFrame::Clock::duration MAX_SNAPSHOT_INTERVAL =
+      std::chrono::milliseconds(100);
+
+  static constexpr size_t COIN_REVISION_SLOTS = 64;
+
+  /** @return Slot of the revision counter covering a column. */
+  static size_t getCoinRevisionSlot(const int column) {
+    return static_cast<size_t>(std::max(column, 0) / COIN_REVISION_COLUMNS) %
+           COIN_REVISION_SLOTS;
+  }
+
+  /** @brief Copies the working frame into the buffer and hands it over. */
+  void publish() {
+    m_frames.back() = m_working;
+    m_frames.publish();
+  }
+
+  std::shared_ptr<MapState> m_map;
+  GameFrame m_working;
+  std::vector<Shared::Protocol::Player> m_drawnPlayers;
+  TripleBuffer<GameFrame> m_frames;
+  std::atomic<int> m_localPlayerId{1};
+  std::array<std::atomic<uint32_t>, COIN_REVISION_SLOTS> m_coinRevisions{};
 };
 
-} // namespace Jetpack::Client
\ No newline at end of file
+} // namespace Jetpack::Client
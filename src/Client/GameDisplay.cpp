@@ -13,9 +13,53 @@
 
 namespace Jetpack::Client {
 
+namespace {
+
+constexpr const char *RESOURCE_DIRECTORY = "./resources";
+constexpr const char *FONT = "jetpack_font.ttf";
+constexpr const char *BACKGROUND = "background.png";
+constexpr const char *PLAYER_SHEET = "player_sprite_sheet.png";
+constexpr const char *COIN_SHEET = "coins_sprite_sheet.png";
+constexpr const char *ZAPPER_SHEET = "zapper_sprite_sheet.png";
+
+constexpr float COIN_SCALE = 0.2f;
+constexpr float ZAPPER_SCALE = 0.6f;
+constexpr float PLAYER_SCALE = 0.4f;
+
+/**
+ * @brief Appends a textured rectangle as one quad.
+ * @param vertices    Quads batch to append to.
+ * @param bounds      Where the rectangle is drawn.
+ * @param textureRect Part of the texture it shows.
+ * @param color       Color the texture is modulated with.
+ */
+void appendQuad(sf::VertexArray &vertices, const sf::FloatRect &bounds,
+                const sf::IntRect &textureRect, const sf::Color &color) {
+  const float left = bounds.left;
+  const float top = bounds.top;
+  const float right = bounds.left + bounds.width;
+  const float bottom = bounds.top + bounds.height;
+  const auto u0 = static_cast<float>(textureRect.left);
+  const auto v0 = static_cast<float>(textureRect.top);
+  const auto u1 = static_cast<float>(textureRect.left + textureRect.width);
+  const auto v1 = static_cast<float>(textureRect.top + textureRect.height);
+
+  vertices.append(
+      sf::Vertex(sf::Vector2f(left, top), color, sf::Vector2f(u0, v0)));
+  vertices.append(
+      sf::Vertex(sf::Vector2f(right, top), color, sf::Vector2f(u1, v0)));
+  vertices.append(
+      sf::Vertex(sf::Vector2f(right, bottom), color, sf::Vector2f(u1, v1)));
+  vertices.append(
+      sf::Vertex(sf::Vector2f(left, bottom), color, sf::Vector2f(u0, v1)));
+}
+
+} // namespace
+
 GameDisplay::GameDisplay(int windowWidth, int windowHeight)
-    : m_window(sf::VideoMode(windowWidth, windowHeight), "Jetpack") {
-  loadResources();
+    : m_resources(RESOURCE_DIRECTORY),
+      m_window(sf::VideoMode(windowWidth, windowHeight), "Jetpack") {
+  requestResources();
   m_window.setFramerateLimit(60);
 
   m_topBoundary = 48.0f;
@@ -34,42 +78,87 @@ GameDisplay::~GameDisplay() {
   }
 }
 
+void GameDisplay::requestResources() {
+  m_resources.request<sf::Font>(FONT);
+  m_resources.request<sf::Image>(BACKGROUND);
+  m_resources.request<sf::Image>(PLAYER_SHEET);
+  m_resources.request<sf::Image>(COIN_SHEET);
+  m_resources.request<sf::Image>(ZAPPER_SHEET);
+  SoundManager::requestResources(m_resources);
+}
+
+void GameDisplay::drawLoadingScreen() {
+  const size_t requested = m_resources.getRequestCount();
+  const float progress =
+      requested == 0 ? 1.0f
+                     : static_cast<float>(m_resources.getFinishedCount()) /
+                           static_cast<float>(requested);
+
+  const sf::Vector2f size(m_window.getSize().x / 3.0f, 6.0f);
+  const sf::Vector2f position((m_window.getSize().x - size.x) / 2.0f,
+                              (m_window.getSize().y - size.y) / 2.0f);
+
+  m_window.clear(sf::Color(10, 10, 30));
+
+  sf::RectangleShape track(size);
+  track.setPosition(position);
+  track.setFillColor(sf::Color(40, 40, 80));
+  m_window.draw(track);
+
+  sf::RectangleShape bar(sf::Vector2f(size.x * progress, size.y));
+  bar.setPosition(position);
+  bar.setFillColor(sf::Color::White);
+  m_window.draw(bar);
+
+  m_window.display();
+}
+
 void GameDisplay::loadResources() {
-  try {
-    if (!m_gameFont.loadFromFile("./resources/jetpack_font.ttf")) {
-      throw Shared::Exceptions::ResourceException(
-          std::filesystem::path("./resources/jetpack_font.ttf"),
-          "No such file or directory");
-    }
-    if (!m_backgroundTexture.loadFromFile("./resources/background.png")) {
-      throw Shared::Exceptions::ResourceException(
-          std::filesystem::path("./resources/background.png"),
-          "No such file or directory");
-    }
-    if (!m_playerSpritesheet.loadFromFile(
-            "./resources/player_sprite_sheet.png")) {
-      throw Shared::Exceptions::ResourceException(
-          std::filesystem::path("./resources/player_sprite_sheet.png"),
-          "No such file or directory");
-    }
-    if (!m_coinSpritesheet.loadFromFile("./resources/coins_sprite_sheet.png")) {
-      throw Shared::Exceptions::ResourceException(
-          std::filesystem::path("./resources/coins_sprite_sheet.png"),
-          "No such file or directory");
-    }
-    if (!m_zapperSpritesheet.loadFromFile(
-            "./resources/zapper_sprite_sheet.png")) {
-      throw Shared::Exceptions::ResourceException(
-          std::filesystem::path("./resources/zapper_sprite_sheet.png"),
-          "No such file or directory");
-    }
+  if (const auto font = m_resources.find<sf::Font>(FONT)) {
+    m_gameFont = *font;
+  }
+  loadTexture(m_backgroundTexture, BACKGROUND);
+  loadTexture(m_playerSpritesheet, PLAYER_SHEET);
 
-    initializeParallaxBackgrounds();
-    initializeAnimations();
-  } catch (const Shared::Exceptions::ResourceException &e) {
-    std::cerr << std::format("Error loading resources: {}", e.what())
+  const auto coinSheet = m_resources.find<sf::Image>(COIN_SHEET);
+  const auto zapperSheet = m_resources.find<sf::Image>(ZAPPER_SHEET);
+  if (coinSheet && zapperSheet) {
+    buildTileAtlas(*coinSheet, *zapperSheet);
+  }
+
+  m_soundManager.load(m_resources);
+  initializeParallaxBackgrounds();
+  initializeAnimations();
+}
+
+void GameDisplay::loadTexture(sf::Texture &texture, const std::string &name) {
+  const auto image = m_resources.find<sf::Image>(name);
+  if (image && !texture.loadFromImage(*image)) {
+    std::cerr << std::format(
+                     "Error loading resources: Cannot create a texture from "
+                     "'{}'",
+                     name)
+              << std::endl;
+  }
+}
+
+void GameDisplay::buildTileAtlas(const sf::Image &coinSheet,
+                                 const sf::Image &zapperSheet) {
+  const sf::Vector2u coinSize = coinSheet.getSize();
+  const sf::Vector2u zapperSize = zapperSheet.getSize();
+
+  sf::Image atlas;
+  atlas.create(std::max(coinSize.x, zapperSize.x), coinSize.y + zapperSize.y,
+               sf::Color::Transparent);
+  atlas.copy(coinSheet, 0, 0);
+  atlas.copy(zapperSheet, 0, coinSize.y);
+
+  if (!m_tileAtlas.loadFromImage(atlas)) {
+    std::cerr << "Error loading resources: Cannot create the tile atlas"
               << std::endl;
+    return;
   }
+  m_zapperAtlasTop = static_cast<int>(coinSize.y);
 }
 
 void GameDisplay::initializeParallaxBackgrounds() {
@@ -79,53 +168,71 @@ void GameDisplay::initializeParallaxBackgrounds() {
   }
 
   m_parallaxLayers.clear();
-  m_parallaxSpeeds.clear();
 
   const std::vector speeds = {0.2f, 0.4f, 0.6f, 0.8f};
 
-  Shared::Protocol::GameMap map = m_gameData.getMap();
+  const int mapWidth = m_renderedMap ? m_renderedMap->getWidth() : 0;
 
-  if (map.width > 0) {
-    constexpr float cameraZoom = 2.0f;
-    m_visibleMapWidth = map.width / cameraZoom;
+  if (mapWidth > 0) {
+    m_visibleMapWidth = getVisibleMapWidth(mapWidth);
   } else {
     m_visibleMapWidth = 10.0f;
   }
 
-  for (size_t i = 0; i < speeds.size(); i++) {
-    sf::Sprite layer(m_backgroundTexture);
+  const sf::Vector2u textureSize = m_backgroundTexture.getSize();
+  const sf::IntRect textureRect(0, 0, static_cast<int>(textureSize.x),
+                                static_cast<int>(textureSize.y));
+  const auto windowWidth = static_cast<float>(m_window.getSize().x);
+  const auto windowHeight = static_cast<float>(m_window.getSize().y);
 
-    float baseScale = static_cast<float>(m_window.getSize().y) /
-                      m_backgroundTexture.getSize().y;
-    baseScale *= 1.2f;
+  for (size_t i = 0; i < speeds.size(); i++) {
+    float scale = windowHeight / textureSize.y * 1.2f;
+    sf::Color color(255, 255, 255, 255);
 
     switch (i) {
     case 0:
-      layer.setScale(baseScale * 0.95f, baseScale * 0.95f);
-      layer.setColor(sf::Color(100, 100, 180, 150));
+      scale *= 0.95f;
+      color = sf::Color(100, 100, 180, 150);
       break;
     case 1:
-      layer.setScale(baseScale * 0.97f, baseScale * 0.97f);
-      layer.setColor(sf::Color(150, 150, 200, 180));
+      scale *= 0.97f;
+      color = sf::Color(150, 150, 200, 180);
       break;
     case 2:
-      layer.setScale(baseScale * 0.99f, baseScale * 0.99f);
-      layer.setColor(sf::Color(200, 200, 230, 210));
+      scale *= 0.99f;
+      color = sf::Color(200, 200, 230, 210);
       break;
     default:
-      layer.setScale(baseScale, baseScale);
-      layer.setColor(sf::Color(255, 255, 255, 255));
       break;
     }
 
-    m_parallaxLayers.push_back(layer);
-    m_parallaxSpeeds.push_back(speeds[i]);
+    ParallaxLayer &layer = m_parallaxLayers.emplace_back();
+    layer.speed = speeds[i];
+    layer.width = textureSize.x * scale;
+    const float height = textureSize.y * scale;
+    layer.top = (windowHeight - height) / 2.0f;
+
+    // Built once from one repetition left of the window; drawing only
+    // shifts the strip by the scroll offset.
+    const int repetitions =
+        static_cast<int>(std::ceil(windowWidth / layer.width)) + 2;
+    for (int j = -1; j < repetitions; j++) {
+      appendQuad(layer.vertices,
+                 sf::FloatRect(j * layer.width, 0.0f, layer.width, height),
+                 textureRect, color);
+    }
   }
 }
 
-void GameDisplay::updateParallaxBackgrounds(float deltaTime) {
+float GameDisplay::getVisibleMapWidth(const int mapWidth) {
+  constexpr float cameraZoom = 2.0f;
+  return std::min(mapWidth, MAX_VIEW_COLUMNS) / cameraZoom;
+}
+
+void GameDisplay::updateParallaxBackgrounds(float deltaTime,
+                                            const GameFrame &frame) {
   int localPlayerId = m_gameData.getLocalPlayerId();
-  std::vector<Shared::Protocol::Player> players = m_gameData.getPlayers();
+  const std::vector<Shared::Protocol::Player> &players = frame.players;
 
   float playerX = 0.0f;
 
@@ -136,19 +243,23 @@ void GameDisplay::updateParallaxBackgrounds(float deltaTime) {
 
   if (localPlayerIt != players.end()) {
     playerX = localPlayerIt->getPosition().x;
+  } else {
+    // Spectators follow whoever is ahead.
+    for (const Shared::Protocol::Player &player : players) {
+      playerX = std::max(playerX, player.getPosition().x);
+    }
   }
 
-  Shared::Protocol::GameMap map = m_gameData.getMap();
+  const int mapWidth = frame.map ? frame.map->getWidth() : 0;
 
-  if (map.width > 0) {
+  if (mapWidth > 0) {
     constexpr float cameraOffsetX = 0.3f;
-    constexpr float cameraZoom = 2.0f;
-    m_visibleMapWidth = map.width / cameraZoom;
+    m_visibleMapWidth = getVisibleMapWidth(mapWidth);
 
     float targetCameraX = playerX - (m_visibleMapWidth * cameraOffsetX);
 
     targetCameraX =
-        std::clamp(targetCameraX, 0.0f, map.width - m_visibleMapWidth);
+        std::clamp(targetCameraX, 0.0f, mapWidth - m_visibleMapWidth);
 
     const float cameraLerpFactor = 5.0f * deltaTime;
     m_cameraPositionX = m_cameraPositionX +
@@ -189,27 +300,49 @@ void GameDisplay::initializeAnimations() {
   for (int i = 0; i < numZapperFrames; i++) {
     constexpr int zapperFrameHeight = 122;
     constexpr int zapperFrameWidth = 47;
-    sf::IntRect frame(i * zapperFrameWidth, 0, zapperFrameWidth,
+    sf::IntRect frame(i * zapperFrameWidth, m_zapperAtlasTop, zapperFrameWidth,
                       zapperFrameHeight);
     m_zapperFrames.push_back(frame);
   }
 }
 
 void GameDisplay::run() {
+  while (m_window.isOpen() && !m_resources.isIdle()) {
+    processEvents();
+    drawLoadingScreen();
+  }
+  if (!m_window.isOpen()) {
+    return;
+  }
+  loadResources();
+  m_resources.saveArchive();
+
   m_animationClock.restart();
   sf::Clock deltaClock;
 
   while (m_window.isOpen()) {
     const float deltaTime = deltaClock.restart().asSeconds();
+    const GameFrame &frame = m_gameData.acquireFrame();
+
+    if (frame.map != m_renderedMap) {
+      const bool resized =
+          !frame.map || !m_renderedMap ||
+          frame.map->getWidth() != m_renderedMap->getWidth();
+      m_renderedMap = frame.map;
+      m_tileLayout.reset();
+      if (resized) {
+        initializeParallaxBackgrounds();
+      }
+    }
 
     processEvents();
-    updateAnimations();
-    updateParallaxBackgrounds(deltaTime);
-    render();
+    updateAnimations(frame);
+    updateParallaxBackgrounds(deltaTime, frame);
+    render(frame);
   }
 }
 
-void GameDisplay::updateAnimations() {
+void GameDisplay::updateAnimations(const GameFrame &frame) {
   const float elapsedTime = m_animationClock.getElapsedTime().asSeconds();
 
   m_playerAnimFrame =
@@ -221,12 +354,12 @@ void GameDisplay::updateAnimations() {
   m_zapperAnimFrame =
       static_cast<int>((elapsedTime * 12.0f)) % m_zapperFrames.size();
 
-  handleJetpackSounds();
+  handleJetpackSounds(frame);
 }
 
-void GameDisplay::handleJetpackSounds() {
+void GameDisplay::handleJetpackSounds(const GameFrame &frame) {
   int localPlayerId = m_gameData.getLocalPlayerId();
-  std::vector<Shared::Protocol::Player> players = m_gameData.getPlayers();
+  const std::vector<Shared::Protocol::Player> &players = frame.players;
 
   bool anyPlayerJetpacking = false;
 
@@ -258,25 +391,25 @@ void GameDisplay::processEvents() {
 
     case sf::Event::KeyPressed:
       if (event.key.code == sf::Keyboard::Space) {
-        m_jetpackActive = true;
+        setJetpackActive(true);
       }
       break;
 
     case sf::Event::KeyReleased:
       if (event.key.code == sf::Keyboard::Space) {
-        m_jetpackActive = false;
+        setJetpackActive(false);
       }
       break;
 
     case sf::Event::MouseButtonPressed:
       if (event.mouseButton.button == sf::Mouse::Left) {
-        m_jetpackActive = true;
+        setJetpackActive(true);
       }
       break;
 
     case sf::Event::MouseButtonReleased:
       if (event.mouseButton.button == sf::Mouse::Left) {
-        m_jetpackActive = false;
+        setJetpackActive(false);
       }
       break;
 
@@ -286,16 +419,16 @@ void GameDisplay::processEvents() {
   }
 }
 
-void GameDisplay::render() {
+void GameDisplay::render(const GameFrame &frame) {
   m_window.clear(sf::Color(10, 10, 30));
 
-  if (m_gameData.isGameOver()) {
-    drawGameOver();
+  if (frame.gameOver) {
+    drawGameOver(frame);
   } else {
     drawParallaxBackgrounds();
-    drawMap();
-    drawPlayers();
-    drawUI();
+    drawMap(frame);
+    drawPlayers(frame);
+    drawUI(frame);
   }
 
   m_window.display();
@@ -307,28 +440,13 @@ void GameDisplay::drawParallaxBackgrounds() {
   darkBackground.setFillColor(sf::Color(20, 20, 50));
   m_window.draw(darkBackground);
 
-  for (size_t i = 0; i < m_parallaxLayers.size(); i++) {
-    float parallaxOffset = m_cameraPositionX * m_parallaxSpeeds[i];
-
-    float spriteWidth =
-        m_backgroundTexture.getSize().x * m_parallaxLayers[i].getScale().x;
-    int repetitions =
-        static_cast<int>(std::ceil(m_window.getSize().x / spriteWidth)) + 2;
+  for (const ParallaxLayer &layer : m_parallaxLayers) {
+    float parallaxOffset = m_cameraPositionX * layer.speed;
+    float startX = -std::fmod(parallaxOffset, layer.width);
 
-    float startX = -std::fmod(parallaxOffset, spriteWidth);
-    float verticalPosition =
-        (m_window.getSize().y -
-         m_backgroundTexture.getSize().y * m_parallaxLayers[i].getScale().y) /
-        2.0f;
-
-    for (int j = -1; j < repetitions; j++) {
-      float posX = startX + j * spriteWidth;
-      m_parallaxLayers[i].setPosition(posX, verticalPosition);
-
-      if (posX < m_window.getSize().x && posX + spriteWidth > 0) {
-        m_window.draw(m_parallaxLayers[i]);
-      }
-    }
+    sf::RenderStates states(&m_backgroundTexture);
+    states.transform.translate(startX, layer.top);
+    m_window.draw(layer.vertices, states);
   }
 
   sf::RectangleShape gradientOverlay(
@@ -367,97 +485,92 @@ void GameDisplay::drawBackground() {
   }
 }
 
-void GameDisplay::drawPlayers() {
-  Shared::Protocol::GameMap map = m_gameData.getMap();
-  std::vector<Shared::Protocol::Player> players = m_gameData.getPlayers();
+void GameDisplay::drawPlayers(const GameFrame &frame) {
   int localPlayerId = m_gameData.getLocalPlayerId();
 
-  if (map.width == 0 || map.height == 0) {
+  if (!frame.map || frame.map->getWidth() == 0 ||
+      frame.map->getHeight() == 0) {
     return;
   }
+  const MapState &map = *frame.map;
+  const GameFrame::Clock::time_point now = GameFrame::Clock::now();
 
-  constexpr float cameraZoom = 2.0f;
-  float visibleMapWidth = map.width / cameraZoom;
+  float visibleMapWidth = getVisibleMapWidth(map.getWidth());
   float cellWidth = static_cast<float>(m_window.getSize().x) / visibleMapWidth;
   float windowHeight = static_cast<float>(m_window.getSize().y);
   float topOffset = m_topBoundary * (windowHeight / m_backgroundHeight);
   float bottomOffset = m_bottomBoundary * (windowHeight / m_backgroundHeight);
   float playableHeight = windowHeight - topOffset - bottomOffset;
 
-  float cellHeight = playableHeight / map.height;
+  float cellHeight = playableHeight / map.getHeight();
 
-  for (const auto &player : players) {
-    float screenX = (player.getPosition().x - m_cameraPositionX) * cellWidth;
+  m_playerVertices.clear();
+  for (const auto &player : frame.players) {
+    const Shared::Protocol::Position position =
+        frame.getRenderPosition(player, localPlayerId, now);
+    float screenX = (position.x - m_cameraPositionX) * cellWidth;
 
     if (screenX < -cellWidth || screenX > m_window.getSize().x + cellWidth) {
       continue;
     }
 
-    sf::Sprite playerSprite(m_playerSpritesheet);
-    if (player.isJetpacking()) {
-      playerSprite.setTextureRect(m_playerJetpackFrames[m_jetpackAnimFrame]);
-    } else {
-      playerSprite.setTextureRect(m_playerRunFrames[m_playerAnimFrame]);
-    }
-
-    float scale = 0.4f;
-    playerSprite.setScale(scale, scale);
+    const sf::IntRect &textureRect =
+        player.isJetpacking() ? m_playerJetpackFrames[m_jetpackAnimFrame]
+                              : m_playerRunFrames[m_playerAnimFrame];
 
-    float spriteWidth = playerSprite.getTextureRect().width * scale;
-    float spriteHeight = playerSprite.getTextureRect().height * scale;
+    float spriteWidth = textureRect.width * PLAYER_SCALE;
+    float spriteHeight = textureRect.height * PLAYER_SCALE;
     float xPos = screenX + (cellWidth - spriteWidth) / 2;
 
     float yOffset = 10.0f;
-    float relativePos = player.getPosition().y / map.height;
+    float relativePos = position.y / map.getHeight();
     float yPos = topOffset + (relativePos * playableHeight) +
                  (cellHeight - spriteHeight) / 2 - yOffset;
 
     yPos =
         std::clamp(yPos, topOffset, windowHeight - bottomOffset - spriteHeight);
 
-    playerSprite.setPosition(xPos, yPos);
-
-    if (player.getId() == localPlayerId) {
-      playerSprite.setColor(sf::Color(200, 255, 200));
-    } else {
-      playerSprite.setColor(sf::Color(255, 200, 200));
-    }
+    const sf::Color color = player.getId() == localPlayerId
+                                ? sf::Color(200, 255, 200)
+                                : sf::Color(255, 200, 200);
+    appendQuad(m_playerVertices,
+               sf::FloatRect(xPos, yPos, spriteWidth, spriteHeight),
+               textureRect, color);
 
     if (m_debugMode) {
       sf::RectangleShape hitbox;
       hitbox.setSize(sf::Vector2f(cellWidth * 0.8f, cellHeight * 0.8f));
       hitbox.setPosition(
           screenX + cellWidth * 0.1f,
-          topOffset + (player.getPosition().y / map.height) * playableHeight +
+          topOffset + (position.y / map.getHeight()) * playableHeight +
               cellHeight * 0.1f);
       hitbox.setFillColor(sf::Color(0, 0, 0, 0));
       hitbox.setOutlineColor(sf::Color::Red);
       hitbox.setOutlineThickness(1.0f);
       m_window.draw(hitbox);
     }
-
-    m_window.draw(playerSprite);
   }
+
+  m_window.draw(m_playerVertices, sf::RenderStates(&m_playerSpritesheet));
 }
 
-void GameDisplay::drawMap() {
-  Shared::Protocol::GameMap map = m_gameData.getMap();
-  std::vector<std::vector<int>> coinStates = m_gameData.getCoinStates();
+void GameDisplay::drawMap(const GameFrame &frame) {
   int localPlayerId = m_gameData.getLocalPlayerId();
 
-  if (map.width == 0 || map.height == 0) {
+  if (!frame.map || frame.map->getWidth() == 0 ||
+      frame.map->getHeight() == 0) {
     return;
   }
+  const MapState &map = *frame.map;
 
-  constexpr float cameraZoom = 2.0f;
-  float visibleMapWidth = map.width / cameraZoom;
+  float visibleMapWidth = getVisibleMapWidth(map.getWidth());
   float cellWidth = static_cast<float>(m_window.getSize().x) / visibleMapWidth;
   float windowHeight = static_cast<float>(m_window.getSize().y);
   float topOffset = m_topBoundary * (windowHeight / m_backgroundHeight);
   float bottomOffset = m_bottomBoundary * (windowHeight / m_backgroundHeight);
   float playableHeight = windowHeight - topOffset - bottomOffset;
 
-  float cellHeight = playableHeight / map.height;
+  float cellHeight = playableHeight / map.getHeight();
 
   if (m_debugMode) {
     sf::RectangleShape topBoundary;
@@ -476,69 +589,104 @@ void GameDisplay::drawMap() {
   int startCol = static_cast<int>(m_cameraPositionX);
   startCol = std::max(0, startCol);
   int endCol = static_cast<int>(m_cameraPositionX + visibleMapWidth + 1);
-  endCol = std::min(endCol, map.width);
-
-  for (int i = 0; i < map.height; i++) {
-    for (int j = startCol; j < endCol; j++) {
-      float xPos = (j - m_cameraPositionX) * cellWidth;
-      float yPos = topOffset + i * cellHeight;
+  endCol = std::min(endCol, map.getWidth());
 
-      if (m_debugMode && map.tiles[i][j] != Shared::Protocol::TileType::EMPTY) {
+  if (m_debugMode) {
+    for (int i = 0; i < map.getHeight(); i++) {
+      for (int j = startCol; j < endCol; j++) {
+        if (map.getTileAt(j, i) == Shared::Protocol::TileType::EMPTY) {
+          continue;
+        }
         sf::RectangleShape cellHitbox;
         cellHitbox.setSize(sf::Vector2f(cellWidth * 0.8f, cellHeight * 0.8f));
-        cellHitbox.setPosition(xPos + cellWidth * 0.1f,
-                               yPos + cellHeight * 0.1f);
+        cellHitbox.setPosition(
+            (j - m_cameraPositionX) * cellWidth + cellWidth * 0.1f,
+            topOffset + i * cellHeight + cellHeight * 0.1f);
         cellHitbox.setFillColor(sf::Color(0, 0, 0, 0));
         cellHitbox.setOutlineColor(sf::Color::Yellow);
         cellHitbox.setOutlineThickness(1.0f);
         m_window.draw(cellHitbox);
       }
+    }
+  }
+
+  const TileLayout layout{localPlayerId, cellWidth, cellHeight, topOffset};
+  if (m_tileLayout != layout) {
+    // Enough slots for every chunk the widest view can touch.
+    m_tileChunks.assign(MAX_VIEW_COLUMNS / TILE_CHUNK_COLUMNS + 2, {});
+    m_tileLayout = layout;
+  }
+
+  // Chunks are laid out from column 0; the camera only shifts them.
+  sf::RenderStates states(&m_tileAtlas);
+  states.transform.translate(-m_cameraPositionX * cellWidth, 0.0f);
+
+  for (int index = startCol / TILE_CHUNK_COLUMNS;
+       index * TILE_CHUNK_COLUMNS < endCol; index++) {
+    TileChunk &chunk = m_tileChunks[index % m_tileChunks.size()];
+    if (chunk.index != index ||
+        chunk.coinRevision !=
+            m_gameData.getCoinRevision(index * TILE_CHUNK_COLUMNS)) {
+      buildTileChunk(map, chunk, index, layout);
+    }
 
-      switch (map.tiles[i][j]) {
+    m_window.draw(chunk.coinFrames[m_coinAnimFrame], states);
+    m_window.draw(chunk.zapperFrames[m_zapperAnimFrame], states);
+  }
+}
+
+void GameDisplay::buildTileChunk(const MapState &map, TileChunk &chunk,
+                                 const int index, const TileLayout &layout) {
+  // Read before the coin states, so a change made meanwhile is seen as
+  // stale next frame rather than missed.
+  chunk.coinRevision = m_gameData.getCoinRevision(index * TILE_CHUNK_COLUMNS);
+  chunk.index = index;
+  chunk.coinFrames.assign(m_coinFrames.size(), sf::VertexArray(sf::Quads));
+  chunk.zapperFrames.assign(m_zapperFrames.size(), sf::VertexArray(sf::Quads));
+
+  const float coinWidth = m_coinFrames[0].width * COIN_SCALE;
+  const float coinHeight = m_coinFrames[0].height * COIN_SCALE;
+  const float zapperWidth = m_zapperFrames[0].width * ZAPPER_SCALE;
+  const float zapperHeight = m_zapperFrames[0].height * ZAPPER_SCALE;
+
+  const int firstColumn = index * TILE_CHUNK_COLUMNS;
+  const int endColumn =
+      std::min(firstColumn + TILE_CHUNK_COLUMNS, map.getWidth());
+
+  for (int i = 0; i < map.getHeight(); i++) {
+    for (int j = firstColumn; j < endColumn; j++) {
+      float xPos = j * layout.cellWidth;
+      float yPos = layout.topOffset + i * layout.cellHeight;
+
+      switch (map.getTileAt(j, i)) {
       case Shared::Protocol::TileType::COIN: {
-        sf::Sprite coinSprite(m_coinSpritesheet);
-        coinSprite.setTextureRect(m_coinFrames[m_coinAnimFrame]);
-
-        float scale = 0.2f;
-        coinSprite.setScale(scale, scale);
-
-        float spriteWidth = m_coinFrames[0].width * scale;
-        float spriteHeight = m_coinFrames[0].height * scale;
-
-        coinSprite.setPosition(xPos + (cellWidth - spriteWidth) / 2,
-                               yPos + (cellHeight - spriteHeight) / 2);
-
-        if (int coinState = coinStates[i][j];
-            localPlayerId == 1 &&
-            coinState ==
-                static_cast<int>(Shared::Protocol::CoinState::COLLECTED_P1)) {
-          coinSprite.setColor(sf::Color(255, 255, 255, 128));
-        } else if (localPlayerId == 2 &&
-                   coinState ==
-                       static_cast<int>(
-                           Shared::Protocol::CoinState::COLLECTED_P2)) {
-          coinSprite.setColor(sf::Color(255, 255, 255, 128));
-        } else {
-          coinSprite.setColor(sf::Color(255, 255, 255, 255));
+        const Shared::Protocol::CoinState coinState = map.getCoinStateAt(j, i);
+        const bool collected =
+            (layout.localPlayerId == 1 &&
+             coinState == Shared::Protocol::CoinState::COLLECTED_P1) ||
+            (layout.localPlayerId == 2 &&
+             coinState == Shared::Protocol::CoinState::COLLECTED_P2);
+        const sf::FloatRect bounds(xPos + (layout.cellWidth - coinWidth) / 2,
+                                   yPos + (layout.cellHeight - coinHeight) / 2,
+                                   coinWidth, coinHeight);
+        const sf::Color color(255, 255, 255, collected ? 128 : 255);
+
+        for (size_t f = 0; f < m_coinFrames.size(); f++) {
+          appendQuad(chunk.coinFrames[f], bounds, m_coinFrames[f], color);
         }
-
-        m_window.draw(coinSprite);
         break;
       }
 
       case Shared::Protocol::TileType::ELECTRICSQUARE: {
-        sf::Sprite zapperSprite(m_zapperSpritesheet);
-        zapperSprite.setTextureRect(m_zapperFrames[m_zapperAnimFrame]);
-
-        float scale = 0.6f;
-        zapperSprite.setScale(scale, scale);
-
-        float spriteWidth = m_zapperFrames[0].width * scale;
-        float spriteHeight = m_zapperFrames[0].height * scale;
-
-        zapperSprite.setPosition(xPos + (cellWidth - spriteWidth) / 2,
-                                 yPos + (cellHeight - spriteHeight) / 2);
-        m_window.draw(zapperSprite);
+        const sf::FloatRect bounds(
+            xPos + (layout.cellWidth - zapperWidth) / 2,
+            yPos + (layout.cellHeight - zapperHeight) / 2, zapperWidth,
+            zapperHeight);
+
+        for (size_t f = 0; f < m_zapperFrames.size(); f++) {
+          appendQuad(chunk.zapperFrames[f], bounds, m_zapperFrames[f],
+                     sf::Color(255, 255, 255, 255));
+        }
         break;
       }
 
@@ -549,100 +697,36 @@ void GameDisplay::drawMap() {
   }
 }
 
-void GameDisplay::drawUI() {
-  std::vector<Shared::Protocol::Player> players = m_gameData.getPlayers();
-  int localPlayerId = m_gameData.getLocalPlayerId();
-
-  if (players.empty()) {
-    sf::Text waitingText;
-    waitingText.setFont(m_gameFont);
-    waitingText.setCharacterSize(30);
-    waitingText.setString("Waiting for other players...");
-    waitingText.setFillColor(sf::Color::White);
-
-    sf::FloatRect textRect = waitingText.getLocalBounds();
-    waitingText.setOrigin(textRect.width / 2.0f, textRect.height / 2.0f);
-    waitingText.setPosition(m_window.getSize().x / 2.0f,
-                            m_window.getSize().y / 2.0f);
-
-    m_window.draw(waitingText);
+void GameDisplay::drawUI(const GameFrame &frame) {
+  if (frame.players.empty()) {
+    m_hud.drawWaiting(m_window);
     return;
   }
 
-  int yOffset = 10;
-  for (const auto &player : players) {
-    sf::Text scoreText;
-    scoreText.setFont(m_gameFont);
-    scoreText.setCharacterSize(20);
-    scoreText.setOutlineThickness(2.0f);
-    scoreText.setOutlineColor(sf::Color::Black);
-
-    if (player.getId() == localPlayerId) {
-      scoreText.setString(std::format("You: {}", player.getScore()));
-      scoreText.setFillColor(sf::Color::Green);
-    } else {
-      scoreText.setString(
-          std::format("Player {}: {}", player.getId(), player.getScore()));
-      scoreText.setFillColor(sf::Color::Red);
-    }
-
-    scoreText.setPosition(10, yOffset);
-    m_window.draw(scoreText);
-    yOffset += 30;
-  }
+  m_hud.drawScores(m_window, frame.players, m_gameData.getLocalPlayerId());
 }
 
-void GameDisplay::drawGameOver() {
-  int winnerId = m_gameData.getWinnerId();
-  int localPlayerId = m_gameData.getLocalPlayerId();
-
+void GameDisplay::drawGameOver(const GameFrame &frame) {
   sf::RectangleShape overlay(
       sf::Vector2f(m_window.getSize().x, m_window.getSize().y));
   overlay.setFillColor(sf::Color(0, 0, 0, 200));
   m_window.draw(overlay);
 
-  sf::Text gameOverText;
-  gameOverText.setFont(m_gameFont);
-  gameOverText.setCharacterSize(60);
-  gameOverText.setString("GAME OVER");
-  gameOverText.setFillColor(sf::Color::White);
-  gameOverText.setOutlineThickness(3.0f);
-  gameOverText.setOutlineColor(sf::Color::Black);
-
-  sf::FloatRect textRect = gameOverText.getLocalBounds();
-  gameOverText.setOrigin(textRect.width / 2.0f, textRect.height / 2.0f);
-  gameOverText.setPosition(m_window.getSize().x / 2.0f,
-                           m_window.getSize().y / 2.0f - 50);
-
-  m_window.draw(gameOverText);
-
-  sf::Text resultText;
-  resultText.setFont(m_gameFont);
-  resultText.setCharacterSize(40);
-  resultText.setOutlineThickness(2.0f);
-  resultText.setOutlineColor(sf::Color::Black);
-
-  if (winnerId == localPlayerId) {
-    resultText.setString("You win!");
-    resultText.setFillColor(sf::Color::Green);
-  } else if (winnerId > 0) {
-    resultText.setString(std::format("Player {} Wins!", winnerId));
-    resultText.setFillColor(sf::Color::Red);
-  } else {
-    resultText.setString("No winner");
-    resultText.setFillColor(sf::Color::Yellow);
-  }
-
-  textRect = resultText.getLocalBounds();
-  resultText.setOrigin(textRect.width / 2.0f, textRect.height / 2.0f);
-  resultText.setPosition(m_window.getSize().x / 2.0f,
-                         m_window.getSize().y / 2.0f + 50);
-  m_window.draw(resultText);
+  m_hud.drawGameOver(m_window, frame.winnerId, m_gameData.getLocalPlayerId());
 }
 
 void GameDisplay::updateMap(const Shared::Protocol::GameMap &map) {
   m_gameData.updateMap(map);
-  initializeParallaxBackgrounds();
+}
+
+void GameDisplay::startMapStream(const int width, const int height,
+                                 const int chunkColumns) {
+  m_gameData.startMapStream(width, height, chunkColumns);
+}
+
+void GameDisplay::addMapChunk(const int firstColumn,
+                              Shared::Protocol::GameMap columns) {
+  m_gameData.addMapChunk(firstColumn, std::move(columns));
 }
 
 void GameDisplay::updateGameState(
@@ -657,23 +741,17 @@ void GameDisplay::updateGameState(
   m_gameData.updatePlayers(players);
 }
 
+void GameDisplay::updateLocalPlayer(const Shared::Protocol::Player &player) {
+  m_gameData.updateLocalPlayer(player);
+}
+
 void GameDisplay::handleCoinCollected(int playerId, int x, int y,
                                       int coinState) {
   m_gameData.updateCoinStates(x, y, coinState);
-  std::vector<Shared::Protocol::Player> players = m_gameData.getPlayers();
   int localPlayerId = m_gameData.getLocalPlayerId();
 
-  const auto playerIt =
-      std::ranges::find_if(players, [playerId](const auto &player) {
-        return player.getId() == playerId;
-      });
-
-  if (playerIt != players.end()) {
-    playerIt->setScore(playerIt->getScore() + 1);
-
-    if (playerId == localPlayerId) {
-      m_soundManager.playCoinPickup();
-    }
+  if (playerId == localPlayerId) {
+    m_soundManager.playCoinPickup();
   }
 }
 
@@ -693,6 +771,12 @@ void GameDisplay::handleGameOver(int winnerId) {
 
 bool GameDisplay::isJetpackActive() const { return m_jetpackActive; }
 
+void GameDisplay::setJetpackActive(const bool active) {
+  if (m_jetpackActive.exchange(active) != active && m_inputListener) {
+    m_inputListener();
+  }
+}
+
 void GameDisplay::setLocalPlayerId(int id) { m_gameData.setLocalPlayerId(id); }
 
 void GameDisplay::setDebugMode(bool debug) { m_debugMode = debug; }
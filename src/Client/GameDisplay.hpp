@@ -7,9 +7,19 @@
 
 #include "../Shared/Protocol.hpp"
 #include "GameData.hpp"
+#include "GameView.hpp"
+#include "Hud.hpp"
+#include "ResourceManager.hpp"
 #include "SoundManager.hpp"
 #include <SFML/Audio.hpp>
 #include <SFML/Graphics.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace Jetpack::Client {
@@ -22,15 +32,16 @@ namespace Jetpack::Client {
  * the map, players, and UI elements. It also processes user input for jetpack control
  * and manages sound effects and animations.
  */
-class GameDisplay {
+class GameDisplay : public GameView {
 public:
   /**
    * @brief Constructs a new GameDisplay.
    * @param windowWidth Width of the game window in pixels.
    * @param windowHeight Height of the game window in pixels.
    * 
-   * Creates the game window, initializes graphics resources, and sets up the rendering
-   * boundaries for the playable area.
+   * Creates the game window, starts loading graphics and audio resources in
+   * the background, and sets up the rendering boundaries for the playable
+   * area.
    */
   explicit GameDisplay(int windowWidth = 1920, int windowHeight = 1080);
   
@@ -39,7 +50,7 @@ public:
    * 
    * Closes the window and stops music playback.
    */
-  ~GameDisplay();
+  ~GameDisplay() override;
 
   /**
    * @brief Deleted copy constructor.
@@ -64,7 +75,8 @@ public:
   /**
    * @brief Enters the main rendering loop.
    * 
-   * Processes events, updates animations and camera position, and renders the scene
+   * Shows a loading screen until the resources are decoded, then processes
+   * events, updates animations and camera position, and renders the scene
    * until the window is closed.
    */
   void run();
@@ -73,13 +85,35 @@ public:
    * @brief Updates the game map with data received from the server.
    * @param map New map data to render.
    */
-  void updateMap(const Shared::Protocol::GameMap &map);
+  void updateMap(const Shared::Protocol::GameMap &map) override;
+
+  /**
+   * @brief Starts a map the server streams in chunks.
+   * @param width        Map width in tiles.
+   * @param height       Map height in tiles.
+   * @param chunkColumns Columns per chunk.
+   */
+  void startMapStream(int width, int height, int chunkColumns) override;
+
+  /**
+   * @brief Adds a chunk of a streamed map.
+   * @param firstColumn Map column of the chunk's first column.
+   * @param columns     The chunk's columns, as a map as wide as the chunk.
+   */
+  void addMapChunk(int firstColumn, Shared::Protocol::GameMap columns) override;
   
   /**
    * @brief Updates player states with data received from the server.
    * @param players List of updated player information.
    */
-  void updateGameState(const std::vector<Shared::Protocol::Player> &players);
+  void updateGameState(
+      const std::vector<Shared::Protocol::Player> &players) override;
+
+  /**
+   * @brief Updates the local player with the client's own prediction.
+   * @param player Predicted local player.
+   */
+  void updateLocalPlayer(const Shared::Protocol::Player &player) override;
   
   /**
    * @brief Handles a coin collection event.
@@ -88,19 +122,19 @@ public:
    * @param y Y-coordinate of the collected coin.
    * @param coinState New state of the coin after collection.
    */
-  void handleCoinCollected(int playerId, int x, int y, int coinState);
+  void handleCoinCollected(int playerId, int x, int y, int coinState) override;
   
   /**
    * @brief Handles a player death event.
    * @param playerId ID of the player who died.
    */
-  void handlePlayerDeath(int playerId);
+  void handlePlayerDeath(int playerId) override;
   
   /**
    * @brief Handles the game over event.
    * @param winnerId ID of the winning player, or -1 if no winner.
    */
-  void handleGameOver(int winnerId);
+  void handleGameOver(int winnerId) override;
 
   /**
    * @brief Sets the ID of the local player.
@@ -118,17 +152,31 @@ public:
    * @brief Checks if the jetpack control is currently active.
    * @return True if the jetpack button is currently pressed.
    */
-  [[nodiscard]] bool isJetpackActive() const;
+  [[nodiscard]] bool isJetpackActive() const override;
+
+  /**
+   * @brief Registers a function called from the render thread whenever
+   *        the jetpack control is pressed or released.
+   * @param listener Callback; must be cheap and thread-safe.
+   */
+  void setInputListener(std::function<void()> listener) {
+    m_inputListener = std::move(listener);
+  }
 
 private:
+  /** Declared first so that assets reading its bytes are destroyed first. */
+  ResourceManager m_resources;
   sf::RenderWindow m_window;
 
   sf::Texture m_backgroundTexture;
   sf::Texture m_playerSpritesheet;
-  sf::Texture m_coinSpritesheet;
-  sf::Texture m_zapperSpritesheet;
+  /** Coin sheet with the zapper sheet below it, so tiles share a texture. */
+  sf::Texture m_tileAtlas;
+  /** Row of the atlas the zapper sheet starts at. */
+  int m_zapperAtlasTop = 0;
 
   sf::Font m_gameFont;
+  Hud m_hud{m_gameFont};
 
   std::vector<sf::IntRect> m_playerRunFrames;
   std::vector<sf::IntRect> m_playerJetpackFrames;
@@ -146,8 +194,18 @@ private:
 
   SoundManager m_soundManager;
   GameData m_gameData;
+  /** Map the parallax layers were last sized for. */
+  std::shared_ptr<const MapState> m_renderedMap;
 
-  bool m_jetpackActive = false;
+  std::atomic<bool> m_jetpackActive{false};
+  std::function<void()> m_inputListener;
+
+  /**
+   * @brief Updates the jetpack control and notifies the input listener
+   *        if it changed.
+   * @param active New state of the control.
+   */
+  void setJetpackActive(bool active);
 
   float m_topBoundary = 0.0f;
   float m_bottomBoundary = 0.0f;
@@ -163,31 +221,119 @@ private:
   
   /**
    * @brief Updates animation frames based on elapsed time.
+   * @param frame Game state acquired for this frame.
    */
-  void updateAnimations();
+  void updateAnimations(const GameFrame &frame);
   
   /**
    * @brief Manages jetpack sound effects based on player state.
+   * @param frame Game state acquired for this frame.
+   */
+  void handleJetpackSounds(const GameFrame &frame);
+
+  /**
+   * @brief Queues every graphical and audio resource for loading.
    */
-  void handleJetpackSounds();
+  void requestResources();
 
   /**
-   * @brief Loads and initializes graphical and audio resources.
+   * @brief Renders a progress bar while resources load.
+   */
+  void drawLoadingScreen();
+
+  /**
+   * @brief Takes the loaded resources and initializes what depends on
+   *        them; a resource that failed is reported and left empty.
    */
   void loadResources();
+
+  /**
+   * @brief Uploads a loaded image into a texture.
+   * @param texture Texture to fill.
+   * @param name    Image requested from m_resources.
+   */
+  void loadTexture(sf::Texture &texture, const std::string &name);
   
+  /**
+   * @brief Builds the tile atlas from the coin and zapper sheets.
+   * @param coinSheet   Coin animation frames.
+   * @param zapperSheet Zapper animation frames.
+   */
+  void buildTileAtlas(const sf::Image &coinSheet, const sf::Image &zapperSheet);
+
   /**
    * @brief Sets up animation frame rectangles from sprite sheets.
    */
   void initializeAnimations();
 
-  std::vector<sf::Sprite> m_parallaxLayers;
-  std::vector<float> m_parallaxSpeeds;
+  /**
+   * @struct ParallaxLayer
+   * @brief One background layer, as a strip of repetitions wide enough to
+   *        cover the window from any scroll offset.
+   */
+  struct ParallaxLayer {
+    sf::VertexArray vertices{sf::Quads};
+    float speed = 0.0f;
+    /** Width of one repetition, in pixels. */
+    float width = 0.0f;
+    float top = 0.0f;
+  };
+
+  /**
+   * @struct TileLayout
+   * @brief Where tiles land on screen; every cached tile chunk is built for
+   *        one layout and dropped when it changes.
+   */
+  struct TileLayout {
+    int localPlayerId = 0;
+    float cellWidth = 0.0f;
+    float cellHeight = 0.0f;
+    float topOffset = 0.0f;
+
+    bool operator==(const TileLayout &) const = default;
+  };
+
+  /**
+   * @struct TileChunk
+   * @brief The coins and zappers of TILE_CHUNK_COLUMNS columns, in map
+   *        space, with one batch per animation frame so that animating
+   *        only picks another batch.
+   */
+  struct TileChunk {
+    /** Chunk held, as first column / TILE_CHUNK_COLUMNS; -1 if none. */
+    int index = -1;
+    /** GameData coin revision the coin batches were built at. */
+    uint32_t coinRevision = 0;
+    std::vector<sf::VertexArray> coinFrames;
+    std::vector<sf::VertexArray> zapperFrames;
+  };
+
+  /** Columns per cached tile chunk; matches GameData's coin revisions. */
+  static constexpr int TILE_CHUNK_COLUMNS = GameData::COIN_REVISION_COLUMNS;
+
+  /** Layout the tile chunks were built for; empty when they are stale. */
+  std::optional<TileLayout> m_tileLayout;
+  /** Ring of cached chunks around the camera, chunk i in slot i % size. */
+  std::vector<TileChunk> m_tileChunks;
+  /** Players of the current frame; drawn in one call. */
+  sf::VertexArray m_playerVertices{sf::Quads};
+
+  std::vector<ParallaxLayer> m_parallaxLayers;
   float m_backgroundScrollPosition = 0.0f;
   float m_cameraPositionX = 0.0f;
   float m_visibleMapWidth = 0.0f;
   float m_cameraZoom = 2.0f;
 
+  /** Widest stretch of map shown before zooming, however long the map. */
+  static constexpr int MAX_VIEW_COLUMNS = 128;
+
+  /**
+   * @brief Get how many columns fit across the window.
+   * @param mapWidth Map width in tiles.
+   * @return Visible width in tiles.
+   */
+  static float getVisibleMapWidth(int mapWidth);
+
   /**
    * @brief Initializes the parallax background layers.
    */
@@ -196,8 +342,9 @@ private:
   /**
    * @brief Updates the position of parallax backgrounds based on camera movement.
    * @param deltaTime Time elapsed since last frame in seconds.
+   * @param frame Game state acquired for this frame.
    */
-  void updateParallaxBackgrounds(float deltaTime);
+  void updateParallaxBackgrounds(float deltaTime, const GameFrame &frame);
   
   /**
    * @brief Renders the parallax background layers.
@@ -206,8 +353,9 @@ private:
 
   /**
    * @brief Main rendering function called each frame.
+   * @param frame Game state acquired for this frame.
    */
-  void render();
+  void render(const GameFrame &frame);
   
   /**
    * @brief Renders the static game background.
@@ -216,23 +364,37 @@ private:
   
   /**
    * @brief Renders the game map tiles (coins, zappers).
+   * @param frame Game state acquired for this frame.
+   */
+  void drawMap(const GameFrame &frame);
+
+  /**
+   * @brief Rebuilds the batches of a tile chunk.
+   * @param map    Map to read the tiles from.
+   * @param chunk  Cache entry to fill.
+   * @param index  Chunk to build.
+   * @param layout Layout to build for.
    */
-  void drawMap();
+  void buildTileChunk(const MapState &map, TileChunk &chunk, int index,
+                      const TileLayout &layout);
   
   /**
    * @brief Renders the player sprites.
+   * @param frame Game state acquired for this frame.
    */
-  void drawPlayers();
+  void drawPlayers(const GameFrame &frame);
   
   /**
    * @brief Renders the UI elements (scores, status).
+   * @param frame Game state acquired for this frame.
    */
-  void drawUI();
+  void drawUI(const GameFrame &frame);
   
   /**
    * @brief Renders the game over screen.
+   * @param frame Game state acquired for this frame.
    */
-  void drawGameOver();
+  void drawGameOver(const GameFrame &frame);
 };
 
 } // namespace Jetpack::Client
\ No newline at end of file
@@ -0,0 +1,87 @@
+/**
+ * @file GameView.hpp
+ * @brief Declaration of the GameView interface, the receiver of the game
+ *        events NetworkClient decodes.
+ */
+
+#pragma once
+
+#include "../Shared/Protocol.hpp"
+#include <vector>
+
+namespace Jetpack::Client {
+
+/**
+ * @class GameView
+ * @brief What NetworkClient needs from whatever presents the game.
+ *
+ * GameDisplay renders it with SFML; the load generator's bots only
+ * measure it. Every method is called from the thread that drives the
+ * client's socket.
+ */
+class GameView {
+public:
+  virtual ~GameView() = default;
+
+  /**
+   * @brief Receives a whole map.
+   * @param map Map data from the server.
+   */
+  virtual void updateMap(const Shared::Protocol::GameMap &map) = 0;
+
+  /**
+   * @brief Starts a map the server streams in chunks.
+   * @param width        Map width in tiles.
+   * @param height       Map height in tiles.
+   * @param chunkColumns Columns per chunk.
+   */
+  virtual void startMapStream(int width, int height, int chunkColumns) = 0;
+
+  /**
+   * @brief Receives a chunk of a streamed map.
+   * @param firstColumn Map column of the chunk's first column.
+   * @param columns     The chunk's columns, as a map as wide as the chunk.
+   */
+  virtual void addMapChunk(int firstColumn,
+                           Shared::Protocol::GameMap columns) = 0;
+
+  /**
+   * @brief Receives the players of a state update or game start.
+   * @param players Every known player.
+   */
+  virtual void
+  updateGameState(const std::vector<Shared::Protocol::Player> &players) = 0;
+
+  /**
+   * @brief Receives the client's own prediction of the local player.
+   * @param player Predicted local player.
+   */
+  virtual void updateLocalPlayer(const Shared::Protocol::Player &player) = 0;
+
+  /**
+   * @brief Handles a coin collection event.
+   * @param playerId  ID of the player who collected the coin.
+   * @param x         X-coordinate of the coin.
+   * @param y         Y-coordinate of the coin.
+   * @param coinState New state of the coin.
+   */
+  virtual void handleCoinCollected(int playerId, int x, int y,
+                                   int coinState) = 0;
+
+  /**
+   * @brief Handles a player death event.
+   * @param playerId ID of the player who died.
+   */
+  virtual void handlePlayerDeath(int playerId) = 0;
+
+  /**
+   * @brief Handles the game over event.
+   * @param winnerId ID of the winning player, or -1 if no winner.
+   */
+  virtual void handleGameOver(int winnerId) = 0;
+
+  /** @return True if the jetpack control is currently held. */
+  [[nodiscard]] virtual bool isJetpackActive() const = 0;
+};
+
+} // namespace Jetpack::Client
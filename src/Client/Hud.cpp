@@ -0,0 +1,112 @@
+/**
+ * @file Hud.cpp
+ * @brief Implements the Hud class.
+ */
+
+#include "Hud.hpp"
+#include <format>
+
+namespace Jetpack::Client {
+
+Hud::Hud(const sf::Font &font)
+    : m_font(font), m_waitingText(makeText(30, 0.0f)),
+      m_gameOverText(makeText(60, 3.0f)), m_resultText(makeText(40, 2.0f)) {
+  m_waitingText.setFillColor(sf::Color::White);
+  m_gameOverText.setFillColor(sf::Color::White);
+}
+
+sf::Text Hud::makeText(const unsigned characterSize,
+                       const float outlineThickness) const {
+  sf::Text text;
+  text.setFont(m_font);
+  text.setCharacterSize(characterSize);
+  if (outlineThickness > 0.0f) {
+    text.setOutlineThickness(outlineThickness);
+    text.setOutlineColor(sf::Color::Black);
+  }
+  return text;
+}
+
+void Hud::setCenteredString(sf::Text &text, const sf::String &string) {
+  text.setString(string);
+  sf::FloatRect textRect = text.getLocalBounds();
+  text.setOrigin(textRect.width / 2.0f, textRect.height / 2.0f);
+}
+
+void Hud::drawWaiting(sf::RenderTarget &target) {
+  if (!m_waitingLaidOut) {
+    setCenteredString(m_waitingText, "Waiting for other players...");
+    m_waitingLaidOut = true;
+  }
+
+  m_waitingText.setPosition(target.getSize().x / 2.0f,
+                            target.getSize().y / 2.0f);
+  target.draw(m_waitingText);
+}
+
+void Hud::drawScores(sf::RenderTarget &target,
+                     const std::vector<Shared::Protocol::Player> &players,
+                     const int localPlayerId) {
+  while (m_scoreLines.size() < players.size()) {
+    ScoreLine &line = m_scoreLines.emplace_back();
+    line.text = makeText(20, 2.0f);
+    line.text.setPosition(10, 10 + 30 * (m_scoreLines.size() - 1));
+  }
+  m_scoreLines.erase(
+      m_scoreLines.begin() + static_cast<std::ptrdiff_t>(players.size()),
+      m_scoreLines.end());
+
+  for (size_t i = 0; i < players.size(); i++) {
+    const Shared::Protocol::Player &player = players[i];
+    ScoreLine &line = m_scoreLines[i];
+    const bool local = player.getId() == localPlayerId;
+
+    if (line.playerId != player.getId() || line.score != player.getScore() ||
+        line.local != local) {
+      if (local) {
+        line.text.setString(std::format("You: {}", player.getScore()));
+        line.text.setFillColor(sf::Color::Green);
+      } else {
+        line.text.setString(
+            std::format("Player {}: {}", player.getId(), player.getScore()));
+        line.text.setFillColor(sf::Color::Red);
+      }
+      line.playerId = player.getId();
+      line.score = player.getScore();
+      line.local = local;
+    }
+
+    target.draw(line.text);
+  }
+}
+
+void Hud::drawGameOver(sf::RenderTarget &target, const int winnerId,
+                       const int localPlayerId) {
+  const std::pair result(winnerId, localPlayerId);
+  if (m_shownResult != result) {
+    setCenteredString(m_gameOverText, "GAME OVER");
+
+    if (winnerId == localPlayerId) {
+      setCenteredString(m_resultText, "You win!");
+      m_resultText.setFillColor(sf::Color::Green);
+    } else if (winnerId > 0) {
+      setCenteredString(m_resultText,
+                        std::format("Player {} Wins!", winnerId));
+      m_resultText.setFillColor(sf::Color::Red);
+    } else {
+      setCenteredString(m_resultText, "No winner");
+      m_resultText.setFillColor(sf::Color::Yellow);
+    }
+    m_shownResult = result;
+  }
+
+  m_gameOverText.setPosition(target.getSize().x / 2.0f,
+                             target.getSize().y / 2.0f - 50);
+  target.draw(m_gameOverText);
+
+  m_resultText.setPosition(target.getSize().x / 2.0f,
+                           target.getSize().y / 2.0f + 50);
+  target.draw(m_resultText);
+}
+
+} // namespace Jetpack::Client
@@ -0,0 +1,99 @@
+/**
+ * @file Hud.hpp
+ * @brief Score list, waiting message and game over screen text.
+ */
+
+#pragma once
+
+#include "../Shared/Protocol.hpp"
+#include <SFML/Graphics.hpp>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace Jetpack::Client {
+
+/**
+ * @class Hud
+ * @brief Draws the game's text from persistent sf::Text objects.
+ *
+ * Laying out text, outlined text above all, is the costly part of drawing
+ * it. Each text is therefore set up once and given a new string only when
+ * what it shows changes; frames in between just draw it again.
+ */
+class Hud {
+public:
+  /**
+   * @brief Constructs the HUD.
+   * @param font Font of every text; must outlive the HUD. It may still be
+   *             loading: texts are laid out on first draw.
+   */
+  explicit Hud(const sf::Font &font);
+
+  /**
+   * @brief Draws the message shown until players are known.
+   * @param target Where to draw.
+   */
+  void drawWaiting(sf::RenderTarget &target);
+
+  /**
+   * @brief Draws the score list, one line per player.
+   * @param target        Where to draw.
+   * @param players       Players of the current frame.
+   * @param localPlayerId ID of the local player.
+   */
+  void drawScores(sf::RenderTarget &target,
+                  const std::vector<Shared::Protocol::Player> &players,
+                  int localPlayerId);
+
+  /**
+   * @brief Draws the game over title and result.
+   * @param target        Where to draw.
+   * @param winnerId      ID of the winning player, or -1 if no winner.
+   * @param localPlayerId ID of the local player.
+   */
+  void drawGameOver(sf::RenderTarget &target, int winnerId, int localPlayerId);
+
+private:
+  /**
+   * @struct ScoreLine
+   * @brief A line of the score list and what it currently shows.
+   */
+  struct ScoreLine {
+    /** Shown player; -1 until the line is first set. */
+    int playerId = -1;
+    int score = 0;
+    bool local = false;
+    sf::Text text;
+  };
+
+  /**
+   * @brief Makes a text in the HUD's font.
+   * @param characterSize    Character size in pixels.
+   * @param outlineThickness Black outline thickness, 0 for none.
+   * @return The text, with an empty string.
+   */
+  [[nodiscard]] sf::Text makeText(unsigned characterSize,
+                                  float outlineThickness) const;
+
+  /**
+   * @brief Sets a text's string and centers its origin on it.
+   * @param text   Text to update.
+   * @param string New string.
+   */
+  static void setCenteredString(sf::Text &text, const sf::String &string);
+
+  const sf::Font &m_font;
+
+  sf::Text m_waitingText;
+  bool m_waitingLaidOut = false;
+
+  std::vector<ScoreLine> m_scoreLines;
+
+  sf::Text m_gameOverText;
+  sf::Text m_resultText;
+  /** Winner and local player the result text shows, once laid out. */
+  std::optional<std::pair<int, int>> m_shownResult;
+};
+
+} // namespace Jetpack::Client
@@ -5,16 +5,24 @@
 
 #include "NetworkClient.hpp"
 #include "../Shared/Exceptions.hpp"
+#include "../Shared/PacketWriter.hpp"
+#include "../Shared/Physics.hpp"
+#include <algorithm>
 #include <arpa/inet.h>
+#include <array>
 #include <chrono>
+#include <cmath>
 #include <cstring>
 #include <fcntl.h>
 #include <format>
 #include <iostream>
 #include <netinet/in.h>
+#include <poll.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <thread>
 #include <unistd.h>
+#include <utility>
 
 namespace Jetpack::Client {
 
@@ -33,6 +41,10 @@ NetworkClient::~NetworkClient() {
   if (m_serverSocket != -1) {
     ::close(m_serverSocket);
   }
+  if (m_wakeFd != -1) {
+    ::close(m_wakeFd);
+  }
+  closeDatagramPath();
 }
 
 bool NetworkClient::connectToServer() {
@@ -66,14 +78,26 @@ bool NetworkClient::connectToServer() {
   const int flags = fcntl(m_serverSocket, F_GETFL, 0);
   fcntl(m_serverSocket, F_SETFL, flags | O_NONBLOCK);
 
-  Shared::Protocol::NetworkPacket packet(
-      Shared::Protocol::PacketType::CONNECT_REQUEST);
-  packet.addByte(static_cast<uint8_t>(0));
-
-  std::vector<std::byte> buffer = packet.serialize();
+  std::array<std::byte, 2> buffer{};
+  Shared::Protocol::PacketWriter packet(
+      buffer, Shared::Protocol::PacketType::CONNECT_REQUEST, 1);
+  uint8_t capabilities = Shared::Protocol::CAPABILITY_DELTA_STATE |
+                         Shared::Protocol::CAPABILITY_PACKED_STATE |
+                         Shared::Protocol::CAPABILITY_MAP_STREAMING;
+  if (m_spectating) {
+    capabilities |= Shared::Protocol::CAPABILITY_SPECTATE;
+  } else {
+    capabilities |= Shared::Protocol::CAPABILITY_INPUT_SEQUENCE;
+    if (m_datagramsWanted) {
+      capabilities |= Shared::Protocol::CAPABILITY_DATAGRAM;
+    }
+  }
+  packet.addByte(capabilities);
 
-  if (::send(m_serverSocket, buffer.data(), buffer.size(), 0) !=
-      static_cast<ssize_t>(buffer.size())) {
+  tracePacket(Shared::TraceDirection::SENT,
+              std::span(buffer).first(packet.size()));
+  if (::send(m_serverSocket, buffer.data(), packet.size(), 0) !=
+      static_cast<ssize_t>(packet.size())) {
     std::cerr << "Failed to send connection request" << std::endl;
     socketGuard();
     return false;
@@ -82,150 +106,219 @@ bool NetworkClient::connectToServer() {
   return true;
 }
 
-void NetworkClient::start() {
-  m_display = std::make_shared<GameDisplay>();
-  m_networkThread = std::thread(&NetworkClient::networkLoop, this);
-
-  using namespace std::chrono_literals;
-
-  while (m_localPlayerId == -1 && m_running) {
-    std::this_thread::sleep_for(50ms);
-  }
-
-  if (m_debugMode) {
-    m_display->setDebugMode(true);
-  }
-
-  if (m_localPlayerId != -1) {
-    m_display->setLocalPlayerId(m_localPlayerId);
-  }
-
-  m_display->run();
-  m_running = false;
-
-  if (m_networkThread.joinable()) {
-    m_networkThread.join();
-  }
-}
-
 void NetworkClient::networkLoop() {
-  constexpr size_t BUFFER_SIZE = 1024;
-  std::array<std::byte, BUFFER_SIZE> recvBuffer{};
-  std::vector<std::byte> accumulatedBuffer;
-  accumulatedBuffer.reserve(BUFFER_SIZE * 2);
+  constexpr auto inputUpdateInterval =
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(1.0 / Shared::Physics::TICK_RATE));
 
-  using namespace std::chrono_literals;
-  constexpr auto inputUpdateInterval = 16ms;
+  auto nextInputUpdate = std::chrono::steady_clock::now();
 
-  auto lastInputUpdate = std::chrono::steady_clock::now();
+  std::array<pollfd, 3> pollFds{};
+  pollFds[0] = {m_serverSocket, POLLIN, 0};
+  pollFds[1] = {m_wakeFd, POLLIN, 0};
+  pollFds[2] = {-1, POLLIN, 0};
 
   while (m_running) {
     auto currentTime = std::chrono::steady_clock::now();
-    if (currentTime - lastInputUpdate >= inputUpdateInterval) {
+    if (currentTime >= nextInputUpdate) {
       sendPlayerInput();
-      lastInputUpdate = currentTime;
+      nextInputUpdate += inputUpdateInterval;
+      if (nextInputUpdate < currentTime) {
+        nextInputUpdate = currentTime + inputUpdateInterval;
+      }
     }
 
-    ssize_t bytesRead =
-        recv(m_serverSocket, recvBuffer.data(), recvBuffer.size(), 0);
-    if (bytesRead > 0) {
-      if (m_debugMode) {
-        std::cout << std::format("Debug: Received {} from server: ", bytesRead);
-
-        for (ssize_t i = 0; i < bytesRead; i++) {
-          std::cout << std::format("{:02X} ",
-                                   static_cast<unsigned char>(recvBuffer[i]));
-        }
+    const auto timeout = std::chrono::ceil<std::chrono::milliseconds>(
+        nextInputUpdate - std::chrono::steady_clock::now());
+    pollFds[2].fd = m_datagramSocket;
+    const int ready =
+        ::poll(pollFds.data(), pollFds.size(),
+               static_cast<int>(std::max<int64_t>(0, timeout.count())));
+    if (ready < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      std::cerr << "Error waiting for server: " << strerror(errno)
+                << std::endl;
+      break;
+    }
 
-        std::cout << std::endl;
+    if (pollFds[1].revents & POLLIN) {
+      uint64_t wakeups = 0;
+      if (::read(m_wakeFd, &wakeups, sizeof(wakeups)) < 0 &&
+          errno != EAGAIN) {
+        std::cerr << "Error reading wakeup: " << strerror(errno)
+                  << std::endl;
       }
+      // A jetpack change goes out at once as the next tick's input, and
+      // that tick's timer send is skipped: every sequence stays one
+      // simulation step. A second change within the tick waits.
+      if (m_display && m_display->isJetpackActive() != m_lastSentJetpack &&
+          nextInputUpdate - std::chrono::steady_clock::now() <=
+              inputUpdateInterval) {
+        sendPlayerInput();
+        nextInputUpdate += inputUpdateInterval;
+      }
+    }
 
-      accumulatedBuffer.insert(accumulatedBuffer.end(), recvBuffer.begin(),
-                               recvBuffer.begin() + bytesRead);
+    if (pollFds[2].revents & POLLIN) {
+      receiveDatagrams();
+    }
 
-      size_t processedBytes = 0;
-      while (processedBytes < accumulatedBuffer.size()) {
-        size_t packetSize =
-            getPacketSize(accumulatedBuffer.data() + processedBytes,
-                          accumulatedBuffer.size() - processedBytes);
+    if ((pollFds[0].revents & (POLLIN | POLLHUP | POLLERR)) == 0) {
+      continue;
+    }
 
-        if (packetSize == 0) {
-          break;
-        }
+    if (!receiveFromServer()) {
+      break;
+    }
+  }
+}
 
-        processPacket(accumulatedBuffer.data() + processedBytes, packetSize);
-        processedBytes += packetSize;
+bool NetworkClient::receiveFromServer() {
+  while (true) {
+    if (m_receiveBuffer.freeSpace() == 0) {
+      // Draining left one incomplete packet filling the whole ring.
+      if (m_receiveBuffer.capacity() >= MAX_RECEIVE_BUFFER_SIZE) {
+        std::cerr << "Error: packet from server exceeds the receive buffer"
+                  << std::endl;
+        return false;
       }
+      m_receiveBuffer.grow(m_receiveBuffer.capacity() * 2);
+    }
 
-      if (processedBytes > 0) {
-        accumulatedBuffer.erase(accumulatedBuffer.begin(),
-                                accumulatedBuffer.begin() + processedBytes);
+    auto [first, second] = m_receiveBuffer.writableRegions();
+    iovec regions[2] = {{first.data(), first.size()},
+                        {second.data(), second.size()}};
+    const ssize_t bytesRead =
+        readv(m_serverSocket, regions, second.empty() ? 1 : 2);
+
+    if (bytesRead < 0) {
+      if (errno == EINTR) {
+        continue;
       }
-    } else if (bytesRead < 0) {
-      if (errno != EAGAIN && errno != EWOULDBLOCK) {
-        std::cerr << "Error reading from server: " << strerror(errno)
-                  << std::endl;
-        break;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return true;
       }
+      std::cerr << "Error reading from server: " << strerror(errno)
+                << std::endl;
+      return false;
+    }
+    if (bytesRead == 0) {
+      std::cerr << "Server closed the connection" << std::endl;
+      return false;
     }
-  }
-}
 
-size_t NetworkClient::getPacketSize(const std::byte *data,
-                                    size_t maxSize) const {
-  if (maxSize < 1) {
-    return 0;
+    m_receiveBuffer.commit(static_cast<size_t>(bytesRead));
+    m_bytesReceived += static_cast<uint64_t>(bytesRead);
+
+    if (!drainReceiveBuffer()) {
+      return false;
+    }
   }
+}
 
-  auto packetType = static_cast<Shared::Protocol::PacketType>(data[0]);
+bool NetworkClient::drainReceiveBuffer() {
+  while (!m_receiveBuffer.empty()) {
+    std::span<const std::byte> packet = m_receiveBuffer.frontRegion();
+    size_t packetSize =
+        Shared::Protocol::getPacketSize(packet.data(), packet.size());
 
-  switch (packetType) {
-  case Shared::Protocol::PacketType::CONNECT_RESPONSE:
-    return (maxSize >= 3) ? 3 : 0;
+    if (packetSize == 0 && m_receiveBuffer.size() > packet.size()) {
+      packet = m_receiveBuffer.linearize();
+      packetSize =
+          Shared::Protocol::getPacketSize(packet.data(), packet.size());
+    }
 
-  case Shared::Protocol::PacketType::MAP_DATA: {
-    if (maxSize < 5) {
-      return 0;
+    if (packetSize == Shared::Protocol::INVALID_PACKET_SIZE) {
+      std::cerr << std::format("Error: unknown packet type {:#04x} from server",
+                               static_cast<unsigned char>(packet[0]))
+                << std::endl;
+      return false;
+    }
+    if (packetSize == 0) {
+      return true;
     }
 
-    const int width = static_cast<unsigned char>(data[1]) |
-                      (static_cast<unsigned char>(data[2]) << 8);
-    const int height = static_cast<unsigned char>(data[3]) |
-                       (static_cast<unsigned char>(data[4]) << 8);
-    const size_t expectedSize = 5 + (width * height * 2);
+    if (m_datagramPath == DatagramPath::UP &&
+        Shared::Protocol::isDatagramPacket(
+            static_cast<Shared::Protocol::PacketType>(packet[0]))) {
+      // The server stopped hearing our datagrams and fell back to TCP.
+      m_datagramPath = DatagramPath::PROBING;
+      m_probesSent = 0;
+      if (m_debugMode) {
+        std::cout << "Debug: State arrived over TCP; probing the datagram "
+                     "path again"
+                  << std::endl;
+      }
+    }
 
-    return (maxSize >= expectedSize) ? expectedSize : 0;
+    processPacket(packet.data(), packetSize);
+    m_receiveBuffer.consume(packetSize);
   }
+  return true;
+}
 
-  case Shared::Protocol::PacketType::GAME_START:
-    return (maxSize >= 3) ? 3 : 0;
+void NetworkClient::receiveDatagrams() {
+  std::array<std::byte, Shared::Protocol::MAX_DATAGRAM_SIZE> buffer;
 
-  case Shared::Protocol::PacketType::GAME_STATE_UPDATE: {
-    if (maxSize < 2) {
-      return 0;
+  while (m_datagramSocket != -1) {
+    const ssize_t received =
+        ::recv(m_datagramSocket, buffer.data(), buffer.size(), 0);
+    if (received < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // Nothing left, or an ICMP error for a probe; probing carries on.
+      return;
     }
 
-    int playerCount = static_cast<unsigned char>(data[1]);
-    constexpr size_t playerDataSize = 10;
-    size_t expectedSize = 2 + playerCount * playerDataSize;
-
-    return (maxSize >= expectedSize) ? expectedSize : 0;
+    const auto length = static_cast<size_t>(received);
+    if (length < Shared::Protocol::DATAGRAM_SEQUENCE_SIZE) {
+      continue;
+    }
+    const auto sequence =
+        static_cast<uint16_t>(std::to_integer<uint16_t>(buffer[0]) |
+                              std::to_integer<uint16_t>(buffer[1]) << 8);
+    if (m_datagramPath == DatagramPath::UP &&
+        !Shared::Protocol::isSequenceNewer(sequence, m_datagramSequence)) {
+      // Overtaken by a newer datagram, whose state replaced this one's.
+      continue;
+    }
+    if (m_datagramPath != DatagramPath::UP && m_debugMode) {
+      std::cout << "Debug: Datagram path up" << std::endl;
+    }
+    m_datagramPath = DatagramPath::UP;
+    m_datagramSequence = sequence;
+    m_bytesReceived += length;
+
+    size_t offset = Shared::Protocol::DATAGRAM_SEQUENCE_SIZE;
+    while (offset < length) {
+      const std::byte *packet = buffer.data() + offset;
+      const size_t packetSize =
+          Shared::Protocol::getPacketSize(packet, length - offset);
+      if (packetSize == 0 ||
+          packetSize == Shared::Protocol::INVALID_PACKET_SIZE) {
+        break;
+      }
+      if (Shared::Protocol::isDatagramPacket(
+              static_cast<Shared::Protocol::PacketType>(packet[0]))) {
+        processPacket(packet, packetSize);
+      }
+      offset += packetSize;
+    }
   }
+}
 
-  case Shared::Protocol::PacketType::COIN_COLLECTED:
-    return (maxSize >= 6) ? 6 : 0;
-
-  case Shared::Protocol::PacketType::PLAYER_DEATH:
-    return (maxSize >= 2) ? 2 : 0;
-
-  case Shared::Protocol::PacketType::GAME_OVER:
-    return (maxSize >= 3) ? 3 : 0;
-
-  case Shared::Protocol::PacketType::PLAYER_INPUT:
-    return (maxSize >= 2) ? 2 : 0;
+void NetworkClient::wakeNetworkThread() const {
+  if (m_wakeFd == -1) {
+    return;
+  }
 
-  default:
-    return 0;
+  constexpr uint64_t wakeup = 1;
+  if (::write(m_wakeFd, &wakeup, sizeof(wakeup)) < 0 && errno != EAGAIN) {
+    std::cerr << "Error waking network thread: " << strerror(errno)
+              << std::endl;
   }
 }
 
@@ -233,6 +326,7 @@ void NetworkClient::processPacket(const std::byte *data, size_t length) {
   if (length < 1) {
     return;
   }
+  tracePacket(Shared::TraceDirection::RECEIVED, std::span(data, length));
 
   auto packetType = static_cast<Shared::Protocol::PacketType>(data[0]);
 
@@ -243,21 +337,45 @@ void NetworkClient::processPacket(const std::byte *data, size_t length) {
   case Shared::Protocol::PacketType::MAP_DATA:
     handleMapData(data, length);
     break;
+  case Shared::Protocol::PacketType::MAP_INFO:
+    handleMapInfo(data, length);
+    break;
+  case Shared::Protocol::PacketType::MAP_CHUNK:
+    handleMapChunk(data, length);
+    break;
   case Shared::Protocol::PacketType::GAME_START:
     handleGameStart(data, length);
     break;
   case Shared::Protocol::PacketType::GAME_STATE_UPDATE:
     handleGameStateUpdate(data, length);
     break;
+  case Shared::Protocol::PacketType::GAME_STATE_DELTA:
+    handleGameStateDelta(data, length);
+    break;
+  case Shared::Protocol::PacketType::STATE_ENCODING:
+    handleStateEncoding(data, length);
+    break;
+  case Shared::Protocol::PacketType::GAME_STATE_PACKED:
+    handleGameStatePacked(data, length);
+    break;
+  case Shared::Protocol::PacketType::INPUT_ACK:
+    handleInputAck(data, length);
+    break;
   case Shared::Protocol::PacketType::COIN_COLLECTED:
     handleCoinCollected(data, length);
     break;
+  case Shared::Protocol::PacketType::COIN_COLLECTED_PACKED:
+    handleCoinCollectedPacked(data, length);
+    break;
   case Shared::Protocol::PacketType::PLAYER_DEATH:
     handlePlayerDeath(data, length);
     break;
   case Shared::Protocol::PacketType::GAME_OVER:
     handleGameOver(data, length);
     break;
+  case Shared::Protocol::PacketType::DATAGRAM_OFFER:
+    handleDatagramOffer(data, length);
+    break;
   default:
     break;
   }
@@ -269,10 +387,93 @@ void NetworkClient::handleConnectResponse(const std::byte *data,
     return;
   }
 
-  m_localPlayerId = static_cast<unsigned char>(data[1]);
+  const int playerId = static_cast<unsigned char>(data[1]);
+  if (m_spectating && playerId != Shared::Protocol::SPECTATOR_ID) {
+    // The seat the server hands out before it reads our request.
+    return;
+  }
+  m_localPlayerId = playerId;
   m_running = true;
 }
 
+void NetworkClient::handleDatagramOffer(const std::byte *data,
+                                        const size_t length) {
+  if (length < Shared::Protocol::DATAGRAM_OFFER_SIZE || !m_datagramsWanted ||
+      m_datagramSocket != -1) {
+    return;
+  }
+
+  const auto port = static_cast<uint16_t>(
+      static_cast<unsigned char>(data[1]) |
+      (static_cast<unsigned char>(data[2]) << 8));
+  uint32_t token = 0;
+  for (size_t i = 0; i < Shared::Protocol::DATAGRAM_TOKEN_SIZE; i++) {
+    token |= std::to_integer<uint32_t>(data[3 + i]) << (8 * i);
+  }
+
+  m_datagramSocket = socket(AF_INET, SOCK_DGRAM, 0);
+  if (m_datagramSocket < 0) {
+    std::cerr << "Failed to create datagram socket; staying on TCP"
+              << std::endl;
+    return;
+  }
+
+  // Connecting filters out datagrams from anyone but the server.
+  sockaddr_in serverAddr{};
+  serverAddr.sin_family = AF_INET;
+  serverAddr.sin_port = htons(port);
+  if (inet_pton(AF_INET, m_serverAddress.c_str(), &serverAddr.sin_addr) <= 0 ||
+      ::connect(m_datagramSocket, reinterpret_cast<sockaddr *>(&serverAddr),
+                sizeof(serverAddr)) < 0) {
+    std::cerr << "Failed to reach the datagram port; staying on TCP"
+              << std::endl;
+    closeDatagramPath();
+    return;
+  }
+  fcntl(m_datagramSocket, F_SETFL,
+        fcntl(m_datagramSocket, F_GETFL, 0) | O_NONBLOCK);
+
+  m_datagramToken = token;
+  m_datagramPath = DatagramPath::PROBING;
+  m_probesSent = 0;
+  probeDatagramPath();
+}
+
+void NetworkClient::probeDatagramPath() {
+  if (m_probesSent >= DATAGRAM_PROBE_ATTEMPTS) {
+    if (m_debugMode) {
+      std::cout << "Debug: No datagram from the server; staying on TCP"
+                << std::endl;
+    }
+    closeDatagramPath();
+    return;
+  }
+  m_probesSent++;
+  sendDatagram({});
+}
+
+void NetworkClient::closeDatagramPath() {
+  if (m_datagramSocket != -1) {
+    ::close(m_datagramSocket);
+    m_datagramSocket = -1;
+  }
+  m_datagramPath = DatagramPath::OFF;
+}
+
+void NetworkClient::sendDatagram(
+    const std::span<const std::byte> packets) const {
+  std::array<std::byte, Shared::Protocol::MAX_DATAGRAM_SIZE> datagram;
+  for (size_t i = 0; i < Shared::Protocol::DATAGRAM_TOKEN_SIZE; i++) {
+    datagram[i] = static_cast<std::byte>(m_datagramToken >> (8 * i));
+  }
+  std::ranges::copy(packets,
+                    datagram.begin() + Shared::Protocol::DATAGRAM_TOKEN_SIZE);
+
+  ::send(m_datagramSocket, datagram.data(),
+         Shared::Protocol::DATAGRAM_TOKEN_SIZE + packets.size(),
+         MSG_DONTWAIT);
+}
+
 void NetworkClient::handleMapData(const std::byte *data, const size_t length) {
   if (length < 5) {
     return;
@@ -283,36 +484,70 @@ void NetworkClient::handleMapData(const std::byte *data, const size_t length) {
   const int height = static_cast<unsigned char>(data[3]) |
                      (static_cast<unsigned char>(data[4]) << 8);
 
-  size_t minRequiredSize = 5 + (width * height * 2);
-  if (length < minRequiredSize) {
+  const size_t cellCount = static_cast<size_t>(width) * height;
+  if (length < 5 + cellCount * 2) {
+    return;
+  }
+
+  m_map.resize(width, height);
+  std::memcpy(m_map.tiles.data(), data + 5, cellCount);
+  std::memcpy(m_map.coinStates.data(), data + 5 + cellCount, cellCount);
+
+  if (m_display) {
+    m_display->updateMap(m_map);
+  }
+}
+
+void NetworkClient::handleMapInfo(const std::byte *data, const size_t length) {
+  if (length < Shared::Protocol::MAP_INFO_SIZE) {
     return;
   }
 
+  const int width = static_cast<unsigned char>(data[1]) |
+                    (static_cast<unsigned char>(data[2]) << 8);
+  const int height = static_cast<unsigned char>(data[3]) |
+                     (static_cast<unsigned char>(data[4]) << 8);
+  const int chunkColumns = static_cast<unsigned char>(data[5]) |
+                           (static_cast<unsigned char>(data[6]) << 8);
+
+  // Prediction only needs the bounds; the tiles live in the display's
+  // chunks.
+  m_map = Shared::Protocol::GameMap();
   m_map.width = width;
   m_map.height = height;
-  m_map.tiles.resize(height, std::vector<Shared::Protocol::TileType>(width));
-  m_map.coinStates.resize(height,
-                          std::vector<Shared::Protocol::CoinState>(width));
 
-  for (int y = 0; y < height; y++) {
-    for (int x = 0; x < width; x++) {
-      m_map.tiles[y][x] = static_cast<Shared::Protocol::TileType>(
-          static_cast<unsigned char>(data[5 + y * width + x]));
-    }
+  if (m_display) {
+    m_display->startMapStream(width, height, chunkColumns);
+  }
+}
+
+void NetworkClient::handleMapChunk(const std::byte *data,
+                                   const size_t length) {
+  if (length < Shared::Protocol::MAP_CHUNK_HEADER_SIZE) {
+    return;
   }
 
-  int coinStatesOffset = 5 + (width * height);
-  if (length >= static_cast<size_t>(coinStatesOffset + width * height)) {
-    for (int y = 0; y < height; y++) {
-      for (int x = 0; x < width; x++) {
-        m_map.coinStates[y][x] = static_cast<Shared::Protocol::CoinState>(
-            static_cast<unsigned char>(data[coinStatesOffset + y * width + x]));
-      }
-    }
+  const int firstColumn = static_cast<unsigned char>(data[1]) |
+                          (static_cast<unsigned char>(data[2]) << 8);
+  const int columnCount = static_cast<unsigned char>(data[3]) |
+                          (static_cast<unsigned char>(data[4]) << 8);
+  const int height = static_cast<unsigned char>(data[5]) |
+                     (static_cast<unsigned char>(data[6]) << 8);
+
+  const size_t cellCount = static_cast<size_t>(columnCount) * height;
+  if (length < Shared::Protocol::MAP_CHUNK_HEADER_SIZE + cellCount * 2 ||
+      height != m_map.height) {
+    return;
   }
 
+  Shared::Protocol::GameMap columns;
+  columns.resize(columnCount, height);
+  const std::byte *cells = data + Shared::Protocol::MAP_CHUNK_HEADER_SIZE;
+  std::memcpy(columns.tiles.data(), cells, cellCount);
+  std::memcpy(columns.coinStates.data(), cells + cellCount, cellCount);
+
   if (m_display) {
-    m_display->updateMap(m_map);
+    m_display->addMapChunk(firstColumn, std::move(columns));
   }
 }
 
@@ -350,40 +585,171 @@ void NetworkClient::handleGameStateUpdate(const std::byte *data,
     return;
   }
 
+  m_receivedSnapshots.clear();
   for (int i = 0; i < playerCount; i++) {
     const int offset = 2 + i * playerDataSize;
-    const int playerId = static_cast<unsigned char>(data[offset]);
-    const auto state = static_cast<Shared::Protocol::PlayerState>(
-        static_cast<unsigned char>(data[offset + 1]));
+    Shared::Protocol::PlayerSnapshot &snapshot =
+        m_receivedSnapshots.emplace_back();
 
-    const int16_t xFixedPrecision =
+    snapshot.id = static_cast<unsigned char>(data[offset]);
+    snapshot.state = static_cast<unsigned char>(data[offset + 1]);
+    snapshot.x = static_cast<int16_t>(
         static_cast<unsigned char>(data[offset + 2]) |
-        (static_cast<unsigned char>(data[offset + 3]) << 8);
-    const int16_t yFixedPrecision =
+        (static_cast<unsigned char>(data[offset + 3]) << 8));
+    snapshot.y = static_cast<int16_t>(
         static_cast<unsigned char>(data[offset + 4]) |
-        (static_cast<unsigned char>(data[offset + 5]) << 8);
-    const float x = xFixedPrecision / 100.0f;
-    const float y = yFixedPrecision / 100.0f;
-
-    const int score = static_cast<unsigned char>(data[offset + 6]) |
-                      (static_cast<unsigned char>(data[offset + 7]) << 8);
-    bool isJetpacking = static_cast<unsigned char>(data[offset + 8]) != 0;
-
-    auto playerIt = std::find_if(
-        m_players.begin(), m_players.end(),
-        [playerId](const auto &player) { return player.getId() == playerId; });
-
-    if (playerIt != m_players.end()) {
-      playerIt->setState(state);
-      playerIt->setPosition(x, y);
-      playerIt->setScore(score);
-      playerIt->setJetpacking(isJetpacking);
+        (static_cast<unsigned char>(data[offset + 5]) << 8));
+    snapshot.score = static_cast<uint16_t>(
+        static_cast<unsigned char>(data[offset + 6]) |
+        (static_cast<unsigned char>(data[offset + 7]) << 8));
+    snapshot.jetpack = static_cast<unsigned char>(data[offset + 8]);
+  }
+
+  applyPlayerSnapshots(m_receivedSnapshots);
+}
+
+void NetworkClient::handleGameStateDelta(const std::byte *data,
+                                         const size_t length) {
+  if (length < Shared::Protocol::DELTA_HEADER_SIZE) {
+    return;
+  }
+
+  const auto readShort = [data](const size_t offset) {
+    return static_cast<uint16_t>(
+        static_cast<unsigned char>(data[offset]) |
+        (static_cast<unsigned char>(data[offset + 1]) << 8));
+  };
+  const uint16_t sequence = readShort(1);
+  const uint16_t baselineSequence = readShort(3);
+  const size_t entryCount = static_cast<unsigned char>(data[5]);
+
+  if (!restoreBaseline(sequence, baselineSequence)) {
+    return;
+  }
+
+  const std::span<const std::byte> packet(data, length);
+  size_t offset = Shared::Protocol::DELTA_HEADER_SIZE;
+  for (size_t i = 0; i < entryCount; i++) {
+    const auto playerId = static_cast<uint8_t>(data[offset]);
+    auto snapshot = std::ranges::find(m_receivedSnapshots, playerId,
+                                      &Shared::Protocol::PlayerSnapshot::id);
+    if (snapshot == m_receivedSnapshots.end()) {
+      snapshot = m_receivedSnapshots.emplace(m_receivedSnapshots.end());
+    }
+    Shared::Protocol::readPlayerDelta(packet, offset, *snapshot);
+  }
+
+  commitSnapshot(sequence);
+}
+
+void NetworkClient::handleStateEncoding(const std::byte *data,
+                                        const size_t length) {
+  if (length < Shared::Protocol::STATE_ENCODING_SIZE) {
+    return;
+  }
+
+  const auto readInt = [data](const size_t offset) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < 4; i++) {
+      value |= std::to_integer<uint32_t>(data[offset + i]) << (8 * i);
+    }
+    return static_cast<int32_t>(value);
+  };
+  const auto scale = static_cast<uint16_t>(
+      static_cast<unsigned char>(data[1]) |
+      (static_cast<unsigned char>(data[2]) << 8));
+  if (scale == 0) {
+    return;
+  }
+  m_positionScale = scale;
+  m_packedOrigin.x = readInt(3);
+  m_packedOrigin.y = readInt(7);
+}
+
+void NetworkClient::handleGameStatePacked(const std::byte *data,
+                                          const size_t length) {
+  if (length < Shared::Protocol::PACKED_HEADER_SIZE) {
+    return;
+  }
+
+  const auto readShort = [data](const size_t offset) {
+    return static_cast<uint16_t>(
+        static_cast<unsigned char>(data[offset]) |
+        (static_cast<unsigned char>(data[offset + 1]) << 8));
+  };
+  const uint16_t sequence = readShort(1);
+  const uint16_t baselineSequence = readShort(3);
+
+  if (!restoreBaseline(sequence, baselineSequence)) {
+    return;
+  }
+
+  const std::span<const std::byte> packet(data, length);
+  size_t offset = Shared::Protocol::PACKED_HEADER_SIZE;
+  uint32_t entryCount = 0;
+  Shared::Protocol::readVarint(data, length, offset, entryCount);
+  for (uint32_t i = 0; i < entryCount; i++) {
+    size_t idOffset = offset;
+    uint32_t playerId = 0;
+    Shared::Protocol::readVarint(data, length, idOffset, playerId);
+    auto snapshot = std::ranges::find(m_receivedSnapshots, playerId,
+                                      &Shared::Protocol::PlayerSnapshot::id);
+    if (snapshot == m_receivedSnapshots.end()) {
+      snapshot = m_receivedSnapshots.insert(m_receivedSnapshots.end(),
+                                            m_packedOrigin);
+    }
+    Shared::Protocol::readPackedDelta(packet, offset, *snapshot);
+  }
+
+  commitSnapshot(sequence);
+}
+
+bool NetworkClient::restoreBaseline(const uint16_t sequence,
+                                    const uint16_t baselineSequence) {
+  m_receivedSnapshots.clear();
+  if (baselineSequence == Shared::Protocol::NO_BASELINE) {
+    return true;
+  }
+
+  const Shared::Protocol::StateSnapshot *baseline =
+      Shared::Protocol::findSnapshot(m_stateHistory, baselineSequence);
+  if (baseline == nullptr) {
+    if (m_debugMode) {
+      std::cout << std::format("Debug: Dropped delta {} with unknown "
+                               "baseline {}",
+                               sequence, baselineSequence)
+                << std::endl;
+    }
+    return false;
+  }
+  m_receivedSnapshots = baseline->players;
+  return true;
+}
+
+void NetworkClient::commitSnapshot(const uint16_t sequence) {
+  Shared::Protocol::StateSnapshot &slot =
+      m_stateHistory[sequence % Shared::Protocol::STATE_HISTORY_SIZE];
+  slot.sequence = sequence;
+  slot.players = m_receivedSnapshots;
+
+  applyPlayerSnapshots(m_receivedSnapshots);
+  sendStateAck(sequence);
+}
+
+void NetworkClient::applyPlayerSnapshots(
+    const std::vector<Shared::Protocol::PlayerSnapshot> &snapshots) {
+  for (const Shared::Protocol::PlayerSnapshot &snapshot : snapshots) {
+    auto playerIt = std::ranges::find_if(m_players, [&snapshot](const auto &p) {
+      return p.getId() == snapshot.id;
+    });
+
+    if (playerIt == m_players.end()) {
+      playerIt = m_players.emplace(m_players.end(), -1, snapshot.id);
+    }
+    if (m_inputSequencing && snapshot.id == m_localPlayerId) {
+      reconcileLocalPlayer(*playerIt, snapshot);
     } else {
-      m_players.emplace_back(-1, playerId);
-      m_players.back().setState(state);
-      m_players.back().setPosition(x, y);
-      m_players.back().setScore(score);
-      m_players.back().setJetpacking(isJetpacking);
+      snapshot.applyTo(*playerIt, m_positionScale);
     }
   }
 
@@ -392,6 +758,77 @@ void NetworkClient::handleGameStateUpdate(const std::byte *data,
   }
 }
 
+void NetworkClient::reconcileLocalPlayer(
+    Shared::Protocol::Player &player,
+    const Shared::Protocol::PlayerSnapshot &snapshot) {
+  const bool wasPlaying =
+      player.getState() == Shared::Protocol::PlayerState::PLAYING;
+  const Shared::Protocol::Position predicted = player.getPosition();
+  const float predictedVelocity = player.getVelocityY();
+  const bool predictedJetpack = player.isJetpacking();
+
+  snapshot.applyTo(player, m_positionScale);
+  if (player.getState() != Shared::Protocol::PlayerState::PLAYING) {
+    return;
+  }
+
+  const PredictedInput *acked = findPredictedInput(m_ackedInput);
+  const Shared::Protocol::Position authoritative = player.getPosition();
+  if (wasPlaying && acked != nullptr &&
+      std::abs(acked->position.x - authoritative.x) <= RECONCILE_TOLERANCE &&
+      std::abs(acked->position.y - authoritative.y) <= RECONCILE_TOLERANCE) {
+    player.setPosition(predicted.x, predicted.y);
+    player.setVelocityY(predictedVelocity);
+    player.setJetpacking(predictedJetpack);
+    return;
+  }
+
+  player.setVelocityY(acked != nullptr ? acked->velocityY : 0.0f);
+  const auto pending = static_cast<uint16_t>(m_inputSequence - m_ackedInput);
+  auto sequence = static_cast<uint16_t>(
+      m_inputSequence - std::min<size_t>(pending, INPUT_HISTORY_SIZE));
+  while (sequence != m_inputSequence) {
+    sequence++;
+    PredictedInput *input = findPredictedInput(sequence);
+    if (input == nullptr) {
+      continue;
+    }
+    player.setJetpacking(input->isJetpacking);
+    Shared::Physics::step(player, m_map.height);
+    input->position = player.getPosition();
+    input->velocityY = player.getVelocityY();
+  }
+
+  if (m_debugMode) {
+    std::cout << std::format("Debug: Corrected prediction at input {} by "
+                             "({:.2f}, {:.2f})",
+                             m_ackedInput, predicted.x - player.getPosition().x,
+                             predicted.y - player.getPosition().y)
+              << std::endl;
+  }
+}
+
+NetworkClient::PredictedInput *
+NetworkClient::findPredictedInput(const uint16_t sequence) {
+  if (sequence == Shared::Protocol::NO_INPUT_SEQUENCE) {
+    return nullptr;
+  }
+  PredictedInput &slot = m_inputHistory[sequence % INPUT_HISTORY_SIZE];
+  return slot.sequence == sequence ? &slot : nullptr;
+}
+
+void NetworkClient::handleInputAck(const std::byte *data,
+                                   const size_t length) {
+  if (length < 3) {
+    return;
+  }
+
+  m_inputSequencing = true;
+  m_ackedInput = static_cast<uint16_t>(
+      static_cast<unsigned char>(data[1]) |
+      (static_cast<unsigned char>(data[2]) << 8));
+}
+
 void NetworkClient::handleCoinCollected(const std::byte *data,
                                         const size_t length) const {
   if (length < 6) {
@@ -408,6 +845,32 @@ void NetworkClient::handleCoinCollected(const std::byte *data,
   }
 }
 
+void NetworkClient::handleCoinCollectedPacked(const std::byte *data,
+                                              const size_t length) const {
+  size_t offset = 1;
+  std::array<uint32_t, 4> fields{};
+  for (uint32_t &field : fields) {
+    const size_t size =
+        Shared::Protocol::readVarint(data, length, offset, field);
+    if (size == 0 || size == Shared::Protocol::INVALID_PACKET_SIZE) {
+      return;
+    }
+  }
+  if (offset >= length) {
+    return;
+  }
+
+  // The last field is the collector's score, which state updates carry.
+  const auto playerId = static_cast<int>(fields[0]);
+  const auto x = static_cast<int>(fields[1]);
+  const auto y = static_cast<int>(fields[2]);
+  const int coinState = static_cast<unsigned char>(data[offset]);
+
+  if (m_display) {
+    m_display->handleCoinCollected(playerId, x, y, coinState);
+  }
+}
+
 void NetworkClient::handlePlayerDeath(const std::byte *data,
                                       const size_t length) const {
   if (length < 2) {
@@ -435,33 +898,120 @@ void NetworkClient::handleGameOver(const std::byte *data,
   }
 }
 
-void NetworkClient::sendPlayerInput() const {
-  if (m_serverSocket < 0 || !m_display) {
+void NetworkClient::sendPlayerInput() {
+  if (m_serverSocket < 0 || !m_display || m_spectating) {
     return;
   }
 
   bool jetpackActive = m_display->isJetpackActive();
+  m_lastSentJetpack = jetpackActive;
 
-  Shared::Protocol::NetworkPacket packet(
-      Shared::Protocol::PacketType::PLAYER_INPUT);
-  packet.addByte(static_cast<uint8_t>(jetpackActive ? 1 : 0));
+  std::array<std::byte, 4> buffer{};
+  const size_t payloadSize = m_inputSequencing ? 3 : 1;
+  Shared::Protocol::PacketWriter packet(
+      buffer, Shared::Protocol::PacketType::PLAYER_INPUT, payloadSize);
 
-  std::vector<std::byte> buffer = packet.serialize();
+  if (m_inputSequencing) {
+    m_inputSequence++;
+    if (m_inputSequence == Shared::Protocol::NO_INPUT_SEQUENCE) {
+      m_inputSequence++;
+    }
+    packet.addByte(Shared::Protocol::InputFlag::SEQUENCED |
+                   (jetpackActive ? Shared::Protocol::InputFlag::JETPACK : 0));
+    packet.addShort(m_inputSequence);
+  } else {
+    packet.addByte(static_cast<uint8_t>(jetpackActive ? 1 : 0));
+  }
+
+  const std::span<const std::byte> input =
+      std::span(buffer).first(packet.size());
+  tracePacket(Shared::TraceDirection::SENT, input);
+
+  if (m_inputSequencing) {
+    if (m_recentInputBytes == m_recentInputs.size()) {
+      std::copy(m_recentInputs.begin() + SEQUENCED_INPUT_SIZE,
+                m_recentInputs.end(), m_recentInputs.begin());
+      m_recentInputBytes -= SEQUENCED_INPUT_SIZE;
+    }
+    std::ranges::copy(input, m_recentInputs.begin() +
+                                 static_cast<std::ptrdiff_t>(
+                                     m_recentInputBytes));
+    m_recentInputBytes += input.size();
+  }
+
+  if (m_datagramPath == DatagramPath::UP) {
+    // Oldest first: the server skips the inputs it already has.
+    sendDatagram(m_inputSequencing
+                     ? std::span<const std::byte>(m_recentInputs)
+                           .first(m_recentInputBytes)
+                     : input);
+  } else {
+    send(m_serverSocket, buffer.data(), packet.size(), 0);
+    if (m_datagramPath == DatagramPath::PROBING) {
+      probeDatagramPath();
+    }
+  }
 
-  if (m_debugMode) {
-    std::cout << std::format("Debug: Sent {} bytes to server: ", buffer.size());
+  if (m_inputSequencing) {
+    predictLocalPlayer(m_inputSequence, jetpackActive);
+  }
+}
 
-    for (size_t i = 0; i < buffer.size(); i++) {
-      std::cout << std::format("{:02X} ",
-                               static_cast<unsigned char>(buffer[i]));
-    }
+void NetworkClient::predictLocalPlayer(const uint16_t sequence,
+                                       const bool isJetpacking) {
+  PredictedInput &input = m_inputHistory[sequence % INPUT_HISTORY_SIZE];
+  input.sequence = sequence;
+  input.isJetpacking = isJetpacking;
+
+  const auto playerIt = std::ranges::find_if(m_players, [this](const auto &p) {
+    return p.getId() == m_localPlayerId;
+  });
+  if (playerIt == m_players.end() ||
+      playerIt->getState() != Shared::Protocol::PlayerState::PLAYING) {
+    input.sequence = Shared::Protocol::NO_INPUT_SEQUENCE;
+    return;
+  }
+
+  playerIt->setJetpacking(isJetpacking);
+  Shared::Physics::step(*playerIt, m_map.height);
+  input.position = playerIt->getPosition();
+  input.velocityY = playerIt->getVelocityY();
 
-    std::cout << std::endl;
+  if (m_display) {
+    m_display->updateLocalPlayer(*playerIt);
   }
+}
 
-  send(m_serverSocket, buffer.data(), buffer.size(), 0);
+void NetworkClient::sendStateAck(const uint16_t sequence) const {
+  std::array<std::byte, 3> buffer{};
+  Shared::Protocol::PacketWriter packet(
+      buffer, Shared::Protocol::PacketType::STATE_ACK, 2);
+  packet.addShort(sequence);
+
+  tracePacket(Shared::TraceDirection::SENT, buffer);
+  if (m_datagramPath == DatagramPath::UP) {
+    sendDatagram(buffer);
+  } else {
+    send(m_serverSocket, buffer.data(), packet.size(), 0);
+  }
+}
+
+void NetworkClient::enableTracing(Shared::TraceOptions options) {
+  m_tracer = std::make_unique<Shared::PacketTracer>(std::move(options));
+  m_traceRing = &m_tracer->addRing();
+}
+
+void NetworkClient::tracePacket(const Shared::TraceDirection direction,
+                                const std::span<const std::byte> packet) const {
+  if (m_traceRing != nullptr) {
+    m_traceRing->record(direction, m_serverSocket, packet);
+  }
 }
 
 int NetworkClient::getLocalPlayerId() const { return m_localPlayerId; }
 
+void NetworkClient::setView(std::shared_ptr<GameView> view) {
+  m_display = std::move(view);
+}
+
 } // namespace Jetpack::Client
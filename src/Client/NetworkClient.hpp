@@ -5,14 +5,21 @@
 
 #pragma once
 
+#include "../Shared/PacketTrace.hpp"
+#include "../Shared/Physics.hpp"
 #include "../Shared/Protocol.hpp"
+#include "../Shared/RingBuffer.hpp"
+#include "../Shared/StateDelta.hpp"
+#include <array>
 #include <atomic>
+#include <cstdint>
 #include <memory>
+#include <span>
 #include <string>
 #include <thread>
 #include <unistd.h>
 
-#include "GameDisplay.hpp"
+#include "GameView.hpp"
 
 namespace Jetpack::Client {
 
@@ -30,7 +37,7 @@ public:
    * @brief Constructs a NetworkClient instance.
    * @param serverPort Port number of the server (default: 8080).
    * @param serverAddress IP address of the server (default: "127.0.0.1").
-   * @param debugMode When true, prints detailed network packet information.
+   * @param debugMode When true, reports dropped deltas and corrections.
    */
   explicit NetworkClient(int serverPort = 8080,
                          std::string serverAddress = "127.0.0.1",
@@ -72,11 +79,42 @@ public:
    */
   [[nodiscard]] bool connectToServer();
 
+  /**
+   * @brief Traces every packet sent and received from now on.
+   *
+   * Call before connectToServer(): the packets are recorded on the thread
+   * that handles them, which must be one thread at a time.
+   *
+   * @param options What to trace and where to write it.
+   * @throws Shared::Exceptions::ResourceException if the trace file cannot
+   *         be created.
+   */
+  void enableTracing(Shared::TraceOptions options);
+
+  /**
+   * @brief Asks to watch a match instead of playing; call before
+   *        connectToServer(). No input is sent and the camera follows
+   *        the leading player.
+   */
+  void enableSpectating() { m_spectating = true; }
+
+  /**
+   * @brief Asks for state and input to travel over UDP when the server
+   *        offers it; call before connectToServer().
+   *
+   * Events stay on TCP, and so does everything else until the server
+   * answers a probe datagram. Each input datagram repeats the previous
+   * inputs, so one lost datagram loses no input.
+   */
+  void enableDatagrams() { m_datagramsWanted = true; }
+
   /**
    * @brief Starts the game client.
    *
    * Initializes the display component, starts the network thread,
-   * and runs the main game loop.
+   * and runs the main game loop. Defined apart from the protocol code,
+   * in NetworkClientDisplay.cpp, so that headless tools can link this
+   * class without SFML.
    */
   void start();
 
@@ -86,23 +124,84 @@ public:
    */
   [[nodiscard]] int getLocalPlayerId() const;
 
+  /**
+   * @brief Sets where decoded game events go, for callers that drive the
+   *        socket themselves instead of calling start().
+   * @param view Receiver of the events; also supplies the jetpack state.
+   */
+  void setView(std::shared_ptr<GameView> view);
+
+  /** @return The connected socket, or -1. */
+  [[nodiscard]] int getSocket() const { return m_serverSocket; }
+
+  /** @return Bytes received from the server so far. */
+  [[nodiscard]] uint64_t getBytesReceived() const { return m_bytesReceived; }
+
+  /**
+   * @brief Reads everything the socket holds into the receive ring and
+   *        processes each complete packet in place.
+   * @return False if the connection is closed, failed or corrupted.
+   */
+  [[nodiscard]] bool receiveFromServer();
+
+  /**
+   * @brief Sends the player's input state to the server.
+   *
+   * Queries the view for the jetpack state and sends it to the server.
+   * Once the server accepts sequenced input, the input is numbered and
+   * the local player is stepped ahead with it.
+   */
+  void sendPlayerInput();
+
 private:
   /**
    * @brief Network thread function that handles incoming data.
    *
-   * Continuously reads from the socket, processes incoming packets,
-   * and sends player input to the server.
+   * Sleeps in poll() until the socket is readable, the display reports
+   * an input change, or the next input step is due; processes incoming
+   * packets and sends player input to the server. A change of the
+   * jetpack state is sent at once as the next tick's input, moving the
+   * input schedule one interval ahead; a second change within the same
+   * interval waits for the timer.
    */
   void networkLoop();
 
   /**
-   * @brief Determines the size of a packet based on its type and header.
-   * @param data Pointer to the packet data.
-   * @param maxSize Maximum available bytes to read.
-   * @return The expected size of the complete packet, or 0 if incomplete.
+   * @brief Reads every pending datagram and processes the packets of
+   *        each one newer than the last.
+   */
+  void receiveDatagrams();
+
+  /**
+   * @brief Opens the UDP path a DATAGRAM_OFFER describes and probes it.
+   * @param data Packet data.
+   * @param length Packet length.
+   */
+  void handleDatagramOffer(const std::byte *data, size_t length);
+
+  /**
+   * @brief Sends the bare token until the server answers, closing the UDP
+   *        socket once DATAGRAM_PROBE_ATTEMPTS go unanswered.
+   */
+  void probeDatagramPath();
+
+  /** @brief Closes the UDP socket; everything goes over TCP again. */
+  void closeDatagramPath();
+
+  /**
+   * @brief Sends packets in one datagram behind the token.
+   * @param packets Whole packets, concatenated.
    */
-  [[nodiscard]] size_t getPacketSize(const std::byte *data,
-                                     size_t maxSize) const;
+  void sendDatagram(std::span<const std::byte> packets) const;
+
+  /**
+   * @brief Processes every complete packet at the head of the ring.
+   * @return False if the stream holds an unknown packet type.
+   */
+  [[nodiscard]] bool drainReceiveBuffer();
+
+  /** @brief Interrupts the network thread's wait; safe from any thread. */
+  void wakeNetworkThread() const;
 
   /**
    * @brief Processes a complete packet received from the server.
@@ -125,6 +224,20 @@ private:
    */
   void handleMapData(const std::byte *data, size_t length);
 
+  /**
+   * @brief Handles the dimensions of a streamed map.
+   * @param data Packet data.
+   * @param length Packet length.
+   */
+  void handleMapInfo(const std::byte *data, size_t length);
+
+  /**
+   * @brief Handles a chunk of a streamed map.
+   * @param data Packet data.
+   * @param length Packet length.
+   */
+  void handleMapChunk(const std::byte *data, size_t length);
+
   /**
    * @brief Handles a game start packet from the server.
    * @param data Packet data.
@@ -139,6 +252,83 @@ private:
    */
   void handleGameStateUpdate(const std::byte *data, size_t length);
 
+  /**
+   * @brief Handles a delta-compressed game state packet from the server.
+   *
+   * Rebuilds the snapshot from the referenced baseline, stores it as a
+   * future baseline, applies it and acknowledges its sequence number.
+   * A delta whose baseline is no longer known is dropped; the server
+   * falls back to a keyframe.
+   *
+   * @param data Packet data.
+   * @param length Packet length.
+   */
+  void handleGameStateDelta(const std::byte *data, size_t length);
+
+  /**
+   * @brief Handles the precision and origin of packed state positions.
+   * @param data Packet data.
+   * @param length Packet length.
+   */
+  void handleStateEncoding(const std::byte *data, size_t length);
+
+  /**
+   * @brief Handles a GAME_STATE_PACKED, the varint form of
+   *        GAME_STATE_DELTA, rebuilding positions from the baseline or
+   *        the match origin.
+   * @param data Packet data.
+   * @param length Packet length.
+   */
+  void handleGameStatePacked(const std::byte *data, size_t length);
+
+  /**
+   * @brief Starts a delta from its baseline in m_receivedSnapshots.
+   * @param sequence         Sequence of the delta.
+   * @param baselineSequence Snapshot it is relative to, or NO_BASELINE.
+   * @return False if the baseline is no longer known.
+   */
+  bool restoreBaseline(uint16_t sequence, uint16_t baselineSequence);
+
+  /**
+   * @brief Stores m_receivedSnapshots as a future baseline, applies it and
+   *        acknowledges it.
+   * @param sequence Sequence of the delta just decoded.
+   */
+  void commitSnapshot(uint16_t sequence);
+
+  /**
+   * @brief Copies decoded player records into the local player list and
+   *        forwards them to the display.
+   * @param snapshots Records received from the server.
+   */
+  void applyPlayerSnapshots(
+      const std::vector<Shared::Protocol::PlayerSnapshot> &snapshots);
+
+  /**
+   * @brief Handles an input acknowledgement from the server.
+   *
+   * The first one confirms the server accepts sequenced PLAYER_INPUT and
+   * turns local prediction on; later ones name the last input included
+   * in the state that follows.
+   *
+   * @param data Packet data.
+   * @param length Packet length.
+   */
+  void handleInputAck(const std::byte *data, size_t length);
+
+  /**
+   * @brief Corrects the predicted local player with an authoritative record.
+   *
+   * If the prediction made for the acknowledged input matches the server,
+   * it is kept; otherwise the player is reset to the server's record and
+   * every input the server has not applied yet is replayed on top.
+   *
+   * @param player   Local player, holding the current prediction.
+   * @param snapshot Authoritative record from the server.
+   */
+  void reconcileLocalPlayer(Shared::Protocol::Player &player,
+                            const Shared::Protocol::PlayerSnapshot &snapshot);
+
   /**
    * @brief Handles a coin collected event packet from the server.
    * @param data Packet data.
@@ -146,6 +336,13 @@ private:
    */
   void handleCoinCollected(const std::byte *data, size_t length) const;
 
+  /**
+   * @brief Handles a COIN_COLLECTED_PACKED event packet from the server.
+   * @param data Packet data.
+   * @param length Packet length.
+   */
+  void handleCoinCollectedPacked(const std::byte *data, size_t length) const;
+
   /**
    * @brief Handles a player death event packet from the server.
    * @param data Packet data.
@@ -161,25 +358,115 @@ private:
   void handleGameOver(const std::byte *data, size_t length) const;
 
   /**
-   * @brief Sends the player's input state to the server.
-   *
-   * Queries the display component for the jetpack state and
-   * sends it to the server.
+   * @brief Runs one simulation step of the local player and records it.
+   * @param sequence     Sequence number of the input just sent.
+   * @param isJetpacking Jetpack state of that input.
+   */
+  void predictLocalPlayer(uint16_t sequence, bool isJetpacking);
+
+  /**
+   * @brief Acknowledges a GAME_STATE_DELTA or GAME_STATE_PACKED so the
+   *        server can use it as the baseline of the next one.
+   * @param sequence Sequence number received.
+   */
+  void sendStateAck(uint16_t sequence) const;
+
+  /** One predicted step, kept until the server has applied its input. */
+  struct PredictedInput {
+    uint16_t sequence = Shared::Protocol::NO_INPUT_SEQUENCE;
+    bool isJetpacking = false;
+    Shared::Protocol::Position position;
+    float velocityY = 0.0f;
+  };
+
+  /** Initial receive ring size; only large MAP_DATA packets exceed it. */
+  static constexpr size_t RECEIVE_BUFFER_SIZE = 64 * 1024;
+
+  /** Largest the ring may grow to hold a single packet. */
+  static constexpr size_t MAX_RECEIVE_BUFFER_SIZE = 64 * 1024 * 1024;
+
+  /** Inputs remembered for replay; about one second at the tick rate. */
+  static constexpr size_t INPUT_HISTORY_SIZE = 64;
+
+  /** Probes sent, one per input step, before UDP is given up. */
+  static constexpr int DATAGRAM_PROBE_ATTEMPTS =
+      2 * Shared::Physics::TICK_RATE;
+
+  /** Inputs each input datagram carries, the newest last. */
+  static constexpr size_t DATAGRAM_INPUT_COPIES = 3;
+
+  /** Size of a sequenced PLAYER_INPUT. */
+  static constexpr size_t SEQUENCED_INPUT_SIZE = 4;
+
+  /** Prediction error (in cells) tolerated before a correction. */
+  static constexpr float RECONCILE_TOLERANCE = 0.02f;
+
+  /**
+   * @param sequence Input sequence wanted.
+   * @return The recorded step, or nullptr if unknown or overwritten.
    */
-  void sendPlayerInput() const;
+  PredictedInput *findPredictedInput(uint16_t sequence);
+
+  /**
+   * @brief Records a packet in the trace, if tracing is enabled.
+   * @param direction Which way it travelled.
+   * @param packet    The whole packet.
+   */
+  void tracePacket(Shared::TraceDirection direction,
+                   std::span<const std::byte> packet) const;
 
   int m_serverPort;
   std::string m_serverAddress;
   bool m_debugMode;
+  bool m_spectating{false};
+  bool m_datagramsWanted{false};
   int m_serverSocket{-1};
+  uint64_t m_bytesReceived{0};
+  Shared::RingBuffer m_receiveBuffer{RECEIVE_BUFFER_SIZE};
+  int m_wakeFd{-1};
+  bool m_lastSentJetpack{false};
   int m_localPlayerId{-1};
 
   Shared::Protocol::GameMap m_map;
   std::vector<Shared::Protocol::Player> m_players;
+  std::vector<Shared::Protocol::PlayerSnapshot> m_receivedSnapshots;
+  Shared::Protocol::StateHistory m_stateHistory;
+  /** Precision of snapshot positions; STATE_ENCODING may change it. */
+  uint16_t m_positionScale = Shared::Protocol::LEGACY_POSITION_SCALE;
+  /** Record new players of a packed delta start from; x and y only. */
+  Shared::Protocol::PlayerSnapshot m_packedOrigin;
+
+  bool m_inputSequencing = false;
+  uint16_t m_inputSequence = Shared::Protocol::NO_INPUT_SEQUENCE;
+  uint16_t m_ackedInput = Shared::Protocol::NO_INPUT_SEQUENCE;
+  std::array<PredictedInput, INPUT_HISTORY_SIZE> m_inputHistory;
+
+  /**
+   * @enum DatagramPath
+   * @brief How far the UDP path is established.
+   */
+  enum class DatagramPath {
+    OFF,     ///< Not offered, refused or given up
+    PROBING, ///< Socket open, no datagram from the server yet
+    UP       ///< The server's datagrams arrive; input goes by datagram
+  };
+
+  DatagramPath m_datagramPath = DatagramPath::OFF;
+  int m_datagramSocket{-1};
+  uint32_t m_datagramToken = 0;
+  int m_probesSent = 0;
+  uint16_t m_datagramSequence = 0;
+  /** Last inputs sent, oldest first, repeated in every input datagram. */
+  std::array<std::byte, DATAGRAM_INPUT_COPIES * SEQUENCED_INPUT_SIZE>
+      m_recentInputs{};
+  size_t m_recentInputBytes = 0;
+
+  std::unique_ptr<Shared::PacketTracer> m_tracer;
+  Shared::TraceRing *m_traceRing = nullptr;
 
   std::atomic<bool> m_running{true};
   std::thread m_networkThread;
 
-  std::shared_ptr<GameDisplay> m_display;
+  std::shared_ptr<GameView> m_display;
 };
 } // namespace Jetpack::Client
@@ -0,0 +1,51 @@
+/**
+ * @file NetworkClientDisplay.cpp
+ * @brief Implements NetworkClient::start(), the only part of the client
+ *        protocol code that depends on the SFML display.
+ */
+
+#include "NetworkClient.hpp"
+#include "../Shared/Exceptions.hpp"
+#include "GameDisplay.hpp"
+#include <chrono>
+#include <sys/eventfd.h>
+#include <thread>
+
+namespace Jetpack::Client {
+
+void NetworkClient::start() {
+  m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (m_wakeFd < 0) {
+    throw Shared::Exceptions::SocketException(
+        "Failed to create network wakeup descriptor");
+  }
+
+  const auto display = std::make_shared<GameDisplay>();
+  display->setInputListener([this] { wakeNetworkThread(); });
+  m_display = display;
+  m_networkThread = std::thread(&NetworkClient::networkLoop, this);
+
+  using namespace std::chrono_literals;
+
+  while (m_localPlayerId == -1 && m_running) {
+    std::this_thread::sleep_for(50ms);
+  }
+
+  if (m_debugMode) {
+    display->setDebugMode(true);
+  }
+
+  if (m_localPlayerId != -1) {
+    display->setLocalPlayerId(m_localPlayerId);
+  }
+
+  display->run();
+  m_running = false;
+  wakeNetworkThread();
+
+  if (m_networkThread.joinable()) {
+    m_networkThread.join();
+  }
+}
+
+} // namespace Jetpack::Client
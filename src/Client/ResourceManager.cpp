@@ -0,0 +1,360 @@
+/**
+ * @file ResourceManager.cpp
+ * @brief Implements the asset worker pool and the packed asset archive.
+ */
+
+#include "ResourceManager.hpp"
+#include "../Shared/Exceptions.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(std::endian::native == std::endian::little,
+              "asset archives are read in place as little-endian");
+
+namespace {
+
+constexpr std::array<char, 8> MAGIC = {'J', 'P', 'P', 'A', 'K', 0, 0, 1};
+constexpr size_t HEADER_SIZE = 16;
+constexpr size_t ENTRY_SIZE = 16;
+/** Alignment of each file's data, so decoders may read it in place. */
+constexpr size_t DATA_ALIGNMENT = 8;
+
+uint32_t readInt(const std::byte *data) {
+  uint32_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+void writeInt(std::byte *data, const uint32_t value) {
+  std::memcpy(data, &value, sizeof(value));
+}
+
+size_t alignData(const size_t offset) {
+  return (offset + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1);
+}
+
+} // namespace
+
+namespace Jetpack::Client {
+
+ResourceManager::ResourceManager(std::filesystem::path directory)
+    : m_directory(std::move(directory)) {
+  mapArchive();
+
+  const unsigned workerCount =
+      std::clamp(std::thread::hardware_concurrency(), 1u, MAX_WORKERS);
+  for (unsigned i = 0; i < workerCount; i++) {
+    m_workers.emplace_back(&ResourceManager::workerLoop, this);
+  }
+}
+
+ResourceManager::~ResourceManager() {
+  {
+    std::lock_guard lock(m_mutex);
+    m_stopping = true;
+    m_jobs.clear();
+  }
+  m_jobsChanged.notify_all();
+
+  for (std::thread &worker : m_workers) {
+    worker.join();
+  }
+
+  if (m_archive != nullptr) {
+    munmap(const_cast<void *>(m_archive), m_archiveSize);
+  }
+}
+
+void ResourceManager::requestAsset(const std::type_index type,
+                                   const std::string &name,
+                                   const Decoder decoder) {
+  std::lock_guard lock(m_mutex);
+  AssetKey key(type, name);
+  if (m_assets.contains(key)) {
+    return;
+  }
+
+  auto task =
+      std::make_shared<std::packaged_task<std::shared_ptr<const void>()>>(
+          [this, name, decoder] {
+            std::shared_ptr<const void> asset = decoder(getBytes(name));
+            if (!asset) {
+              throw Shared::Exceptions::ResourceException(m_directory / name,
+                                                          "Cannot decode file");
+            }
+            return asset;
+          });
+  m_assets.emplace(std::move(key), task->get_future().share());
+  submitLocked([task] { (*task)(); });
+}
+
+void ResourceManager::requestBytes(const std::string &name) {
+  std::lock_guard lock(m_mutex);
+  std::unique_ptr<File> &file = m_files[name];
+  if (file) {
+    return;
+  }
+
+  file = std::make_unique<File>();
+  submitLocked([this, name, entry = file.get()] {
+    std::call_once(entry->read, &ResourceManager::readFile, this, name,
+                   std::ref(*entry));
+  });
+}
+
+std::shared_ptr<const void>
+ResourceManager::getAsset(const std::type_index type,
+                          const std::string &name) {
+  Asset asset;
+  {
+    std::lock_guard lock(m_mutex);
+    asset = m_assets.at(AssetKey(type, name));
+  }
+  return asset.get();
+}
+
+std::shared_ptr<const void>
+ResourceManager::findAsset(const std::type_index type,
+                           const std::string &name) {
+  try {
+    return getAsset(type, name);
+  } catch (const Shared::Exceptions::ResourceException &e) {
+    std::cerr << std::format("Error loading resources: {}", e.what())
+              << std::endl;
+    return nullptr;
+  }
+}
+
+std::span<const std::byte>
+ResourceManager::getBytes(const std::string &name) {
+  File &file = getFile(name);
+  std::call_once(file.read, &ResourceManager::readFile, this, name,
+                 std::ref(file));
+
+  if (!file.error.empty()) {
+    throw Shared::Exceptions::ResourceException(m_directory / name,
+                                                file.error);
+  }
+  return file.bytes;
+}
+
+void ResourceManager::saveArchive() {
+  if (!m_readLooseFile.exchange(false)) {
+    return;
+  }
+
+  std::vector<std::pair<std::string, std::span<const std::byte>>> files;
+  {
+    std::lock_guard lock(m_mutex);
+    for (const auto &[name, file] : m_files) {
+      if (file->done.load(std::memory_order_acquire) && file->error.empty()) {
+        files.emplace_back(name, file->bytes);
+      }
+    }
+    std::ranges::sort(files, {}, &decltype(files)::value_type::first);
+
+    m_jobs.emplace_back(
+        [this, files = std::move(files)] { writeArchive(files); });
+  }
+  m_jobsChanged.notify_one();
+}
+
+void ResourceManager::mapArchive() {
+  const std::filesystem::path path = m_directory / ARCHIVE_NAME;
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return;
+  }
+
+  struct stat info {};
+  if (fstat(fd, &info) == -1 ||
+      info.st_size < static_cast<off_t>(HEADER_SIZE)) {
+    close(fd);
+    return;
+  }
+
+  const auto size = static_cast<size_t>(info.st_size);
+  void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return;
+  }
+
+  const auto *data = static_cast<const std::byte *>(mapping);
+  const size_t count = readInt(data + 8);
+  bool valid = std::memcmp(data, MAGIC.data(), MAGIC.size()) == 0 &&
+               count <= (size - HEADER_SIZE) / ENTRY_SIZE;
+
+  std::unordered_map<std::string, std::span<const std::byte>> entries;
+  for (size_t i = 0; valid && i < count; i++) {
+    const std::byte *entry = data + HEADER_SIZE + i * ENTRY_SIZE;
+    const size_t nameOffset = readInt(entry);
+    const size_t nameLength = readInt(entry + 4);
+    const size_t dataOffset = readInt(entry + 8);
+    const size_t dataSize = readInt(entry + 12);
+
+    valid = nameOffset <= size && nameLength <= size - nameOffset &&
+            dataOffset <= size && dataSize <= size - dataOffset;
+    if (valid) {
+      entries.emplace(
+          std::string(reinterpret_cast<const char *>(data + nameOffset),
+                      nameLength),
+          std::span(data + dataOffset, dataSize));
+    }
+  }
+
+  std::error_code error;
+  const auto archiveTime = std::filesystem::last_write_time(path, error);
+  if (!valid || error) {
+    munmap(mapping, size);
+    return;
+  }
+
+  m_archive = mapping;
+  m_archiveSize = size;
+  m_archiveTime = archiveTime;
+  m_archiveEntries = std::move(entries);
+}
+
+void ResourceManager::readFile(const std::string &name, File &file) {
+  const std::filesystem::path path = m_directory / name;
+  std::error_code error;
+  const auto sourceTime = std::filesystem::last_write_time(path, error);
+
+  if (const auto archived = m_archiveEntries.find(name);
+      archived != m_archiveEntries.end() &&
+      (error || sourceTime < m_archiveTime)) {
+    file.bytes = archived->second;
+    file.done.store(true, std::memory_order_release);
+    return;
+  }
+
+  const auto size = error ? 0 : std::filesystem::file_size(path, error);
+  std::ifstream input(path, std::ios::binary);
+  if (error) {
+    file.error = error.message();
+  } else if (!input.is_open()) {
+    file.error = "Cannot open file";
+  } else {
+    file.storage.resize(size);
+    if (input.read(reinterpret_cast<char *>(file.storage.data()),
+                   static_cast<std::streamsize>(size))) {
+      file.bytes = file.storage;
+      m_readLooseFile.store(true, std::memory_order_release);
+    } else {
+      file.storage.clear();
+      file.error = "Cannot read file";
+    }
+  }
+  file.done.store(true, std::memory_order_release);
+}
+
+ResourceManager::File &ResourceManager::getFile(const std::string &name) {
+  std::lock_guard lock(m_mutex);
+  std::unique_ptr<File> &file = m_files[name];
+  if (!file) {
+    file = std::make_unique<File>();
+  }
+  return *file;
+}
+
+void ResourceManager::submitLocked(std::function<void()> job) {
+  m_requestCount.fetch_add(1, std::memory_order_release);
+  m_jobs.emplace_back([this, job = std::move(job)] {
+    job();
+    m_finishedCount.fetch_add(1, std::memory_order_release);
+  });
+  m_jobsChanged.notify_one();
+}
+
+void ResourceManager::workerLoop() {
+  while (true) {
+    std::function<void()> job;
+    {
+      std::unique_lock lock(m_mutex);
+      m_jobsChanged.wait(lock,
+                         [this] { return m_stopping || !m_jobs.empty(); });
+      if (m_stopping) {
+        return;
+      }
+      job = std::move(m_jobs.front());
+      m_jobs.pop_front();
+    }
+    job();
+  }
+}
+
+void ResourceManager::writeArchive(
+    const std::vector<std::pair<std::string, std::span<const std::byte>>>
+        &files) const {
+  size_t namesOffset = HEADER_SIZE + files.size() * ENTRY_SIZE;
+  size_t size = namesOffset;
+  for (const auto &[name, bytes] : files) {
+    size += name.size();
+  }
+  for (const auto &[name, bytes] : files) {
+    size = alignData(size) + bytes.size();
+  }
+  if (size > std::numeric_limits<uint32_t>::max()) {
+    return;
+  }
+
+  std::vector<std::byte> archive(size);
+  std::memcpy(archive.data(), MAGIC.data(), MAGIC.size());
+  writeInt(archive.data() + 8, static_cast<uint32_t>(files.size()));
+  writeInt(archive.data() + 12, 0);
+
+  size_t nameOffset = namesOffset;
+  size_t dataOffset = namesOffset;
+  for (const auto &[name, bytes] : files) {
+    dataOffset += name.size();
+  }
+  for (size_t i = 0; i < files.size(); i++) {
+    const auto &[name, bytes] = files[i];
+    dataOffset = alignData(dataOffset);
+
+    std::byte *entry = archive.data() + HEADER_SIZE + i * ENTRY_SIZE;
+    writeInt(entry, static_cast<uint32_t>(nameOffset));
+    writeInt(entry + 4, static_cast<uint32_t>(name.size()));
+    writeInt(entry + 8, static_cast<uint32_t>(dataOffset));
+    writeInt(entry + 12, static_cast<uint32_t>(bytes.size()));
+
+    std::memcpy(archive.data() + nameOffset, name.data(), name.size());
+    std::memcpy(archive.data() + dataOffset, bytes.data(), bytes.size());
+    nameOffset += name.size();
+    dataOffset += bytes.size();
+  }
+
+  const std::filesystem::path output = m_directory / ARCHIVE_NAME;
+  const std::filesystem::path temporary =
+      output.string() + ".tmp" + std::to_string(getpid());
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file.write(reinterpret_cast<const char *>(archive.data()),
+                    static_cast<std::streamsize>(archive.size()))) {
+      file.close();
+      std::error_code error;
+      std::filesystem::remove(temporary, error);
+      return;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporary, output, error);
+  if (error) {
+    std::filesystem::remove(temporary, error);
+  }
+}
+
+} // namespace Jetpack::Client
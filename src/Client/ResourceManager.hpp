@@ -0,0 +1,268 @@
+/**
+ * @file ResourceManager.hpp
+ * @brief Declaration of the ResourceManager class, which reads and decodes
+ *        client assets on a pool of worker threads.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Jetpack::Client {
+
+/**
+ * @class ResourceManager
+ * @brief Loads assets in parallel and keeps one decoded copy of each.
+ *
+ * Assets are requested by name, relative to the resource directory, and
+ * decoded by worker threads while the caller carries on; get() then hands
+ * out the shared result. Each file is read once however many assets
+ * decode it, and its bytes stay alive as long as the manager, so fonts
+ * and music may keep reading them.
+ *
+ * Files are read from a packed archive when one is present, which costs a
+ * single open and mmap() instead of one read per file. The archive is
+ * little-endian:
+ *
+ *     Magic (8) | Entry Count (4) | Reserved (4) |
+ *     Entries (16 * Entry Count) | Names | Data
+ *
+ * where each entry is Name Offset (4) | Name Length (4) | Data Offset (4)
+ * | Data Size (4), offsets counted from the start of the file. An entry
+ * is used unless its loose file is newer than the archive; whenever a
+ * loose file had to be read, saveArchive() writes a fresh archive beside
+ * them.
+ */
+class ResourceManager {
+public:
+  /** Name of the archive inside the resource directory. */
+  static constexpr const char *ARCHIVE_NAME = "assets.jpak";
+
+  /**
+   * @brief Maps the archive, if any, and starts the worker threads.
+   * @param directory Directory holding the loose files and the archive.
+   */
+  explicit ResourceManager(std::filesystem::path directory);
+
+  /** @brief Drops queued jobs, waits for running ones and unmaps. */
+  ~ResourceManager();
+
+  ResourceManager(const ResourceManager &) = delete;
+  ResourceManager &operator=(const ResourceManager &) = delete;
+  ResourceManager(ResourceManager &&) = delete;
+  ResourceManager &operator=(ResourceManager &&) = delete;
+
+  /**
+   * @brief Queues decoding an asset, unless it was already requested.
+   * @tparam T Type with loadFromMemory(data, size), such as sf::Image,
+   *           sf::SoundBuffer or sf::Font.
+   * @param name File name, relative to the resource directory.
+   */
+  template <typename T> void request(const std::string &name) {
+    requestAsset(typeid(T), name,
+                 [](const std::span<const std::byte> bytes)
+                     -> std::shared_ptr<const void> {
+                   auto asset = std::make_shared<T>();
+                   if (!asset->loadFromMemory(bytes.data(), bytes.size())) {
+                     return nullptr;
+                   }
+                   return asset;
+                 });
+  }
+
+  /**
+   * @brief Queues reading a file's bytes, unless already requested.
+   * @param name File name, relative to the resource directory.
+   */
+  void requestBytes(const std::string &name);
+
+  /**
+   * @brief Get a decoded asset, requesting it first if needed and waiting
+   *        for it.
+   * @tparam T Type of the asset, as for request().
+   * @param name File name, relative to the resource directory.
+   * @return The shared asset.
+   * @throws Shared::Exceptions::ResourceException if it cannot be read or
+   *         decoded.
+   */
+  template <typename T>
+  [[nodiscard]] std::shared_ptr<const T> get(const std::string &name) {
+    request<T>(name);
+    return std::static_pointer_cast<const T>(getAsset(typeid(T), name));
+  }
+
+  /**
+   * @brief Get a decoded asset like get(), reporting failure instead of
+   *        throwing.
+   * @tparam T Type of the asset, as for request().
+   * @param name File name, relative to the resource directory.
+   * @return The shared asset, or nullptr after printing why it failed.
+   */
+  template <typename T>
+  [[nodiscard]] std::shared_ptr<const T> find(const std::string &name) {
+    request<T>(name);
+    return std::static_pointer_cast<const T>(findAsset(typeid(T), name));
+  }
+
+  /**
+   * @brief Get a file's bytes, reading it on this thread if no worker has.
+   * @param name File name, relative to the resource directory.
+   * @return The bytes, valid for the manager's lifetime.
+   * @throws Shared::Exceptions::ResourceException if it cannot be read.
+   */
+  [[nodiscard]] std::span<const std::byte> getBytes(const std::string &name);
+
+  /** @return Number of requests queued so far. */
+  [[nodiscard]] size_t getRequestCount() const {
+    return m_requestCount.load(std::memory_order_acquire);
+  }
+
+  /** @return Number of requests done, successfully or not. */
+  [[nodiscard]] size_t getFinishedCount() const {
+    return m_finishedCount.load(std::memory_order_acquire);
+  }
+
+  /** @return True once every request so far is done. */
+  [[nodiscard]] bool isIdle() const {
+    return getFinishedCount() == getRequestCount();
+  }
+
+  /**
+   * @brief Queues writing every file read so far into a new archive, if
+   *        any of them came from a loose file.
+   *
+   * The archive is written to a temporary file and renamed into place,
+   * so the mapping of the current one stays valid; failure to write it,
+   * for instance in a read-only directory, is silent.
+   */
+  void saveArchive();
+
+private:
+  /**
+   * @struct File
+   * @brief A file's bytes, read once by whichever thread needs them first.
+   */
+  struct File {
+    std::once_flag read;
+    std::span<const std::byte> bytes;
+    /** Holds the bytes of a loose file; empty for archived ones. */
+    std::vector<std::byte> storage;
+    /** Why the file could not be read; empty on success. */
+    std::string error;
+    /** Set once the fields above are final. */
+    std::atomic<bool> done{false};
+  };
+
+  using AssetKey = std::pair<std::type_index, std::string>;
+  using Asset = std::shared_future<std::shared_ptr<const void>>;
+  /** Decodes a file's bytes; returns nullptr if they are invalid. */
+  using Decoder = std::shared_ptr<const void> (*)(std::span<const std::byte>);
+
+  /** Upper bound on worker threads; there are only a dozen assets. */
+  static constexpr unsigned MAX_WORKERS = 4;
+
+  /**
+   * @brief Queues decoding an asset, unless it was already requested.
+   * @param type    Type of the asset.
+   * @param name    File name, relative to the resource directory.
+   * @param decoder Makes the asset from the file's bytes.
+   */
+  void requestAsset(std::type_index type, const std::string &name,
+                    Decoder decoder);
+
+  /**
+   * @brief Waits for a requested asset.
+   * @param type Type of the asset.
+   * @param name File name, relative to the resource directory.
+   * @return The asset.
+   * @throws Shared::Exceptions::ResourceException if it failed to load.
+   */
+  [[nodiscard]] std::shared_ptr<const void> getAsset(std::type_index type,
+                                                     const std::string &name);
+
+  /**
+   * @brief Waits for a requested asset, reporting failure.
+   * @param type Type of the asset.
+   * @param name File name, relative to the resource directory.
+   * @return The asset, or nullptr after printing why it failed.
+   */
+  [[nodiscard]] std::shared_ptr<const void>
+  findAsset(std::type_index type, const std::string &name);
+
+  /**
+   * @brief Maps the archive and indexes its entries, if it is valid.
+   */
+  void mapArchive();
+
+  /**
+   * @brief Fills a file from the archive or from its loose file.
+   * @param name File name, relative to the resource directory.
+   * @param file Entry to fill.
+   */
+  void readFile(const std::string &name, File &file);
+
+  /**
+   * @brief Get the entry of a file, creating it if needed.
+   * @param name File name, relative to the resource directory.
+   * @return The entry, valid for the manager's lifetime.
+   */
+  File &getFile(const std::string &name);
+
+  /**
+   * @brief Queues a request's job for the workers, counting it towards
+   *        the progress; m_mutex must be held.
+   * @param job Job to run on a worker thread.
+   */
+  void submitLocked(std::function<void()> job);
+
+  /** @brief Runs queued jobs until the manager is destroyed. */
+  void workerLoop();
+
+  /**
+   * @brief Writes an archive holding the given files.
+   * @param files File names and bytes, sorted by name.
+   */
+  void writeArchive(
+      const std::vector<std::pair<std::string, std::span<const std::byte>>>
+          &files) const;
+
+  const std::filesystem::path m_directory;
+
+  const void *m_archive = nullptr;
+  size_t m_archiveSize = 0;
+  std::filesystem::file_time_type m_archiveTime;
+  /** Entries of the mapped archive; read-only once constructed. */
+  std::unordered_map<std::string, std::span<const std::byte>>
+      m_archiveEntries;
+
+  std::mutex m_mutex;
+  std::unordered_map<std::string, std::unique_ptr<File>> m_files;
+  std::map<AssetKey, Asset> m_assets;
+  std::deque<std::function<void()>> m_jobs;
+  std::condition_variable m_jobsChanged;
+  bool m_stopping = false;
+
+  std::atomic<size_t> m_requestCount{0};
+  std::atomic<size_t> m_finishedCount{0};
+  std::atomic<bool> m_readLooseFile{false};
+
+  std::vector<std::thread> m_workers;
+};
+
+} // namespace Jetpack::Client
@@ -7,46 +7,59 @@
 #include "../Shared/Exceptions.hpp"
 #include <format>
 #include <iostream>
+#include <span>
 
-Jetpack::Client::SoundManager::SoundManager() {
-  try {
-    if (!m_coinPickupBuffer.loadFromFile("./resources/coin_pickup_1.wav")) {
-      throw Shared::Exceptions::ResourceException(
-          std::filesystem::path("./resources/coin_pickup_1.wav"),
-          "No such file or directory");
-    }
-    if (!m_jetpackStartBuffer.loadFromFile("./resources/jetpack_start.wav")) {
-      throw Shared::Exceptions::ResourceException(
-          std::filesystem::path("./resources/jetpack_start.wav"),
-          "No such file or directory");
-    }
-    if (!m_jetpackLoopBuffer.loadFromFile("./resources/jetpack_lp.wav")) {
-      throw Shared::Exceptions::ResourceException(
-          std::filesystem::path("./resources/jetpack_lp.wav"), "NSo");
-    }
-    if (!m_jetpackStopBuffer.loadFromFile("./resources/jetpack_stop.wav")) {
-      throw Shared::Exceptions::ResourceException(
-          std::filesystem::path("./resources/jetpack_stop.wav"),
-          "No such file or directory");
-    }
-    if (!m_zapperBuffer.loadFromFile("./resources/dud_zapper_pop.wav")) {
-      throw Shared::Exceptions::ResourceException(
-          std::filesystem::path("./resources/dud_zapper_pop.wav"),
-          "No such file or directory");
-    }
+namespace {
 
-    m_coinPickupSound.setBuffer(m_coinPickupBuffer);
-    m_jetpackStartSound.setBuffer(m_jetpackStartBuffer);
-    m_jetpackLoopSound.setBuffer(m_jetpackLoopBuffer);
-    m_jetpackLoopSound.setLoop(true);
-    m_jetpackStopSound.setBuffer(m_jetpackStopBuffer);
-    m_zapperSound.setBuffer(m_zapperBuffer);
+constexpr const char *COIN_PICKUP = "coin_pickup_1.wav";
+constexpr const char *JETPACK_START = "jetpack_start.wav";
+constexpr const char *JETPACK_LOOP = "jetpack_lp.wav";
+constexpr const char *JETPACK_STOP = "jetpack_stop.wav";
+constexpr const char *ZAPPER = "dud_zapper_pop.wav";
+constexpr const char *THEME = "theme.ogg";
 
+} // namespace
+
+void Jetpack::Client::SoundManager::requestResources(
+    ResourceManager &resources) {
+  resources.request<sf::SoundBuffer>(COIN_PICKUP);
+  resources.request<sf::SoundBuffer>(JETPACK_START);
+  resources.request<sf::SoundBuffer>(JETPACK_LOOP);
+  resources.request<sf::SoundBuffer>(JETPACK_STOP);
+  resources.request<sf::SoundBuffer>(ZAPPER);
+  resources.requestBytes(THEME);
+}
+
+void Jetpack::Client::SoundManager::load(ResourceManager &resources) {
+  m_coinPickupBuffer = resources.find<sf::SoundBuffer>(COIN_PICKUP);
+  m_jetpackStartBuffer = resources.find<sf::SoundBuffer>(JETPACK_START);
+  m_jetpackLoopBuffer = resources.find<sf::SoundBuffer>(JETPACK_LOOP);
+  m_jetpackStopBuffer = resources.find<sf::SoundBuffer>(JETPACK_STOP);
+  m_zapperBuffer = resources.find<sf::SoundBuffer>(ZAPPER);
+
+  if (m_coinPickupBuffer) {
+    m_coinPickupSound.setBuffer(*m_coinPickupBuffer);
+  }
+  if (m_jetpackStartBuffer) {
+    m_jetpackStartSound.setBuffer(*m_jetpackStartBuffer);
+  }
+  if (m_jetpackLoopBuffer) {
+    m_jetpackLoopSound.setBuffer(*m_jetpackLoopBuffer);
+  }
+  m_jetpackLoopSound.setLoop(true);
+  if (m_jetpackStopBuffer) {
+    m_jetpackStopSound.setBuffer(*m_jetpackStopBuffer);
+  }
+  if (m_zapperBuffer) {
+    m_zapperSound.setBuffer(*m_zapperBuffer);
+  }
+
+  try {
+    const std::span<const std::byte> theme = resources.getBytes(THEME);
     m_gameMusic.emplace();
-    if (!m_gameMusic->openFromFile("./resources/theme.ogg")) {
+    if (!m_gameMusic->openFromMemory(theme.data(), theme.size())) {
       throw Shared::Exceptions::ResourceException(
-          std::filesystem::path("./resources/theme.ogg"),
-          "No such file or directory");
+          std::filesystem::path(THEME), "Cannot decode file");
     }
     m_gameMusic->setLoop(true);
     m_gameMusic->setVolume(50.0f);
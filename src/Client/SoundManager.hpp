@@ -5,7 +5,9 @@
 
 #pragma once
 
+#include "ResourceManager.hpp"
 #include <SFML/Audio.hpp>
+#include <memory>
 #include <optional>
 
 namespace Jetpack::Client {
@@ -19,13 +21,25 @@ namespace Jetpack::Client {
  */
 class SoundManager {
 public:
+  /** @brief Constructs a silent manager; load() gives it its sounds. */
+  SoundManager() = default;
+
   /**
-   * @brief Constructor that loads all audio resources.
+   * @brief Queues the sound effects and music for loading.
+   * @param resources Manager to load them with.
+   */
+  static void requestResources(ResourceManager &resources);
+
+  /**
+   * @brief Takes the loaded sound effects and starts the music.
+   *
+   * Each asset that failed to load is reported and stays silent; the
+   * others play normally.
    *
-   * Loads sound effects and music assets from the resources directory.
-   * May throw ResourceException if assets cannot be loaded.
+   * @param resources Manager the assets were requested from; must outlive
+   *                  this object, since the music streams from its bytes.
    */
-  SoundManager();
+  void load(ResourceManager &resources);
 
   /**
    * @brief Plays the coin pickup sound effect.
@@ -64,11 +78,11 @@ public:
   std::optional<sf::Music> &getGameMusic() { return m_gameMusic; }
 
 private:
-  sf::SoundBuffer m_coinPickupBuffer;
-  sf::SoundBuffer m_jetpackStartBuffer;
-  sf::SoundBuffer m_jetpackLoopBuffer;
-  sf::SoundBuffer m_jetpackStopBuffer;
-  sf::SoundBuffer m_zapperBuffer;
+  std::shared_ptr<const sf::SoundBuffer> m_coinPickupBuffer;
+  std::shared_ptr<const sf::SoundBuffer> m_jetpackStartBuffer;
+  std::shared_ptr<const sf::SoundBuffer> m_jetpackLoopBuffer;
+  std::shared_ptr<const sf::SoundBuffer> m_jetpackStopBuffer;
+  std::shared_ptr<const sf::SoundBuffer> m_zapperBuffer;
 
   sf::Sound m_coinPickupSound;
   sf::Sound m_jetpackStartSound;
@@ -0,0 +1,62 @@
+/**
+ * @file TripleBuffer.hpp
+ * @brief Lock-free single-producer, single-consumer triple buffer.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace Jetpack::Client {
+
+/**
+ * @class TripleBuffer
+ * @brief Hands the latest complete value from one thread to another
+ *        without locks or copies on the reading side.
+ *
+ * The writer fills back() and publish()es it; the reader acquire()s the
+ * most recent published value and may use it until its next acquire().
+ * Both sides exchange their slot with a shared middle slot through one
+ * atomic, so neither ever waits for the other. Intermediate values the
+ * reader never asked for are simply overwritten.
+ *
+ * @tparam T Slot type; slots are reused, so a writer that assigns into
+ *           back() keeps the capacity of its containers.
+ */
+template <typename T> class TripleBuffer {
+public:
+  /** @return The slot the writer fills next; writer thread only. */
+  [[nodiscard]] T &back() { return m_slots[m_back]; }
+
+  /** @brief Makes back() the latest value; writer thread only. */
+  void publish() {
+    m_back = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel) &
+             INDEX_MASK;
+  }
+
+  /**
+   * @brief Picks up the latest published value; reader thread only.
+   * @return The value, valid until the next call.
+   */
+  [[nodiscard]] const T &acquire() {
+    if (m_middle.load(std::memory_order_relaxed) & FRESH) {
+      m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) &
+                INDEX_MASK;
+    }
+    return m_slots[m_front];
+  }
+
+private:
+  /** Set in m_middle while it holds a value the reader has not taken. */
+  static constexpr uint8_t FRESH = 0x4;
+  static constexpr uint8_t INDEX_MASK = 0x3;
+
+  std::array<T, 3> m_slots{};
+  uint8_t m_back = 0;
+  std::atomic<uint8_t> m_middle{1};
+  uint8_t m_front = 2;
+};
+
+} // namespace Jetpack::Client
@@ -8,15 +8,21 @@
 #include <iostream>
 #include <optional>
 #include <string>
+#include <utility>
 
 void printUsage(const std::string &programName) {
-  std::cerr << std::format("Usage: {} -h <ip> -p <port> [-d]\n", programName);
+  std::cerr << std::format("Usage: {} -h <ip> -p <port> [-d] "
+                           "[-t <trace.pcap>] [-s <sampling>] [-S] [-u]\n",
+                           programName);
 }
 
 struct ClientOptions {
   std::string serverIp = "127.0.0.1";
   int serverPort = 8080;
   bool debugMode = false;
+  bool spectate = false;
+  bool datagrams = false;
+  Jetpack::Shared::TraceOptions trace;
 };
 
 std::optional<ClientOptions> parseCommandLine(const int argc, char *argv[]) {
@@ -40,6 +46,17 @@ std::optional<ClientOptions> parseCommandLine(const int argc, char *argv[]) {
       }
     } else if (arg == "-d") {
       options.debugMode = true;
+    } else if (arg == "-S") {
+      options.spectate = true;
+    } else if (arg == "-u") {
+      options.datagrams = true;
+    } else if (arg == "-t" && i + 1 < argc) {
+      options.trace.path = argv[++i];
+    } else if (arg == "-s" && i + 1 < argc) {
+      if (!options.trace.parseSampling(argv[++i])) {
+        std::cerr << "Error: Invalid trace sampling\n";
+        return std::nullopt;
+      }
     } else {
       printUsage(argv[0]);
       return std::nullopt;
@@ -58,6 +75,15 @@ int main(const int argc, char *argv[]) {
 
     Jetpack::Client::NetworkClient client(
         options->serverPort, options->serverIp, options->debugMode);
+    if (options->debugMode || !options->trace.path.empty()) {
+      client.enableTracing(std::move(options->trace));
+    }
+    if (options->spectate) {
+      client.enableSpectating();
+    }
+    if (options->datagrams) {
+      client.enableDatagrams();
+    }
 
     if (client.connectToServer()) {
       std::cout << std::format("Connected to server at {}:{}\n",
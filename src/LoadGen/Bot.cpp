@@ -0,0 +1,98 @@
+/**
+ * @file Bot.cpp
+ * @brief Implements the scripted headless player and its patterns.
+ */
+
+#include "Bot.hpp"
+#include <exception>
+
+namespace Jetpack::LoadGen {
+
+std::optional<JetpackPattern> JetpackPattern::parse(const std::string &text) {
+  if (text == "hold") {
+    return JetpackPattern{1, 0, std::nullopt};
+  }
+  if (text == "off") {
+    return JetpackPattern{0, 1, std::nullopt};
+  }
+
+  try {
+    if (text.starts_with("pulse:")) {
+      const size_t separator = text.find(':', 6);
+      if (separator == std::string::npos) {
+        return std::nullopt;
+      }
+      const int on = std::stoi(text.substr(6, separator - 6));
+      const int off = std::stoi(text.substr(separator + 1));
+      if (on < 0 || off < 0 || on + off == 0) {
+        return std::nullopt;
+      }
+      return JetpackPattern{on, off, std::nullopt};
+    }
+    if (text.starts_with("random:")) {
+      const int percent = std::stoi(text.substr(7));
+      if (percent < 0 || percent > 100) {
+        return std::nullopt;
+      }
+      return JetpackPattern{0, 1, percent};
+    }
+  } catch (const std::exception &) {
+    return std::nullopt;
+  }
+  return std::nullopt;
+}
+
+Bot::Bot(const int id, const JetpackPattern &pattern, LoadStats &stats)
+    : m_id(id), m_pattern(pattern), m_stats(stats),
+      m_random(static_cast<uint32_t>(id) * 2654435761u + 1) {}
+
+void Bot::advance(const uint64_t tick) {
+  if (m_pattern.randomPercent) {
+    // xorshift32: cheap, and deterministic per bot for repeatable runs.
+    m_random ^= m_random << 13;
+    m_random ^= m_random >> 17;
+    m_random ^= m_random << 5;
+    m_jetpackActive =
+        static_cast<int>(m_random % 100) < *m_pattern.randomPercent;
+    return;
+  }
+
+  const auto period =
+      static_cast<uint64_t>(m_pattern.onTicks + m_pattern.offTicks);
+  m_jetpackActive = (tick + static_cast<uint64_t>(m_id)) % period <
+                    static_cast<uint64_t>(m_pattern.onTicks);
+}
+
+void Bot::updateMap(const Shared::Protocol::GameMap &) {}
+
+void Bot::startMapStream(int, int, int) {}
+
+void Bot::addMapChunk(int, Shared::Protocol::GameMap) {}
+
+void Bot::updateGameState(const std::vector<Shared::Protocol::Player> &) {
+  const auto now = std::chrono::steady_clock::now();
+  if (m_lastUpdate) {
+    m_stats.stateInterval.record(
+        std::chrono::duration<double, std::milli>(now - *m_lastUpdate)
+            .count());
+  }
+  m_lastUpdate = now;
+  m_stats.stateUpdates++;
+}
+
+void Bot::updateLocalPlayer(const Shared::Protocol::Player &) {}
+
+void Bot::handleCoinCollected(int, int, int, int) {}
+
+void Bot::handlePlayerDeath(int) {}
+
+void Bot::handleGameOver(int) {
+  if (!m_gameOver) {
+    m_gameOver = true;
+    m_stats.gamesOver++;
+  }
+}
+
+bool Bot::isJetpackActive() const { return m_jetpackActive; }
+
+} // namespace Jetpack::LoadGen
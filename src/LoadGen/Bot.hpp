@@ -0,0 +1,86 @@
+/**
+ * @file Bot.hpp
+ * @brief Declaration of the Bot class, a scripted headless player, and
+ *        of the jetpack patterns it follows.
+ */
+
+#pragma once
+
+#include "../Client/GameView.hpp"
+#include "LoadStats.hpp"
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Jetpack::LoadGen {
+
+/**
+ * @struct JetpackPattern
+ * @brief When a bot holds its jetpack, one decision per input tick.
+ */
+struct JetpackPattern {
+  /** Ticks the jetpack is held, then released, in a repeating cycle. */
+  int onTicks = 1;
+  int offTicks = 0;
+  /** If set, each tick holds with this chance in percent instead. */
+  std::optional<int> randomPercent;
+
+  /**
+   * @brief Parses "hold", "off", "pulse:<on>:<off>" or "random:<percent>".
+   * @param text Pattern from the command line.
+   * @return The pattern, or std::nullopt if malformed.
+   */
+  static std::optional<JetpackPattern> parse(const std::string &text);
+};
+
+/**
+ * @class Bot
+ * @brief GameView of a headless player: presses the jetpack on a pattern
+ *        and measures the state updates it receives.
+ *
+ * Driven by one load generator thread, which owns the stats it writes.
+ */
+class Bot : public Client::GameView {
+public:
+  /**
+   * @param id      Bot number, used to offset its pattern and seed.
+   * @param pattern Jetpack pattern to follow.
+   * @param stats   Stats of the thread driving the bot.
+   */
+  Bot(int id, const JetpackPattern &pattern, LoadStats &stats);
+
+  /**
+   * @brief Decides the jetpack state for the next input.
+   * @param tick Input tick counter of the driving thread.
+   */
+  void advance(uint64_t tick);
+
+  /** @return True once the server has sent GAME_OVER. */
+  [[nodiscard]] bool isGameOver() const { return m_gameOver; }
+
+  void updateMap(const Shared::Protocol::GameMap &map) override;
+  void startMapStream(int width, int height, int chunkColumns) override;
+  void addMapChunk(int firstColumn,
+                   Shared::Protocol::GameMap columns) override;
+  void updateGameState(
+      const std::vector<Shared::Protocol::Player> &players) override;
+  void updateLocalPlayer(const Shared::Protocol::Player &player) override;
+  void handleCoinCollected(int playerId, int x, int y,
+                           int coinState) override;
+  void handlePlayerDeath(int playerId) override;
+  void handleGameOver(int winnerId) override;
+  [[nodiscard]] bool isJetpackActive() const override;
+
+private:
+  int m_id;
+  JetpackPattern m_pattern;
+  LoadStats &m_stats;
+  uint32_t m_random;
+  bool m_jetpackActive = false;
+  bool m_gameOver = false;
+  std::optional<std::chrono::steady_clock::time_point> m_lastUpdate;
+};
+
+} // namespace Jetpack::LoadGen
@@ -0,0 +1,196 @@
+/**
+ * @file LoadGenerator.cpp
+ * @brief Implements the multi-threaded bot driver.
+ */
+
+#include "LoadGenerator.hpp"
+#include "../Client/NetworkClient.hpp"
+#include "../Shared/Physics.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <sys/epoll.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace Jetpack::LoadGen {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/** One bot and the client that speaks for it. */
+struct BotSession {
+  std::shared_ptr<Bot> bot;
+  std::unique_ptr<Client::NetworkClient> client;
+  Clock::time_point connectStart;
+  bool joined = false;
+  bool alive = true;
+};
+
+/** Events fetched per epoll_wait() call. */
+constexpr int MAX_EVENTS = 256;
+
+/** How long a bot's CONNECT_RESPONSE is awaited before the next connects. */
+constexpr auto HANDSHAKE_TIMEOUT = std::chrono::seconds(1);
+
+} // namespace
+
+LoadGenerator::LoadGenerator(LoadOptions options)
+    : m_options(std::move(options)) {}
+
+LoadStats LoadGenerator::run() const {
+  std::vector<LoadStats> stats(static_cast<size_t>(m_options.threadCount));
+  std::vector<std::thread> threads;
+  threads.reserve(stats.size());
+  std::barrier connected(m_options.threadCount);
+
+  for (int i = 0; i < m_options.threadCount; i++) {
+    threads.emplace_back(&LoadGenerator::runThread, this, i,
+                         std::ref(stats[static_cast<size_t>(i)]),
+                         std::ref(connected));
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  LoadStats total;
+  for (const LoadStats &threadStats : stats) {
+    total.merge(threadStats);
+  }
+  return total;
+}
+
+void LoadGenerator::runThread(const int index, LoadStats &stats,
+                              std::barrier<> &connected) const {
+  const int epollFd = epoll_create1(EPOLL_CLOEXEC);
+  if (epollFd < 0) {
+    std::cerr << std::format("Error creating epoll instance: {}\n",
+                             strerror(errno));
+    connected.arrive_and_drop();
+    return;
+  }
+
+  std::vector<BotSession> sessions;
+  std::vector<epoll_event> events(MAX_EVENTS);
+
+  // Reads whatever the server sent the bots, waiting up to timeout for
+  // the first event; returns false when epoll itself failed.
+  const auto pollBots = [&](const Clock::duration timeout) {
+    const auto timeoutMs = std::chrono::ceil<std::chrono::milliseconds>(
+        std::max(timeout, Clock::duration::zero()));
+    const int ready = epoll_wait(epollFd, events.data(), MAX_EVENTS,
+                                 static_cast<int>(timeoutMs.count()));
+    if (ready < 0 && errno != EINTR) {
+      std::cerr << std::format("Error waiting for bots: {}\n",
+                               strerror(errno));
+      return false;
+    }
+
+    for (int i = 0; i < ready; i++) {
+      BotSession &session = sessions[events[i].data.u64];
+      if (!session.alive) {
+        continue;
+      }
+      if (!session.client->receiveFromServer()) {
+        session.alive = false;
+        stats.disconnected++;
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, session.client->getSocket(),
+                  nullptr);
+        continue;
+      }
+      if (!session.joined && session.client->getLocalPlayerId() != -1) {
+        session.joined = true;
+        stats.connected++;
+        stats.connectLatency.record(
+            std::chrono::duration<double, std::milli>(Clock::now() -
+                                                      session.connectStart)
+                .count());
+      }
+    }
+    return true;
+  };
+
+  bool healthy = true;
+  for (int id = index; healthy && id < m_options.botCount;
+       id += m_options.threadCount) {
+    BotSession session;
+    session.bot = std::make_shared<Bot>(id, m_options.pattern, stats);
+    session.client = std::make_unique<Client::NetworkClient>(
+        m_options.serverPort, m_options.serverIp, false);
+    session.client->setView(session.bot);
+    session.connectStart = Clock::now();
+
+    try {
+      if (!session.client->connectToServer()) {
+        stats.failed++;
+        continue;
+      }
+    } catch (const std::exception &e) {
+      if (stats.failed++ == 0) {
+        std::cerr << std::format("Bot {}: {}: {}\n", id, e.what(),
+                                 strerror(errno));
+      }
+      continue;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = sessions.size();
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, session.client->getSocket(), &event);
+    sessions.push_back(std::move(session));
+
+    // Wait for this bot's CONNECT_RESPONSE before the next one connects,
+    // so the latency covers its own handshake and not the bots after it.
+    const BotSession &connecting = sessions.back();
+    const auto handshakeDeadline = Clock::now() + HANDSHAKE_TIMEOUT;
+    while (healthy && connecting.alive && !connecting.joined &&
+           Clock::now() < handshakeDeadline) {
+      healthy = pollBots(handshakeDeadline - Clock::now());
+    }
+  }
+
+  // A thread that stops early ends its bots' matches under bots of the
+  // others, which would then count a game over.
+  connected.arrive_and_wait();
+
+  constexpr auto tickInterval = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(1.0 / Shared::Physics::TICK_RATE));
+  const auto deadline =
+      Clock::now() +
+      std::chrono::duration_cast<Clock::duration>(m_options.duration);
+  auto nextTick = Clock::now();
+  uint64_t tick = 0;
+
+  while (healthy && Clock::now() < deadline) {
+    if (Clock::now() >= nextTick) {
+      for (BotSession &session : sessions) {
+        if (session.alive && session.joined) {
+          session.bot->advance(tick);
+          session.client->sendPlayerInput();
+          stats.inputsSent++;
+        }
+      }
+      tick++;
+      nextTick += tickInterval;
+      if (nextTick < Clock::now()) {
+        nextTick = Clock::now() + tickInterval;
+      }
+    }
+
+    healthy = pollBots(std::min(nextTick, deadline) - Clock::now());
+  }
+
+  for (const BotSession &session : sessions) {
+    stats.bytesReceived += session.client->getBytesReceived();
+  }
+  ::close(epollFd);
+}
+
+} // namespace Jetpack::LoadGen
@@ -0,0 +1,63 @@
+/**
+ * @file LoadGenerator.hpp
+ * @brief Declaration of the LoadGenerator class, which runs many bots
+ *        against a server from a few threads.
+ */
+
+#pragma once
+
+#include "Bot.hpp"
+#include "LoadStats.hpp"
+#include <barrier>
+#include <chrono>
+#include <string>
+
+namespace Jetpack::LoadGen {
+
+/**
+ * @struct LoadOptions
+ * @brief What to run: where, how many bots, on how many threads, for how
+ *        long, and how they play.
+ */
+struct LoadOptions {
+  std::string serverIp = "127.0.0.1";
+  int serverPort = 8080;
+  int botCount = 100;
+  int threadCount = 4;
+  std::chrono::duration<double> duration{10.0};
+  JetpackPattern pattern;
+};
+
+/**
+ * @class LoadGenerator
+ * @brief Spreads bots over threads; each thread multiplexes its bots'
+ *        sockets with epoll and sends every bot's input at the tick rate,
+ *        like a real client would.
+ */
+class LoadGenerator {
+public:
+  /** @param options What to run. */
+  explicit LoadGenerator(LoadOptions options);
+
+  /**
+   * @brief Connects the bots, plays for the configured duration and
+   *        disconnects them.
+   * @return Stats of every thread, merged.
+   */
+  [[nodiscard]] LoadStats run() const;
+
+private:
+  /**
+   * @brief Runs the bots whose number is index modulo the thread count.
+   * @param index     Thread number.
+   * @param stats     Receives this thread's measurements.
+   * @param connected Reached once this thread's bots are connected, so
+   *        every thread plays over the same window.
+   */
+  void runThread(int index, LoadStats &stats,
+                 std::barrier<> &connected) const;
+
+  LoadOptions m_options;
+};
+
+} // namespace Jetpack::LoadGen
@@ -0,0 +1,136 @@
+/**
+ * @file LoadStats.hpp
+ * @brief Declaration of the latency histogram and the counters the load
+ *        generator collects per thread and merges at the end.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Jetpack::LoadGen {
+
+/**
+ * @class Histogram
+ * @brief Fixed-width buckets of durations in milliseconds.
+ *
+ * Recording is one increment, so a thread can record every state update
+ * of thousands of bots; percentiles are exact to one bucket.
+ */
+class Histogram {
+public:
+  /**
+   * @param bucketWidth Width of a bucket in milliseconds.
+   * @param bucketCount Number of buckets; larger samples share the last.
+   */
+  Histogram(const double bucketWidth, const size_t bucketCount)
+      : m_bucketWidth(bucketWidth), m_buckets(bucketCount) {}
+
+  /** @param milliseconds Sample to record. */
+  void record(const double milliseconds) {
+    const auto bucket = static_cast<size_t>(milliseconds / m_bucketWidth);
+    m_buckets[std::min(bucket, m_buckets.size() - 1)]++;
+    m_count++;
+    m_sum += milliseconds;
+    m_sumSquares += milliseconds * milliseconds;
+    m_max = std::max(m_max, milliseconds);
+  }
+
+  /** @param other Histogram with the same buckets, added to this one. */
+  void merge(const Histogram &other) {
+    for (size_t i = 0; i < m_buckets.size(); i++) {
+      m_buckets[i] += other.m_buckets[i];
+    }
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+    m_sumSquares += other.m_sumSquares;
+    m_max = std::max(m_max, other.m_max);
+  }
+
+  /** @return Number of samples. */
+  [[nodiscard]] uint64_t getCount() const { return m_count; }
+
+  /** @return Largest sample, or 0. */
+  [[nodiscard]] double getMax() const { return m_max; }
+
+  /** @return Mean of the samples, or 0. */
+  [[nodiscard]] double getMean() const {
+    return m_count != 0 ? m_sum / static_cast<double>(m_count) : 0.0;
+  }
+
+  /** @return Standard deviation of the samples, or 0. */
+  [[nodiscard]] double getStandardDeviation() const {
+    if (m_count == 0) {
+      return 0.0;
+    }
+    const double mean = getMean();
+    const double variance =
+        m_sumSquares / static_cast<double>(m_count) - mean * mean;
+    return std::sqrt(std::max(variance, 0.0));
+  }
+
+  /**
+   * @param fraction Rank wanted, in [0, 1].
+   * @return Upper edge of the bucket holding that rank, or 0.
+   */
+  [[nodiscard]] double getPercentile(const double fraction) const {
+    if (m_count == 0) {
+      return 0.0;
+    }
+    const auto rank = static_cast<uint64_t>(
+        std::ceil(fraction * static_cast<double>(m_count)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < m_buckets.size(); i++) {
+      seen += m_buckets[i];
+      if (seen >= std::max<uint64_t>(rank, 1)) {
+        return std::min(static_cast<double>(i + 1) * m_bucketWidth, m_max);
+      }
+    }
+    return m_max;
+  }
+
+private:
+  double m_bucketWidth;
+  std::vector<uint64_t> m_buckets;
+  uint64_t m_count = 0;
+  double m_sum = 0.0;
+  double m_sumSquares = 0.0;
+  double m_max = 0.0;
+};
+
+/**
+ * @struct LoadStats
+ * @brief Everything one load generator thread measured.
+ */
+struct LoadStats {
+  /** From connect() to CONNECT_RESPONSE; 0.1 ms buckets up to 5 s. */
+  Histogram connectLatency{0.1, 50000};
+  /** Between two state updates of one bot; 0.05 ms buckets up to 1 s. */
+  Histogram stateInterval{0.05, 20000};
+  uint64_t bytesReceived = 0;
+  uint64_t stateUpdates = 0;
+  uint64_t inputsSent = 0;
+  uint64_t connected = 0;
+  uint64_t failed = 0;
+  uint64_t disconnected = 0;
+  uint64_t gamesOver = 0;
+
+  /** @param other Stats of another thread, added to these. */
+  void merge(const LoadStats &other) {
+    connectLatency.merge(other.connectLatency);
+    stateInterval.merge(other.stateInterval);
+    bytesReceived += other.bytesReceived;
+    stateUpdates += other.stateUpdates;
+    inputsSent += other.inputsSent;
+    connected += other.connected;
+    failed += other.failed;
+    disconnected += other.disconnected;
+    gamesOver += other.gamesOver;
+  }
+};
+
+} // namespace Jetpack::LoadGen
@@ -0,0 +1,118 @@
+/**
+ * @file main.cpp
+ * @brief Entry point for the Jetpack headless load generator.
+ */
+
+#include "LoadGenerator.hpp"
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <string>
+
+void printUsage(const std::string &programName) {
+  std::cerr << std::format(
+      "Usage: {} -h <ip> -p <port> [-n <bots>] [-j <threads>] "
+      "[-t <seconds>] [-m <hold|off|pulse:<on>:<off>|random:<percent>>]\n",
+      programName);
+}
+
+std::optional<Jetpack::LoadGen::LoadOptions>
+parseCommandLine(const int argc, char *argv[]) {
+  Jetpack::LoadGen::LoadOptions options;
+  options.pattern = *Jetpack::LoadGen::JetpackPattern::parse("pulse:20:40");
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+
+    try {
+      if (arg == "-h" && i + 1 < argc) {
+        options.serverIp = argv[++i];
+      } else if (arg == "-p" && i + 1 < argc) {
+        options.serverPort = std::stoi(argv[++i]);
+        if (options.serverPort <= 0 || options.serverPort > 65535) {
+          std::cerr << "Error: Port number must be between 1 and 65535\n";
+          return std::nullopt;
+        }
+      } else if (arg == "-n" && i + 1 < argc) {
+        options.botCount = std::stoi(argv[++i]);
+        if (options.botCount <= 0) {
+          std::cerr << "Error: Bot count must be positive\n";
+          return std::nullopt;
+        }
+      } else if (arg == "-j" && i + 1 < argc) {
+        options.threadCount = std::stoi(argv[++i]);
+        if (options.threadCount <= 0) {
+          std::cerr << "Error: Thread count must be positive\n";
+          return std::nullopt;
+        }
+      } else if (arg == "-t" && i + 1 < argc) {
+        options.duration = std::chrono::duration<double>(std::stod(argv[++i]));
+        if (options.duration.count() <= 0.0) {
+          std::cerr << "Error: Duration must be positive\n";
+          return std::nullopt;
+        }
+      } else if (arg == "-m" && i + 1 < argc) {
+        const auto pattern =
+            Jetpack::LoadGen::JetpackPattern::parse(argv[++i]);
+        if (!pattern) {
+          std::cerr << std::format("Error: Invalid jetpack pattern '{}'\n",
+                                   argv[i]);
+          return std::nullopt;
+        }
+        options.pattern = *pattern;
+      } else {
+        printUsage(argv[0]);
+        return std::nullopt;
+      }
+    } catch (const std::exception &e) {
+      std::cerr << std::format("Error parsing {}: {}\n", arg, e.what());
+      return std::nullopt;
+    }
+  }
+
+  options.threadCount = std::min(options.threadCount, options.botCount);
+  return options;
+}
+
+void printReport(const Jetpack::LoadGen::LoadStats &stats,
+                 const double seconds) {
+  std::cout << std::format("bots: {} connected, {} failed, {} disconnected, "
+                           "{} saw game over\n",
+                           stats.connected, stats.failed, stats.disconnected,
+                           stats.gamesOver);
+  std::cout << std::format(
+      "connect latency (ms): mean {:.2f} p50 {:.2f} p99 {:.2f} max {:.2f}\n",
+      stats.connectLatency.getMean(), stats.connectLatency.getPercentile(0.5),
+      stats.connectLatency.getPercentile(0.99),
+      stats.connectLatency.getMax());
+  std::cout << std::format(
+      "state interval (ms): mean {:.2f} p50 {:.2f} p99 {:.2f} max {:.2f} "
+      "jitter {:.2f}\n",
+      stats.stateInterval.getMean(), stats.stateInterval.getPercentile(0.5),
+      stats.stateInterval.getPercentile(0.99), stats.stateInterval.getMax(),
+      stats.stateInterval.getStandardDeviation());
+  std::cout << std::format(
+      "throughput: {:.0f} state updates/s, {:.1f} KiB/s received, "
+      "{:.0f} inputs/s sent\n",
+      static_cast<double>(stats.stateUpdates) / seconds,
+      static_cast<double>(stats.bytesReceived) / 1024.0 / seconds,
+      static_cast<double>(stats.inputsSent) / seconds);
+}
+
+int main(const int argc, char *argv[]) {
+  auto options = parseCommandLine(argc, argv);
+  if (!options) {
+    return 1;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const Jetpack::LoadGen::LoadStats stats =
+      Jetpack::LoadGen::LoadGenerator(*options).run();
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  printReport(stats, elapsed.count());
+  return stats.connected > 0 ? 0 : 1;
+}
@@ -5,108 +5,364 @@
 
 #include "Broadcaster.hpp"
 #include <algorithm>
-#include <format>
-#include <iostream>
-#include <sys/socket.h>
+#include <array>
+#include <iterator>
 
 namespace Jetpack::Server {
 
 Broadcaster::Broadcaster(
+    PacketSink &sink,
     std::unordered_map<int, Shared::Protocol::Player> &serverPlayersReference,
-    const bool debugMode)
-    : m_serverPlayersReference(serverPlayersReference), m_debugMode(debugMode) {
+    const std::vector<int> &spectatorsReference)
+    : m_sink(sink), m_serverPlayersReference(serverPlayersReference),
+      m_spectatorsReference(spectatorsReference) {}
+
+/**
+ * @brief Reserves every history slot and the per-tick frame cache.
+ * @param players Most players a snapshot holds.
+ * @param viewers Most clients sent state in one tick.
+ */
+void Broadcaster::reserve(const size_t players, const size_t viewers) {
+  for (Shared::Protocol::StateSnapshot &snapshot : m_stateHistory) {
+    snapshot.players.reserve(players);
+  }
+  m_deltaFrames.reserve(viewers);
 }
 
 /**
- * @brief Sends a raw byte buffer to a client and optionally logs the result.
+ * @brief Queues a frame for a client.
  * @param clientSocket The file descriptor of the client socket.
- * @param data         The bytes to send.
+ * @param frame        The frame to send.
  */
 void Broadcaster::sendToClient(const int clientSocket,
-                               const std::vector<std::byte> &data) const {
-  const ssize_t bytesSent = send(clientSocket, data.data(), data.size(), 0);
-  const bool success = (bytesSent == static_cast<ssize_t>(data.size()));
-
-  if (m_debugMode) {
-    logDebugInfo(clientSocket, data, success);
-  }
+                               const Shared::Protocol::Frame &frame) const {
+  m_sink.queueFrame(clientSocket, frame);
 }
 
 /**
- * @brief Broadcasts a raw byte buffer to all connected clients.
- * @param data The buffer to broadcast.
+ * @brief Queues one shared frame for every player and spectator.
+ * @param frame The frame to broadcast.
  */
-void Broadcaster::broadcastToAll(const std::vector<std::byte> &data) const {
+void Broadcaster::broadcastToAll(const Shared::Protocol::Frame &frame) const {
   for (const auto &[playerSocket, _] : m_serverPlayersReference) {
-    sendToClient(playerSocket, data);
+    sendToClient(playerSocket, frame);
+  }
+  for (const int spectatorSocket : m_spectatorsReference) {
+    sendToClient(spectatorSocket, frame);
   }
 }
 
 /**
- * @brief Logs debug information for a send operation.
- * @param clientSocket The client socket descriptor.
- * @param data         The data buffer.
- * @param success      True if send succeeded.
+ * @brief Constructs a GAME_START packet.
+ * @return The shared frame.
  */
-void Broadcaster::logDebugInfo(int clientSocket,
-                               const std::vector<std::byte> &data,
-                               const bool success) {
-  if (success) {
-    std::cout << std::format("Debug: Sent {} bytes to client {}: ", data.size(),
-                             clientSocket);
-  } else {
-    std::cerr << std::format("Debug: Failed to send to client {}: ",
-                             clientSocket);
-  }
-  for (size_t i = 0; i < data.size(); i++) {
-    std::cout << std::format("{:02X} ", static_cast<unsigned char>(data[i]));
-  }
-  std::cout << std::endl;
+Shared::Protocol::Frame Broadcaster::buildGameStart() const {
+  Shared::Protocol::FrameBuilder packet(
+      m_sink.getFrameArena(), Shared::Protocol::PacketType::GAME_START, 2);
+  packet.addByte(static_cast<uint8_t>(m_serverPlayersReference.size()));
+  packet.addByte(static_cast<uint8_t>(0));
+  return packet.finish();
 }
 
 /**
  * @brief Constructs and broadcasts a GAME_START packet.
  */
 void Broadcaster::broadcastGameStart() const {
-  Shared::Protocol::NetworkPacket packet(
-      Shared::Protocol::PacketType::GAME_START);
-  packet.addByte(static_cast<uint8_t>(m_serverPlayersReference.size()));
-  packet.addByte(static_cast<uint8_t>(0));
-  broadcastToAll(packet.serialize());
+  broadcastToAll(buildGameStart());
 }
 
 /**
- * @brief Constructs and broadcasts a GAME_STATE_UPDATE packet containing
- *        each player's id, state, position, score, and jetpack status.
+ * @brief Constructs a GAME_START packet for a single client.
+ * @param clientSocket Destination descriptor.
  */
-void Broadcaster::broadcastGameState() const {
-  Shared::Protocol::NetworkPacket packet(
-      Shared::Protocol::PacketType::GAME_STATE_UPDATE);
+void Broadcaster::sendGameStart(const int clientSocket) const {
+  sendToClient(clientSocket, buildGameStart());
+}
 
-  packet.addByte(static_cast<uint8_t>(m_serverPlayersReference.size()));
+/**
+ * @brief Snapshots every player, stores the snapshot as a future delta
+ *        baseline, and sends it: one shared GAME_STATE_UPDATE for legacy
+ *        clients, and one GAME_STATE_DELTA or GAME_STATE_PACKED per
+ *        distinct baseline for delta clients.
+ */
+void Broadcaster::broadcastGameState() {
+  m_stateSequence++;
+  if (m_stateSequence == Shared::Protocol::NO_BASELINE) {
+    m_stateSequence++;
+  }
 
+  Shared::Protocol::StateSnapshot &current =
+      m_stateHistory[m_stateSequence % Shared::Protocol::STATE_HISTORY_SIZE];
+  current.sequence = m_stateSequence;
+  current.players.clear();
   for (const auto &[_, player] : m_serverPlayersReference) {
-    packet.addByte(static_cast<uint8_t>(player.getId()));
-    packet.addByte(static_cast<uint8_t>(player.getState()));
+    current.players.push_back(
+        Shared::Protocol::PlayerSnapshot::capture(player, m_unitsPerTile));
+  }
+
+  Shared::Protocol::Frame fullState;
+  m_deltaFrames.clear();
+
+  for (const auto &[playerSocket, _] : m_serverPlayersReference) {
+    sendGameState(playerSocket, current, fullState);
+  }
+  for (const int spectatorSocket : m_spectatorsReference) {
+    sendGameState(spectatorSocket, current, fullState);
+  }
+}
+
+/**
+ * @brief Sends legacy clients the shared GAME_STATE_UPDATE and delta
+ *        clients the frame for their baseline, building either once.
+ * @param clientSocket Destination descriptor.
+ * @param current      Snapshot being sent.
+ * @param fullState    GAME_STATE_UPDATE of this tick, built on first use.
+ */
+void Broadcaster::sendGameState(const int clientSocket,
+                                const Shared::Protocol::StateSnapshot &current,
+                                Shared::Protocol::Frame &fullState) {
+  const auto subscriber = m_deltaSubscribers.find(clientSocket);
+  if (subscriber == m_deltaSubscribers.end()) {
+    if (fullState.empty()) {
+      fullState = buildFullState(current);
+    }
+    sendToClient(clientSocket, fullState);
+    return;
+  }
 
-    const int16_t xFixedPrecision =
-        static_cast<int16_t>(player.getPosition().x * 100);
-    const int16_t yFixedPrecision =
-        static_cast<int16_t>(player.getPosition().y * 100);
+  DeltaSubscriber &client = subscriber->second;
+  const Shared::Protocol::StateSnapshot *baseline =
+      Shared::Protocol::findSnapshot(m_stateHistory, client.ackedSequence);
+  if (static_cast<uint16_t>(m_stateSequence - client.lastKeyframe) >=
+      KEYFRAME_INTERVAL) {
+    baseline = nullptr;
+  }
+
+  const uint16_t baselineSequence =
+      baseline != nullptr ? baseline->sequence : Shared::Protocol::NO_BASELINE;
+  if (baseline == nullptr) {
+    client.lastKeyframe = m_stateSequence;
+  }
 
-    packet.addShort(static_cast<uint16_t>(xFixedPrecision));
-    packet.addShort(static_cast<uint16_t>(yFixedPrecision));
+  auto cached = std::ranges::find_if(
+      m_deltaFrames, [baselineSequence, &client](const DeltaFrame &frame) {
+        return frame.baseline == baselineSequence &&
+               frame.packed == client.packed;
+      });
+  if (cached == m_deltaFrames.end()) {
+    m_deltaFrames.push_back({baselineSequence, client.packed,
+                             client.packed ? buildPackedDelta(current, baseline)
+                                           : buildDelta(current, baseline)});
+    cached = std::prev(m_deltaFrames.end());
+  }
+  sendToClient(clientSocket, cached->frame);
+}
 
-    packet.addShort(static_cast<uint16_t>(player.getScore()));
-    packet.addByte(static_cast<uint8_t>(player.isJetpacking() ? 1 : 0));
+/**
+ * @brief Constructs a GAME_STATE_UPDATE packet containing each player's
+ *        id, state, position, score, and jetpack status.
+ * @param current Snapshot to serialize.
+ * @return The shared frame.
+ */
+Shared::Protocol::Frame Broadcaster::buildFullState(
+    const Shared::Protocol::StateSnapshot &current) const {
+  Shared::Protocol::FrameBuilder packet(
+      m_sink.getFrameArena(), Shared::Protocol::PacketType::GAME_STATE_UPDATE,
+      1 + current.players.size() * PLAYER_STATE_SIZE);
+
+  packet.addByte(static_cast<uint8_t>(current.players.size()));
+
+  for (const Shared::Protocol::PlayerSnapshot &player : current.players) {
+    packet.addByte(static_cast<uint8_t>(player.id));
+    packet.addByte(player.state);
+    packet.addShort(static_cast<uint16_t>(
+        Shared::Protocol::toLegacyPosition(player.x, m_unitsPerTile)));
+    packet.addShort(static_cast<uint16_t>(
+        Shared::Protocol::toLegacyPosition(player.y, m_unitsPerTile)));
+    packet.addShort(static_cast<uint16_t>(player.score));
+    packet.addByte(player.jetpack);
     packet.addByte(0);
   }
 
-  broadcastToAll(packet.serialize());
+  return packet.finish();
 }
 
 /**
- * @brief Constructs and broadcasts a COIN_COLLECTED event.
+ * @brief Constructs a GAME_STATE_DELTA packet: header, then an entry only
+ *        for players whose quantized record differs from the baseline.
+ * @param current  Snapshot to serialize.
+ * @param baseline Snapshot the recipients hold, or nullptr for a keyframe.
+ * @return The frame.
+ */
+Shared::Protocol::Frame
+Broadcaster::buildDelta(const Shared::Protocol::StateSnapshot &current,
+                        const Shared::Protocol::StateSnapshot *baseline) const {
+  const auto maskFor = [baseline](const Shared::Protocol::PlayerSnapshot &p) {
+    return Shared::Protocol::computeDeltaMask(
+        baseline != nullptr ? baseline->find(p.id) : nullptr, p);
+  };
+
+  size_t payloadSize = Shared::Protocol::DELTA_HEADER_SIZE - 1;
+  uint8_t entryCount = 0;
+  for (const Shared::Protocol::PlayerSnapshot &player : current.players) {
+    const uint8_t mask = maskFor(player);
+    if (mask != 0) {
+      payloadSize += 2 + Shared::Protocol::getDeltaFieldsSize(mask);
+      entryCount++;
+    }
+  }
+
+  Shared::Protocol::FrameBuilder packet(
+      m_sink.getFrameArena(), Shared::Protocol::PacketType::GAME_STATE_DELTA,
+      payloadSize);
+  packet.addShort(current.sequence);
+  packet.addShort(baseline != nullptr ? baseline->sequence
+                                      : Shared::Protocol::NO_BASELINE);
+  packet.addByte(entryCount);
+
+  for (const Shared::Protocol::PlayerSnapshot &player : current.players) {
+    const uint8_t mask = maskFor(player);
+    if (mask != 0) {
+      Shared::Protocol::writePlayerDelta(packet.getWriter(), mask, player,
+                                         m_unitsPerTile);
+    }
+  }
+
+  return packet.finish();
+}
+
+/**
+ * @brief Constructs a GAME_STATE_PACKED packet: the GAME_STATE_DELTA
+ *        entries with varint fields, positions relative to the player's
+ *        baseline record or, lacking one, to the match origin.
+ * @param current  Snapshot to serialize.
+ * @param baseline Snapshot the recipients hold, or nullptr for a keyframe.
+ * @return The frame.
+ */
+Shared::Protocol::Frame Broadcaster::buildPackedDelta(
+    const Shared::Protocol::StateSnapshot &current,
+    const Shared::Protocol::StateSnapshot *baseline) const {
+  const auto referenceFor =
+      [baseline](const Shared::Protocol::PlayerSnapshot &p)
+      -> const Shared::Protocol::PlayerSnapshot * {
+    return baseline != nullptr ? baseline->find(p.id) : nullptr;
+  };
+
+  size_t payloadSize = Shared::Protocol::PACKED_HEADER_SIZE - 1;
+  uint32_t entryCount = 0;
+  for (const Shared::Protocol::PlayerSnapshot &player : current.players) {
+    const Shared::Protocol::PlayerSnapshot *reference = referenceFor(player);
+    const uint8_t mask = Shared::Protocol::computeDeltaMask(reference, player);
+    if (mask != 0) {
+      payloadSize += Shared::Protocol::getPackedDeltaSize(
+          mask, player, reference != nullptr ? *reference : m_origin);
+      entryCount++;
+    }
+  }
+  payloadSize += Shared::Protocol::getVarintSize(entryCount);
+
+  Shared::Protocol::FrameBuilder packet(
+      m_sink.getFrameArena(), Shared::Protocol::PacketType::GAME_STATE_PACKED,
+      payloadSize);
+  packet.addShort(current.sequence);
+  packet.addShort(baseline != nullptr ? baseline->sequence
+                                      : Shared::Protocol::NO_BASELINE);
+  packet.addVarint(entryCount);
+
+  for (const Shared::Protocol::PlayerSnapshot &player : current.players) {
+    const Shared::Protocol::PlayerSnapshot *reference = referenceFor(player);
+    const uint8_t mask = Shared::Protocol::computeDeltaMask(reference, player);
+    if (mask != 0) {
+      Shared::Protocol::writePackedDelta(
+          packet.getWriter(), mask, player,
+          reference != nullptr ? *reference : m_origin);
+    }
+  }
+
+  return packet.finish();
+}
+
+/**
+ * @brief Quantizes the origin with the precision so keyframes are
+ *        relative to a value the clients can rebuild exactly.
+ * @param unitsPerTile Position units per tile.
+ * @param origin       Position keyframes are relative to.
+ */
+void Broadcaster::setStateEncoding(const uint16_t unitsPerTile,
+                                   const Shared::Protocol::Position origin) {
+  m_unitsPerTile = unitsPerTile;
+  m_origin.x = static_cast<int32_t>(origin.x * unitsPerTile);
+  m_origin.y = static_cast<int32_t>(origin.y * unitsPerTile);
+}
+
+/**
+ * @brief Registers a client for GAME_STATE_DELTA; its first update is a
+ *        keyframe since it has acknowledged nothing yet.
+ * @param clientSocket Client that advertised the capability.
+ */
+void Broadcaster::enableDeltaState(const int clientSocket) {
+  m_deltaSubscribers.try_emplace(clientSocket);
+}
+
+/**
+ * @brief Registers a client for GAME_STATE_PACKED and sends STATE_ENCODING
+ *        ahead of the first update.
+ * @param clientSocket Client that advertised the capability.
+ */
+void Broadcaster::enablePackedState(const int clientSocket) {
+  m_deltaSubscribers[clientSocket].packed = true;
+
+  Shared::Protocol::FrameBuilder packet(
+      m_sink.getFrameArena(), Shared::Protocol::PacketType::STATE_ENCODING,
+      Shared::Protocol::STATE_ENCODING_SIZE - 1);
+  packet.addShort(m_unitsPerTile);
+  packet.addInt(static_cast<uint32_t>(m_origin.x));
+  packet.addInt(static_cast<uint32_t>(m_origin.y));
+  sendToClient(clientSocket, packet.finish());
+}
+
+/**
+ * @param clientSocket Client to look up.
+ * @return True if the client receives the packed revision.
+ */
+bool Broadcaster::usesPackedState(const int clientSocket) const {
+  const auto subscriber = m_deltaSubscribers.find(clientSocket);
+  return subscriber != m_deltaSubscribers.end() && subscriber->second.packed;
+}
+
+/**
+ * @brief Moves a client's baseline forward; stale, duplicate or unknown
+ *        sequence numbers are ignored.
+ * @param clientSocket Client sending STATE_ACK.
+ * @param sequence     Sequence number acknowledged.
+ */
+void Broadcaster::acknowledgeState(const int clientSocket,
+                                   const uint16_t sequence) {
+  const auto subscriber = m_deltaSubscribers.find(clientSocket);
+  if (subscriber == m_deltaSubscribers.end() ||
+      Shared::Protocol::findSnapshot(m_stateHistory, sequence) == nullptr) {
+    return;
+  }
+
+  uint16_t &acked = subscriber->second.ackedSequence;
+  if (acked == Shared::Protocol::NO_BASELINE ||
+      Shared::Protocol::isSequenceNewer(sequence, acked)) {
+    acked = sequence;
+  }
+}
+
+/**
+ * @brief Drops the delta state of a departing client.
+ * @param clientSocket Client being removed.
+ */
+void Broadcaster::removeClient(const int clientSocket) {
+  m_deltaSubscribers.erase(clientSocket);
+}
+
+/**
+ * @brief Constructs and broadcasts a COIN_COLLECTED event, and its
+ *        COIN_COLLECTED_PACKED form for clients of the packed revision;
+ *        each is built once, on first use.
  * @param playerId Identifier of the player who collected the coin.
  * @param x        X coordinate of the coin.
  * @param y        Y coordinate of the coin.
@@ -123,15 +379,51 @@ void Broadcaster::broadcastCoinCollected(int playerId, int x, int y,
     score = playerIt->second.getScore();
   }
 
-  Shared::Protocol::NetworkPacket packet(
-      Shared::Protocol::PacketType::COIN_COLLECTED);
-  packet.addByte(static_cast<uint8_t>(playerId));
-  packet.addByte(static_cast<uint8_t>(x));
-  packet.addByte(static_cast<uint8_t>(y));
-  packet.addByte(static_cast<uint8_t>(score));
-  packet.addByte(static_cast<uint8_t>(coinState));
+  Shared::Protocol::Frame legacy;
+  Shared::Protocol::Frame packed;
+  const auto send = [&](const int clientSocket) {
+    if (!usesPackedState(clientSocket)) {
+      if (legacy.empty()) {
+        Shared::Protocol::FrameBuilder packet(
+            m_sink.getFrameArena(),
+            Shared::Protocol::PacketType::COIN_COLLECTED, 5);
+        packet.addByte(static_cast<uint8_t>(playerId));
+        packet.addByte(static_cast<uint8_t>(x));
+        packet.addByte(static_cast<uint8_t>(y));
+        packet.addByte(static_cast<uint8_t>(score));
+        packet.addByte(static_cast<uint8_t>(coinState));
+        legacy = packet.finish();
+      }
+      sendToClient(clientSocket, legacy);
+      return;
+    }
+
+    if (packed.empty()) {
+      const std::array<uint32_t, 4> fields = {
+          static_cast<uint32_t>(playerId), static_cast<uint32_t>(x),
+          static_cast<uint32_t>(y), static_cast<uint32_t>(score)};
+      size_t payloadSize = 1;
+      for (const uint32_t field : fields) {
+        payloadSize += Shared::Protocol::getVarintSize(field);
+      }
+      Shared::Protocol::FrameBuilder packet(
+          m_sink.getFrameArena(),
+          Shared::Protocol::PacketType::COIN_COLLECTED_PACKED, payloadSize);
+      for (const uint32_t field : fields) {
+        packet.addVarint(field);
+      }
+      packet.addByte(static_cast<uint8_t>(coinState));
+      packed = packet.finish();
+    }
+    sendToClient(clientSocket, packed);
+  };
 
-  broadcastToAll(packet.serialize());
+  for (const auto &[playerSocket, _] : m_serverPlayersReference) {
+    send(playerSocket);
+  }
+  for (const int spectatorSocket : m_spectatorsReference) {
+    send(spectatorSocket);
+  }
 }
 
 /**
@@ -139,10 +431,10 @@ void Broadcaster::broadcastCoinCollected(int playerId, int x, int y,
  * @param playerId Identifier of the player who died.
  */
 void Broadcaster::broadcastPlayerDeath(int playerId) const {
-  Shared::Protocol::NetworkPacket packet(
-      Shared::Protocol::PacketType::PLAYER_DEATH);
+  Shared::Protocol::FrameBuilder packet(
+      m_sink.getFrameArena(), Shared::Protocol::PacketType::PLAYER_DEATH, 1);
   packet.addByte(static_cast<uint8_t>(playerId));
-  broadcastToAll(packet.serialize());
+  broadcastToAll(packet.finish());
 }
 
 /**
@@ -152,12 +444,12 @@ void Broadcaster::broadcastPlayerDeath(int playerId) const {
 void Broadcaster::broadcastGameOver(int winnerId) const {
   const bool hasWinner = (winnerId > 0);
 
-  Shared::Protocol::NetworkPacket packet(
-      Shared::Protocol::PacketType::GAME_OVER);
+  Shared::Protocol::FrameBuilder packet(
+      m_sink.getFrameArena(), Shared::Protocol::PacketType::GAME_OVER, 2);
   packet.addByte(static_cast<uint8_t>(hasWinner ? 1 : 0));
   packet.addByte(static_cast<uint8_t>(hasWinner ? winnerId : 0));
 
-  broadcastToAll(packet.serialize());
+  broadcastToAll(packet.finish());
 }
 
 } // namespace Jetpack::Server
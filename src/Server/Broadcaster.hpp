@@ -6,8 +6,12 @@
 
 #pragma once
 
+#include "../Shared/Frame.hpp"
 #include "../Shared/Protocol.hpp"
-#include <sys/socket.h>
+#include "../Shared/StateDelta.hpp"
+#include "PacketSink.hpp"
+#include <cstdint>
+#include <span>
 #include <unordered_map>
 #include <vector>
 
@@ -17,37 +21,113 @@ namespace Jetpack::Server {
  * @class Broadcaster
  * @brief Handles sending and broadcasting game‐related network packets
  *        to all connected clients.
+ *
+ * Each packet is serialized once into a shared Frame and handed to a
+ * PacketSink, which queues a reference per client and coalesces
+ * everything produced during a tick into one write.
+ *
+ * Clients that negotiated CAPABILITY_DELTA_STATE receive GAME_STATE_DELTA
+ * instead of GAME_STATE_UPDATE: only the fields that changed since the
+ * last snapshot they acknowledged, with a full keyframe at least every
+ * KEYFRAME_INTERVAL ticks. Clients sharing a baseline share the frame.
+ *
+ * Clients that negotiated CAPABILITY_PACKED_STATE get the same deltas as
+ * GAME_STATE_PACKED, whose varint fields hold any map or score: the
+ * match's precision and origin go out once in STATE_ENCODING, and
+ * COIN_COLLECTED_PACKED replaces COIN_COLLECTED.
+ *
+ * Spectators receive every broadcast the players do; a frame is built
+ * once however many of them watch.
  */
 class Broadcaster {
 public:
   /**
    * @brief Constructs a Broadcaster.
+   * @param sink Destination of every outbound packet.
    * @param serverPlayersReference Reference to the map of client sockets
    *        to Player objects.
-   * @param debugMode When true, logs raw packet bytes and send results
-   *        to stdout/stderr.
+   * @param spectatorsReference Reference to the sockets of the spectators.
    */
-  Broadcaster(
-      std::unordered_map<int, Shared::Protocol::Player> &serverPlayersReference,
-      bool debugMode = false);
+  Broadcaster(PacketSink &sink,
+              std::unordered_map<int, Shared::Protocol::Player>
+                  &serverPlayersReference,
+              const std::vector<int> &spectatorsReference);
+
+  /** Serialized size of one player entry in GAME_STATE_UPDATE. */
+  static constexpr size_t PLAYER_STATE_SIZE = 10;
+
+  /** Most ticks a delta client goes without a full keyframe. */
+  static constexpr uint16_t KEYFRAME_INTERVAL = 120;
+
+  /**
+   * @brief Sizes the snapshot history and frame cache up front so that
+   *        broadcasting never allocates once a match is running.
+   * @param players Most players a snapshot holds.
+   * @param viewers Most clients, players and spectators, sent state.
+   */
+  void reserve(size_t players, size_t viewers);
+
+  /**
+   * @brief Sets the fixed-point precision and origin of every snapshot;
+   *        called before any client subscribes.
+   * @param unitsPerTile Position units per tile.
+   * @param origin       Position GAME_STATE_PACKED keyframes are relative
+   *                     to, such as the spawn point.
+   */
+  void setStateEncoding(uint16_t unitsPerTile,
+                        Shared::Protocol::Position origin);
+
+  /**
+   * @brief Switches a client to delta-compressed state updates.
+   * @param clientSocket Client that advertised CAPABILITY_DELTA_STATE.
+   */
+  void enableDeltaState(int clientSocket);
 
   /**
-   * @brief Sends a raw byte buffer to a single client.
+   * @brief Switches a client to GAME_STATE_PACKED and sends it the
+   *        STATE_ENCODING its decoder needs.
+   * @param clientSocket Client that advertised CAPABILITY_PACKED_STATE.
+   */
+  void enablePackedState(int clientSocket);
+
+  /**
+   * @brief Records that a client holds a snapshot, making it a baseline.
+   * @param clientSocket Client sending STATE_ACK.
+   * @param sequence     Sequence number acknowledged.
+   */
+  void acknowledgeState(int clientSocket, uint16_t sequence);
+
+  /**
+   * @brief Forgets the delta state of a departing client.
+   * @param clientSocket Client being removed.
+   */
+  void removeClient(int clientSocket);
+
+  /**
+   * @brief Queues a frame for a single client.
    * @param clientSocket The file descriptor of the client socket.
-   * @param data The bytes to send.
+   * @param frame The frame to send.
    */
-  void sendToClient(int clientSocket, const std::vector<std::byte> &data) const;
+  void sendToClient(int clientSocket,
+                    const Shared::Protocol::Frame &frame) const;
 
   /**
    * @brief Broadcasts a GAME_START packet to all clients.
    */
   void broadcastGameStart() const;
 
+  /**
+   * @brief Sends GAME_START to one client, such as a spectator joining a
+   *        match already under way.
+   * @param clientSocket Destination descriptor.
+   */
+  void sendGameStart(int clientSocket) const;
+
   /**
    * @brief Broadcasts the current game state (positions, scores, etc.)
-   *        to all clients.
+   *        to all clients, as a full update or a delta per client.
    */
-  void broadcastGameState() const;
+  void broadcastGameState();
 
   /**
    * @brief Broadcasts a COIN_COLLECTED event to all clients.
@@ -73,22 +153,91 @@ public:
 
 private:
   /**
-   * @brief Sends raw data to every connected client.
-   * @param data The buffer to broadcast.
+   * @brief Queues the same frame for every connected client.
+   * @param frame The frame to broadcast.
+   */
+  void broadcastToAll(const Shared::Protocol::Frame &frame) const;
+
+  /** @return A GAME_START frame carrying the player count. */
+  [[nodiscard]] Shared::Protocol::Frame buildGameStart() const;
+
+  /**
+   * @brief Sends one client the current snapshot, as a full update or a
+   *        delta against its baseline.
+   * @param clientSocket Destination descriptor.
+   * @param current      Snapshot being sent.
+   * @param fullState    GAME_STATE_UPDATE of this tick, built on first use.
+   */
+  void sendGameState(int clientSocket,
+                     const Shared::Protocol::StateSnapshot &current,
+                     Shared::Protocol::Frame &fullState);
+
+  /**
+   * @brief Serializes every player into one GAME_STATE_UPDATE.
+   * @return The shared frame.
+   */
+  [[nodiscard]] Shared::Protocol::Frame
+  buildFullState(const Shared::Protocol::StateSnapshot &current) const;
+
+  /**
+   * @brief Serializes a GAME_STATE_DELTA against a baseline.
+   * @param current  Snapshot being sent.
+   * @param baseline Snapshot the client holds, or nullptr for a keyframe.
+   * @return The frame.
    */
-  void broadcastToAll(const std::vector<std::byte> &data) const;
+  [[nodiscard]] Shared::Protocol::Frame
+  buildDelta(const Shared::Protocol::StateSnapshot &current,
+             const Shared::Protocol::StateSnapshot *baseline) const;
 
   /**
-   * @brief Logs debug information about a send operation.
-   * @param clientSocket The socket descriptor used.
-   * @param data         The data that was (attempted) sent.
-   * @param success      True if the send succeeded.
+   * @brief Serializes a GAME_STATE_PACKED against a baseline.
+   * @param current  Snapshot being sent.
+   * @param baseline Snapshot the client holds, or nullptr for a keyframe.
+   * @return The frame.
    */
-  static void logDebugInfo(int clientSocket, const std::vector<std::byte> &data,
-                           bool success);
+  [[nodiscard]] Shared::Protocol::Frame
+  buildPackedDelta(const Shared::Protocol::StateSnapshot &current,
+                   const Shared::Protocol::StateSnapshot *baseline) const;
 
+  /**
+   * @param clientSocket Client to look up.
+   * @return True if the client negotiated CAPABILITY_PACKED_STATE.
+   */
+  [[nodiscard]] bool usesPackedState(int clientSocket) const;
+
+  /**
+   * @struct DeltaSubscriber
+   * @brief Acknowledgement state of a delta client.
+   */
+  struct DeltaSubscriber {
+    uint16_t ackedSequence = Shared::Protocol::NO_BASELINE;
+    uint16_t lastKeyframe = Shared::Protocol::NO_BASELINE;
+    /** Sent GAME_STATE_PACKED rather than GAME_STATE_DELTA. */
+    bool packed = false;
+  };
+
+  /**
+   * @struct DeltaFrame
+   * @brief A delta built this tick, shared by clients on its baseline.
+   */
+  struct DeltaFrame {
+    uint16_t baseline;
+    bool packed;
+    Shared::Protocol::Frame frame;
+  };
+
+  PacketSink &m_sink;
   std::unordered_map<int, Shared::Protocol::Player> &m_serverPlayersReference;
-  bool m_debugMode = false;
+  const std::vector<int> &m_spectatorsReference;
+
+  uint16_t m_unitsPerTile = Shared::Protocol::LEGACY_POSITION_SCALE;
+  /** Reference of keyframe positions; only x and y are used. */
+  Shared::Protocol::PlayerSnapshot m_origin;
+
+  Shared::Protocol::StateHistory m_stateHistory;
+  uint16_t m_stateSequence = Shared::Protocol::NO_BASELINE;
+  std::unordered_map<int, DeltaSubscriber> m_deltaSubscribers;
+  std::vector<DeltaFrame> m_deltaFrames;
 };
 
 } // namespace Jetpack::Server
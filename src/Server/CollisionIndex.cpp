@@ -0,0 +1,119 @@
+/**
+ * @file CollisionIndex.cpp
+ * @brief Implements the column-bucketed obstacle index and swept tests.
+ */
+
+#include "CollisionIndex.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+/**
+ * @brief Narrows [enter, exit] to the part of a motion during which one
+ *        coordinate lies inside [lo, hi).
+ * @param start Coordinate at the start of the motion.
+ * @param delta Change of the coordinate over the motion.
+ * @param lo    Lower bound of the slab.
+ * @param hi    Upper bound of the slab.
+ * @param enter Earliest fraction of the motion still overlapping.
+ * @param exit  Latest fraction of the motion still overlapping.
+ * @return False if the motion never overlaps the slab in [enter, exit].
+ */
+bool clipToSlab(const float start, const float delta, const float lo,
+                const float hi, float &enter, float &exit) {
+  if (delta == 0.0f) {
+    return start >= lo && start < hi;
+  }
+
+  float near = (lo - start) / delta;
+  float far = (hi - start) / delta;
+  if (near > far) {
+    std::swap(near, far);
+  }
+  enter = std::max(enter, near);
+  exit = std::min(exit, far);
+  return enter <= exit;
+}
+
+} // namespace
+
+namespace Jetpack::Server {
+
+CollisionIndex::CollisionIndex(
+    const int width, const int height,
+    const std::span<const Shared::Protocol::TileType> tiles)
+    : m_width(width), m_columnStarts(static_cast<size_t>(width) + 1, 0) {
+  const auto isObstacle = [](const Shared::Protocol::TileType tile) {
+    return tile == Shared::Protocol::TileType::COIN ||
+           tile == Shared::Protocol::TileType::ELECTRICSQUARE;
+  };
+
+  for (size_t cell = 0; cell < tiles.size(); cell++) {
+    if (isObstacle(tiles[cell])) {
+      m_columnStarts[cell % width + 1]++;
+    }
+  }
+  for (int x = 0; x < width; x++) {
+    m_columnStarts[x + 1] += m_columnStarts[x];
+  }
+
+  m_obstacles.resize(m_columnStarts[width]);
+  std::vector<uint32_t> cursors(m_columnStarts.begin(),
+                                m_columnStarts.end() - 1);
+  uint32_t coin = 0;
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      const Shared::Protocol::TileType tile =
+          tiles[static_cast<size_t>(y) * width + x];
+      if (!isObstacle(tile)) {
+        continue;
+      }
+      const bool isCoin = tile == Shared::Protocol::TileType::COIN;
+      m_obstacles[cursors[x]++] = {x, y, tile, isCoin ? coin++ : 0};
+    }
+  }
+}
+
+void CollisionIndex::sweep(const Shared::Protocol::Position from,
+                           const Shared::Protocol::Position to,
+                           const Hitbox box, std::vector<Hit> &hits) const {
+  hits.clear();
+
+  const float deltaX = to.x - from.x;
+  const float deltaY = to.y - from.y;
+  const int firstColumn =
+      std::max(0, static_cast<int>(std::floor(std::min(from.x, to.x))));
+  const int lastColumn =
+      std::min(m_width - 1, static_cast<int>(std::floor(
+                                std::max(from.x, to.x) + box.width)));
+  const int firstRow = static_cast<int>(std::floor(std::min(from.y, to.y)));
+  const int lastRow =
+      static_cast<int>(std::floor(std::max(from.y, to.y) + box.height));
+
+  for (int x = firstColumn; x <= lastColumn; x++) {
+    for (uint32_t i = m_columnStarts[x]; i < m_columnStarts[x + 1]; i++) {
+      const Obstacle &obstacle = m_obstacles[i];
+      if (obstacle.y < firstRow) {
+        continue;
+      }
+      if (obstacle.y > lastRow) {
+        break;
+      }
+
+      float enter = 0.0f;
+      float exit = 1.0f;
+      if (clipToSlab(from.x, deltaX, obstacle.x - box.width, obstacle.x + 1.0f,
+                     enter, exit) &&
+          clipToSlab(from.y, deltaY, obstacle.y - box.height,
+                     obstacle.y + 1.0f, enter, exit)) {
+        hits.push_back({&obstacle, enter});
+      }
+    }
+  }
+
+  std::ranges::sort(hits, {}, &Hit::time);
+}
+
+} // namespace Jetpack::Server
@@ -0,0 +1,78 @@
+/**
+ * @file CollisionIndex.hpp
+ * @brief Declaration of the CollisionIndex class, the static broad phase
+ *        of coins and electric squares.
+ */
+
+#pragma once
+
+#include "../Shared/Protocol.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Jetpack::Server {
+
+/**
+ * @class CollisionIndex
+ * @brief Every coin and electric square of a map, bucketed by column.
+ *
+ * Built once per map and shared by every match playing it. A sweep only
+ * visits the columns the moving box spans, so its cost depends on how
+ * far a player moves in a tick, never on the size of the map.
+ */
+class CollisionIndex {
+public:
+  /** A tile players interact with. */
+  struct Obstacle {
+    int x;
+    int y;
+    Shared::Protocol::TileType tile;
+    /** Coin ordinal for coins, in MapImage::findCoin() order. */
+    uint32_t coin;
+  };
+
+  /** An obstacle a sweep touched, and when. */
+  struct Hit {
+    const Obstacle *obstacle;
+    /** Fraction of the motion, in [0, 1], at which the box reaches it. */
+    float time;
+  };
+
+  /** Size of a moving box, which extends right and down from its position. */
+  struct Hitbox {
+    float width;
+    float height;
+  };
+
+  /**
+   * @brief Indexes the interactive tiles of a map.
+   * @param width  Map width in tiles.
+   * @param height Map height in tiles.
+   * @param tiles  Row-major tiles; coins are numbered in that order.
+   */
+  CollisionIndex(int width, int height,
+                 std::span<const Shared::Protocol::TileType> tiles);
+
+  /**
+   * @brief Finds every obstacle a box touches while moving in a straight
+   *        line, so that fast movers cannot skip one between two ticks.
+   * @param from Box position at the start of the tick.
+   * @param to   Box position at the end of the tick.
+   * @param box  Size of the box.
+   * @param hits Receives the hits, earliest first; cleared first, its
+   *             capacity is reused.
+   */
+  void sweep(Shared::Protocol::Position from, Shared::Protocol::Position to,
+             Hitbox box, std::vector<Hit> &hits) const;
+
+private:
+  int m_width;
+  /** Obstacles of column x are [m_columnStarts[x], m_columnStarts[x + 1]). */
+  std::vector<uint32_t> m_columnStarts;
+  /** Sorted by column, then row. */
+  std::vector<Obstacle> m_obstacles;
+};
+
+} // namespace Jetpack::Server
@@ -0,0 +1,72 @@
+/**
+ * @file Connection.hpp
+ * @brief Per-client socket state owned by a Worker.
+ */
+
+#pragma once
+
+#include "../Shared/RingBuffer.hpp"
+#include "SendQueue.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <netinet/in.h>
+#include <vector>
+
+namespace Jetpack::Server {
+
+class Match;
+
+/**
+ * @struct Connection
+ * @brief A connected client: its descriptor, room, and stream buffers.
+ *
+ * A client offered the datagram path also has a token. Once a datagram
+ * carrying it arrives, state and input acknowledgements go to the address
+ * it came from, until datagrams stop arriving.
+ */
+struct Connection {
+  /** Client→server packets are tiny; this holds hundreds of them. */
+  static constexpr size_t RECEIVE_BUFFER_SIZE = 4096;
+
+  /**
+   * @brief Wraps an accepted socket.
+   * @param clientSocket Connected, non-blocking descriptor.
+   */
+  explicit Connection(const int clientSocket) : socket(clientSocket) {}
+
+  int socket;
+  Match *match = nullptr;
+  /** Set once the client watches match instead of playing in it. */
+  bool spectating = false;
+  /** Set once CONNECT_REQUEST arrived; the seat is dropped without it. */
+  bool requested = false;
+  /** Worker tick at which the client was seated. */
+  uint64_t seatedTick = 0;
+  Shared::RingBuffer receiveBuffer{RECEIVE_BUFFER_SIZE};
+  SendQueue sendQueue;
+  /** True while EVENT_WRITE is registered for a short-written queue. */
+  bool writeWatched = false;
+  /** Set once the backlog passes the limit; closed at the next flush. */
+  bool overflowed = false;
+  /**
+   * Bytes of a whole MAP_DATA still queued, which the backlog limit does
+   * not count: a long map may exceed it on its own.
+   */
+  size_t mapBacklog = 0;
+
+  /** Names this client's datagrams; 0 until DATAGRAM_OFFER is sent. */
+  uint32_t datagramToken = 0;
+  /** Set while datagrams go to datagramAddress instead of the stream. */
+  bool datagramBound = false;
+  sockaddr_in datagramAddress{};
+  /** Worker tick at which the last datagram from the client arrived. */
+  uint64_t lastDatagramTick = 0;
+  /** Sequence number of the last datagram sent. */
+  uint16_t datagramSequence = 0;
+  /** Packets of the datagram sent at the next flush. */
+  std::vector<std::byte> datagram;
+  /** Set to confirm the path with a datagram even if it carries nothing. */
+  bool datagramReply = false;
+};
+
+} // namespace Jetpack::Server
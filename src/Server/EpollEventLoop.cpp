@@ -0,0 +1,84 @@
+/**
+ * @file EpollEventLoop.cpp
+ * @brief Implements the epoll(7) event loop backend.
+ */
+
+#include "EpollEventLoop.hpp"
+
+#ifdef __linux__
+
+#include "../Shared/Exceptions.hpp"
+#include <unistd.h>
+
+namespace Jetpack::Server {
+
+EpollEventLoop::EpollEventLoop() : m_readyEvents(MAX_EVENTS) {
+  m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+  if (m_epollFd < 0) {
+    throw Shared::Exceptions::SocketException(
+        "Failed to create epoll instance");
+  }
+}
+
+EpollEventLoop::~EpollEventLoop() {
+  if (m_epollFd != -1) {
+    close(m_epollFd);
+  }
+}
+
+uint32_t EpollEventLoop::toEpollEvents(const uint32_t interest) {
+  uint32_t events = EPOLLET | EPOLLRDHUP;
+  if (interest & EVENT_READ) {
+    events |= EPOLLIN;
+  }
+  if (interest & EVENT_WRITE) {
+    events |= EPOLLOUT;
+  }
+  return events;
+}
+
+void EpollEventLoop::add(const int fd, const uint32_t interest) {
+  epoll_event event{};
+  event.events = toEpollEvents(interest);
+  event.data.fd = fd;
+
+  if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+    throw Shared::Exceptions::SocketException(
+        "Failed to register descriptor with epoll");
+  }
+}
+
+void EpollEventLoop::modify(const int fd, const uint32_t interest) {
+  epoll_event event{};
+  event.events = toEpollEvents(interest);
+  event.data.fd = fd;
+  epoll_ctl(m_epollFd, EPOLL_CTL_MOD, fd, &event);
+}
+
+void EpollEventLoop::remove(const int fd) {
+  epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+int EpollEventLoop::wait(const int timeoutMs, std::vector<IoEvent> &events) {
+  events.clear();
+
+  const int ready = epoll_wait(m_epollFd, m_readyEvents.data(),
+                               static_cast<int>(m_readyEvents.size()),
+                               timeoutMs);
+  if (ready <= 0) {
+    return ready;
+  }
+
+  for (int i = 0; i < ready; i++) {
+    const uint32_t revents = m_readyEvents[i].events;
+    events.push_back({m_readyEvents[i].data.fd, (revents & EPOLLIN) != 0,
+                      (revents & EPOLLOUT) != 0,
+                      (revents & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) != 0});
+  }
+
+  return ready;
+}
+
+} // namespace Jetpack::Server
+
+#endif
@@ -0,0 +1,56 @@
+/**
+ * @file EpollEventLoop.hpp
+ * @brief Linux epoll(7) event loop backend.
+ */
+
+#pragma once
+
+#ifdef __linux__
+
+#include "EventLoop.hpp"
+#include <sys/epoll.h>
+#include <vector>
+
+namespace Jetpack::Server {
+
+/**
+ * @class EpollEventLoop
+ * @brief Edge-triggered backend built on epoll(7).
+ *
+ * Registration and removal are O(1) in the kernel and wait() only returns
+ * the descriptors that actually changed state, so the cost per wakeup no
+ * longer grows with the number of idle connections.
+ */
+class EpollEventLoop final : public EventLoop {
+public:
+  /**
+   * @brief Creates the epoll instance.
+   * @throws Shared::Exceptions::SocketException on failure.
+   */
+  EpollEventLoop();
+
+  ~EpollEventLoop() override;
+
+  EpollEventLoop(const EpollEventLoop &) = delete;
+  EpollEventLoop &operator=(const EpollEventLoop &) = delete;
+
+  void add(int fd, uint32_t interest) override;
+  void modify(int fd, uint32_t interest) override;
+  void remove(int fd) override;
+  int wait(int timeoutMs, std::vector<IoEvent> &events) override;
+
+  [[nodiscard]] std::string_view getName() const override { return "epoll"; }
+
+private:
+  static constexpr size_t MAX_EVENTS = 256;
+
+  /** @return epoll event mask matching the given interest flags. */
+  static uint32_t toEpollEvents(uint32_t interest);
+
+  int m_epollFd = -1;
+  std::vector<epoll_event> m_readyEvents;
+};
+
+} // namespace Jetpack::Server
+
+#endif
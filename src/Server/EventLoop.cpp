@@ -0,0 +1,36 @@
+/**
+ * @file EventLoop.cpp
+ * @brief Implements backend selection for the EventLoop interface.
+ */
+
+#include "EventLoop.hpp"
+#include "../Shared/Exceptions.hpp"
+#include "EpollEventLoop.hpp"
+#include "PollEventLoop.hpp"
+
+namespace Jetpack::Server {
+
+std::unique_ptr<EventLoop> EventLoop::create(const EventBackend backend) {
+  switch (backend) {
+  case EventBackend::EPOLL:
+#ifdef __linux__
+    return std::make_unique<EpollEventLoop>();
+#else
+    throw Shared::Exceptions::SocketException(
+        "epoll backend is only available on Linux", 0);
+#endif
+  case EventBackend::POLL:
+  default:
+    return std::make_unique<PollEventLoop>();
+  }
+}
+
+EventBackend EventLoop::getDefaultBackend() {
+#ifdef __linux__
+  return EventBackend::EPOLL;
+#else
+  return EventBackend::POLL;
+#endif
+}
+
+} // namespace Jetpack::Server
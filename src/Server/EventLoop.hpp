@@ -0,0 +1,100 @@
+/**
+ * @file EventLoop.hpp
+ * @brief Declaration of the EventLoop interface, the readiness backend the
+ *        GameServer waits on.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace Jetpack::Server {
+
+/**
+ * @enum EventBackend
+ * @brief Available readiness notification mechanisms.
+ */
+enum class EventBackend : uint8_t { POLL = 0, EPOLL = 1 };
+
+/**
+ * @name Interest flags
+ * Bitmask values accepted by EventLoop::add() and EventLoop::modify().
+ * @{
+ */
+inline constexpr uint32_t EVENT_READ = 1U << 0;
+inline constexpr uint32_t EVENT_WRITE = 1U << 1;
+/** @} */
+
+/**
+ * @struct IoEvent
+ * @brief One readiness notification returned by EventLoop::wait().
+ */
+struct IoEvent {
+  int fd = -1;
+  bool readable = false;
+  bool writable = false;
+  bool hangup = false;
+};
+
+/**
+ * @class EventLoop
+ * @brief Registers descriptors and waits for them to become ready.
+ *
+ * Backends may be edge-triggered: callers must drain a readable socket
+ * (or accept every pending connection) until the call returns EAGAIN.
+ * Events are copied out before dispatch, so handlers may add or remove
+ * descriptors freely while iterating the result of wait().
+ */
+class EventLoop {
+public:
+  virtual ~EventLoop() = default;
+
+  /**
+   * @brief Starts watching a descriptor.
+   * @param fd       Descriptor to register.
+   * @param interest Combination of EVENT_READ / EVENT_WRITE.
+   * @throws Shared::Exceptions::SocketException on registration failure.
+   */
+  virtual void add(int fd, uint32_t interest) = 0;
+
+  /**
+   * @brief Changes the interest set of a registered descriptor.
+   * @param fd       Registered descriptor.
+   * @param interest Combination of EVENT_READ / EVENT_WRITE.
+   */
+  virtual void modify(int fd, uint32_t interest) = 0;
+
+  /**
+   * @brief Stops watching a descriptor; call before closing it.
+   * @param fd Registered descriptor.
+   */
+  virtual void remove(int fd) = 0;
+
+  /**
+   * @brief Blocks until descriptors are ready or the timeout expires.
+   * @param timeoutMs Maximum wait in milliseconds (-1 waits forever).
+   * @param events    Cleared, then filled with the ready descriptors.
+   * @return Number of events, or -1 with errno set on failure.
+   */
+  virtual int wait(int timeoutMs, std::vector<IoEvent> &events) = 0;
+
+  /** @return Human-readable backend name for logs. */
+  [[nodiscard]] virtual std::string_view getName() const = 0;
+
+  /**
+   * @brief Instantiates the requested backend.
+   * @param backend Mechanism to use.
+   * @return Owning pointer to the new event loop.
+   * @throws Shared::Exceptions::SocketException if the backend is not
+   *         available on this platform or fails to initialize.
+   */
+  static std::unique_ptr<EventLoop> create(EventBackend backend);
+
+  /** @return Fastest backend available on this platform. */
+  static EventBackend getDefaultBackend();
+};
+
+} // namespace Jetpack::Server
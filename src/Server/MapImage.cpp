@@ -0,0 +1,323 @@
+/**
+ * @file MapImage.cpp
+ * @brief Implements the map compiler and the read-only mapping of
+ *        compiled maps.
+ */
+
+#include "MapImage.hpp"
+#include "../Shared/Exceptions.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+static_assert(std::endian::native == std::endian::little,
+              "compiled maps are read in place as little-endian");
+
+namespace {
+
+constexpr std::array<char, 8> MAGIC = {'J', 'P', 'M', 'A', 'P', 0, 0, 1};
+constexpr size_t HEADER_SIZE = 24;
+constexpr size_t MAX_DIMENSION = 0xFFFF;
+
+/** @return Offset of the coin cells, past the tiles and their padding. */
+size_t getCoinCellsOffset(const size_t cellCount) {
+  return (HEADER_SIZE + cellCount + 3) & ~static_cast<size_t>(3);
+}
+
+const std::byte *asBytes(const void *mapping) {
+  return static_cast<const std::byte *>(mapping);
+}
+
+uint32_t readInt(const std::byte *data) {
+  uint32_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+void writeInt(std::byte *data, const uint32_t value) {
+  std::memcpy(data, &value, sizeof(value));
+}
+
+/** FNV-1a over the dimensions and the tiles, all a match reads. */
+uint64_t hashLayout(const std::byte *data, const size_t cellCount) {
+  uint64_t hash = 0xCBF29CE484222325;
+  const auto mix = [&hash](const std::byte *bytes, const size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      hash = (hash ^ std::to_integer<uint64_t>(bytes[i])) * 0x100000001B3;
+    }
+  };
+  mix(data + 8, 8);
+  mix(data + HEADER_SIZE, cellCount);
+  return hash;
+}
+
+/**
+ * @brief Checks that a buffer is a well-formed compiled map.
+ * @param data Start of the buffer.
+ * @param size Length of the buffer.
+ * @return True if every field, tile and coin cell is consistent.
+ */
+bool isValidImage(const std::byte *data, const size_t size) {
+  if (size < HEADER_SIZE || std::memcmp(data, MAGIC.data(), MAGIC.size())) {
+    return false;
+  }
+
+  const size_t width = readInt(data + 8);
+  const size_t height = readInt(data + 12);
+  const size_t coinCount = readInt(data + 16);
+  if (width == 0 || height == 0 || width > MAX_DIMENSION ||
+      height > MAX_DIMENSION) {
+    return false;
+  }
+
+  const size_t cellCount = width * height;
+  if (size != getCoinCellsOffset(cellCount) + coinCount * sizeof(uint32_t)) {
+    return false;
+  }
+
+  const std::byte *tiles = data + HEADER_SIZE;
+  if (std::any_of(tiles, tiles + cellCount, [](const std::byte tile) {
+        return tile > std::byte{static_cast<uint8_t>(
+                          Jetpack::Shared::Protocol::TileType::ELECTRICSQUARE)};
+      })) {
+    return false;
+  }
+
+  const std::byte *coinCells = data + getCoinCellsOffset(cellCount);
+  size_t previous = 0;
+  for (size_t i = 0; i < coinCount; i++) {
+    const size_t cell = readInt(coinCells + i * sizeof(uint32_t));
+    if (cell >= cellCount || (i > 0 && cell <= previous) ||
+        static_cast<Jetpack::Shared::Protocol::TileType>(tiles[cell]) !=
+            Jetpack::Shared::Protocol::TileType::COIN) {
+      return false;
+    }
+    previous = cell;
+  }
+  return true;
+}
+
+/**
+ * @brief Parses a text map into the bytes of a compiled map.
+ * @param source Text map.
+ * @return The compiled map.
+ * @throws Jetpack::Shared::Exceptions::MapLoaderException if invalid.
+ */
+std::vector<std::byte> compileText(const std::filesystem::path &source) {
+  std::ifstream file(source);
+  if (!file.is_open()) {
+    throw Jetpack::Shared::Exceptions::MapLoaderException(
+        source, "No such file or directory");
+  }
+
+  std::vector<std::byte> image(HEADER_SIZE);
+  size_t width = 0;
+  size_t height = 0;
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    if (height == 0) {
+      width = line.length();
+    } else if (line.length() != width) {
+      throw Jetpack::Shared::Exceptions::MapLoaderException(
+          source, "Rows differ in width");
+    }
+
+    for (const char cell : line) {
+      Jetpack::Shared::Protocol::TileType tile =
+          Jetpack::Shared::Protocol::TileType::EMPTY;
+      if (cell == 'c') {
+        tile = Jetpack::Shared::Protocol::TileType::COIN;
+      } else if (cell == 'e') {
+        tile = Jetpack::Shared::Protocol::TileType::ELECTRICSQUARE;
+      }
+      image.push_back(static_cast<std::byte>(tile));
+    }
+    height++;
+  }
+
+  if (height == 0) {
+    throw Jetpack::Shared::Exceptions::MapLoaderException(source,
+                                                          "Map is empty");
+  }
+  if (width > MAX_DIMENSION || height > MAX_DIMENSION) {
+    throw Jetpack::Shared::Exceptions::MapLoaderException(source,
+                                                          "Map is too large");
+  }
+
+  const size_t cellCount = width * height;
+  std::vector<uint32_t> coinCells;
+  for (size_t cell = 0; cell < cellCount; cell++) {
+    if (static_cast<Jetpack::Shared::Protocol::TileType>(
+            image[HEADER_SIZE + cell]) ==
+        Jetpack::Shared::Protocol::TileType::COIN) {
+      coinCells.push_back(static_cast<uint32_t>(cell));
+    }
+  }
+
+  image.resize(getCoinCellsOffset(cellCount) +
+               coinCells.size() * sizeof(uint32_t));
+  std::memcpy(image.data(), MAGIC.data(), MAGIC.size());
+  writeInt(image.data() + 8, static_cast<uint32_t>(width));
+  writeInt(image.data() + 12, static_cast<uint32_t>(height));
+  writeInt(image.data() + 16, static_cast<uint32_t>(coinCells.size()));
+  writeInt(image.data() + 20, 0);
+  std::memcpy(image.data() + getCoinCellsOffset(cellCount), coinCells.data(),
+              coinCells.size() * sizeof(uint32_t));
+  return image;
+}
+
+/**
+ * @brief Writes a compiled map through a temporary file and a rename.
+ * @param output Destination path.
+ * @param image  Compiled map.
+ * @return False if the file could not be written.
+ */
+bool writeImage(const std::filesystem::path &output,
+                const std::vector<std::byte> &image) {
+  const std::filesystem::path temporary =
+      output.string() + ".tmp" + std::to_string(getpid());
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file.write(reinterpret_cast<const char *>(image.data()),
+                    static_cast<std::streamsize>(image.size()))) {
+      file.close();
+      std::error_code error;
+      std::filesystem::remove(temporary, error);
+      return false;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporary, output, error);
+  if (error) {
+    std::filesystem::remove(temporary, error);
+    return false;
+  }
+  return true;
+}
+
+/** @return True if the file starts with the compiled map magic. */
+bool isCompiledMap(const std::filesystem::path &path) {
+  std::ifstream file(path, std::ios::binary);
+  std::array<char, MAGIC.size()> magic{};
+  return file.read(magic.data(), magic.size()) && magic == MAGIC;
+}
+
+} // namespace
+
+namespace Jetpack::Server {
+
+MapImage::MapImage(const void *mapping, const size_t size)
+    : m_mapping(mapping), m_mappingSize(size),
+      m_width(static_cast<int>(readInt(asBytes(mapping) + 8))),
+      m_height(static_cast<int>(readInt(asBytes(mapping) + 12))),
+      m_tiles(reinterpret_cast<const Shared::Protocol::TileType *>(
+                  asBytes(mapping) + HEADER_SIZE),
+              static_cast<size_t>(m_width) * m_height),
+      m_coinCells(reinterpret_cast<const uint32_t *>(
+                      asBytes(mapping) + getCoinCellsOffset(m_tiles.size())),
+                  readInt(asBytes(mapping) + 16)),
+      m_collisionIndex(m_width, m_height, m_tiles),
+      m_hash(hashLayout(asBytes(mapping), m_tiles.size())) {}
+
+MapImage::~MapImage() {
+  munmap(const_cast<void *>(m_mapping), m_mappingSize);
+}
+
+std::shared_ptr<const MapImage>
+MapImage::load(const std::filesystem::path &path) {
+  if (isCompiledMap(path)) {
+    std::shared_ptr<const MapImage> image = mapFile(path);
+    if (!image) {
+      throw Shared::Exceptions::MapLoaderException(path,
+                                                   "Corrupt compiled map");
+    }
+    return image;
+  }
+
+  std::error_code error;
+  const std::filesystem::path cache = path.string() + CACHE_SUFFIX;
+  const auto sourceTime = std::filesystem::last_write_time(path, error);
+  if (error) {
+    throw Shared::Exceptions::MapLoaderException(path, error.message());
+  }
+  const auto cacheTime = std::filesystem::last_write_time(cache, error);
+  if (!error && cacheTime > sourceTime) {
+    if (std::shared_ptr<const MapImage> image = mapFile(cache)) {
+      return image;
+    }
+  }
+
+  const std::vector<std::byte> compiled = compileText(path);
+  if (writeImage(cache, compiled)) {
+    if (std::shared_ptr<const MapImage> image = mapFile(cache)) {
+      return image;
+    }
+  }
+
+  void *mapping = mmap(nullptr, compiled.size(), PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapping == MAP_FAILED) {
+    throw Shared::Exceptions::MapLoaderException(path, std::strerror(errno));
+  }
+  std::memcpy(mapping, compiled.data(), compiled.size());
+  mprotect(mapping, compiled.size(), PROT_READ);
+  return std::shared_ptr<const MapImage>(
+      new MapImage(mapping, compiled.size()));
+}
+
+void MapImage::compile(const std::filesystem::path &source,
+                       const std::filesystem::path &output) {
+  if (!writeImage(output, compileText(source))) {
+    throw Shared::Exceptions::MapLoaderException(output,
+                                                 "Cannot write compiled map");
+  }
+}
+
+std::shared_ptr<const MapImage>
+MapImage::mapFile(const std::filesystem::path &path) {
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return nullptr;
+  }
+
+  struct stat info {};
+  if (fstat(fd, &info) == -1 || info.st_size <= 0) {
+    close(fd);
+    return nullptr;
+  }
+
+  const auto size = static_cast<size_t>(info.st_size);
+  void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return nullptr;
+  }
+
+  if (!isValidImage(static_cast<const std::byte *>(mapping), size)) {
+    munmap(mapping, size);
+    return nullptr;
+  }
+  return std::shared_ptr<const MapImage>(new MapImage(mapping, size));
+}
+
+size_t MapImage::findCoin(const size_t cell) const {
+  const auto coin = std::ranges::lower_bound(m_coinCells, cell);
+  if (coin == m_coinCells.end() || *coin != cell) {
+    return NO_COIN;
+  }
+  return static_cast<size_t>(coin - m_coinCells.begin());
+}
+
+} // namespace Jetpack::Server
@@ -0,0 +1,164 @@
+/**
+ * @file MapImage.hpp
+ * @brief Declaration of the MapImage class, a compiled map layout mapped
+ *        read-only into memory and shared by every match.
+ */
+
+#pragma once
+
+#include "../Shared/Protocol.hpp"
+#include "CollisionIndex.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+
+namespace Jetpack::Server {
+
+/**
+ * @class MapImage
+ * @brief Immutable tile layout of a map, compiled once and mmap()ed.
+ *
+ * A compiled map is one little-endian file:
+ *
+ *     Magic (8) | Width (4) | Height (4) | Coin Count (4) | Reserved (4) |
+ *     Tiles (Width * Height, row-major) | Padding to 4 bytes |
+ *     Coin Cells (4 * Coin Count, ascending)
+ *
+ * Coin cells list the row-major index of every coin tile, so a match can
+ * keep one CoinState per coin instead of one per cell. Text maps are
+ * compiled into a cache file next to the source (or into anonymous
+ * memory if that directory is read-only) and the result is mapped, so
+ * every match and every worker reads the same pages. The collision index
+ * is built once per image and shared the same way.
+ */
+class MapImage {
+public:
+  /** Returned by findCoin() for a cell that holds no coin. */
+  static constexpr size_t NO_COIN = static_cast<size_t>(-1);
+
+  /** Suffix appended to a text map's path to name its compiled cache. */
+  static constexpr const char *CACHE_SUFFIX = ".jpmap";
+
+  /**
+   * @brief Maps a map file, compiling it first if it is a text map whose
+   *        cache is missing or older than the source.
+   * @param path Text or compiled map.
+   * @return The shared image.
+   * @throws Shared::Exceptions::MapLoaderException if the map is invalid.
+   */
+  [[nodiscard]] static std::shared_ptr<const MapImage>
+  load(const std::filesystem::path &path);
+
+  /**
+   * @brief Compiles a text map into a compiled map file.
+   *
+   * The output is written to a temporary file and renamed into place, so
+   * images already mapped from a previous version stay valid.
+   *
+   * @param source Text map: one line per row, 'c' coin, 'e' electric
+   *               square, anything else empty.
+   * @param output Path of the compiled map.
+   * @throws Shared::Exceptions::MapLoaderException on invalid input or
+   *         write failure.
+   */
+  static void compile(const std::filesystem::path &source,
+                      const std::filesystem::path &output);
+
+  /** @brief Unmaps the image. */
+  ~MapImage();
+
+  MapImage(const MapImage &) = delete;
+  MapImage &operator=(const MapImage &) = delete;
+  MapImage(MapImage &&) = delete;
+  MapImage &operator=(MapImage &&) = delete;
+
+  /** @return Map width in tiles. */
+  [[nodiscard]] int getWidth() const { return m_width; }
+
+  /** @return Map height in tiles. */
+  [[nodiscard]] int getHeight() const { return m_height; }
+
+  /** @return Number of cells, width * height. */
+  [[nodiscard]] size_t getCellCount() const { return m_tiles.size(); }
+
+  /** @return Number of coin tiles. */
+  [[nodiscard]] size_t getCoinCount() const { return m_coinCells.size(); }
+
+  /**
+   * @brief Get the row-major index of a cell; the cell must be valid.
+   * @param x Column index
+   * @param y Row index
+   */
+  [[nodiscard]] size_t getIndex(const int x, const int y) const {
+    return static_cast<size_t>(y) * m_width + x;
+  }
+
+  /** @return True if (x, y) lies inside the map. */
+  [[nodiscard]] bool isValidPosition(const int x, const int y) const {
+    return x >= 0 && x < m_width && y >= 0 && y < m_height;
+  }
+
+  /**
+   * @param cell Row-major cell index, below getCellCount().
+   * @return The tile of that cell.
+   */
+  [[nodiscard]] Shared::Protocol::TileType getTile(const size_t cell) const {
+    return m_tiles[cell];
+  }
+
+  /**
+   * @param y Row index, inside the map.
+   * @return The tiles of that row.
+   */
+  [[nodiscard]] std::span<const Shared::Protocol::TileType>
+  getTileRow(const int y) const {
+    return m_tiles.subspan(getIndex(0, y), static_cast<size_t>(m_width));
+  }
+
+  /**
+   * @return FNV-1a hash of the dimensions and tiles, identifying the
+   *         layout whatever file it was loaded from.
+   */
+  [[nodiscard]] uint64_t getHash() const { return m_hash; }
+
+  /** @return Coins and electric squares bucketed by column. */
+  [[nodiscard]] const CollisionIndex &getCollisionIndex() const {
+    return m_collisionIndex;
+  }
+
+  /**
+   * @brief Get the ordinal of the coin in a cell, by binary search.
+   * @param cell Row-major cell index.
+   * @return Index below getCoinCount(), or NO_COIN.
+   */
+  [[nodiscard]] size_t findCoin(size_t cell) const;
+
+private:
+  /**
+   * @brief Takes ownership of a mapping already validated by load().
+   * @param mapping Start of the mapping.
+   * @param size    Length of the mapping in bytes.
+   */
+  MapImage(const void *mapping, size_t size);
+
+  /**
+   * @brief Maps a compiled map file read-only.
+   * @param path Compiled map.
+   * @return The image, or nullptr if the file is not a valid compiled map.
+   */
+  [[nodiscard]] static std::shared_ptr<const MapImage>
+  mapFile(const std::filesystem::path &path);
+
+  const void *m_mapping;
+  size_t m_mappingSize;
+  int m_width;
+  int m_height;
+  std::span<const Shared::Protocol::TileType> m_tiles;
+  std::span<const uint32_t> m_coinCells;
+  CollisionIndex m_collisionIndex;
+  uint64_t m_hash;
+};
+
+} // namespace Jetpack::Server
@@ -0,0 +1,633 @@
+/**
+ * @file Match.cpp
+ * @brief Implements a single game room: seating, game loop and state logic.
+ */
+
+#include "Match.hpp"
+#include "../Shared/Physics.hpp"
+#include <algorithm>
+#include <array>
+#include <format>
+#include <iostream>
+#include <span>
+
+namespace Jetpack::Server {
+
+Match::Match(const int matchId, std::shared_ptr<const MapImage> map,
+             PacketSink &sink, const bool debugMode,
+             WorkerMetrics *metrics)
+    : m_id(matchId), m_debugMode(debugMode), m_map(std::move(map)),
+      m_coinOwners(m_map->getCoinCount()),
+      m_sink(sink), m_broadcaster(m_sink, m_players, m_spectators) {
+  if (metrics != nullptr) {
+    m_physicsDuration = &metrics->physicsDuration;
+    m_collisionsDuration = &metrics->collisionsDuration;
+  }
+  m_pendingInputs.reserve(MAX_PLAYERS * MAX_QUEUED_INPUTS);
+  m_hits.reserve(MAX_HITS_PER_SWEEP);
+  m_batch.reserve(MAX_PLAYERS);
+  m_batchPlayers.reserve(MAX_PLAYERS);
+  m_broadcaster.reserve(MAX_PLAYERS, MAX_PLAYERS + MAX_SPECTATORS);
+  setPositionScale(Shared::Protocol::LEGACY_POSITION_SCALE);
+}
+
+void Match::setPositionScale(const uint16_t unitsPerTile) {
+  m_broadcaster.setStateEncoding(unitsPerTile, getSpawnPosition());
+}
+
+Shared::Protocol::Position Match::getSpawnPosition() const {
+  return {1.0f, static_cast<float>(m_map->getHeight()) - 2.0f};
+}
+
+bool Match::addPlayer(const int clientSocket) {
+  if (!isAcceptingPlayers()) {
+    return false;
+  }
+
+  record(MatchRecording::EventType::JOIN, clientSocket);
+  const int newPlayerId = nextFreePlayerId();
+  m_players.emplace(clientSocket,
+                    Shared::Protocol::Player(clientSocket, newPlayerId));
+  m_sessions.try_emplace(clientSocket);
+
+  if (m_debugMode) {
+    std::cout << std::format("Debug: Client {} joined match {} as player {}",
+                             clientSocket, m_id, newPlayerId)
+              << std::endl;
+  }
+
+  sendConnectResponse(clientSocket, newPlayerId);
+  return true;
+}
+
+bool Match::addSpectator(const int clientSocket, const uint8_t capabilities) {
+  if (isOver() || m_spectators.size() >= MAX_SPECTATORS) {
+    return false;
+  }
+  m_spectators.push_back(clientSocket);
+
+  if ((capabilities & Shared::Protocol::CAPABILITY_DELTA_STATE) != 0) {
+    m_broadcaster.enableDeltaState(clientSocket);
+  }
+  sendConnectResponse(clientSocket, Shared::Protocol::SPECTATOR_ID);
+  if ((capabilities & Shared::Protocol::CAPABILITY_PACKED_STATE) != 0) {
+    m_broadcaster.enablePackedState(clientSocket);
+  }
+  if ((capabilities & Shared::Protocol::CAPABILITY_MAP_STREAMING) != 0) {
+    // The camera follows the leader and shows less than a chunk behind
+    // it; everything further back has been played already.
+    const int leadingColumn = getLeadingColumn();
+    int &streamedColumns = m_spectatorStreams[clientSocket];
+    streamedColumns =
+        std::max(0, leadingColumn / MAP_CHUNK_COLUMNS - 1) * MAP_CHUNK_COLUMNS;
+    sendMapInfo(clientSocket);
+    streamMapChunksTo(
+        clientSocket, streamedColumns,
+        std::min(m_map->getWidth(), leadingColumn + STREAM_AHEAD_COLUMNS));
+  } else {
+    sendMapData(clientSocket);
+  }
+  if (isInProgress()) {
+    m_broadcaster.sendGameStart(clientSocket);
+  }
+  return true;
+}
+
+void Match::removePlayer(const int clientSocket) {
+  if (std::erase(m_spectators, clientSocket) != 0) {
+    m_spectatorStreams.erase(clientSocket);
+    m_broadcaster.removeClient(clientSocket);
+    return;
+  }
+
+  const auto it = m_players.find(clientSocket);
+  if (it == m_players.end()) {
+    return;
+  }
+  record(MatchRecording::EventType::LEAVE, clientSocket);
+  m_players.erase(it);
+  m_broadcaster.removeClient(clientSocket);
+  m_inputAcks.erase(clientSocket);
+  m_sessions.erase(clientSocket);
+  std::erase_if(m_pendingInputs, [clientSocket](const PendingInput &input) {
+    return input.clientSocket == clientSocket;
+  });
+
+  if (m_gameState == Shared::Protocol::GameState::IN_PROGRESS) {
+    int activePlayers = 0;
+    for (const auto &[_, player] : m_players) {
+      if (player.getState() == Shared::Protocol::PlayerState::PLAYING) {
+        activePlayers++;
+      }
+    }
+
+    if (activePlayers < MIN_PLAYERS) {
+      m_gameState = Shared::Protocol::GameState::GAME_OVER;
+      m_broadcaster.broadcastGameOver();
+    }
+  }
+}
+
+bool Match::isAcceptingPlayers() const {
+  return m_gameState == Shared::Protocol::GameState::WAITING_FOR_PLAYERS &&
+         m_players.size() < static_cast<size_t>(MAX_PLAYERS);
+}
+
+std::vector<int> Match::getClientSockets() const {
+  std::vector<int> sockets;
+  sockets.reserve(m_players.size() + m_spectators.size());
+  for (const auto &[playerSocket, _] : m_players) {
+    sockets.push_back(playerSocket);
+  }
+  sockets.insert(sockets.end(), m_spectators.begin(), m_spectators.end());
+  return sockets;
+}
+
+int Match::nextFreePlayerId() const {
+  int playerId = 1;
+  bool taken = true;
+  while (taken) {
+    taken = false;
+    for (const auto &[_, player] : m_players) {
+      if (player.getId() == playerId) {
+        taken = true;
+        playerId++;
+        break;
+      }
+    }
+  }
+  return playerId;
+}
+
+void Match::handlePlayerInput(const int clientSocket, const uint8_t *data,
+                              const size_t length) {
+  if (length < 2)
+    return;
+
+  if (!m_players.contains(clientSocket)) {
+    return;
+  }
+
+  const uint8_t flags = data[1];
+  if ((flags & Shared::Protocol::InputFlag::SEQUENCED) == 0) {
+    const bool isJetpacking = flags != 0;
+    const auto pending = std::ranges::find(m_pendingInputs, clientSocket,
+                                           &PendingInput::clientSocket);
+    if (pending != m_pendingInputs.end()) {
+      pending->isJetpacking = isJetpacking;
+    } else {
+      m_pendingInputs.push_back(
+          {clientSocket, isJetpacking, Shared::Protocol::NO_INPUT_SEQUENCE});
+    }
+    return;
+  }
+
+  const auto ack = m_inputAcks.find(clientSocket);
+  if (length < 4 || ack == m_inputAcks.end()) {
+    return;
+  }
+
+  const auto sequence = static_cast<uint16_t>(data[2] | data[3] << 8);
+  uint16_t &lastReceived = ack->second.lastReceived;
+  if (sequence == Shared::Protocol::NO_INPUT_SEQUENCE ||
+      (lastReceived != Shared::Protocol::NO_INPUT_SEQUENCE &&
+       !Shared::Protocol::isSequenceNewer(sequence, lastReceived))) {
+    return;
+  }
+  lastReceived = sequence;
+
+  if (std::ranges::count(m_pendingInputs, clientSocket,
+                         &PendingInput::clientSocket) >=
+      static_cast<std::ptrdiff_t>(MAX_QUEUED_INPUTS)) {
+    m_pendingInputs.erase(std::ranges::find(m_pendingInputs, clientSocket,
+                                            &PendingInput::clientSocket));
+  }
+  m_pendingInputs.push_back(
+      {clientSocket, (flags & Shared::Protocol::InputFlag::JETPACK) != 0,
+       sequence});
+}
+
+void Match::handleConnectRequest(const int clientSocket,
+                                 const uint8_t capabilities) {
+  const auto session = m_sessions.find(clientSocket);
+  if (session == m_sessions.end() || session->second.joined) {
+    return;
+  }
+  record(MatchRecording::EventType::CONNECT, clientSocket, capabilities);
+
+  if ((capabilities & Shared::Protocol::CAPABILITY_DELTA_STATE) != 0) {
+    m_broadcaster.enableDeltaState(clientSocket);
+  }
+  if ((capabilities & Shared::Protocol::CAPABILITY_PACKED_STATE) != 0) {
+    m_broadcaster.enablePackedState(clientSocket);
+  }
+  if ((capabilities & Shared::Protocol::CAPABILITY_INPUT_SEQUENCE) != 0 &&
+      m_inputAcks.try_emplace(clientSocket).second) {
+    sendInputAck(clientSocket, Shared::Protocol::NO_INPUT_SEQUENCE);
+  }
+
+  session->second.joined = true;
+  if ((capabilities & Shared::Protocol::CAPABILITY_MAP_STREAMING) != 0) {
+    session->second.streamsMap = true;
+    sendMapInfo(clientSocket);
+    streamMapChunks();
+  } else {
+    sendMapData(clientSocket);
+  }
+
+  checkGameStart();
+}
+
+void Match::handleStateAck(const int clientSocket, const uint8_t *data,
+                           const size_t length) {
+  if (length < 3)
+    return;
+
+  m_broadcaster.acknowledgeState(clientSocket,
+                                 static_cast<uint16_t>(data[1] | data[2] << 8));
+}
+
+void Match::applyPendingInputs() {
+  std::array<int, MAX_PLAYERS> served{};
+  size_t servedCount = 0;
+
+  for (PendingInput &input : m_pendingInputs) {
+    const auto servedEnd = served.begin() + servedCount;
+    if (servedCount == served.size() ||
+        std::find(served.begin(), servedEnd, input.clientSocket) !=
+            servedEnd) {
+      continue;
+    }
+    served[servedCount++] = input.clientSocket;
+
+    const auto it = m_players.find(input.clientSocket);
+    if (it != m_players.end() &&
+        it->second.getState() == Shared::Protocol::PlayerState::PLAYING &&
+        it->second.isJetpacking() != input.isJetpacking) {
+      record(input.isJetpacking ? MatchRecording::EventType::JETPACK_ON
+                                : MatchRecording::EventType::JETPACK_OFF,
+             input.clientSocket);
+      it->second.setJetpacking(input.isJetpacking);
+    }
+    if (input.sequence != Shared::Protocol::NO_INPUT_SEQUENCE) {
+      const auto ack = m_inputAcks.find(input.clientSocket);
+      if (ack != m_inputAcks.end()) {
+        ack->second.lastApplied = input.sequence;
+      }
+    }
+    input.clientSocket = -1;
+  }
+
+  std::erase_if(m_pendingInputs, [](const PendingInput &input) {
+    return input.clientSocket == -1;
+  });
+}
+
+void Match::sendInputAck(const int clientSocket, const uint16_t sequence) {
+  Shared::Protocol::FrameBuilder packet(
+      m_sink.getFrameArena(), Shared::Protocol::PacketType::INPUT_ACK, 2);
+  packet.addShort(sequence);
+  m_sink.queueFrame(clientSocket, packet.finish());
+}
+
+void Match::broadcastGameState() {
+  for (const auto &[clientSocket, ack] : m_inputAcks) {
+    sendInputAck(clientSocket, ack.lastApplied);
+  }
+  m_broadcaster.broadcastGameState();
+}
+
+void Match::sendConnectResponse(const int clientSocket, const int playerId) {
+  Shared::Protocol::FrameBuilder packet(
+      m_sink.getFrameArena(), Shared::Protocol::PacketType::CONNECT_RESPONSE,
+      2);
+  packet.addByte(static_cast<uint8_t>(playerId));
+  packet.addByte(static_cast<uint8_t>(m_players.size()));
+
+  m_sink.queueFrame(clientSocket, packet.finish());
+}
+
+void Match::sendMapData(const int clientSocket) {
+  Shared::Protocol::FrameBuilder packet(
+      m_sink.getFrameArena(), Shared::Protocol::PacketType::MAP_DATA,
+      4 + m_map->getCellCount() * 2);
+
+  packet.addShort(static_cast<uint16_t>(m_map->getWidth()));
+  packet.addShort(static_cast<uint16_t>(m_map->getHeight()));
+  addCells(packet, 0, m_map->getWidth());
+  m_sink.queueFrame(clientSocket, packet.finish());
+}
+
+void Match::sendMapInfo(const int clientSocket) {
+  Shared::Protocol::FrameBuilder packet(
+      m_sink.getFrameArena(), Shared::Protocol::PacketType::MAP_INFO,
+      Shared::Protocol::MAP_INFO_SIZE - 1);
+  packet.addShort(static_cast<uint16_t>(m_map->getWidth()));
+  packet.addShort(static_cast<uint16_t>(m_map->getHeight()));
+  packet.addShort(static_cast<uint16_t>(MAP_CHUNK_COLUMNS));
+  m_sink.queueFrame(clientSocket, packet.finish());
+}
+
+void Match::sendMapChunk(const int clientSocket, const int firstColumn,
+                         const int columnCount) {
+  const size_t chunkWidth = static_cast<size_t>(columnCount);
+  Shared::Protocol::FrameBuilder packet(
+      m_sink.getFrameArena(), Shared::Protocol::PacketType::MAP_CHUNK,
+      Shared::Protocol::MAP_CHUNK_HEADER_SIZE - 1 +
+          chunkWidth * m_map->getHeight() * 2);
+  packet.addShort(static_cast<uint16_t>(firstColumn));
+  packet.addShort(static_cast<uint16_t>(columnCount));
+  packet.addShort(static_cast<uint16_t>(m_map->getHeight()));
+  addCells(packet, firstColumn, columnCount);
+  m_sink.queueFrame(clientSocket, packet.finish());
+}
+
+void Match::addCells(Shared::Protocol::FrameBuilder &packet,
+                     const int firstColumn, const int columnCount) const {
+  const size_t chunkWidth = static_cast<size_t>(columnCount);
+  for (int y = 0; y < m_map->getHeight(); y++) {
+    const std::span<const Shared::Protocol::TileType> row =
+        m_map->getTileRow(y).subspan(firstColumn, chunkWidth);
+    if (std::ranges::find(row, Shared::Protocol::TileType::COIN) ==
+        row.end()) {
+      packet.addBytes(std::as_bytes(row));
+      continue;
+    }
+    for (size_t x = 0; x < chunkWidth; x++) {
+      const Shared::Protocol::TileType tile = row[x];
+      const bool taken = tile == Shared::Protocol::TileType::COIN &&
+                         getCoinState(m_map->getIndex(firstColumn + x, y)) ==
+                             Shared::Protocol::CoinState::COLLECTED_BOTH;
+      packet.addByte(static_cast<uint8_t>(
+          taken ? Shared::Protocol::TileType::EMPTY : tile));
+    }
+  }
+
+  for (int y = 0; y < m_map->getHeight(); y++) {
+    const size_t rowStart = m_map->getIndex(firstColumn, y);
+    for (size_t x = 0; x < chunkWidth; x++) {
+      packet.addByte(static_cast<uint8_t>(getCoinState(rowStart + x)));
+    }
+  }
+}
+
+Shared::Protocol::CoinState Match::getCoinState(const size_t cell) const {
+  if (m_map->getTile(cell) != Shared::Protocol::TileType::COIN) {
+    return Shared::Protocol::CoinState::AVAILABLE;
+  }
+  const size_t coin = m_map->findCoin(cell);
+  return coin != MapImage::NO_COIN ? toCoinState(m_coinOwners[coin])
+                                   : Shared::Protocol::CoinState::AVAILABLE;
+}
+
+Shared::Protocol::CoinState Match::toCoinState(const CoinOwners &owners) {
+  const bool first = owners.test(0);
+  const bool second = owners.test(1);
+  if (first && second) {
+    return Shared::Protocol::CoinState::COLLECTED_BOTH;
+  }
+  if (first) {
+    return Shared::Protocol::CoinState::COLLECTED_P1;
+  }
+  if (second) {
+    return Shared::Protocol::CoinState::COLLECTED_P2;
+  }
+  return Shared::Protocol::CoinState::AVAILABLE;
+}
+
+void Match::streamMapChunks() {
+  for (auto &[clientSocket, session] : m_sessions) {
+    if (!session.streamsMap) {
+      continue;
+    }
+
+    const auto player = m_players.find(clientSocket);
+    const int playerColumn =
+        player != m_players.end()
+            ? std::max(0, static_cast<int>(player->second.getPosition().x))
+            : 0;
+    streamMapChunksTo(
+        clientSocket, session.streamedColumns,
+        std::min(m_map->getWidth(), playerColumn + STREAM_AHEAD_COLUMNS));
+  }
+
+  if (m_spectatorStreams.empty()) {
+    return;
+  }
+  const int target = std::min(m_map->getWidth(),
+                              getLeadingColumn() + STREAM_AHEAD_COLUMNS);
+  for (auto &[clientSocket, streamedColumns] : m_spectatorStreams) {
+    streamMapChunksTo(clientSocket, streamedColumns, target);
+  }
+}
+
+void Match::streamMapChunksTo(const int clientSocket, int &streamedColumns,
+                              const int target) {
+  while (streamedColumns < target) {
+    const int columnCount =
+        std::min(MAP_CHUNK_COLUMNS, m_map->getWidth() - streamedColumns);
+    sendMapChunk(clientSocket, streamedColumns, columnCount);
+    streamedColumns += columnCount;
+  }
+}
+
+int Match::getLeadingColumn() const {
+  int column = 0;
+  for (const auto &[_, player] : m_players) {
+    column = std::max(column, static_cast<int>(player.getPosition().x));
+  }
+  return column;
+}
+
+void Match::checkGameStart() {
+  if (m_gameState != Shared::Protocol::GameState::WAITING_FOR_PLAYERS) {
+    return;
+  }
+
+  const auto readyPlayersCount = std::ranges::count_if(
+      m_sessions, [](const auto &entry) { return entry.second.joined; });
+
+  if (readyPlayersCount >= MIN_PLAYERS &&
+      readyPlayersCount == static_cast<std::ptrdiff_t>(m_players.size())) {
+    m_gameState = Shared::Protocol::GameState::IN_PROGRESS;
+
+    const Shared::Protocol::Position spawn = getSpawnPosition();
+    for (auto &[_, player] : m_players) {
+      player.setState(Shared::Protocol::PlayerState::READY);
+      player.setPosition(spawn.x, spawn.y);
+    }
+
+    m_broadcaster.broadcastGameStart();
+    broadcastGameState();
+  }
+}
+
+void Match::update() {
+  applyPendingInputs();
+  m_tick++;
+
+  if (m_gameState != Shared::Protocol::GameState::IN_PROGRESS) {
+    return;
+  }
+
+  bool allReady = true;
+  bool anyPlaying = false;
+
+  for (const auto &[_, player] : m_players) {
+    if (player.getState() == Shared::Protocol::PlayerState::PLAYING) {
+      anyPlaying = true;
+    } else if (player.getState() == Shared::Protocol::PlayerState::READY) {
+    } else {
+      allReady = false;
+    }
+  }
+
+  if (allReady && !anyPlaying) {
+    for (auto &[_, player] : m_players) {
+      if (player.getState() == Shared::Protocol::PlayerState::READY) {
+        player.setState(Shared::Protocol::PlayerState::PLAYING);
+      }
+    }
+    broadcastGameState();
+    return;
+  }
+
+  updatePlayers();
+  broadcastGameState();
+  streamMapChunks();
+  checkGameEnd();
+}
+
+void Match::updatePlayers() {
+  m_batch.clear();
+  m_batchPlayers.clear();
+  for (auto &[_, player] : m_players) {
+    if (player.getState() == Shared::Protocol::PlayerState::PLAYING) {
+      m_batch.add(player);
+      m_batchPlayers.push_back(&player);
+    }
+  }
+  {
+    const ScopedTimer timer(m_physicsDuration);
+    Shared::Physics::step(m_batch, m_map->getHeight());
+  }
+
+  const ScopedTimer timer(m_collisionsDuration);
+  for (size_t lane = 0; lane < m_batchPlayers.size(); lane++) {
+    Shared::Protocol::Player &player = *m_batchPlayers[lane];
+    const Shared::Protocol::Position from = player.getPosition();
+    m_batch.store(lane, player);
+    checkCollisions(player, from);
+
+    if (player.getState() == Shared::Protocol::PlayerState::PLAYING &&
+        player.getPosition().x >= m_map->getWidth()) {
+      player.setState(Shared::Protocol::PlayerState::FINISHED);
+    }
+  }
+}
+
+void Match::checkCollisions(Shared::Protocol::Player &player,
+                            const Shared::Protocol::Position from) {
+  m_map->getCollisionIndex().sweep(from, player.getPosition(), PLAYER_HITBOX,
+                                   m_hits);
+  const size_t owner = static_cast<size_t>(player.getId() - 1);
+
+  for (const CollisionIndex::Hit &hit : m_hits) {
+    const CollisionIndex::Obstacle &obstacle = *hit.obstacle;
+
+    if (obstacle.tile == Shared::Protocol::TileType::ELECTRICSQUARE) {
+      player.setState(Shared::Protocol::PlayerState::DEAD);
+      m_broadcaster.broadcastPlayerDeath(player.getId());
+      return;
+    }
+
+    CoinOwners &owners = m_coinOwners[obstacle.coin];
+    if (owners.test(owner)) {
+      continue;
+    }
+    owners.set(owner);
+    player.setScore(player.getScore() + 1);
+    m_broadcaster.broadcastCoinCollected(
+        player.getId(), obstacle.x, obstacle.y,
+        static_cast<int>(toCoinState(owners)));
+  }
+}
+
+void Match::checkGameEnd() {
+  bool allFinished = true;
+  bool anyDead = false;
+  int activePlayersCount = 0;
+
+  for (const auto &[_, player] : m_players) {
+    if (player.getState() == Shared::Protocol::PlayerState::PLAYING) {
+      allFinished = false;
+      activePlayersCount++;
+    } else if (player.getState() == Shared::Protocol::PlayerState::FINISHED) {
+      activePlayersCount++;
+    } else if (player.getState() == Shared::Protocol::PlayerState::DEAD) {
+      anyDead = true;
+    }
+  }
+
+  if ((allFinished && activePlayersCount > 0) || anyDead ||
+      (activePlayersCount < MIN_PLAYERS && m_players.size() >= MIN_PLAYERS)) {
+    m_gameState = Shared::Protocol::GameState::GAME_OVER;
+
+    m_winnerId = -1;
+    int highestScore = -1;
+
+    for (const auto &[_, player] : m_players) {
+      if (anyDead && player.getState() != Shared::Protocol::PlayerState::DEAD) {
+        m_winnerId = player.getId();
+        break;
+      }
+
+      if (player.getScore() > highestScore) {
+        highestScore = player.getScore();
+        m_winnerId = player.getId();
+      }
+    }
+
+    m_broadcaster.broadcastGameOver(m_winnerId);
+  }
+}
+
+void Match::startRecording() {
+  m_recording = std::make_unique<MatchRecording>();
+  m_recording->mapHash = m_map->getHash();
+}
+
+std::unique_ptr<MatchRecording> Match::finishRecording() {
+  if (m_recording == nullptr ||
+      m_gameState == Shared::Protocol::GameState::WAITING_FOR_PLAYERS) {
+    m_recording.reset();
+    return nullptr;
+  }
+  m_recording->outcome = getOutcome();
+  return std::move(m_recording);
+}
+
+MatchRecording::Outcome Match::getOutcome() const {
+  MatchRecording::Outcome outcome;
+  outcome.ticks = m_tick;
+  outcome.gameState = m_gameState;
+  outcome.winnerId = m_winnerId;
+  outcome.players.reserve(m_players.size());
+  for (const auto &[clientSocket, player] : m_players) {
+    outcome.players.push_back({clientSocket, player.getId(),
+                               player.getState(), player.getScore(),
+                               player.getPosition()});
+  }
+  std::ranges::sort(outcome.players, {},
+                    &MatchRecording::PlayerOutcome::socket);
+  return outcome;
+}
+
+void Match::record(const MatchRecording::EventType type,
+                   const int clientSocket, const uint8_t capabilities) {
+  if (m_recording != nullptr) {
+    m_recording->events.push_back({m_tick, type, clientSocket, capabilities});
+  }
+}
+
+} // namespace Jetpack::Server
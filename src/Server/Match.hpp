@@ -0,0 +1,404 @@
+/**
+ * @file Match.hpp
+ * @brief Declaration of the Match class, a single game room owning its
+ *        coin states, players, broadcaster and state machine.
+ */
+
+#pragma once
+
+#include "../Shared/PlayerBatch.hpp"
+#include "../Shared/Protocol.hpp"
+#include "Broadcaster.hpp"
+#include "CollisionIndex.hpp"
+#include "MapImage.hpp"
+#include "MatchRecording.hpp"
+#include "Metrics.hpp"
+#include "PacketSink.hpp"
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Jetpack::Server {
+
+/**
+ * @class Match
+ * @brief One game room hosted by the server.
+ *
+ * A Match never touches the listening socket or the poll set: the
+ * GameServer lobby hands it connected sockets, forwards their input, and
+ * closes them once the match reports it is over. Outbound packets go
+ * through the owner's PacketSink rather than straight to the sockets.
+ */
+class Match {
+public:
+  static constexpr int MAX_PLAYERS = 2;
+  static constexpr int MIN_PLAYERS = 2;
+  /** Spectators watching directly; relays serve larger audiences. */
+  static constexpr size_t MAX_SPECTATORS = 32;
+
+  /**
+   * @brief Creates a room waiting for players.
+   * @param matchId   Identifier used in debug output.
+   * @param map       Shared layout; the match only keeps one coin state
+   *                  per coin on top of it.
+   * @param sink      Queues the packets sent to seated clients.
+   * @param debugMode If true, logs players joining.
+   * @param metrics   Where the tick phases are timed, or nullptr.
+   */
+  Match(int matchId, std::shared_ptr<const MapImage> map, PacketSink &sink,
+        bool debugMode = false, WorkerMetrics *metrics = nullptr);
+
+  Match(const Match &) = delete;
+  Match &operator=(const Match &) = delete;
+  Match(Match &&) = delete;
+  Match &operator=(Match &&) = delete;
+
+  /** @return Identifier of this match. */
+  [[nodiscard]] int getId() const { return m_id; }
+
+  /**
+   * @brief Seats a freshly connected client in the room.
+   *
+   * Sends CONNECT_RESPONSE; the map follows once the client's
+   * CONNECT_REQUEST says how it wants to receive it.
+   *
+   * @param clientSocket Descriptor of the new client.
+   * @return False if the room is not accepting players.
+   */
+  bool addPlayer(int clientSocket);
+
+  /**
+   * @brief Lets a client watch the match without a seat.
+   *
+   * Sends CONNECT_RESPONSE with SPECTATOR_ID and the map with its
+   * current coins, plus GAME_START if the game is under way; from then on
+   * the spectator receives every broadcast. A streaming spectator gets
+   * MAP_INFO and the chunks from just behind the leading player, then
+   * the chunks ahead of that player as it moves. Spectators are not
+   * players: they do not count towards MAX_PLAYERS and their input is
+   * ignored.
+   *
+   * @param clientSocket Descriptor of the spectator, seated nowhere.
+   * @param capabilities CONNECT_REQUEST capabilities; only
+   *                     CAPABILITY_DELTA_STATE, CAPABILITY_PACKED_STATE and
+   *                     CAPABILITY_MAP_STREAMING matter to a spectator.
+   * @return False if the match is over or has MAX_SPECTATORS already.
+   */
+  bool addSpectator(int clientSocket, uint8_t capabilities);
+
+  /**
+   * @brief Removes a client that hung up or asked to leave.
+   * @param clientSocket Descriptor of the departing player or spectator.
+   */
+  void removePlayer(int clientSocket);
+
+  /**
+   * @brief Handles PLAYER_INPUT packets (jetpack toggle).
+   *
+   * The input is buffered and applied at the start of the next tick. For
+   * legacy clients only the latest input received before that tick is
+   * kept; sequenced inputs are queued and applied one per tick, in order,
+   * so each one matches a step of the client's prediction.
+   *
+   * @param clientSocket Sender descriptor.
+   * @param data         Packet body.
+   * @param length       Number of bytes.
+   */
+  void handlePlayerInput(int clientSocket, const uint8_t *data, size_t length);
+
+  /**
+   * @brief Handles the capability byte of a CONNECT_REQUEST.
+   *
+   * A client asking for sequenced input gets an immediate INPUT_ACK, which
+   * tells it the server understands the sequenced PLAYER_INPUT form.
+   * The client then gets the map, whole or as MAP_INFO and the chunks
+   * ahead of its start, and the game starts once every seated client has
+   * its map.
+   *
+   * @param clientSocket Sender descriptor.
+   * @param capabilities Combination of Shared::Protocol::CAPABILITY_* bits.
+   */
+  void handleConnectRequest(int clientSocket, uint8_t capabilities);
+
+  /**
+   * @brief Handles STATE_ACK packets (delta baseline acknowledgement).
+   * @param clientSocket Sender descriptor.
+   * @param data         Packet body.
+   * @param length       Number of bytes.
+   */
+  void handleStateAck(int clientSocket, const uint8_t *data, size_t length);
+
+  /**
+   * @brief Advances game logic by one tick, then streams the map chunks
+   *        players moved towards.
+   */
+  void update();
+
+  /** @return True while the room waits for players and has a free seat. */
+  [[nodiscard]] bool isAcceptingPlayers() const;
+
+  /** @return True between GAME_START and GAME_OVER. */
+  [[nodiscard]] bool isInProgress() const {
+    return m_gameState == Shared::Protocol::GameState::IN_PROGRESS;
+  }
+
+  /** @return True once GAME_OVER has been broadcast. */
+  [[nodiscard]] bool isOver() const {
+    return m_gameState == Shared::Protocol::GameState::GAME_OVER;
+  }
+
+  /** @return Number of seated players. */
+  [[nodiscard]] size_t getPlayerCount() const { return m_players.size(); }
+
+  /** @return Number of spectators. */
+  [[nodiscard]] size_t getSpectatorCount() const {
+    return m_spectators.size();
+  }
+
+  /** @return Descriptors of every seated player, then every spectator. */
+  [[nodiscard]] std::vector<int> getClientSockets() const;
+
+  /** @return Number of update() calls so far. */
+  [[nodiscard]] uint32_t getTick() const { return m_tick; }
+
+  /**
+   * @brief Sets the fixed-point precision of GAME_STATE_PACKED positions.
+   *
+   * Call before the first player is seated; the default is the legacy
+   * LEGACY_POSITION_SCALE.
+   *
+   * @param unitsPerTile Position units per tile.
+   */
+  void setPositionScale(uint16_t unitsPerTile);
+
+  /**
+   * @brief Starts logging what steers the match, from the next event on.
+   *
+   * Call before the first player is seated for the recording to replay.
+   */
+  void startRecording();
+
+  /**
+   * @brief Stops logging and returns the recording with its outcome.
+   * @return The recording, or nullptr if none was started or the game
+   *         never started.
+   */
+  [[nodiscard]] std::unique_ptr<MatchRecording> finishRecording();
+
+  /** @return How the match stands now, players by ascending socket. */
+  [[nodiscard]] MatchRecording::Outcome getOutcome() const;
+
+private:
+  /**
+   * @brief Replies to CONNECT_REQUEST with assigned player ID and count.
+   * @param clientSocket Descriptor to send on.
+   * @param playerId     ID assigned to this client.
+   */
+  void sendConnectResponse(int clientSocket, int playerId);
+
+  /** @return Where every player starts, the origin of packed state. */
+  [[nodiscard]] Shared::Protocol::Position getSpawnPosition() const;
+
+  /**
+   * @brief Sends the entire map layout and coin states to a client.
+   * @param clientSocket Descriptor to send on.
+   */
+  void sendMapData(int clientSocket);
+
+  /**
+   * @brief Sends the map dimensions that precede streamed chunks.
+   * @param clientSocket Descriptor to send on.
+   */
+  void sendMapInfo(int clientSocket);
+
+  /**
+   * @brief Sends a range of whole columns, tiles then coin states.
+   * @param clientSocket Descriptor to send on.
+   * @param firstColumn  Leftmost column of the chunk.
+   * @param columnCount  Number of columns in the chunk.
+   */
+  void sendMapChunk(int clientSocket, int firstColumn, int columnCount);
+
+  /**
+   * @brief Writes the tiles, then the coin states, of a range of whole
+   *        columns, row by row; a coin both players took reads as EMPTY.
+   * @param packet      Packet being built.
+   * @param firstColumn Leftmost column.
+   * @param columnCount Number of columns.
+   */
+  void addCells(Shared::Protocol::FrameBuilder &packet, int firstColumn,
+                int columnCount) const;
+
+  /**
+   * @param cell Row-major cell index.
+   * @return State of the coin in that cell, AVAILABLE if it holds none.
+   */
+  [[nodiscard]] Shared::Protocol::CoinState getCoinState(size_t cell) const;
+
+  /** Players who took a coin; bit n stands for player ID n + 1. */
+  using CoinOwners = std::bitset<MAX_PLAYERS>;
+
+  /**
+   * @param owners Players who took a coin.
+   * @return The coin's state as sent on the wire, which only tells
+   *         players 1 and 2 apart.
+   */
+  [[nodiscard]] static Shared::Protocol::CoinState
+  toCoinState(const CoinOwners &owners);
+
+  /**
+   * The server has always collided the player's reference point, the top
+   * left of its sprite; a wider box would change which pickups count.
+   */
+  static constexpr CollisionIndex::Hitbox PLAYER_HITBOX{0.0f, 0.0f};
+
+  /** Hits a sweep is expected to return at most, to size m_hits. */
+  static constexpr size_t MAX_HITS_PER_SWEEP = 16;
+
+  /**
+   * @brief Sends each streaming client the chunks it lacks up to
+   *        STREAM_AHEAD_COLUMNS past its player, or past the leading
+   *        player for a spectator.
+   */
+  void streamMapChunks();
+
+  /**
+   * @brief Sends a client the chunks from streamedColumns up to a column.
+   * @param clientSocket    Descriptor to send on.
+   * @param streamedColumns First column not sent yet; advanced past the
+   *                        chunks sent.
+   * @param target          Column the client should hold up to.
+   */
+  void streamMapChunksTo(int clientSocket, int &streamedColumns,
+                         int target);
+
+  /** @return Column of the player furthest along, 0 if there is none. */
+  [[nodiscard]] int getLeadingColumn() const;
+
+  /** @return Lowest player ID not used by a seated player. */
+  [[nodiscard]] int nextFreePlayerId() const;
+
+  /** Sequenced inputs a client may have waiting before old ones drop. */
+  static constexpr size_t MAX_QUEUED_INPUTS = 4;
+
+  /** Columns per MAP_CHUNK. */
+  static constexpr int MAP_CHUNK_COLUMNS = 64;
+
+  /**
+   * Columns a streaming client always holds ahead of its player; wider
+   * than the furthest the client camera looks ahead.
+   */
+  static constexpr int STREAM_AHEAD_COLUMNS = 2 * MAP_CHUNK_COLUMNS;
+
+  /** How far a seated client is through joining. */
+  struct Session {
+    /** Set once CONNECT_REQUEST arrived and the map was sent. */
+    bool joined = false;
+    bool streamsMap = false;
+    /** Columns [0, streamedColumns) have been sent as MAP_CHUNK. */
+    int streamedColumns = 0;
+  };
+
+  /** Input received from a client and not yet applied. */
+  struct PendingInput {
+    int clientSocket;
+    bool isJetpacking;
+    /** NO_INPUT_SEQUENCE for legacy input. */
+    uint16_t sequence;
+  };
+
+  /** Progress of a client sending sequenced input. */
+  struct InputAck {
+    uint16_t lastReceived = Shared::Protocol::NO_INPUT_SEQUENCE;
+    uint16_t lastApplied = Shared::Protocol::NO_INPUT_SEQUENCE;
+  };
+
+  /** @brief Applies at most one buffered input per client. */
+  void applyPendingInputs();
+
+  /**
+   * @brief Tells a sequenced client which of its inputs the next state
+   *        already includes.
+   * @param clientSocket Descriptor to send on.
+   * @param sequence     Last input applied.
+   */
+  void sendInputAck(int clientSocket, uint16_t sequence);
+
+  /**
+   * @brief Sends INPUT_ACK to every sequenced client, then the game state,
+   *        so each client pairs the state with its input history.
+   */
+  void broadcastGameState();
+
+  /**
+   * @brief If enough players are connected and all have the map, starts
+   *        the game.
+   */
+  void checkGameStart();
+
+  /**
+   * @brief Steps the physics of every playing player as one batch, then
+   *        handles each player's collisions along the way.
+   */
+  void updatePlayers();
+
+  /**
+   * @brief Handles the coin pickups and electric-square hits along one
+   *        player's motion this tick, in the order they are reached.
+   * @param player Player that moved.
+   * @param from   Where the player started the tick.
+   */
+  void checkCollisions(Shared::Protocol::Player &player,
+                       Shared::Protocol::Position from);
+
+  /** @brief Determines if game over conditions are met and broadcasts. */
+  void checkGameEnd();
+
+  /**
+   * @brief Appends an event to the recording, if one is running.
+   * @param type         What happened.
+   * @param clientSocket Client it happened to.
+   * @param capabilities Capabilities of a CONNECT request.
+   */
+  void record(MatchRecording::EventType type, int clientSocket,
+              uint8_t capabilities = 0);
+
+  int m_id;
+  bool m_debugMode;
+  std::shared_ptr<const MapImage> m_map;
+  /** Owners of each coin of m_map, in MapImage::findCoin() order. */
+  std::vector<CoinOwners> m_coinOwners;
+  /** Scratch output of collision sweeps. */
+  std::vector<CollisionIndex::Hit> m_hits;
+  /** Kinematic state of the playing players, stepped together. */
+  Shared::PlayerBatch m_batch;
+  /** Player behind each lane of m_batch. */
+  std::vector<Shared::Protocol::Player *> m_batchPlayers;
+  PacketSink &m_sink;
+  std::unordered_map<int, Shared::Protocol::Player> m_players;
+  std::vector<PendingInput> m_pendingInputs;
+  std::unordered_map<int, InputAck> m_inputAcks;
+  std::unordered_map<int, Session> m_sessions;
+  std::vector<int> m_spectators;
+  /**
+   * First column not yet sent to each streaming spectator; the chunks
+   * from where it joined up to there have been sent.
+   */
+  std::unordered_map<int, int> m_spectatorStreams;
+  Broadcaster m_broadcaster;
+  Shared::Protocol::GameState m_gameState =
+      Shared::Protocol::GameState::WAITING_FOR_PLAYERS;
+  uint32_t m_tick = 0;
+  /** Winner broadcast with GAME_OVER, or -1. */
+  int m_winnerId = -1;
+  /** Events logged so far; nullptr when not recording. */
+  std::unique_ptr<MatchRecording> m_recording;
+  /** Phase timings of updatePlayers(); nullptr when not measured. */
+  Histogram *m_physicsDuration = nullptr;
+  Histogram *m_collisionsDuration = nullptr;
+};
+
+} // namespace Jetpack::Server
@@ -0,0 +1,242 @@
+/**
+ * @file MatchRecording.cpp
+ * @brief Implements the encoding of match recordings.
+ */
+
+#include "MatchRecording.hpp"
+#include "../Shared/Exceptions.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+
+static_assert(std::endian::native == std::endian::little,
+              "recordings are encoded as little-endian");
+
+namespace {
+
+constexpr std::array<char, 8> MAGIC = {'J', 'P', 'R', 'E', 'C', 0, 0, 1};
+constexpr uint8_t NO_WINNER = 0xFF;
+
+/**
+ * @class Writer
+ * @brief Appends little-endian fields to a byte vector.
+ */
+class Writer {
+public:
+  explicit Writer(std::vector<std::byte> &out) : m_out(out) {}
+
+  void addByte(const uint8_t value) {
+    m_out.push_back(static_cast<std::byte>(value));
+  }
+
+  template <typename T> void addValue(const T value) {
+    const auto bytes = std::bit_cast<std::array<std::byte, sizeof(T)>>(value);
+    m_out.insert(m_out.end(), bytes.begin(), bytes.end());
+  }
+
+  void addVarint(uint32_t value) {
+    while (value >= 0x80) {
+      addByte(static_cast<uint8_t>(value | 0x80));
+      value >>= 7;
+    }
+    addByte(static_cast<uint8_t>(value));
+  }
+
+private:
+  std::vector<std::byte> &m_out;
+};
+
+/**
+ * @class Reader
+ * @brief Reads little-endian fields, throwing past the end of the data.
+ */
+class Reader {
+public:
+  explicit Reader(const std::span<const std::byte> data) : m_data(data) {}
+
+  uint8_t readByte() {
+    return std::to_integer<uint8_t>(take(1)[0]);
+  }
+
+  template <typename T> T readValue() {
+    std::array<std::byte, sizeof(T)> bytes;
+    std::memcpy(bytes.data(), take(sizeof(T)).data(), sizeof(T));
+    return std::bit_cast<T>(bytes);
+  }
+
+  uint32_t readVarint() {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+      const uint8_t byte = readByte();
+      value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+    throw Jetpack::Shared::Exceptions::ProtocolException(
+        "Recording varint is too long");
+  }
+
+  std::span<const std::byte> take(const size_t size) {
+    if (size > m_data.size() - m_offset) {
+      throw Jetpack::Shared::Exceptions::ProtocolException(
+          "Recording is truncated");
+    }
+    const std::span<const std::byte> bytes = m_data.subspan(m_offset, size);
+    m_offset += size;
+    return bytes;
+  }
+
+  [[nodiscard]] bool atEnd() const { return m_offset == m_data.size(); }
+
+private:
+  std::span<const std::byte> m_data;
+  size_t m_offset = 0;
+};
+
+} // namespace
+
+namespace Jetpack::Server {
+
+std::vector<std::byte> MatchRecording::serialize() const {
+  std::vector<std::byte> out;
+  out.reserve(32 + events.size() * 3 + outcome.players.size() * 18);
+  Writer writer(out);
+
+  for (const char c : MAGIC) {
+    writer.addByte(static_cast<uint8_t>(c));
+  }
+  writer.addValue<uint64_t>(mapHash);
+  writer.addValue<uint32_t>(static_cast<uint32_t>(events.size()));
+
+  uint32_t tick = 0;
+  for (const Event &event : events) {
+    writer.addVarint(event.tick - tick);
+    tick = event.tick;
+    writer.addByte(static_cast<uint8_t>(event.type));
+    writer.addVarint(static_cast<uint32_t>(event.socket));
+    if (event.type == EventType::CONNECT) {
+      writer.addByte(event.capabilities);
+    }
+  }
+
+  writer.addValue<uint32_t>(outcome.ticks);
+  writer.addByte(static_cast<uint8_t>(outcome.gameState));
+  writer.addByte(outcome.winnerId > 0 ? static_cast<uint8_t>(outcome.winnerId)
+                                      : NO_WINNER);
+  writer.addByte(static_cast<uint8_t>(outcome.players.size()));
+  for (const PlayerOutcome &player : outcome.players) {
+    writer.addValue<int32_t>(player.socket);
+    writer.addByte(static_cast<uint8_t>(player.id));
+    writer.addByte(static_cast<uint8_t>(player.state));
+    writer.addValue<int32_t>(player.score);
+    writer.addValue<float>(player.position.x);
+    writer.addValue<float>(player.position.y);
+  }
+  return out;
+}
+
+MatchRecording
+MatchRecording::deserialize(const std::span<const std::byte> data) {
+  Reader reader(data);
+  if (std::memcmp(reader.take(MAGIC.size()).data(), MAGIC.data(),
+                  MAGIC.size()) != 0) {
+    throw Shared::Exceptions::ProtocolException("Not a match recording");
+  }
+
+  MatchRecording recording;
+  recording.mapHash = reader.readValue<uint64_t>();
+
+  const uint32_t eventCount = reader.readValue<uint32_t>();
+  // Every event takes at least three bytes, which bounds the reservation.
+  recording.events.reserve(std::min<size_t>(eventCount, data.size() / 3));
+  uint32_t tick = 0;
+  for (uint32_t i = 0; i < eventCount; i++) {
+    Event &event = recording.events.emplace_back();
+    tick += reader.readVarint();
+    event.tick = tick;
+    const uint8_t type = reader.readByte();
+    if (type > static_cast<uint8_t>(EventType::JETPACK_OFF)) {
+      throw Shared::Exceptions::ProtocolException(
+          std::format("Unknown recording event type {}", type));
+    }
+    event.type = static_cast<EventType>(type);
+    event.socket = static_cast<int>(reader.readVarint());
+    if (event.type == EventType::CONNECT) {
+      event.capabilities = reader.readByte();
+    }
+  }
+
+  Outcome &outcome = recording.outcome;
+  outcome.ticks = reader.readValue<uint32_t>();
+  outcome.gameState = static_cast<Shared::Protocol::GameState>(
+      reader.readByte());
+  const uint8_t winnerId = reader.readByte();
+  outcome.winnerId = winnerId != NO_WINNER ? winnerId : -1;
+
+  const uint8_t playerCount = reader.readByte();
+  for (uint8_t i = 0; i < playerCount; i++) {
+    PlayerOutcome &player = outcome.players.emplace_back();
+    player.socket = reader.readValue<int32_t>();
+    player.id = reader.readByte();
+    player.state = static_cast<Shared::Protocol::PlayerState>(
+        reader.readByte());
+    player.score = reader.readValue<int32_t>();
+    player.position.x = reader.readValue<float>();
+    player.position.y = reader.readValue<float>();
+  }
+
+  if (!reader.atEnd()) {
+    throw Shared::Exceptions::ProtocolException(
+        "Trailing bytes after recording");
+  }
+  return recording;
+}
+
+void MatchRecording::save(const std::filesystem::path &path) const {
+  const std::vector<std::byte> data = serialize();
+  const std::filesystem::path temporary =
+      path.string() + ".tmp" + std::to_string(getpid());
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file.write(reinterpret_cast<const char *>(data.data()),
+                    static_cast<std::streamsize>(data.size()))) {
+      file.close();
+      std::error_code error;
+      std::filesystem::remove(temporary, error);
+      throw Shared::Exceptions::ResourceException(
+          std::format("Cannot write recording '{}'", path.string()));
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporary, path, error);
+  if (error) {
+    std::filesystem::remove(temporary, error);
+    throw Shared::Exceptions::ResourceException(
+        std::format("Cannot write recording '{}'", path.string()));
+  }
+}
+
+MatchRecording MatchRecording::load(const std::filesystem::path &path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    throw Shared::Exceptions::ResourceException(path, "Cannot open file");
+  }
+  std::vector<char> contents((std::istreambuf_iterator<char>(file)),
+                             std::istreambuf_iterator<char>());
+
+  try {
+    return deserialize(std::as_bytes(std::span(contents)));
+  } catch (const Shared::Exceptions::ProtocolException &e) {
+    throw Shared::Exceptions::ResourceException(path, e.what());
+  }
+}
+
+} // namespace Jetpack::Server
@@ -0,0 +1,134 @@
+/**
+ * @file MatchRecording.hpp
+ * @brief Declaration of MatchRecording, the compact log of a match that
+ *        is enough to simulate it again.
+ */
+
+#pragma once
+
+#include "../Shared/Protocol.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace Jetpack::Server {
+
+/**
+ * @struct MatchRecording
+ * @brief Everything that steered a match, and how it ended.
+ *
+ * The simulation is deterministic given the map and what the players did,
+ * so a recording keeps only the map hash and the events that reached the
+ * match, each stamped with the number of ticks run before it: players
+ * joining, connecting and leaving, and every change of jetpack state a
+ * tick applied. Clients are named by their socket, which also fixes the
+ * order the match visits them in. The outcome lets a replay check that
+ * it ended the same way.
+ *
+ * Files are little-endian:
+ *
+ *     Magic (8) | Map Hash (8) | Event Count (4) | Events |
+ *     Ticks (4) | Game State (1) | Winner ID (1) | Player Count (1) |
+ *     Players
+ *
+ * where an event is Tick Delta (varint) | Type (1) | Socket (varint),
+ * followed by Capabilities (1) for CONNECT, and a player is Socket (4) |
+ * ID (1) | State (1) | Score (4) | X (4) | Y (4). Varints are LEB128;
+ * the winner ID 0xFF means no winner.
+ */
+struct MatchRecording {
+  /** File name suffix of recordings. */
+  static constexpr const char *FILE_SUFFIX = ".jrec";
+
+  /**
+   * @enum EventType
+   * @brief What happened to a client.
+   */
+  enum class EventType : uint8_t {
+    JOIN = 0,
+    CONNECT = 1,
+    LEAVE = 2,
+    JETPACK_ON = 3,
+    JETPACK_OFF = 4
+  };
+
+  /**
+   * @struct Event
+   * @brief One thing a client did.
+   */
+  struct Event {
+    /** Ticks the match had run when the event reached it. */
+    uint32_t tick = 0;
+    EventType type = EventType::JOIN;
+    int socket = -1;
+    /** Capabilities of a CONNECT request. */
+    uint8_t capabilities = 0;
+  };
+
+  /**
+   * @struct PlayerOutcome
+   * @brief Final state of one player.
+   */
+  struct PlayerOutcome {
+    int socket = -1;
+    int id = 0;
+    Shared::Protocol::PlayerState state =
+        Shared::Protocol::PlayerState::CONNECTED;
+    int score = 0;
+    Shared::Protocol::Position position;
+
+    bool operator==(const PlayerOutcome &other) const = default;
+  };
+
+  /**
+   * @struct Outcome
+   * @brief How a match ended.
+   */
+  struct Outcome {
+    uint32_t ticks = 0;
+    Shared::Protocol::GameState gameState =
+        Shared::Protocol::GameState::WAITING_FOR_PLAYERS;
+    /** ID of the winning player, or -1. */
+    int winnerId = -1;
+    /** Players left at the end, by ascending socket. */
+    std::vector<PlayerOutcome> players;
+
+    bool operator==(const Outcome &other) const = default;
+  };
+
+  uint64_t mapHash = 0;
+  std::vector<Event> events;
+  Outcome outcome;
+
+  /**
+   * @brief Writes the recording to a file.
+   * @param path File to create or replace.
+   * @throws Shared::Exceptions::ResourceException if it cannot be written.
+   */
+  void save(const std::filesystem::path &path) const;
+
+  /**
+   * @brief Reads a recording written by save().
+   * @param path Recording file.
+   * @return The recording.
+   * @throws Shared::Exceptions::ResourceException if it cannot be read or
+   *         is malformed.
+   */
+  [[nodiscard]] static MatchRecording load(const std::filesystem::path &path);
+
+  /** @return The recording encoded as described above. */
+  [[nodiscard]] std::vector<std::byte> serialize() const;
+
+  /**
+   * @brief Decodes a recording.
+   * @param data Encoded recording.
+   * @return The recording.
+   * @throws Shared::Exceptions::ProtocolException if it is malformed.
+   */
+  [[nodiscard]] static MatchRecording
+  deserialize(std::span<const std::byte> data);
+};
+
+} // namespace Jetpack::Server
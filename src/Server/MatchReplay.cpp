@@ -0,0 +1,167 @@
+/**
+ * @file MatchReplay.cpp
+ * @brief Implements the re-simulation of recorded matches.
+ */
+
+#include "MatchReplay.hpp"
+#include "../Shared/Exceptions.hpp"
+#include "Match.hpp"
+#include "PacketSink.hpp"
+#include <algorithm>
+#include <array>
+#include <format>
+#include <string>
+#include <vector>
+
+namespace Jetpack::Server::Replay {
+
+namespace {
+
+/**
+ * @class NullSink
+ * @brief PacketSink that drops every frame, rewinding its arena whenever
+ *        the replay would have flushed.
+ */
+class NullSink : public PacketSink {
+public:
+  void queueFrame(int, const Shared::Protocol::Frame &) override {}
+
+  Shared::Arena &getFrameArena() override { return m_arena; }
+
+  /** @brief Ends a loop iteration, like a worker after flushing. */
+  void flush() { m_arena.reset(); }
+
+private:
+  Shared::Arena m_arena;
+};
+
+/**
+ * @brief Hands one recorded event to the match, as the worker did.
+ * @param match Match being replayed.
+ * @param event Event to apply.
+ */
+void dispatch(Match &match, const MatchRecording::Event &event) {
+  using EventType = MatchRecording::EventType;
+
+  switch (event.type) {
+  case EventType::JOIN:
+    match.addPlayer(event.socket);
+    break;
+  case EventType::CONNECT:
+    match.handleConnectRequest(event.socket, event.capabilities);
+    break;
+  case EventType::LEAVE:
+    match.removePlayer(event.socket);
+    break;
+  case EventType::JETPACK_ON:
+  case EventType::JETPACK_OFF: {
+    // Recorded inputs are the ones the next tick applied, so the legacy
+    // form, which that tick applies whatever preceded it, replays them.
+    const uint8_t flags = event.type == EventType::JETPACK_ON
+                              ? Shared::Protocol::InputFlag::JETPACK
+                              : 0;
+    const std::array<uint8_t, 2> input = {
+        static_cast<uint8_t>(Shared::Protocol::PacketType::PLAYER_INPUT),
+        flags};
+    match.handlePlayerInput(event.socket, input.data(), input.size());
+    break;
+  }
+  }
+}
+
+/** @return A one-line account of an outcome, for mismatch reports. */
+std::string describe(const MatchRecording::Outcome &outcome) {
+  std::string text =
+      std::format("{} ticks, state {}, winner {}", outcome.ticks,
+                  static_cast<int>(outcome.gameState), outcome.winnerId);
+  for (const MatchRecording::PlayerOutcome &player : outcome.players) {
+    text += std::format("; player {} state {} score {} at ({}, {})",
+                        player.id, static_cast<int>(player.state),
+                        player.score, player.position.x, player.position.y);
+  }
+  return text;
+}
+
+/**
+ * @brief Lists the recordings named by the paths.
+ * @param paths Recordings or directories of recordings.
+ * @return Every file to replay, each directory's sorted by name.
+ */
+std::vector<std::filesystem::path>
+collectRecordings(const std::span<const std::filesystem::path> paths) {
+  std::vector<std::filesystem::path> files;
+  for (const std::filesystem::path &path : paths) {
+    if (!std::filesystem::is_directory(path)) {
+      files.push_back(path);
+      continue;
+    }
+
+    const size_t first = files.size();
+    for (const auto &entry : std::filesystem::directory_iterator(path)) {
+      if (entry.is_regular_file() &&
+          entry.path().extension() == MatchRecording::FILE_SUFFIX) {
+        files.push_back(entry.path());
+      }
+    }
+    std::sort(files.begin() + static_cast<std::ptrdiff_t>(first),
+              files.end());
+  }
+  return files;
+}
+
+} // namespace
+
+MatchRecording::Outcome run(const MatchRecording &recording,
+                            std::shared_ptr<const MapImage> map) {
+  if (recording.mapHash != map->getHash()) {
+    throw Shared::Exceptions::ResourceException(
+        "Recording was made on another map");
+  }
+
+  NullSink sink;
+  Match match(0, std::move(map), sink);
+  const auto advanceTo = [&match, &sink](const uint32_t tick) {
+    while (match.getTick() < tick) {
+      match.update();
+      sink.flush();
+    }
+  };
+
+  for (const MatchRecording::Event &event : recording.events) {
+    advanceTo(event.tick);
+    dispatch(match, event);
+  }
+  advanceTo(recording.outcome.ticks);
+  sink.flush();
+  return match.getOutcome();
+}
+
+Summary runAll(const std::span<const std::filesystem::path> paths,
+               const std::shared_ptr<const MapImage> &map,
+               std::ostream &log) {
+  Summary summary;
+  for (const std::filesystem::path &path : collectRecordings(paths)) {
+    summary.replayed++;
+    try {
+      const MatchRecording recording = MatchRecording::load(path);
+
+      const auto start = std::chrono::steady_clock::now();
+      const MatchRecording::Outcome outcome = run(recording, map);
+      summary.elapsed += std::chrono::steady_clock::now() - start;
+      summary.ticks += outcome.ticks;
+
+      if (outcome != recording.outcome) {
+        summary.mismatches++;
+        log << std::format("{}: recorded {}\n{}: replayed {}\n",
+                           path.string(), describe(recording.outcome),
+                           path.string(), describe(outcome));
+      }
+    } catch (const Shared::Exceptions::Exception &e) {
+      summary.mismatches++;
+      log << std::format("{}: {}\n", path.string(), e.what());
+    }
+  }
+  return summary;
+}
+
+} // namespace Jetpack::Server::Replay
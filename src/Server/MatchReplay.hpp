@@ -0,0 +1,62 @@
+/**
+ * @file MatchReplay.hpp
+ * @brief Re-simulation of recorded matches without sockets or a clock.
+ */
+
+#pragma once
+
+#include "MapImage.hpp"
+#include "MatchRecording.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <ostream>
+#include <span>
+
+namespace Jetpack::Server::Replay {
+
+/**
+ * @struct Summary
+ * @brief What a batch of replays found.
+ */
+struct Summary {
+  size_t replayed = 0;
+  /** Recordings that ended differently, or could not be replayed. */
+  size_t mismatches = 0;
+  /** Ticks simulated over every replay. */
+  uint64_t ticks = 0;
+  /** Time spent simulating, file reads excluded. */
+  std::chrono::nanoseconds elapsed{0};
+};
+
+/**
+ * @brief Runs a recorded match again, back to back with no tick clock.
+ *
+ * The events are fed to a real Match at the tick they reached the
+ * original, and its packets are dropped, so the replay goes through the
+ * same physics, collisions and game rules as a live match.
+ *
+ * @param recording Recording to replay.
+ * @param map       Layout the match was played on.
+ * @return How the replay ended.
+ * @throws Shared::Exceptions::ResourceException if the recording was made
+ *         on another layout.
+ */
+[[nodiscard]] MatchRecording::Outcome
+run(const MatchRecording &recording, std::shared_ptr<const MapImage> map);
+
+/**
+ * @brief Replays recordings and compares each outcome with the original.
+ * @param paths Recordings, or directories whose recordings are all
+ *              replayed.
+ * @param map   Layout the matches were played on.
+ * @param log   Receives one line per recording that does not match.
+ * @return What the batch found.
+ */
+[[nodiscard]] Summary runAll(std::span<const std::filesystem::path> paths,
+                             const std::shared_ptr<const MapImage> &map,
+                             std::ostream &log);
+
+} // namespace Jetpack::Server::Replay
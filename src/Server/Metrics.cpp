@@ -0,0 +1,188 @@
+/**
+ * @file Metrics.cpp
+ * @brief Implements the Prometheus rendering of the worker metrics.
+ */
+
+#include "Metrics.hpp"
+#include <format>
+#include <string_view>
+
+namespace Jetpack::Server {
+
+namespace {
+
+/**
+ * @struct Bound
+ * @brief Upper bound of an exported bucket: its label and raw value.
+ */
+struct Bound {
+  std::string_view label;
+  uint64_t value;
+};
+
+/** Duration buckets, 1 µs to 1 s in 1-2.5-5 steps, labelled in seconds. */
+constexpr Bound DURATION_BOUNDS[] = {
+    {"0.000001", 1'000},       {"0.0000025", 2'500},
+    {"0.000005", 5'000},       {"0.00001", 10'000},
+    {"0.000025", 25'000},      {"0.00005", 50'000},
+    {"0.0001", 100'000},       {"0.00025", 250'000},
+    {"0.0005", 500'000},       {"0.001", 1'000'000},
+    {"0.0025", 2'500'000},     {"0.005", 5'000'000},
+    {"0.01", 10'000'000},      {"0.025", 25'000'000},
+    {"0.05", 50'000'000},      {"0.1", 100'000'000},
+    {"0.25", 250'000'000},     {"0.5", 500'000'000},
+    {"1", 1'000'000'000}};
+
+constexpr Bound WAKEUP_BOUNDS[] = {{"0", 0},   {"1", 1},   {"2", 2},
+                                   {"4", 4},   {"8", 8},   {"16", 16},
+                                   {"32", 32}, {"64", 64}, {"128", 128}};
+
+constexpr Bound BYTE_BOUNDS[] = {{"64", 64},         {"256", 256},
+                                 {"1024", 1024},     {"4096", 4096},
+                                 {"16384", 16384},   {"65536", 65536},
+                                 {"262144", 262144}, {"1048576", 1048576}};
+
+/**
+ * @struct HistogramFamily
+ * @brief An exported histogram: name, help, field and bucket bounds.
+ */
+struct HistogramFamily {
+  std::string_view name;
+  std::string_view help;
+  Histogram WorkerMetrics::*field;
+  std::span<const Bound> bounds;
+  /** True for nanosecond samples, exported in seconds. */
+  bool seconds;
+};
+
+constexpr HistogramFamily HISTOGRAMS[] = {
+    {"jetpack_tick_duration_seconds",
+     "Time of one simulation step of every match on the worker.",
+     &WorkerMetrics::tickDuration, DURATION_BOUNDS, true},
+    {"jetpack_socket_events_duration_seconds",
+     "Time spent handling the sockets of one event loop wakeup.",
+     &WorkerMetrics::socketEventsDuration, DURATION_BOUNDS, true},
+    {"jetpack_flush_duration_seconds",
+     "Time spent writing queued frames at the end of a loop iteration.",
+     &WorkerMetrics::flushDuration, DURATION_BOUNDS, true},
+    {"jetpack_physics_duration_seconds",
+     "Time of the physics step of one match.",
+     &WorkerMetrics::physicsDuration, DURATION_BOUNDS, true},
+    {"jetpack_collisions_duration_seconds",
+     "Time of the collision checks of one match.",
+     &WorkerMetrics::collisionsDuration, DURATION_BOUNDS, true},
+    {"jetpack_wakeups_per_tick", "Event loop wakeups between two ticks.",
+     &WorkerMetrics::wakeupsPerTick, WAKEUP_BOUNDS, false},
+    {"jetpack_send_queue_bytes",
+     "Bytes queued for a client when its queue is flushed.",
+     &WorkerMetrics::sendQueueBytes, BYTE_BOUNDS, false}};
+
+/**
+ * @struct CounterFamily
+ * @brief An exported counter or gauge: name, help and field.
+ */
+struct CounterFamily {
+  std::string_view name;
+  std::string_view help;
+  Counter WorkerMetrics::*field;
+  std::string_view type;
+};
+
+constexpr CounterFamily COUNTERS[] = {
+    {"jetpack_wakeups_total", "Event loop wakeups.", &WorkerMetrics::wakeups,
+     "counter"},
+    {"jetpack_ticks_total", "Simulation steps run.", &WorkerMetrics::ticks,
+     "counter"},
+    {"jetpack_tick_overruns_total",
+     "Steps run more than one period after their deadline.",
+     &WorkerMetrics::tickOverruns, "counter"},
+    {"jetpack_dropped_ticks_total",
+     "Steps skipped because the worker fell too far behind.",
+     &WorkerMetrics::droppedTicks, "counter"},
+    {"jetpack_sent_packets_total", "Packets queued for clients.",
+     &WorkerMetrics::packetsSent, "counter"},
+    {"jetpack_sent_bytes_total", "Bytes queued for clients.",
+     &WorkerMetrics::bytesSent, "counter"},
+    {"jetpack_short_writes_total",
+     "Flushes that left bytes waiting for the socket.",
+     &WorkerMetrics::shortWrites, "counter"},
+    {"jetpack_received_packets_total", "Packets received from clients.",
+     &WorkerMetrics::packetsReceived, "counter"},
+    {"jetpack_received_bytes_total", "Bytes of packets received.",
+     &WorkerMetrics::bytesReceived, "counter"},
+    {"jetpack_backlog_disconnects_total",
+     "Clients dropped for exceeding the send backlog.",
+     &WorkerMetrics::backlogDisconnects, "counter"},
+    {"jetpack_sent_datagrams_total", "UDP datagrams sent to clients.",
+     &WorkerMetrics::datagramsSent, "counter"},
+    {"jetpack_received_datagrams_total",
+     "UDP datagrams accepted from clients.",
+     &WorkerMetrics::datagramsReceived, "counter"},
+    {"jetpack_datagram_fallbacks_total",
+     "Clients moved back to TCP after their datagrams stopped.",
+     &WorkerMetrics::datagramFallbacks, "counter"},
+    {"jetpack_connections", "Connected clients.",
+     &WorkerMetrics::connections, "gauge"},
+    {"jetpack_matches", "Open matches.", &WorkerMetrics::matches, "gauge"}};
+
+/**
+ * @brief Appends one worker's series of a histogram.
+ *
+ * A bucket of the recorded histogram counts towards a bound once all its
+ * samples are at or below it, so exported counts are exact to 1/16.
+ */
+void renderHistogram(std::string &out, const HistogramFamily &family,
+                     const size_t worker, const Histogram &histogram) {
+  uint64_t cumulative = 0;
+  size_t bucket = 0;
+  for (const Bound &bound : family.bounds) {
+    for (; bucket < Histogram::BUCKET_COUNT &&
+           Histogram::getBucketMax(bucket) <= bound.value;
+         bucket++) {
+      cumulative += histogram.getBucket(bucket);
+    }
+    out += std::format("{}_bucket{{worker=\"{}\",le=\"{}\"}} {}\n",
+                       family.name, worker, bound.label, cumulative);
+  }
+  for (; bucket < Histogram::BUCKET_COUNT; bucket++) {
+    cumulative += histogram.getBucket(bucket);
+  }
+  out += std::format("{}_bucket{{worker=\"{}\",le=\"+Inf\"}} {}\n",
+                     family.name, worker, cumulative);
+
+  const uint64_t sum = histogram.getSum();
+  if (family.seconds) {
+    out += std::format("{}_sum{{worker=\"{}\"}} {}.{:09}\n", family.name,
+                       worker, sum / 1'000'000'000, sum % 1'000'000'000);
+  } else {
+    out += std::format("{}_sum{{worker=\"{}\"}} {}\n", family.name, worker,
+                       sum);
+  }
+  out += std::format("{}_count{{worker=\"{}\"}} {}\n", family.name, worker,
+                     cumulative);
+}
+
+} // namespace
+
+std::string
+renderPrometheus(const std::span<const WorkerMetrics *const> workers) {
+  std::string out;
+  for (const HistogramFamily &family : HISTOGRAMS) {
+    out += std::format("# HELP {} {}\n# TYPE {} histogram\n", family.name,
+                       family.help, family.name);
+    for (size_t i = 0; i < workers.size(); i++) {
+      renderHistogram(out, family, i, workers[i]->*family.field);
+    }
+  }
+  for (const CounterFamily &family : COUNTERS) {
+    out += std::format("# HELP {} {}\n# TYPE {} {}\n", family.name,
+                       family.help, family.name, family.type);
+    for (size_t i = 0; i < workers.size(); i++) {
+      out += std::format("{}{{worker=\"{}\"}} {}\n", family.name, i,
+                         (workers[i]->*family.field).get());
+    }
+  }
+  return out;
+}
+
+} // namespace Jetpack::Server
@@ -0,0 +1,213 @@
+/**
+ * @file Metrics.hpp
+ * @brief Declaration of the per-worker counters and histograms the server
+ *        exposes to monitoring, and of their Prometheus text rendering.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+namespace Jetpack::Server {
+
+/**
+ * @class Counter
+ * @brief Monotonic count written by one thread and read by any.
+ *
+ * The owner thread is the only writer, so add() is a plain load and store
+ * rather than a locked read-modify-write; readers see a recent value.
+ */
+class Counter {
+public:
+  /** @param amount Amount to add; owner thread only. */
+  void add(const uint64_t amount = 1) {
+    m_value.store(m_value.load(std::memory_order_relaxed) + amount,
+                  std::memory_order_relaxed);
+  }
+
+  /** @param value New value, for counts kept elsewhere; owner only. */
+  void set(const uint64_t value) {
+    m_value.store(value, std::memory_order_relaxed);
+  }
+
+  /** @return The current value. */
+  [[nodiscard]] uint64_t get() const {
+    return m_value.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::atomic<uint64_t> m_value{0};
+};
+
+/**
+ * @class Histogram
+ * @brief Log-linear histogram of integer samples, HDR-style.
+ *
+ * Samples below SUB_BUCKETS get a bucket each; above that every power of
+ * two is split into SUB_BUCKETS buckets, so any sample is known to within
+ * 1/16 of its value while the whole range up to 2^36 (about 68 s in
+ * nanoseconds) fits in a few kilobytes. Like Counter, it has one writer.
+ */
+class Histogram {
+public:
+  /** Buckets per power of two. */
+  static constexpr uint64_t SUB_BUCKETS = 16;
+  /** Samples at or above 2^MAX_BITS share the last bucket. */
+  static constexpr int MAX_BITS = 36;
+  static constexpr size_t BUCKET_COUNT =
+      (MAX_BITS - std::bit_width(SUB_BUCKETS) + 2) * SUB_BUCKETS;
+
+  /** @param value Sample to record; owner thread only. */
+  void record(const uint64_t value) {
+    std::atomic<uint64_t> &bucket = m_buckets[getBucketIndex(value)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1,
+                 std::memory_order_relaxed);
+    m_sum.store(m_sum.load(std::memory_order_relaxed) + value,
+                std::memory_order_relaxed);
+  }
+
+  /**
+   * @param index Bucket index, below BUCKET_COUNT.
+   * @return Samples recorded in that bucket.
+   */
+  [[nodiscard]] uint64_t getBucket(const size_t index) const {
+    return m_buckets[index].load(std::memory_order_relaxed);
+  }
+
+  /** @return Sum of every sample. */
+  [[nodiscard]] uint64_t getSum() const {
+    return m_sum.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @param value A sample.
+   * @return Index of the bucket it is counted in.
+   */
+  static size_t getBucketIndex(const uint64_t value) {
+    if (value < SUB_BUCKETS) {
+      return value;
+    }
+    const int shift = std::bit_width(value) - std::bit_width(SUB_BUCKETS);
+    const size_t index = static_cast<size_t>(shift + 1) * SUB_BUCKETS +
+                         ((value >> shift) - SUB_BUCKETS);
+    return std::min(index, BUCKET_COUNT - 1);
+  }
+
+  /**
+   * @param index Bucket index, below BUCKET_COUNT.
+   * @return Largest sample counted in that bucket.
+   */
+  static uint64_t getBucketMax(const size_t index) {
+    if (index < SUB_BUCKETS) {
+      return index;
+    }
+    if (index == BUCKET_COUNT - 1) {
+      return UINT64_MAX;
+    }
+    const size_t shift = index / SUB_BUCKETS - 1;
+    return ((index % SUB_BUCKETS + SUB_BUCKETS + 1) << shift) - 1;
+  }
+
+private:
+  std::array<std::atomic<uint64_t>, BUCKET_COUNT> m_buckets{};
+  std::atomic<uint64_t> m_sum{0};
+};
+
+/**
+ * @class ScopedTimer
+ * @brief Records the nanoseconds a scope took into a histogram.
+ */
+class ScopedTimer {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /** @param histogram Where to record, or nullptr to time nothing. */
+  explicit ScopedTimer(Histogram *histogram)
+      : m_histogram(histogram),
+        m_start(histogram != nullptr ? Clock::now() : Clock::time_point()) {}
+
+  ~ScopedTimer() {
+    if (m_histogram != nullptr) {
+      m_histogram->record(static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                               m_start)
+              .count()));
+    }
+  }
+
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+  ScopedTimer(ScopedTimer &&) = delete;
+  ScopedTimer &operator=(ScopedTimer &&) = delete;
+
+private:
+  Histogram *m_histogram;
+  Clock::time_point m_start;
+};
+
+/**
+ * @struct WorkerMetrics
+ * @brief Everything one worker measures about its loop and its clients.
+ *
+ * The worker thread writes; the acceptor thread renders them on scrape.
+ * Durations are in nanoseconds. Per-connection figures are summed over
+ * the worker's clients, and their spread kept in histograms, so a scrape
+ * stays the same size however many clients are connected.
+ */
+struct WorkerMetrics {
+  /** One simulation step of every match on the worker. */
+  Histogram tickDuration;
+  /** Handling the sockets that one wakeup reported ready. */
+  Histogram socketEventsDuration;
+  /** Writing every queued frame at the end of a loop iteration. */
+  Histogram flushDuration;
+  /** Physics step of one match's players. */
+  Histogram physicsDuration;
+  /** Collision sweeps of one match's players. */
+  Histogram collisionsDuration;
+  /** Event loop wakeups between two simulation steps. */
+  Histogram wakeupsPerTick;
+  /** Bytes a client had queued when its queue was flushed. */
+  Histogram sendQueueBytes;
+
+  Counter wakeups;
+  Counter ticks;
+  Counter tickOverruns;
+  Counter droppedTicks;
+  Counter packetsSent;
+  Counter bytesSent;
+  /** Flushes the socket did not fully accept. */
+  Counter shortWrites;
+  Counter packetsReceived;
+  Counter bytesReceived;
+  /** Clients dropped for exceeding the send backlog. */
+  Counter backlogDisconnects;
+  Counter datagramsSent;
+  Counter datagramsReceived;
+  /** Clients moved back to TCP after their datagrams stopped. */
+  Counter datagramFallbacks;
+
+  /** Connected clients, as a gauge. */
+  Counter connections;
+  /** Open matches, as a gauge. */
+  Counter matches;
+};
+
+/**
+ * @brief Renders the metrics of every worker in the Prometheus text
+ *        exposition format, one series per worker.
+ * @param workers Metrics of each worker, labelled by index.
+ * @return The exposition, "\n"-terminated.
+ */
+[[nodiscard]] std::string
+renderPrometheus(std::span<const WorkerMetrics *const> workers);
+
+} // namespace Jetpack::Server
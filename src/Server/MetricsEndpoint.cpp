@@ -0,0 +1,211 @@
+/**
+ * @file MetricsEndpoint.cpp
+ * @brief Implements the MetricsEndpoint class.
+ */
+
+#include "MetricsEndpoint.hpp"
+#include "../Shared/Exceptions.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <format>
+#include <string_view>
+#include <sys/fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <utility>
+
+namespace Jetpack::Server {
+
+MetricsEndpoint::MetricsEndpoint(const int listenSocket, EventLoop &eventLoop,
+                                 Renderer render)
+    : m_listenSocket(listenSocket), m_eventLoop(eventLoop),
+      m_render(std::move(render)) {
+  try {
+    m_eventLoop.add(m_listenSocket, EVENT_READ);
+  } catch (const Shared::Exceptions::SocketException &) {
+    close(m_listenSocket);
+    throw;
+  }
+}
+
+MetricsEndpoint::~MetricsEndpoint() {
+  for (const auto &[socket, _] : m_scrapes) {
+    m_eventLoop.remove(socket);
+    close(socket);
+  }
+  m_eventLoop.remove(m_listenSocket);
+  close(m_listenSocket);
+}
+
+bool MetricsEndpoint::handleEvent(const IoEvent &event) {
+  if (event.fd == m_listenSocket) {
+    if (event.readable) {
+      acceptScrapes();
+    }
+    return true;
+  }
+
+  const auto it = m_scrapes.find(event.fd);
+  if (it == m_scrapes.end()) {
+    return false;
+  }
+
+  if (it->second.response.empty()) {
+    if (event.readable || event.hangup) {
+      readRequest(event.fd, it->second);
+    }
+  } else if (event.writable || event.hangup) {
+    writeResponse(event.fd, it->second);
+  }
+  return true;
+}
+
+int MetricsEndpoint::getTimeout(const Clock::time_point now) const {
+  if (m_scrapes.empty()) {
+    return -1;
+  }
+
+  Clock::time_point next = Clock::time_point::max();
+  for (const auto &[_, scrape] : m_scrapes) {
+    next = std::min(next, scrape.deadline);
+  }
+  if (next <= now) {
+    return 0;
+  }
+  return static_cast<int>(
+      std::chrono::ceil<std::chrono::milliseconds>(next - now).count());
+}
+
+void MetricsEndpoint::closeExpiredScrapes(const Clock::time_point now) {
+  for (auto it = m_scrapes.begin(); it != m_scrapes.end();) {
+    if (it->second.deadline <= now) {
+      m_eventLoop.remove(it->first);
+      close(it->first);
+      it = m_scrapes.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void MetricsEndpoint::acceptScrapes() {
+  closeExpiredScrapes(Clock::now());
+  while (true) {
+    const int socket = accept(m_listenSocket, nullptr, nullptr);
+    if (socket < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+
+    if (m_scrapes.size() >= MAX_SCRAPES) {
+      close(socket);
+      continue;
+    }
+
+    const int flags = fcntl(socket, F_GETFL, 0);
+    fcntl(socket, F_SETFL, flags | O_NONBLOCK);
+    try {
+      m_eventLoop.add(socket, EVENT_READ);
+    } catch (const Shared::Exceptions::SocketException &) {
+      close(socket);
+      continue;
+    }
+
+    // Scrapers usually send the request with the connection; answering
+    // now saves a trip around the loop.
+    Scrape &scrape = m_scrapes[socket];
+    scrape.deadline = Clock::now() + SCRAPE_TIMEOUT;
+    readRequest(socket, scrape);
+  }
+}
+
+void MetricsEndpoint::readRequest(const int socket, Scrape &scrape) {
+  char buffer[1024];
+  while (scrape.request.size() <= MAX_REQUEST_SIZE) {
+    const ssize_t bytesRead = recv(socket, buffer, sizeof(buffer), 0);
+    if (bytesRead > 0) {
+      scrape.request.append(buffer, static_cast<size_t>(bytesRead));
+      continue;
+    }
+    if (bytesRead < 0 && errno == EINTR) {
+      continue;
+    }
+    if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    }
+    if (bytesRead == 0 &&
+        scrape.request.find("\r\n\r\n") != std::string::npos) {
+      // The scraper shut down its side after the request; it still reads.
+      break;
+    }
+    closeScrape(socket);
+    return;
+  }
+
+  const size_t headersEnd = scrape.request.find("\r\n\r\n");
+  if (headersEnd == std::string::npos &&
+      scrape.request.size() <= MAX_REQUEST_SIZE) {
+    return;
+  }
+
+  scrape.response = respond(scrape.request);
+  m_eventLoop.modify(socket, EVENT_WRITE);
+  writeResponse(socket, scrape);
+}
+
+std::string MetricsEndpoint::respond(const std::string &request) const {
+  const std::string_view requestLine =
+      std::string_view(request).substr(0, request.find("\r\n"));
+
+  std::string_view status = "200 OK";
+  std::string body;
+  if (request.size() > MAX_REQUEST_SIZE) {
+    status = "431 Request Header Fields Too Large";
+  } else if (!requestLine.starts_with("GET ")) {
+    status = "405 Method Not Allowed";
+  } else {
+    const std::string_view target =
+        requestLine.substr(4, requestLine.find(' ', 4) - 4);
+    if (target == "/metrics" || target.starts_with("/metrics?")) {
+      body = m_render();
+    } else {
+      status = "404 Not Found";
+    }
+  }
+
+  return std::format("HTTP/1.1 {}\r\n"
+                     "Content-Type: text/plain; version=0.0.4\r\n"
+                     "Content-Length: {}\r\n"
+                     "Connection: close\r\n"
+                     "\r\n",
+                     status, body.size()) +
+         body;
+}
+
+void MetricsEndpoint::writeResponse(const int socket, Scrape &scrape) {
+  while (scrape.sent < scrape.response.size()) {
+    const ssize_t bytesSent =
+        send(socket, scrape.response.data() + scrape.sent,
+             scrape.response.size() - scrape.sent, MSG_NOSIGNAL);
+    if (bytesSent > 0) {
+      scrape.sent += static_cast<size_t>(bytesSent);
+    } else if (bytesSent < 0 && errno == EINTR) {
+      continue;
+    } else if (bytesSent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return;
+    } else {
+      break;
+    }
+  }
+  closeScrape(socket);
+}
+
+void MetricsEndpoint::closeScrape(const int socket) {
+  m_eventLoop.remove(socket);
+  close(socket);
+  m_scrapes.erase(socket);
+}
+
+} // namespace Jetpack::Server
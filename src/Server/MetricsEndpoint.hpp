@@ -0,0 +1,129 @@
+/**
+ * @file MetricsEndpoint.hpp
+ * @brief Declaration of the MetricsEndpoint class, a minimal HTTP server
+ *        answering Prometheus scrapes from the acceptor's event loop.
+ */
+
+#pragma once
+
+#include "EventLoop.hpp"
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+namespace Jetpack::Server {
+
+/**
+ * @class MetricsEndpoint
+ * @brief Serves GET /metrics without a thread of its own.
+ *
+ * Its sockets are registered with the event loop of the thread that owns
+ * it, and are read and written without blocking, so a slow scraper never
+ * holds up the rest of that loop. Each connection carries one request and
+ * is closed once the response is written, or once SCRAPE_TIMEOUT has
+ * passed, so idle connections cannot hold every slot.
+ */
+class MetricsEndpoint {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /** Produces the exposition text on each scrape. */
+  using Renderer = std::function<std::string()>;
+
+  /**
+   * @brief Starts accepting scrapes.
+   * @param listenSocket Non-blocking listening socket; owned from now on.
+   * @param eventLoop    Loop the sockets are registered with.
+   * @param render       Called once per scrape.
+   * @throws Shared::Exceptions::SocketException if the socket cannot be
+   *         registered.
+   */
+  MetricsEndpoint(int listenSocket, EventLoop &eventLoop, Renderer render);
+
+  /** @brief Closes the listening socket and every open scrape. */
+  ~MetricsEndpoint();
+
+  MetricsEndpoint(const MetricsEndpoint &) = delete;
+  MetricsEndpoint &operator=(const MetricsEndpoint &) = delete;
+  MetricsEndpoint(MetricsEndpoint &&) = delete;
+  MetricsEndpoint &operator=(MetricsEndpoint &&) = delete;
+
+  /**
+   * @brief Handles an event if it concerns one of the endpoint's sockets.
+   * @param event Event returned by the loop.
+   * @return False if the descriptor is not the endpoint's.
+   */
+  bool handleEvent(const IoEvent &event);
+
+  /**
+   * @param now Current time.
+   * @return Milliseconds until the oldest scrape times out, or -1.
+   */
+  [[nodiscard]] int getTimeout(Clock::time_point now) const;
+
+  /**
+   * @brief Closes every scrape older than SCRAPE_TIMEOUT.
+   * @param now Current time.
+   */
+  void closeExpiredScrapes(Clock::time_point now);
+
+private:
+  /**
+   * @struct Scrape
+   * @brief One scrape connection: what was read and what is left to write.
+   */
+  struct Scrape {
+    std::string request;
+    std::string response;
+    size_t sent = 0;
+    /** Time the connection is closed at, answered or not. */
+    Clock::time_point deadline;
+  };
+
+  /** Requests larger than this are answered with an error. */
+  static constexpr size_t MAX_REQUEST_SIZE = 8192;
+  /** Connections held at once; further ones are refused. */
+  static constexpr size_t MAX_SCRAPES = 16;
+  /** Time a connection gets to send its request and read the response. */
+  static constexpr std::chrono::seconds SCRAPE_TIMEOUT{10};
+
+  /** @brief Accepts every pending connection. */
+  void acceptScrapes();
+
+  /**
+   * @brief Reads the request and, once it is complete, starts answering.
+   * @param socket Scrape connection.
+   * @param scrape Its state; destroyed if the connection is closed.
+   */
+  void readRequest(int socket, Scrape &scrape);
+
+  /**
+   * @brief Builds the response to a complete request.
+   * @param request The request, up to the end of its headers.
+   * @return The whole response, headers included.
+   */
+  [[nodiscard]] std::string respond(const std::string &request) const;
+
+  /**
+   * @brief Writes as much of the response as the socket takes, closing the
+   *        connection once it is all written.
+   * @param socket Scrape connection.
+   * @param scrape Its state.
+   */
+  void writeResponse(int socket, Scrape &scrape);
+
+  /**
+   * @brief Unregisters and closes a scrape connection.
+   * @param socket Scrape connection.
+   */
+  void closeScrape(int socket);
+
+  int m_listenSocket;
+  EventLoop &m_eventLoop;
+  Renderer m_render;
+  std::unordered_map<int, Scrape> m_scrapes;
+};
+
+} // namespace Jetpack::Server
@@ -0,0 +1,41 @@
+/**
+ * @file PacketSink.hpp
+ * @brief Interface through which matches hand outbound packets to the
+ *        owner of the client sockets.
+ */
+
+#pragma once
+
+#include "../Shared/Arena.hpp"
+#include "../Shared/Frame.hpp"
+
+namespace Jetpack::Server {
+
+/**
+ * @class PacketSink
+ * @brief Destination for serialized frames addressed to one client.
+ *
+ * Matches and their Broadcaster never write to sockets themselves: the
+ * sink queues the bytes and flushes them once per loop iteration.
+ */
+class PacketSink {
+public:
+  virtual ~PacketSink() = default;
+
+  /**
+   * @brief Queues a frame for a client; the frame is shared, not copied.
+   * @param clientSocket Destination descriptor.
+   * @param frame        Serialized packet.
+   */
+  virtual void queueFrame(int clientSocket,
+                          const Shared::Protocol::Frame &frame) = 0;
+
+  /**
+   * @brief Scratch memory for frames queued during the current loop
+   *        iteration; reset once every queue has been flushed.
+   * @return The arena to build frames in.
+   */
+  virtual Shared::Arena &getFrameArena() = 0;
+};
+
+} // namespace Jetpack::Server
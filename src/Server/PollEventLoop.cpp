@@ -0,0 +1,78 @@
+/**
+ * @file PollEventLoop.cpp
+ * @brief Implements the poll(2) event loop backend.
+ */
+
+#include "PollEventLoop.hpp"
+
+namespace Jetpack::Server {
+
+short PollEventLoop::toPollEvents(const uint32_t interest) {
+  short events = 0;
+  if (interest & EVENT_READ) {
+    events |= POLLIN;
+  }
+  if (interest & EVENT_WRITE) {
+    events |= POLLOUT;
+  }
+  return events;
+}
+
+void PollEventLoop::add(const int fd, const uint32_t interest) {
+  if (m_slots.contains(fd)) {
+    modify(fd, interest);
+    return;
+  }
+
+  m_slots.emplace(fd, m_pollfds.size());
+  m_pollfds.push_back({fd, toPollEvents(interest), 0});
+}
+
+void PollEventLoop::modify(const int fd, const uint32_t interest) {
+  const auto it = m_slots.find(fd);
+  if (it != m_slots.end()) {
+    m_pollfds[it->second].events = toPollEvents(interest);
+  }
+}
+
+void PollEventLoop::remove(const int fd) {
+  const auto it = m_slots.find(fd);
+  if (it == m_slots.end()) {
+    return;
+  }
+
+  const size_t slot = it->second;
+  m_slots.erase(it);
+
+  if (slot != m_pollfds.size() - 1) {
+    m_pollfds[slot] = m_pollfds.back();
+    m_slots[m_pollfds[slot].fd] = slot;
+  }
+  m_pollfds.pop_back();
+}
+
+int PollEventLoop::wait(const int timeoutMs, std::vector<IoEvent> &events) {
+  events.clear();
+
+  const int ready = poll(m_pollfds.data(), m_pollfds.size(), timeoutMs);
+  if (ready <= 0) {
+    return ready;
+  }
+
+  for (const pollfd &pfd : m_pollfds) {
+    if (pfd.revents == 0) {
+      continue;
+    }
+
+    events.push_back({pfd.fd, (pfd.revents & POLLIN) != 0,
+                      (pfd.revents & POLLOUT) != 0,
+                      (pfd.revents & (POLLHUP | POLLERR | POLLNVAL)) != 0});
+    if (events.size() == static_cast<size_t>(ready)) {
+      break;
+    }
+  }
+
+  return static_cast<int>(events.size());
+}
+
+} // namespace Jetpack::Server
@@ -0,0 +1,39 @@
+/**
+ * @file PollEventLoop.hpp
+ * @brief Portable poll(2) event loop backend.
+ */
+
+#pragma once
+
+#include "EventLoop.hpp"
+#include <poll.h>
+#include <unordered_map>
+#include <vector>
+
+namespace Jetpack::Server {
+
+/**
+ * @class PollEventLoop
+ * @brief Level-triggered fallback backend built on poll(2).
+ *
+ * Keeps a dense pollfd array plus an fd → slot index so that removal is
+ * a constant-time swap with the last slot instead of a search and erase.
+ */
+class PollEventLoop final : public EventLoop {
+public:
+  void add(int fd, uint32_t interest) override;
+  void modify(int fd, uint32_t interest) override;
+  void remove(int fd) override;
+  int wait(int timeoutMs, std::vector<IoEvent> &events) override;
+
+  [[nodiscard]] std::string_view getName() const override { return "poll"; }
+
+private:
+  /** @return poll(2) event mask matching the given interest flags. */
+  static short toPollEvents(uint32_t interest);
+
+  std::vector<pollfd> m_pollfds;
+  std::unordered_map<int, size_t> m_slots;
+};
+
+} // namespace Jetpack::Server
@@ -0,0 +1,397 @@
+/**
+ * @file Relay.cpp
+ * @brief Implements the Relay class.
+ */
+
+#include "Relay.hpp"
+#include "../Shared/Exceptions.hpp"
+#include "Server.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <netinet/in.h>
+#include <sys/fcntl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace Jetpack::Server {
+
+namespace {
+
+/**
+ * @param chunk A released MAP_CHUNK.
+ * @return Column just past the chunk.
+ */
+int getChunkEnd(const Shared::Protocol::Frame &chunk) {
+  const auto read16 = [&chunk](const size_t offset) {
+    return std::to_integer<int>(chunk.data()[offset]) |
+           std::to_integer<int>(chunk.data()[offset + 1]) << 8;
+  };
+  return read16(1) + read16(3);
+}
+
+} // namespace
+
+Relay::Relay(const ServerConfig &config)
+    : m_upstreamHost(config.upstreamHost), m_upstreamPort(config.upstreamPort),
+      m_delay(std::chrono::milliseconds(config.relayDelayMs)),
+      m_maxSendBacklog(config.maxSendBacklog), m_debugMode(config.debugMode),
+      m_eventLoop(EventLoop::create(config.backend)) {
+  m_listenSocket = GameServer::createListenSocket(config.port, false);
+  m_eventLoop->add(m_listenSocket, EVENT_READ);
+}
+
+Relay::~Relay() {
+  for (const auto &[socket, _] : m_viewers) {
+    close(socket);
+  }
+  if (m_upstreamSocket != -1) {
+    close(m_upstreamSocket);
+  }
+  close(m_listenSocket);
+}
+
+void Relay::run() {
+  subscribe();
+
+  while (true) {
+    const int ready = m_eventLoop->wait(getTimeout(Clock::now()), m_events);
+    if (ready < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw Shared::Exceptions::SocketException("Relay event loop failed");
+    }
+
+    for (const IoEvent &event : m_events) {
+      if (event.fd == m_listenSocket) {
+        acceptViewers();
+      } else if (event.fd == m_upstreamSocket) {
+        receiveUpstream();
+      } else if (m_viewers.contains(event.fd)) {
+        if (event.readable || event.hangup) {
+          readViewer(event.fd);
+        }
+        if (event.writable && m_viewers.contains(event.fd)) {
+          flushViewer(event.fd);
+        }
+      }
+    }
+
+    const Clock::time_point now = Clock::now();
+    releaseFrames(now);
+    if (m_upstreamClosed && m_delayed.empty()) {
+      finishMatch();
+    }
+    if (m_resubscribeTime && now >= *m_resubscribeTime) {
+      subscribe();
+    }
+  }
+}
+
+void Relay::subscribe() {
+  m_resubscribeTime.reset();
+
+  const int upstream = socket(AF_INET, SOCK_STREAM, 0);
+  if (upstream < 0) {
+    throw Shared::Exceptions::SocketException("Failed to create socket");
+  }
+
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(static_cast<uint16_t>(m_upstreamPort));
+  if (inet_pton(AF_INET, m_upstreamHost.c_str(), &address.sin_addr) <= 0) {
+    close(upstream);
+    throw Shared::Exceptions::SocketException("Invalid upstream address");
+  }
+
+  if (connect(upstream, reinterpret_cast<sockaddr *>(&address),
+              sizeof(address)) < 0) {
+    std::cerr << std::format("Relay: cannot reach {}:{}: {}", m_upstreamHost,
+                             m_upstreamPort, std::strerror(errno))
+              << std::endl;
+    close(upstream);
+    m_resubscribeTime = Clock::now() + RECONNECT_INTERVAL;
+    return;
+  }
+
+  const std::array<uint8_t, 2> request = {
+      static_cast<uint8_t>(Shared::Protocol::PacketType::CONNECT_REQUEST),
+      Shared::Protocol::CAPABILITY_SPECTATE |
+          Shared::Protocol::CAPABILITY_MAP_STREAMING};
+  if (send(upstream, request.data(), request.size(), MSG_NOSIGNAL) !=
+      static_cast<ssize_t>(request.size())) {
+    close(upstream);
+    m_resubscribeTime = Clock::now() + RECONNECT_INTERVAL;
+    return;
+  }
+
+  fcntl(upstream, F_SETFL, fcntl(upstream, F_GETFL, 0) | O_NONBLOCK);
+  m_eventLoop->add(upstream, EVENT_READ);
+  m_upstreamSocket = upstream;
+  if (m_debugMode) {
+    std::cout << std::format("Debug: Relay subscribed to {}:{}",
+                             m_upstreamHost, m_upstreamPort)
+              << std::endl;
+  }
+}
+
+void Relay::receiveUpstream() {
+  while (m_upstreamSocket != -1) {
+    if (m_upstreamBuffer.freeSpace() == 0) {
+      if (m_upstreamBuffer.capacity() >= MAX_RECEIVE_BUFFER_SIZE) {
+        std::cerr << "Relay: packet from upstream exceeds the receive buffer"
+                  << std::endl;
+        closeUpstream();
+        return;
+      }
+      m_upstreamBuffer.grow(m_upstreamBuffer.capacity() * 2);
+    }
+
+    auto [first, second] = m_upstreamBuffer.writableRegions();
+    iovec regions[2] = {{first.data(), first.size()},
+                        {second.data(), second.size()}};
+    const ssize_t bytesRead =
+        readv(m_upstreamSocket, regions, second.empty() ? 1 : 2);
+
+    if (bytesRead <= 0) {
+      if (bytesRead < 0 && errno == EINTR) {
+        continue;
+      }
+      if (bytesRead == 0 ||
+          (bytesRead < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        closeUpstream();
+      }
+      return;
+    }
+
+    m_upstreamBuffer.commit(static_cast<size_t>(bytesRead));
+    if (!drainUpstream()) {
+      std::cerr << "Relay: invalid packet from upstream" << std::endl;
+      closeUpstream();
+      return;
+    }
+  }
+}
+
+bool Relay::drainUpstream() {
+  const Clock::time_point releaseTime = Clock::now() + m_delay;
+
+  while (!m_upstreamBuffer.empty()) {
+    std::span<const std::byte> packet = m_upstreamBuffer.frontRegion();
+    size_t packetSize =
+        Shared::Protocol::getPacketSize(packet.data(), packet.size());
+
+    if (packetSize == 0 && m_upstreamBuffer.size() > packet.size()) {
+      packet = m_upstreamBuffer.linearize();
+      packetSize =
+          Shared::Protocol::getPacketSize(packet.data(), packet.size());
+    }
+    if (packetSize == Shared::Protocol::INVALID_PACKET_SIZE) {
+      return false;
+    }
+    if (packetSize == 0) {
+      return true;
+    }
+
+    // The server first seats every client as a player; the response that
+    // matters here is the one naming the relay a spectator.
+    const auto type = static_cast<Shared::Protocol::PacketType>(packet[0]);
+    const bool provisional =
+        type == Shared::Protocol::PacketType::CONNECT_RESPONSE &&
+        std::to_integer<uint8_t>(packet[1]) != Shared::Protocol::SPECTATOR_ID;
+    if (!provisional) {
+      std::shared_ptr<std::byte[]> bytes(new std::byte[packetSize]);
+      std::copy_n(packet.data(), packetSize, bytes.get());
+      m_delayed.push_back(
+          {releaseTime,
+           Shared::Protocol::Frame(bytes, std::span(bytes.get(), packetSize))});
+    }
+    m_upstreamBuffer.consume(packetSize);
+  }
+  return true;
+}
+
+void Relay::closeUpstream() {
+  m_eventLoop->remove(m_upstreamSocket);
+  close(m_upstreamSocket);
+  m_upstreamSocket = -1;
+  m_upstreamBuffer.clear();
+  m_upstreamClosed = true;
+}
+
+void Relay::releaseFrames(const Clock::time_point now) {
+  bool released = false;
+  while (!m_delayed.empty() && m_delayed.front().releaseTime <= now) {
+    const Shared::Protocol::Frame &frame = m_delayed.front().frame;
+    for (auto &[_, viewer] : m_viewers) {
+      viewer.sendQueue.push(frame);
+    }
+    rememberFrame(frame);
+    m_delayed.pop_front();
+    released = true;
+  }
+
+  if (released) {
+    flushViewers();
+  }
+}
+
+void Relay::rememberFrame(const Shared::Protocol::Frame &frame) {
+  const auto type = static_cast<Shared::Protocol::PacketType>(frame.data()[0]);
+  if (type == Shared::Protocol::PacketType::GAME_STATE_UPDATE ||
+      type == Shared::Protocol::PacketType::GAME_STATE_DELTA) {
+    m_lastState = frame;
+    return;
+  }
+
+  if (type == Shared::Protocol::PacketType::MAP_CHUNK) {
+    m_streamedColumns = std::max(m_streamedColumns, getChunkEnd(frame));
+  }
+  m_history.push_back(frame);
+}
+
+void Relay::acceptViewers() {
+  while (true) {
+    const int socket = accept(m_listenSocket, nullptr, nullptr);
+    if (socket < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+
+    fcntl(socket, F_SETFL, fcntl(socket, F_GETFL, 0) | O_NONBLOCK);
+    try {
+      m_eventLoop->add(socket, EVENT_READ);
+    } catch (const Shared::Exceptions::SocketException &) {
+      close(socket);
+      continue;
+    }
+
+    Viewer &viewer = m_viewers[socket];
+    for (const Shared::Protocol::Frame &frame : m_history) {
+      // Chunks far behind every player would only be evicted.
+      if (static_cast<Shared::Protocol::PacketType>(frame.data()[0]) ==
+              Shared::Protocol::PacketType::MAP_CHUNK &&
+          getChunkEnd(frame) <= m_streamedColumns - CATCH_UP_COLUMNS) {
+        continue;
+      }
+      viewer.sendQueue.push(frame);
+    }
+    viewer.sendQueue.push(m_lastState);
+    viewer.catchUpBacklog = viewer.sendQueue.getPendingBytes();
+    flushViewer(socket);
+  }
+}
+
+void Relay::readViewer(const int socket) {
+  // Viewers only ever send their connect request and inputs, which a
+  // relay has no use for.
+  std::array<std::byte, 1024> buffer;
+  while (true) {
+    const ssize_t bytesRead = recv(socket, buffer.data(), buffer.size(), 0);
+    if (bytesRead > 0) {
+      continue;
+    }
+    if (bytesRead < 0 && errno == EINTR) {
+      continue;
+    }
+    if (bytesRead == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+      closeViewer(socket);
+    }
+    return;
+  }
+}
+
+void Relay::flushViewer(const int socket) {
+  Viewer &viewer = m_viewers.at(socket);
+  const SendQueue::FlushResult result = viewer.sendQueue.flush(socket);
+  viewer.catchUpBacklog =
+      std::min(viewer.catchUpBacklog, viewer.sendQueue.getPendingBytes());
+  if (result == SendQueue::FlushResult::FAILED ||
+      viewer.sendQueue.getPendingBytes() >
+          m_maxSendBacklog + viewer.catchUpBacklog) {
+    closeViewer(socket);
+    return;
+  }
+
+  const bool pending = result == SendQueue::FlushResult::PENDING;
+  if (pending != viewer.writeWatched) {
+    m_eventLoop->modify(socket, pending ? EVENT_READ | EVENT_WRITE
+                                        : EVENT_READ);
+    viewer.writeWatched = pending;
+  }
+}
+
+void Relay::flushViewers() {
+  m_viewerScratch.clear();
+  for (const auto &[socket, viewer] : m_viewers) {
+    if (!viewer.writeWatched) {
+      m_viewerScratch.push_back(socket);
+    }
+  }
+  for (const int socket : m_viewerScratch) {
+    flushViewer(socket);
+  }
+}
+
+void Relay::closeViewer(const int socket) {
+  m_eventLoop->remove(socket);
+  close(socket);
+  m_viewers.erase(socket);
+}
+
+void Relay::finishMatch() {
+  m_upstreamClosed = false;
+  if (m_history.empty()) {
+    // Turned away before any match began: keep the viewers and retry.
+    m_resubscribeTime = Clock::now() + RECONNECT_INTERVAL;
+    return;
+  }
+
+  if (m_debugMode) {
+    std::cout << std::format("Debug: Relayed match ended; closing {} "
+                             "viewer(s)",
+                             m_viewers.size())
+              << std::endl;
+  }
+
+  m_viewerScratch.clear();
+  for (auto &[socket, viewer] : m_viewers) {
+    // Best effort: hand GAME_OVER to the kernel before closing.
+    viewer.sendQueue.flush(socket);
+    m_viewerScratch.push_back(socket);
+  }
+  for (const int socket : m_viewerScratch) {
+    closeViewer(socket);
+  }
+
+  m_history.clear();
+  m_streamedColumns = 0;
+  m_lastState = {};
+  subscribe();
+}
+
+int Relay::getTimeout(const Clock::time_point now) const {
+  std::optional<Clock::time_point> next = m_resubscribeTime;
+  if (!m_delayed.empty() &&
+      (!next || m_delayed.front().releaseTime < *next)) {
+    next = m_delayed.front().releaseTime;
+  }
+  if (!next) {
+    return -1;
+  }
+  if (*next <= now) {
+    return 0;
+  }
+  return static_cast<int>(
+      std::chrono::ceil<std::chrono::milliseconds>(*next - now).count());
+}
+
+} // namespace Jetpack::Server
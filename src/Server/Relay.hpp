@@ -0,0 +1,198 @@
+/**
+ * @file Relay.hpp
+ * @brief Declaration of the Relay class, which watches a match as one
+ *        spectator and fans its stream out to many viewers.
+ */
+
+#pragma once
+
+#include "../Shared/Frame.hpp"
+#include "../Shared/RingBuffer.hpp"
+#include "EventLoop.hpp"
+#include "SendQueue.hpp"
+#include "ServerConfig.hpp"
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Jetpack::Server {
+
+/**
+ * @class Relay
+ * @brief Re-sends the stream of one upstream match to any number of
+ *        viewers, so the host simulating it pays for a single spectator.
+ *
+ * The relay subscribes upstream as a spectator streaming the map, so the
+ * stream carries MAP_INFO, the chunks ahead of the leading player and
+ * full state updates, which need no per-viewer baseline; viewers must
+ * accept a streamed map. Each packet is copied once into a shared Frame
+ * and every viewer's SendQueue references it. A viewer joining late
+ * first gets the packets that set the match up, the chunks around the
+ * leading player and every event since, then the latest state; that
+ * catch-up does not count towards the send backlog limit. Viewers are
+ * spectators, and may be relays in turn, which gives a tree of any
+ * depth.
+ *
+ * With a delay, packets are held back that long before anyone sees
+ * them. Once the upstream match ends and the delay has passed, viewers
+ * are disconnected as a server would, and the relay subscribes again
+ * for the next match.
+ */
+class Relay {
+public:
+  /**
+   * @brief Listens for viewers; the upstream connection opens in run().
+   * @param config Relay options: port, upstream, delay, backend, backlog.
+   * @throws Shared::Exceptions::SocketException on socket errors.
+   */
+  explicit Relay(const ServerConfig &config);
+
+  /** @brief Closes the upstream connection and every viewer. */
+  ~Relay();
+
+  Relay(const Relay &) = delete;
+  Relay &operator=(const Relay &) = delete;
+  Relay(Relay &&) = delete;
+  Relay &operator=(Relay &&) = delete;
+
+  /** @brief Relays one upstream match after another, forever. */
+  void run();
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  /** Upstream packets are at most a map; the ring grows to hold one. */
+  static constexpr size_t MAX_RECEIVE_BUFFER_SIZE = 64 * 1024 * 1024;
+
+  /** Wait before subscribing again when the upstream turned us away. */
+  static constexpr std::chrono::seconds RECONNECT_INTERVAL{1};
+
+  /**
+   * Columns a late viewer is sent, back from the furthest chunk: the
+   * server streams two chunks past the leading player, and the camera
+   * shows less than one behind it.
+   */
+  static constexpr int CATCH_UP_COLUMNS = 256;
+
+  /**
+   * @struct Viewer
+   * @brief A connected viewer and the frames it has yet to receive.
+   */
+  struct Viewer {
+    SendQueue sendQueue;
+    /** True while EVENT_WRITE is registered for a short-written queue. */
+    bool writeWatched = false;
+    /** Bytes of the catch-up still queued, left out of the backlog. */
+    size_t catchUpBacklog = 0;
+  };
+
+  /**
+   * @struct DelayedFrame
+   * @brief An upstream packet and when viewers may see it.
+   */
+  struct DelayedFrame {
+    Clock::time_point releaseTime;
+    Shared::Protocol::Frame frame;
+  };
+
+  /**
+   * @brief Connects upstream and asks to spectate, or schedules a retry.
+   */
+  void subscribe();
+
+  /**
+   * @brief Reads upstream packets and queues each behind the delay; ends
+   *        the match when the upstream closes.
+   */
+  void receiveUpstream();
+
+  /**
+   * @brief Splits the upstream ring into packets.
+   * @return False if the stream is corrupted.
+   */
+  bool drainUpstream();
+
+  /** @brief Closes the upstream socket; the match plays out the delay. */
+  void closeUpstream();
+
+  /**
+   * @brief Hands every packet whose delay has passed to the viewers.
+   * @param now Current time.
+   */
+  void releaseFrames(Clock::time_point now);
+
+  /**
+   * @brief Remembers a released packet for viewers who join later.
+   * @param frame Released packet.
+   */
+  void rememberFrame(const Shared::Protocol::Frame &frame);
+
+  /** @brief Accepts every pending viewer and catches it up. */
+  void acceptViewers();
+
+  /**
+   * @brief Discards whatever a viewer sent, closing it on hangup.
+   * @param socket Viewer connection.
+   */
+  void readViewer(int socket);
+
+  /**
+   * @brief Writes a viewer's queue, watching for writability if short,
+   *        and drops it once it fails or falls too far behind.
+   * @param socket Viewer connection.
+   */
+  void flushViewer(int socket);
+
+  /** @brief Flushes every viewer with queued frames. */
+  void flushViewers();
+
+  /**
+   * @brief Unregisters and closes a viewer.
+   * @param socket Viewer connection.
+   */
+  void closeViewer(int socket);
+
+  /**
+   * @brief After the last delayed packet of a match: hands what is queued
+   *        to the kernel, closes every viewer and forgets the match.
+   */
+  void finishMatch();
+
+  /**
+   * @param now Current time.
+   * @return Milliseconds until the next release or retry, or -1.
+   */
+  [[nodiscard]] int getTimeout(Clock::time_point now) const;
+
+  std::string m_upstreamHost;
+  int m_upstreamPort;
+  Clock::duration m_delay;
+  size_t m_maxSendBacklog;
+  bool m_debugMode;
+
+  int m_listenSocket = -1;
+  int m_upstreamSocket = -1;
+  /** Set once the upstream match closed; viewers still get the delay. */
+  bool m_upstreamClosed = false;
+  std::optional<Clock::time_point> m_resubscribeTime;
+
+  std::unique_ptr<EventLoop> m_eventLoop;
+  std::vector<IoEvent> m_events;
+  Shared::RingBuffer m_upstreamBuffer;
+  std::deque<DelayedFrame> m_delayed;
+  /** Released packets that set up the match, then every event since. */
+  std::vector<Shared::Protocol::Frame> m_history;
+  /** End of the furthest released MAP_CHUNK. */
+  int m_streamedColumns = 0;
+  /** Latest released state update. */
+  Shared::Protocol::Frame m_lastState;
+  std::unordered_map<int, Viewer> m_viewers;
+  std::vector<int> m_viewerScratch;
+};
+
+} // namespace Jetpack::Server
@@ -0,0 +1,121 @@
+/**
+ * @file SendQueue.cpp
+ * @brief Implements the outbound queue of a client connection.
+ */
+
+#include "SendQueue.hpp"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+namespace Jetpack::Server {
+
+void SendQueue::push(const Shared::Protocol::Frame &frame) {
+  if (frame.empty()) {
+    return;
+  }
+  m_pendingBytes += frame.size();
+  m_frames.push_back(frame);
+}
+
+SendQueue::FlushResult SendQueue::flush(const int clientSocket) {
+  std::array<iovec, MAX_IOVECS> regions{};
+
+  while (m_pendingBytes > 0) {
+    size_t regionCount = 0;
+
+    // sendmsg() never writes through iov_base.
+    if (m_backlogOffset < m_backlog.size()) {
+      regions[regionCount++] = {m_backlog.data() + m_backlogOffset,
+                                m_backlog.size() - m_backlogOffset};
+    }
+    for (size_t i = m_frameHead;
+         i < m_frames.size() && regionCount < MAX_IOVECS; i++) {
+      const size_t offset = (i == m_frameHead) ? m_frontOffset : 0;
+      regions[regionCount++] = {
+          const_cast<std::byte *>(m_frames[i].data() + offset),
+          m_frames[i].size() - offset};
+    }
+
+    msghdr message{};
+    message.msg_iov = regions.data();
+    message.msg_iovlen = regionCount;
+
+    const ssize_t bytesSent = sendmsg(clientSocket, &message, MSG_NOSIGNAL);
+    if (bytesSent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return FlushResult::PENDING;
+      }
+      return FlushResult::FAILED;
+    }
+
+    size_t remaining = static_cast<size_t>(bytesSent);
+    m_pendingBytes -= remaining;
+
+    const size_t fromBacklog =
+        std::min(remaining, m_backlog.size() - m_backlogOffset);
+    m_backlogOffset += fromBacklog;
+    remaining -= fromBacklog;
+    if (m_backlogOffset == m_backlog.size()) {
+      m_backlog.clear();
+      m_backlogOffset = 0;
+    }
+
+    while (remaining > 0) {
+      const size_t frontLength = m_frames[m_frameHead].size() - m_frontOffset;
+      if (remaining < frontLength) {
+        m_frontOffset += remaining;
+        return FlushResult::PENDING;
+      }
+      remaining -= frontLength;
+      m_frameHead++;
+      m_frontOffset = 0;
+    }
+
+    if (m_frameHead == m_frames.size()) {
+      m_frames.clear();
+      m_frameHead = 0;
+    }
+  }
+
+  return FlushResult::DRAINED;
+}
+
+void SendQueue::detachFrames() {
+  if (!hasFrames()) {
+    return;
+  }
+
+  if (m_backlogOffset > 0) {
+    m_backlog.erase(m_backlog.begin(),
+                    m_backlog.begin() +
+                        static_cast<std::ptrdiff_t>(m_backlogOffset));
+    m_backlogOffset = 0;
+  }
+
+  for (size_t i = m_frameHead; i < m_frames.size(); i++) {
+    const auto bytes = m_frames[i].bytes().subspan(
+        i == m_frameHead ? m_frontOffset : 0);
+    m_backlog.insert(m_backlog.end(), bytes.begin(), bytes.end());
+  }
+
+  m_frames.clear();
+  m_frameHead = 0;
+  m_frontOffset = 0;
+}
+
+void SendQueue::clear() {
+  m_backlog.clear();
+  m_backlogOffset = 0;
+  m_frames.clear();
+  m_frameHead = 0;
+  m_frontOffset = 0;
+  m_pendingBytes = 0;
+}
+
+} // namespace Jetpack::Server
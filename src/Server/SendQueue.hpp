@@ -0,0 +1,84 @@
+/**
+ * @file SendQueue.hpp
+ * @brief Declaration of the SendQueue class, the outbound byte queue of a
+ *        client connection.
+ */
+
+#pragma once
+
+#include "../Shared/Frame.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace Jetpack::Server {
+
+/**
+ * @class SendQueue
+ * @brief FIFO of shared frames flushed with scatter-gather writes.
+ *
+ * Every frame produced for a client during a loop iteration is queued
+ * here by reference and written with as few sendmsg() calls as the kernel
+ * allows. Frames usually borrow per-iteration arena memory, so whatever a
+ * short write leaves behind is moved into the queue's own backlog by
+ * detachFrames() before the arena is reset. Only slow clients pay for
+ * that copy, and the backlog keeps its capacity between uses.
+ */
+class SendQueue {
+public:
+  /**
+   * @enum FlushResult
+   * @brief Outcome of a flush() call.
+   */
+  enum class FlushResult {
+    /** Every queued byte was handed to the kernel. */
+    DRAINED,
+    /** The socket buffer is full; wait for it to become writable. */
+    PENDING,
+    /** The connection is broken and must be closed. */
+    FAILED
+  };
+
+  /** Upper bound on the iovec array passed to a single sendmsg(). */
+  static constexpr size_t MAX_IOVECS = 64;
+
+  /**
+   * @brief Appends a frame to the queue.
+   * @param frame Serialized packet; the queue holds a reference to it.
+   */
+  void push(const Shared::Protocol::Frame &frame);
+
+  /**
+   * @brief Writes as much of the queue as the socket accepts.
+   * @param clientSocket Non-blocking descriptor to write to.
+   * @return Whether the queue drained, is waiting, or the socket failed.
+   */
+  FlushResult flush(int clientSocket);
+
+  /**
+   * @brief Copies every queued frame into the owned backlog so that no
+   *        reference to arena memory survives the next reset.
+   */
+  void detachFrames();
+
+  /** @return True if frame references are queued (see detachFrames()). */
+  [[nodiscard]] bool hasFrames() const { return m_frameHead < m_frames.size(); }
+
+  /** @return Number of bytes queued but not yet written. */
+  [[nodiscard]] size_t getPendingBytes() const { return m_pendingBytes; }
+
+  /** @return True if nothing is waiting to be written. */
+  [[nodiscard]] bool empty() const { return m_pendingBytes == 0; }
+
+  /** @brief Drops every queued byte. */
+  void clear();
+
+private:
+  std::vector<std::byte> m_backlog;
+  size_t m_backlogOffset = 0;
+  std::vector<Shared::Protocol::Frame> m_frames;
+  size_t m_frameHead = 0;
+  size_t m_frontOffset = 0;
+  size_t m_pendingBytes = 0;
+};
+
+} // namespace Jetpack::Server
@@ -1,145 +1,108 @@
 /**
  * @file Server.hpp
- * @brief Declaration of the GameServer class, managing network I/O,
- *        game loop, and player state for Jetpack Server.
+ * @brief Declaration of the GameServer class, managing the listening
+ *        socket and the pool of workers that host matches.
  */
 
 #pragma once
 
+#include "../Shared/PacketTrace.hpp"
 #include "../Shared/Protocol.hpp"
-#include "Broadcaster.hpp"
+#include "EventLoop.hpp"
+#include "MapImage.hpp"
+#include "MetricsEndpoint.hpp"
+#include "ServerConfig.hpp"
+#include "Worker.hpp"
 #include <filesystem>
-#include <poll.h>
+#include <memory>
+#include <netinet/in.h>
 #include <string>
 #include <unistd.h>
-#include <unordered_map>
+#include <vector>
 
 namespace Jetpack::Server {
 
 /**
  * @class GameServer
- * @brief Main server: accepts clients, drives game loop, and broadcasts
- * updates.
+ * @brief Main server: accepts clients and spreads them over worker
+ * threads, each driving its own matches.
  */
 class GameServer {
 public:
   /**
    * @brief Creates and configures a GameServer.
-   * @param port      TCP port to listen on.
-   * @param mapFile   Path to the text map definition.
-   * @param debugMode If true, logs raw packet data.
+   * @param config Options parsed from the command line.
    * @throws Shared::Exceptions::MapLoaderException on map load failure.
    * @throws Shared::Exceptions::SocketException    on socket errors.
    */
-  GameServer(int port, const std::string &mapFile, bool debugMode = false);
+  explicit GameServer(const ServerConfig &config);
 
   /**
-   * @brief Cleans up sockets and connected clients.
+   * @brief Stops every worker and closes the listening socket.
    */
   ~GameServer();
 
   /**
-   * @brief Enters the main loop: polling, updating, and broadcasting.
+   * @brief Starts the workers, then runs the accept and map watch loop
+   *        (or only the watch when workers own SO_REUSEPORT listeners).
    */
   void start();
 
-private:
-  static constexpr int MAX_CLIENTS = 2;
-  static constexpr int MIN_PLAYERS = 2;
-  static constexpr int GAME_TICK_MS = 16;
-  static constexpr int BUFFER_SIZE = 1024;
-
-  /**
-   * @brief Loads map data from m_mapFile into m_map.
-   * @return True on success, false on error/invalid map.
-   */
-  bool loadMap();
-
   /**
-   * @brief Creates, configures, binds, and listens on server socket.
+   * @brief Creates, configures, binds, and listens on a non-blocking
+   *        server socket.
+   * @param port      Port to listen on.
+   * @param reusePort If true, sets SO_REUSEPORT so several sockets can
+   *        share the port.
+   * @return The listening descriptor.
    * @throws Shared::Exceptions::SocketException on error.
    */
-  void initializeSocket();
-
-  /**
-   * @brief Polls m_pollfds and dispatches events: new clients, data,
-   * disconnects.
-   */
-  void handleSocketEvents();
-
-  /** @brief Accepts a new incoming TCP connection. */
-  void acceptNewClient();
-
-  /**
-   * @brief Reads available bytes from a client.
-   * @param clientSocket The descriptor to read from.
-   */
-  void handleClientData(int clientSocket);
-
-  /**
-   * @brief Cleans up after a client hangs up or errors.
-   * @param clientSocket The descriptor to remove.
-   */
-  void handleClientDisconnect(int clientSocket);
+  [[nodiscard]] static int createListenSocket(int port, bool reusePort);
 
+private:
   /**
-   * @brief Replies to CONNECT_REQUEST with assigned player ID and count.
-   * @param clientSocket Descriptor to send on.
-   * @param playerId     ID assigned to this client.
+   * @brief Watches the directory of m_config.mapFile so that edits to the
+   *        map are picked up; reload is disabled if inotify is not usable.
    */
-  void sendConnectResponse(int clientSocket, int playerId) const;
+  void watchMapFile();
 
   /**
-   * @brief Sends the entire map layout and coin states to a client.
-   * @param clientSocket Descriptor to send on.
+   * @brief Drains map watch events and, if the map file changed, loads it
+   *        and hands it to every worker for the matches they open next.
+   *
+   * Runs on the acceptor thread, so workers keep ticking while the map
+   * compiles; an invalid edit keeps the previous map.
    */
-  void sendMapData(int clientSocket);
-
-  /** @brief If enough players are connected, starts the game. */
-  void checkGameStart();
-
-  /** @brief Advances game logic: input, physics, collisions, broadcasts. */
-  void updateGameState();
+  void handleMapChange();
 
-  /** @brief Applies physics and bounds to each playing player. */
-  void updatePlayers();
+  /** @return The metrics of every worker, in Prometheus text format. */
+  [[nodiscard]] std::string renderMetrics() const;
 
-  /** @brief Detects and handles coin pickups and electric‐square hits. */
-  void checkCollisions();
-
-  /** @brief Determines if game over conditions are met and broadcasts. */
-  void checkGameEnd();
-
-  /**
-   * @brief Parses a raw packet buffer and dispatches by type.
-   * @param clientSocket Client sending the data.
-   * @param data         Byte buffer pointer.
-   * @param length       Number of valid bytes.
-   */
-  void processPacket(int clientSocket, const uint8_t *data, size_t length);
+  /** @brief Accepts every pending connection and hands it to a worker. */
+  void acceptNewClients();
 
   /**
-   * @brief Handles PLAYER_INPUT packets (jetpack toggle).
-   * @param clientSocket Sender descriptor.
-   * @param data         Packet body.
-   * @param length       Number of bytes.
+   * @brief Chooses the worker that receives a freshly accepted socket.
+   *
+   * A worker whose lobby room is half-full always wins, so that players
+   * sent to the same room are paired; otherwise the dispatch policy
+   * decides which worker opens the next room.
+   *
+   * @param clientAddr Peer address, used by the HASH policy.
+   * @return The selected worker.
    */
-  void handlePlayerInput(int clientSocket, const uint8_t *data, size_t length);
-
-  /** @brief Reset the game and reinitialize the map. */
-  void resetGame();
+  Worker &selectWorker(const sockaddr_in &clientAddr);
 
-private:
-  int m_port;
-  std::filesystem::path m_mapFile;
-  bool m_debugMode;
-  Shared::Protocol::GameMap m_map;
+  ServerConfig m_config;
   int m_serverSocket = -1;
-  std::vector<pollfd> m_pollfds;
-  std::unordered_map<int, Shared::Protocol::Player> m_players;
-  Broadcaster m_broadcaster;
-  Shared::Protocol::GameState m_gameState =
-      Shared::Protocol::GameState::WAITING_FOR_PLAYERS;
+  int m_mapWatchFd = -1;
+  std::unique_ptr<EventLoop> m_eventLoop;
+  std::vector<IoEvent> m_events;
+  /** Writes the workers' packet traces; outlives them. */
+  std::unique_ptr<Shared::PacketTracer> m_tracer;
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  /** Serves scrapes from m_eventLoop; nullptr when disabled. */
+  std::unique_ptr<MetricsEndpoint> m_metricsEndpoint;
   bool m_running = true;
 };
 
@@ -0,0 +1,62 @@
+/**
+ * @file ServerConfig.hpp
+ * @brief Runtime options shared by the GameServer and its workers.
+ */
+
+#pragma once
+
+#include "../Shared/PacketTrace.hpp"
+#include "../Shared/Protocol.hpp"
+#include "EventLoop.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Jetpack::Server {
+
+/**
+ * @enum DispatchPolicy
+ * @brief How accepted connections are spread across worker threads.
+ */
+enum class DispatchPolicy : uint8_t {
+  /** Acceptor thread hands each new room to the worker with fewest sockets. */
+  LEAST_LOADED = 0,
+  /** Acceptor thread hashes the peer address to pick the worker. */
+  HASH = 1,
+  /**
+   * Every worker owns an SO_REUSEPORT listener and the kernel balances;
+   * a worker hands a socket to a peer whose room has a player waiting.
+   */
+  REUSEPORT = 2
+};
+
+/**
+ * @struct ServerConfig
+ * @brief Options parsed from the command line.
+ */
+struct ServerConfig {
+  int port = 8080;
+  std::string mapFile;
+  bool debugMode = false;
+  EventBackend backend = EventLoop::getDefaultBackend();
+  /** Number of worker threads; 0 means one per hardware thread. */
+  int workerCount = 1;
+  DispatchPolicy dispatchPolicy = DispatchPolicy::LEAST_LOADED;
+  /** Unsent bytes a client may accumulate before it is disconnected. */
+  size_t maxSendBacklog = 256 * 1024;
+  /** Port serving Prometheus metrics over HTTP; 0 disables it. */
+  int metricsPort = 0;
+  /** Packet tracing; on in debug mode or when a trace file is set. */
+  Shared::TraceOptions trace;
+  /** Fixed-point units per tile of GAME_STATE_PACKED positions. */
+  uint16_t positionScale = Shared::Protocol::LEGACY_POSITION_SCALE;
+  /** Directory finished matches are recorded into; empty disables it. */
+  std::string recordDirectory;
+  /** Server or relay a relay watches matches on; relay mode if set. */
+  std::string upstreamHost;
+  int upstreamPort = 0;
+  /** How long a relay holds packets back before viewers see them. */
+  int relayDelayMs = 0;
+};
+
+} // namespace Jetpack::Server
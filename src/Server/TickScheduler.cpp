@@ -0,0 +1,66 @@
+/**
+ * @file TickScheduler.cpp
+ * @brief Implements the fixed-timestep tick accumulator.
+ */
+
+#include "TickScheduler.hpp"
+#include <algorithm>
+
+namespace Jetpack::Server {
+
+TickScheduler::TickScheduler(const int ticksPerSecond,
+                             const int maxCatchUpTicks)
+    : m_tickDuration(std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(1.0 / std::max(1, ticksPerSecond)))),
+      m_maxCatchUpTicks(std::max(1, maxCatchUpTicks)) {
+  start();
+}
+
+void TickScheduler::start() {
+  m_nextTick = Clock::now() + m_tickDuration;
+  m_stats = TickStats{};
+}
+
+int TickScheduler::getPollTimeoutMs() const {
+  const auto remaining = m_nextTick - Clock::now();
+  if (remaining <= Clock::duration::zero()) {
+    return 0;
+  }
+
+  const auto remainingMs =
+      std::chrono::ceil<std::chrono::milliseconds>(remaining);
+  return static_cast<int>(remainingMs.count());
+}
+
+int TickScheduler::consumeDueTicks() {
+  const auto now = Clock::now();
+  int dueTicks = 0;
+
+  while (m_nextTick <= now) {
+    if (dueTicks == m_maxCatchUpTicks) {
+      const auto behind = now - m_nextTick;
+      const auto dropped = behind / m_tickDuration + 1;
+      m_stats.droppedTicks += static_cast<uint64_t>(dropped);
+      m_nextTick += m_tickDuration * dropped;
+      break;
+    }
+
+    const int64_t lateUs =
+        std::chrono::duration_cast<std::chrono::microseconds>(now - m_nextTick)
+            .count();
+    if (now - m_nextTick > m_tickDuration) {
+      m_stats.overruns++;
+    }
+    m_stats.lastJitterUs = lateUs;
+    m_stats.maxJitterUs = std::max(m_stats.maxJitterUs, lateUs);
+    m_stats.totalJitterUs += lateUs;
+    m_stats.ticks++;
+
+    m_nextTick += m_tickDuration;
+    dueTicks++;
+  }
+
+  return dueTicks;
+}
+
+} // namespace Jetpack::Server
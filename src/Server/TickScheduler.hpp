@@ -0,0 +1,92 @@
+/**
+ * @file TickScheduler.hpp
+ * @brief Declaration of the TickScheduler class, a fixed-timestep clock
+ *        that decouples simulation steps from I/O wakeups.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace Jetpack::Server {
+
+/**
+ * @struct TickStats
+ * @brief Counters describing how well the scheduler kept its deadlines.
+ */
+struct TickStats {
+  /** Number of simulation steps handed out since start(). */
+  uint64_t ticks = 0;
+  /** Steps that ran more than one full period after their deadline. */
+  uint64_t overruns = 0;
+  /** Steps dropped because the loop fell too far behind to catch up. */
+  uint64_t droppedTicks = 0;
+  /** Lateness of the most recent step, in microseconds. */
+  int64_t lastJitterUs = 0;
+  /** Worst lateness observed, in microseconds. */
+  int64_t maxJitterUs = 0;
+  /** Sum of all lateness samples, in microseconds (for averaging). */
+  int64_t totalJitterUs = 0;
+
+  /** @return Mean lateness per step, in microseconds. */
+  [[nodiscard]] int64_t meanJitterUs() const {
+    return ticks > 0 ? totalJitterUs / static_cast<int64_t>(ticks) : 0;
+  }
+};
+
+/**
+ * @class TickScheduler
+ * @brief Monotonic-clock accumulator emitting exactly N steps per second.
+ *
+ * The owner asks for a poll timeout bounded by the next tick deadline,
+ * waits for I/O, then asks how many steps are due. Wakeups caused by
+ * incoming packets therefore never advance the simulation on their own.
+ */
+class TickScheduler {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief Constructs a scheduler.
+   * @param ticksPerSecond  Simulation rate (steps per second).
+   * @param maxCatchUpTicks Maximum number of steps returned by a single
+   *        consumeDueTicks() call; older missed steps are dropped.
+   */
+  explicit TickScheduler(int ticksPerSecond, int maxCatchUpTicks = 5);
+
+  /**
+   * @brief Resets the time reference; the first step is due one period
+   *        from now.
+   */
+  void start();
+
+  /**
+   * @brief Computes how long the caller may block waiting for I/O.
+   * @return Milliseconds until the next deadline, rounded up, never
+   *         negative.
+   */
+  [[nodiscard]] int getPollTimeoutMs() const;
+
+  /**
+   * @brief Advances the accumulator to the current time.
+   * @return Number of simulation steps the caller must run now.
+   */
+  int consumeDueTicks();
+
+  /** @return Duration of one simulation step. */
+  [[nodiscard]] Clock::duration getTickDuration() const {
+    return m_tickDuration;
+  }
+
+  /** @return Deadline and jitter counters collected so far. */
+  [[nodiscard]] const TickStats &getStats() const { return m_stats; }
+
+private:
+  Clock::duration m_tickDuration;
+  int m_maxCatchUpTicks;
+  Clock::time_point m_nextTick;
+  TickStats m_stats;
+};
+
+} // namespace Jetpack::Server
@@ -0,0 +1,914 @@
+/**
+ * @file Worker.cpp
+ * @brief Implements a server shard: event loop, lobby and match ticking.
+ */
+
+#include "Worker.hpp"
+#include "../Shared/Exceptions.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fcntl.h>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace Jetpack::Server {
+
+Worker::Worker(const int workerId, const int workerCount,
+               std::shared_ptr<const MapImage> mapTemplate,
+               const ServerConfig &config, const int listenSocket,
+               Shared::TraceRing *trace)
+    : m_id(workerId), m_workerCount(workerCount),
+      m_mapTemplate(std::move(mapTemplate)), m_debugMode(config.debugMode),
+      m_maxSendBacklog(config.maxSendBacklog),
+      m_positionScale(config.positionScale),
+      m_recordDirectory(config.recordDirectory), m_listenSocket(listenSocket),
+      m_trace(trace), m_eventLoop(EventLoop::create(config.backend)) {
+  int wakeFds[2];
+  if (pipe(wakeFds) < 0) {
+    throw Shared::Exceptions::SocketException("Failed to create wake pipe");
+  }
+  m_wakeReadFd = wakeFds[0];
+  m_wakeWriteFd = wakeFds[1];
+  fcntl(m_wakeReadFd, F_SETFL, fcntl(m_wakeReadFd, F_GETFL, 0) | O_NONBLOCK);
+  fcntl(m_wakeWriteFd, F_SETFL, fcntl(m_wakeWriteFd, F_GETFL, 0) | O_NONBLOCK);
+
+  m_eventLoop->add(m_wakeReadFd, EVENT_READ);
+  if (m_listenSocket != -1) {
+    m_eventLoop->add(m_listenSocket, EVENT_READ);
+  }
+  openDatagramSocket();
+}
+
+Worker::~Worker() {
+  stop();
+
+  for (const auto &[playerSocket, _] : m_connections) {
+    close(playerSocket);
+  }
+  for (const int clientSocket : m_handoffQueue) {
+    close(clientSocket);
+  }
+  if (m_listenSocket != -1) {
+    close(m_listenSocket);
+  }
+  close(m_datagramSocket);
+  close(m_wakeReadFd);
+  close(m_wakeWriteFd);
+}
+
+void Worker::openDatagramSocket() {
+  m_datagramSocket = socket(AF_INET, SOCK_DGRAM, 0);
+  if (m_datagramSocket < 0) {
+    throw Shared::Exceptions::SocketException(
+        "Failed to create datagram socket");
+  }
+
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = INADDR_ANY;
+  address.sin_port = 0;
+  socklen_t addressLength = sizeof(address);
+  if (bind(m_datagramSocket, reinterpret_cast<sockaddr *>(&address),
+           sizeof(address)) < 0 ||
+      getsockname(m_datagramSocket, reinterpret_cast<sockaddr *>(&address),
+                  &addressLength) < 0) {
+    close(m_datagramSocket);
+    throw Shared::Exceptions::SocketException(
+        "Failed to bind datagram socket");
+  }
+  m_datagramPort = ntohs(address.sin_port);
+
+  fcntl(m_datagramSocket, F_SETFL,
+        fcntl(m_datagramSocket, F_GETFL, 0) | O_NONBLOCK);
+  m_eventLoop->add(m_datagramSocket, EVENT_READ);
+}
+
+void Worker::start() {
+  m_running = true;
+  m_thread = std::thread(&Worker::run, this);
+}
+
+void Worker::stop() {
+  m_running = false;
+  const char wake = 0;
+  [[maybe_unused]] const ssize_t written = write(m_wakeWriteFd, &wake, 1);
+  join();
+}
+
+void Worker::join() {
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+void Worker::enqueueClient(const int clientSocket) {
+  m_connectionCount.fetch_add(1, std::memory_order_relaxed);
+  m_pendingClients.fetch_add(1, std::memory_order_release);
+  {
+    std::lock_guard lock(m_handoffMutex);
+    m_handoffQueue.push_back(clientSocket);
+  }
+
+  const char wake = 1;
+  [[maybe_unused]] const ssize_t written = write(m_wakeWriteFd, &wake, 1);
+}
+
+void Worker::setPeers(std::vector<Worker *> peers) {
+  m_peers = std::move(peers);
+}
+
+void Worker::setMapTemplate(std::shared_ptr<const MapImage> mapTemplate) {
+  std::lock_guard lock(m_mapMutex);
+  m_mapTemplate = std::move(mapTemplate);
+}
+
+void Worker::queueFrame(const int clientSocket,
+                        const Shared::Protocol::Frame &frame) {
+  const auto it = m_connections.find(clientSocket);
+  if (it == m_connections.end()) {
+    return;
+  }
+
+  Connection &connection = it->second;
+  if (connection.overflowed) {
+    return;
+  }
+
+  if (m_trace != nullptr) {
+    m_trace->record(Shared::TraceDirection::SENT, clientSocket,
+                    frame.bytes());
+  }
+  m_metrics.packetsSent.add();
+  m_metrics.bytesSent.add(frame.size());
+
+  if (!connection.sendQueue.hasFrames() && connection.datagram.empty()) {
+    m_dirtyConnections.push_back(clientSocket);
+  }
+  if (routesByDatagram(connection, frame)) {
+    connection.datagram.insert(connection.datagram.end(),
+                               frame.bytes().begin(), frame.bytes().end());
+    return;
+  }
+  connection.sendQueue.push(frame);
+  if (static_cast<Shared::Protocol::PacketType>(frame.data()[0]) ==
+      Shared::Protocol::PacketType::MAP_DATA) {
+    connection.mapBacklog += frame.size();
+  }
+
+  if (connection.sendQueue.getPendingBytes() >
+      m_maxSendBacklog + connection.mapBacklog) {
+    // Closing here would mutate the match mid-broadcast; the next flush
+    // drops the client instead.
+    connection.overflowed = true;
+    connection.sendQueue.clear();
+    m_dirtyConnections.push_back(clientSocket);
+  }
+}
+
+bool Worker::routesByDatagram(Connection &connection,
+                              const Shared::Protocol::Frame &frame) {
+  if (!connection.datagramBound ||
+      !Shared::Protocol::isDatagramPacket(
+          static_cast<Shared::Protocol::PacketType>(frame.data()[0]))) {
+    return false;
+  }
+
+  if (m_tickScheduler.getStats().ticks - connection.lastDatagramTick >
+      DATAGRAM_TIMEOUT_TICKS) {
+    // The client's next datagram binds the path again.
+    connection.datagramBound = false;
+    m_metrics.datagramFallbacks.add();
+    if (m_debugMode) {
+      std::cout << std::format("Debug: Client {} stopped sending datagrams; "
+                               "back to TCP",
+                               connection.socket)
+                << std::endl;
+    }
+    return false;
+  }
+
+  return Shared::Protocol::DATAGRAM_SEQUENCE_SIZE +
+             connection.datagram.size() + frame.size() <=
+         Shared::Protocol::MAX_DATAGRAM_SIZE;
+}
+
+void Worker::pinToCore() const {
+#ifdef __linux__
+  const unsigned cores = std::thread::hardware_concurrency();
+  if (cores == 0) {
+    return;
+  }
+
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  CPU_SET(static_cast<unsigned>(m_id) % cores, &cpuSet);
+  pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+#endif
+}
+
+void Worker::run() {
+  pinToCore();
+
+  if (m_debugMode) {
+    std::cout << std::format("Debug: Worker {} using {} event backend, "
+                             "datagrams on port {}",
+                             m_id, m_eventLoop->getName(), m_datagramPort)
+              << std::endl;
+  }
+
+  m_tickScheduler.start();
+  uint64_t wakeupsSinceTick = 0;
+
+  while (m_running) {
+    const int ready =
+        m_eventLoop->wait(m_tickScheduler.getPollTimeoutMs(), m_events);
+
+    if (ready < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    m_metrics.wakeups.add();
+    wakeupsSinceTick++;
+
+    if (ready > 0) {
+      const ScopedTimer timer(&m_metrics.socketEventsDuration);
+      handleSocketEvents();
+    }
+
+    for (int dueTicks = m_tickScheduler.consumeDueTicks(); dueTicks > 0;
+         dueTicks--) {
+      const ScopedTimer timer(&m_metrics.tickDuration);
+      updateMatches();
+      m_metrics.wakeupsPerTick.record(wakeupsSinceTick);
+      wakeupsSinceTick = 0;
+    }
+    if (!m_dirtyConnections.empty()) {
+      const ScopedTimer timer(&m_metrics.flushDuration);
+      flushConnections();
+    }
+    dropSilentClients();
+    reapMatches();
+    m_frameArena.reset();
+    publishMetrics();
+  }
+}
+
+void Worker::drainHandoffQueue() {
+  char wakeBuffer[64];
+  while (read(m_wakeReadFd, wakeBuffer, sizeof(wakeBuffer)) > 0) {
+  }
+
+  {
+    std::lock_guard lock(m_handoffMutex);
+    m_handoffScratch.swap(m_handoffQueue);
+  }
+
+  for (const int clientSocket : m_handoffScratch) {
+    adoptClient(clientSocket);
+    m_pendingClients.fetch_sub(1, std::memory_order_release);
+  }
+  m_handoffScratch.clear();
+}
+
+void Worker::handleSocketEvents() {
+  for (const IoEvent &event : m_events) {
+    if (event.fd == m_wakeReadFd) {
+      drainHandoffQueue();
+      continue;
+    }
+
+    if (event.fd == m_listenSocket) {
+      if (event.readable) {
+        acceptNewClients();
+      }
+      continue;
+    }
+
+    if (event.fd == m_datagramSocket) {
+      if (event.readable) {
+        receiveDatagrams();
+      }
+      continue;
+    }
+
+    if (!m_connections.contains(event.fd)) {
+      continue;
+    }
+
+    if (event.readable) {
+      handleClientData(event.fd);
+    } else if (event.hangup) {
+      handleClientDisconnect(event.fd);
+      continue;
+    }
+
+    if (event.writable && m_connections.contains(event.fd)) {
+      handleClientWritable(event.fd);
+    }
+  }
+}
+
+void Worker::acceptNewClients() {
+  while (true) {
+    int clientSocket = accept(m_listenSocket, nullptr, nullptr);
+    if (clientSocket < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+
+    const int flags = fcntl(clientSocket, F_GETFL, 0);
+    fcntl(clientSocket, F_SETFL, flags | O_NONBLOCK);
+
+    if (Worker *peer = findWaitingPeer(); peer != nullptr) {
+      // The kernel chose this worker, but a player waits on the peer.
+      peer->enqueueClient(clientSocket);
+      continue;
+    }
+
+    m_connectionCount.fetch_add(1, std::memory_order_relaxed);
+    adoptClient(clientSocket);
+  }
+}
+
+Worker *Worker::findWaitingPeer() const {
+  if (getLobbyOccupancy() % Match::MAX_PLAYERS != 0) {
+    return nullptr;
+  }
+  for (Worker *peer : m_peers) {
+    if (peer != this && peer->getLobbyOccupancy() % Match::MAX_PLAYERS != 0) {
+      return peer;
+    }
+  }
+  return nullptr;
+}
+
+void Worker::adoptClient(const int clientSocket) {
+  try {
+    m_eventLoop->add(clientSocket, EVENT_READ);
+  } catch (const Shared::Exceptions::SocketException &e) {
+    std::cerr << std::format("Worker {}: {}", m_id, e.what()) << std::endl;
+    close(clientSocket);
+    m_connectionCount.fetch_sub(1, std::memory_order_relaxed);
+    return;
+  }
+
+  assignToMatch(clientSocket);
+}
+
+void Worker::assignToMatch(const int clientSocket) {
+  Match *match = findLobbyMatch();
+  if (match == nullptr) {
+    const int matchId = m_nextMatchSequence++ * m_workerCount + m_id + 1;
+    std::shared_ptr<const MapImage> map;
+    {
+      std::lock_guard lock(m_mapMutex);
+      map = m_mapTemplate;
+    }
+    auto created = std::make_unique<Match>(matchId, std::move(map), *this,
+                                           m_debugMode, &m_metrics);
+    created->setPositionScale(m_positionScale);
+    if (!m_recordDirectory.empty()) {
+      created->startRecording();
+    }
+    m_openMatches.push_back(created.get());
+    match = created.get();
+    m_matches.emplace(matchId, std::move(created));
+  }
+
+  Connection &connection =
+      m_connections.try_emplace(clientSocket, clientSocket).first->second;
+  connection.match = match;
+  connection.seatedTick = m_tickScheduler.getStats().ticks;
+  m_silentClients.emplace_back(clientSocket, connection.seatedTick);
+  match->addPlayer(clientSocket);
+  publishLobbyOccupancy();
+}
+
+Match *Worker::findLobbyMatch() {
+  std::erase_if(m_openMatches, [](const Match *match) {
+    return !match->isAcceptingPlayers();
+  });
+
+  Match *fullest = nullptr;
+  for (Match *match : m_openMatches) {
+    if (fullest == nullptr ||
+        match->getPlayerCount() > fullest->getPlayerCount()) {
+      fullest = match;
+    }
+  }
+  return fullest;
+}
+
+void Worker::reopenMatch(Match &match) {
+  if (match.isAcceptingPlayers() &&
+      std::ranges::find(m_openMatches, &match) == m_openMatches.end()) {
+    m_openMatches.push_back(&match);
+  }
+}
+
+void Worker::dropSilentClients() {
+  const uint64_t tick = m_tickScheduler.getStats().ticks;
+  while (!m_silentClients.empty()) {
+    const auto [clientSocket, seatedTick] = m_silentClients.front();
+    if (tick - seatedTick <= CONNECT_TIMEOUT_TICKS) {
+      return;
+    }
+    m_silentClients.pop_front();
+
+    // The descriptor may have been closed and reused since it was queued.
+    const auto it = m_connections.find(clientSocket);
+    if (it != m_connections.end() && !it->second.requested &&
+        it->second.seatedTick == seatedTick) {
+      if (m_debugMode) {
+        std::cout << std::format("Debug: Client {} sent no CONNECT_REQUEST; "
+                                 "freeing its seat",
+                                 clientSocket)
+                  << std::endl;
+      }
+      handleClientDisconnect(clientSocket);
+    }
+  }
+}
+
+void Worker::spectate(const int clientSocket, const uint8_t capabilities) {
+  const auto it = m_connections.find(clientSocket);
+  if (it == m_connections.end() || it->second.spectating) {
+    return;
+  }
+
+  Match &seat = *it->second.match;
+  seat.removePlayer(clientSocket);
+  // The provisional seat may have filled the room while another opened;
+  // whoever waits in it must still be matched.
+  reopenMatch(seat);
+
+  Match *lobby = findLobbyMatch();
+  Match *watched = lobby != nullptr ? lobby : &seat;
+  for (const auto &[matchId, match] : m_matches) {
+    if (match->isInProgress() &&
+        match->getSpectatorCount() < Match::MAX_SPECTATORS &&
+        (!watched->isInProgress() || matchId > watched->getId())) {
+      watched = match.get();
+    }
+  }
+
+  if (!watched->addSpectator(clientSocket, capabilities)) {
+    handleClientDisconnect(clientSocket);
+    return;
+  }
+  it->second.match = watched;
+  it->second.spectating = true;
+  publishLobbyOccupancy();
+
+  if (m_debugMode) {
+    std::cout << std::format("Debug: Client {} spectates match {}",
+                             clientSocket, watched->getId())
+              << std::endl;
+  }
+}
+
+void Worker::offerDatagrams(const int clientSocket) {
+  const auto it = m_connections.find(clientSocket);
+  if (it == m_connections.end() || it->second.datagramToken != 0) {
+    return;
+  }
+
+  uint32_t token = 0;
+  while (token == 0 || m_datagramClients.contains(token)) {
+    token = static_cast<uint32_t>(m_tokenGenerator());
+  }
+  it->second.datagramToken = token;
+  m_datagramClients.emplace(token, clientSocket);
+
+  Shared::Protocol::FrameBuilder packet(
+      m_frameArena, Shared::Protocol::PacketType::DATAGRAM_OFFER,
+      Shared::Protocol::DATAGRAM_OFFER_SIZE - 1);
+  packet.addShort(m_datagramPort);
+  packet.addInt(token);
+  queueFrame(clientSocket, packet.finish());
+}
+
+void Worker::receiveDatagrams() {
+  std::array<std::byte, Shared::Protocol::MAX_DATAGRAM_SIZE> buffer;
+
+  while (true) {
+    sockaddr_in sender{};
+    socklen_t senderLength = sizeof(sender);
+    const ssize_t received =
+        recvfrom(m_datagramSocket, buffer.data(), buffer.size(), 0,
+                 reinterpret_cast<sockaddr *>(&sender), &senderLength);
+    if (received < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+
+    const auto length = static_cast<size_t>(received);
+    if (length < Shared::Protocol::DATAGRAM_TOKEN_SIZE) {
+      continue;
+    }
+    uint32_t token = 0;
+    for (size_t i = 0; i < Shared::Protocol::DATAGRAM_TOKEN_SIZE; i++) {
+      token |= std::to_integer<uint32_t>(buffer[i]) << (8 * i);
+    }
+    const auto client = m_datagramClients.find(token);
+    if (client == m_datagramClients.end()) {
+      continue;
+    }
+
+    const int clientSocket = client->second;
+    Connection &connection = m_connections.at(clientSocket);
+    m_metrics.datagramsReceived.add();
+    connection.lastDatagramTick = m_tickScheduler.getStats().ticks;
+
+    if (!connection.datagramBound ||
+        sender.sin_addr.s_addr != connection.datagramAddress.sin_addr.s_addr ||
+        sender.sin_port != connection.datagramAddress.sin_port) {
+      // The token is the proof, so a client whose NAT moved it keeps its
+      // path; the reply tells it datagrams get through both ways.
+      connection.datagramAddress = sender;
+      connection.datagramBound = true;
+      connection.datagramReply = true;
+      if (m_debugMode) {
+        std::cout << std::format("Debug: Client {} sends datagrams from port "
+                                 "{}",
+                                 clientSocket, ntohs(sender.sin_port))
+                  << std::endl;
+      }
+    }
+    if (length == Shared::Protocol::DATAGRAM_TOKEN_SIZE) {
+      // A bare token probes the path until the client hears back.
+      connection.datagramReply = true;
+    }
+    if (connection.datagramReply) {
+      m_dirtyConnections.push_back(clientSocket);
+    }
+
+    size_t offset = Shared::Protocol::DATAGRAM_TOKEN_SIZE;
+    while (offset < length) {
+      const std::byte *packet = buffer.data() + offset;
+      const size_t packetSize =
+          Shared::Protocol::getPacketSize(packet, length - offset);
+      if (packetSize == 0 ||
+          packetSize == Shared::Protocol::INVALID_PACKET_SIZE) {
+        break;
+      }
+      if (Shared::Protocol::isDatagramPacket(
+              static_cast<Shared::Protocol::PacketType>(packet[0]))) {
+        processPacket(clientSocket, reinterpret_cast<const uint8_t *>(packet),
+                      packetSize);
+      }
+      offset += packetSize;
+    }
+  }
+}
+
+void Worker::sendDatagram(Connection &connection) {
+  if (connection.datagram.empty() && !connection.datagramReply) {
+    return;
+  }
+
+  connection.datagramSequence++;
+  std::array<std::byte, Shared::Protocol::DATAGRAM_SEQUENCE_SIZE> header = {
+      static_cast<std::byte>(connection.datagramSequence & 0xFF),
+      static_cast<std::byte>(connection.datagramSequence >> 8)};
+  // sendmsg() never writes through iov_base.
+  iovec parts[2] = {{header.data(), header.size()},
+                    {connection.datagram.data(), connection.datagram.size()}};
+  msghdr message{};
+  message.msg_name = &connection.datagramAddress;
+  message.msg_namelen = sizeof(connection.datagramAddress);
+  message.msg_iov = parts;
+  message.msg_iovlen = connection.datagram.empty() ? 1 : 2;
+
+  // A datagram that does not make it is superseded by the next tick's, so
+  // a failed send is not retried.
+  if (sendmsg(m_datagramSocket, &message, MSG_DONTWAIT | MSG_NOSIGNAL) >= 0) {
+    m_metrics.datagramsSent.add();
+  }
+  connection.datagram.clear();
+  connection.datagramReply = false;
+}
+
+void Worker::publishLobbyOccupancy() {
+  const Match *lobby = findLobbyMatch();
+  const int lobbyPlayers =
+      lobby != nullptr ? static_cast<int>(lobby->getPlayerCount()) : 0;
+  m_lobbyPlayers.store(lobbyPlayers, std::memory_order_release);
+}
+
+void Worker::handleClientWritable(const int clientSocket) {
+  const auto it = m_connections.find(clientSocket);
+  if (it != m_connections.end() && it->second.writeWatched) {
+    flushConnection(clientSocket);
+  }
+}
+
+void Worker::flushConnections() {
+  while (!m_dirtyConnections.empty()) {
+    m_flushScratch.swap(m_dirtyConnections);
+    for (const int clientSocket : m_flushScratch) {
+      flushConnection(clientSocket);
+    }
+    m_flushScratch.clear();
+  }
+}
+
+bool Worker::flushConnection(const int clientSocket) {
+  const auto it = m_connections.find(clientSocket);
+  if (it == m_connections.end()) {
+    return false;
+  }
+  Connection &connection = it->second;
+
+  if (connection.overflowed) {
+    std::cerr << std::format("Worker {}: client {} exceeded the {} byte send "
+                             "backlog, disconnecting",
+                             m_id, clientSocket, m_maxSendBacklog)
+              << std::endl;
+    m_metrics.backlogDisconnects.add();
+    handleClientDisconnect(clientSocket);
+    return false;
+  }
+
+  sendDatagram(connection);
+  if (!connection.sendQueue.hasFrames() && !connection.writeWatched) {
+    return true;
+  }
+
+  m_metrics.sendQueueBytes.record(connection.sendQueue.getPendingBytes());
+  const SendQueue::FlushResult result =
+      connection.sendQueue.flush(clientSocket);
+  // Little is queued ahead of the map, so the bytes it leaves are its own.
+  connection.mapBacklog = std::min(connection.mapBacklog,
+                                   connection.sendQueue.getPendingBytes());
+  switch (result) {
+  case SendQueue::FlushResult::DRAINED:
+    if (connection.writeWatched) {
+      m_eventLoop->modify(clientSocket, EVENT_READ);
+      connection.writeWatched = false;
+    }
+    return true;
+  case SendQueue::FlushResult::PENDING:
+    m_metrics.shortWrites.add();
+    connection.sendQueue.detachFrames();
+    if (!connection.writeWatched) {
+      m_eventLoop->modify(clientSocket, EVENT_READ | EVENT_WRITE);
+      connection.writeWatched = true;
+    }
+    return true;
+  case SendQueue::FlushResult::FAILED:
+    break;
+  }
+
+  handleClientDisconnect(clientSocket);
+  return false;
+}
+
+void Worker::handleClientDisconnect(const int clientSocket) {
+  const auto it = m_connections.find(clientSocket);
+  if (it != m_connections.end()) {
+    it->second.match->removePlayer(clientSocket);
+    reopenMatch(*it->second.match);
+    m_datagramClients.erase(it->second.datagramToken);
+    m_connections.erase(it);
+    m_connectionCount.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  m_eventLoop->remove(clientSocket);
+  close(clientSocket);
+  publishLobbyOccupancy();
+}
+
+void Worker::handleClientData(const int clientSocket) {
+  while (true) {
+    const auto it = m_connections.find(clientSocket);
+    if (it == m_connections.end()) {
+      return;
+    }
+    Shared::RingBuffer &receiveBuffer = it->second.receiveBuffer;
+
+    if (receiveBuffer.freeSpace() == 0) {
+      // A full ring after draining holds one oversized packet; clients
+      // never send those.
+      handleClientDisconnect(clientSocket);
+      return;
+    }
+
+    auto [first, second] = receiveBuffer.writableRegions();
+    iovec regions[2] = {{first.data(), first.size()},
+                        {second.data(), second.size()}};
+    const ssize_t bytesRead =
+        readv(clientSocket, regions, second.empty() ? 1 : 2);
+
+    if (bytesRead <= 0) {
+      if (bytesRead < 0 && errno == EINTR) {
+        continue;
+      }
+      if (bytesRead == 0 ||
+          (bytesRead < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        handleClientDisconnect(clientSocket);
+      }
+      return;
+    }
+
+    receiveBuffer.commit(static_cast<size_t>(bytesRead));
+
+    if (!drainReceiveBuffer(clientSocket)) {
+      return;
+    }
+  }
+}
+
+bool Worker::drainReceiveBuffer(const int clientSocket) {
+  while (true) {
+    const auto it = m_connections.find(clientSocket);
+    if (it == m_connections.end()) {
+      return false;
+    }
+    Shared::RingBuffer &receiveBuffer = it->second.receiveBuffer;
+    if (receiveBuffer.empty()) {
+      return true;
+    }
+
+    std::span<const std::byte> packet = receiveBuffer.frontRegion();
+    size_t packetSize =
+        Shared::Protocol::getPacketSize(packet.data(), packet.size());
+
+    if (packetSize == 0 && receiveBuffer.size() > packet.size()) {
+      packet = receiveBuffer.linearize();
+      packetSize =
+          Shared::Protocol::getPacketSize(packet.data(), packet.size());
+    }
+
+    if (packetSize == Shared::Protocol::INVALID_PACKET_SIZE) {
+      std::cerr << std::format("Worker {}: invalid packet type {:#04x} from "
+                               "client {}",
+                               m_id, static_cast<unsigned>(packet[0]),
+                               clientSocket)
+                << std::endl;
+      handleClientDisconnect(clientSocket);
+      return false;
+    }
+
+    if (packetSize == 0) {
+      return true;
+    }
+
+    processPacket(clientSocket,
+                  reinterpret_cast<const uint8_t *>(packet.data()),
+                  packetSize);
+
+    const auto current = m_connections.find(clientSocket);
+    if (current == m_connections.end()) {
+      return false;
+    }
+    current->second.receiveBuffer.consume(packetSize);
+  }
+}
+
+void Worker::processPacket(const int clientSocket, const uint8_t *data,
+                           const size_t length) {
+  if (length < 1)
+    return;
+
+  if (m_trace != nullptr) {
+    m_trace->record(Shared::TraceDirection::RECEIVED, clientSocket,
+                    std::as_bytes(std::span(data, length)));
+  }
+  m_metrics.packetsReceived.add();
+  m_metrics.bytesReceived.add(length);
+
+  const Shared::Protocol::PacketType type =
+      static_cast<Shared::Protocol::PacketType>(data[0]);
+
+  switch (type) {
+  case Shared::Protocol::PacketType::CONNECT_REQUEST: {
+    const auto it = m_connections.find(clientSocket);
+    if (it == m_connections.end() || length < 2) {
+      break;
+    }
+    it->second.requested = true;
+    if ((data[1] & Shared::Protocol::CAPABILITY_SPECTATE) != 0) {
+      spectate(clientSocket, data[1]);
+    } else {
+      it->second.match->handleConnectRequest(clientSocket, data[1]);
+      if ((data[1] & Shared::Protocol::CAPABILITY_DATAGRAM) != 0) {
+        offerDatagrams(clientSocket);
+      }
+    }
+    break;
+  }
+  case Shared::Protocol::PacketType::PLAYER_INPUT: {
+    const auto it = m_connections.find(clientSocket);
+    if (it != m_connections.end()) {
+      it->second.match->handlePlayerInput(clientSocket, data, length);
+    }
+    break;
+  }
+  case Shared::Protocol::PacketType::STATE_ACK: {
+    const auto it = m_connections.find(clientSocket);
+    if (it != m_connections.end()) {
+      it->second.match->handleStateAck(clientSocket, data, length);
+    }
+    break;
+  }
+  case Shared::Protocol::PacketType::PLAYER_DISCONNECT:
+    handleClientDisconnect(clientSocket);
+    break;
+  default:
+    break;
+  }
+}
+
+void Worker::updateMatches() {
+  for (const auto &[_, match] : m_matches) {
+    match->update();
+  }
+}
+
+void Worker::publishMetrics() {
+  const TickStats &stats = m_tickScheduler.getStats();
+  m_metrics.ticks.set(stats.ticks);
+  m_metrics.tickOverruns.set(stats.overruns);
+  m_metrics.droppedTicks.set(stats.droppedTicks);
+  m_metrics.connections.set(m_connections.size());
+  m_metrics.matches.set(m_matches.size());
+}
+
+void Worker::reapMatches() {
+  for (auto it = m_matches.begin(); it != m_matches.end();) {
+    Match &match = *it->second;
+
+    if (!match.isOver() &&
+        match.getPlayerCount() + match.getSpectatorCount() > 0) {
+      ++it;
+      continue;
+    }
+
+    if (m_debugMode) {
+      const TickStats &stats = m_tickScheduler.getStats();
+      std::cout << std::format("Debug: Match {} ended on worker {}; tick "
+                               "stats: {} ticks, {} overruns, {} dropped, "
+                               "jitter mean {}us max {}us",
+                               match.getId(), m_id, stats.ticks,
+                               stats.overruns, stats.droppedTicks,
+                               stats.meanJitterUs(), stats.maxJitterUs)
+                << std::endl;
+    }
+
+    saveRecording(match);
+    for (const int clientSocket : match.getClientSockets()) {
+      const auto connection = m_connections.find(clientSocket);
+      if (connection != m_connections.end()) {
+        // Best effort: hand GAME_OVER to the kernel before closing.
+        connection->second.sendQueue.flush(clientSocket);
+        m_datagramClients.erase(connection->second.datagramToken);
+        m_connections.erase(connection);
+      }
+      m_eventLoop->remove(clientSocket);
+      ::close(clientSocket);
+      m_connectionCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    std::erase(m_openMatches, &match);
+    it = m_matches.erase(it);
+  }
+  publishLobbyOccupancy();
+}
+
+void Worker::saveRecording(Match &match) {
+  const std::unique_ptr<MatchRecording> recording = match.finishRecording();
+  if (recording == nullptr) {
+    return;
+  }
+
+  const auto now = std::chrono::system_clock::now().time_since_epoch();
+  const std::filesystem::path path =
+      std::filesystem::path(m_recordDirectory) /
+      std::format("match-{}-{}{}",
+                  std::chrono::duration_cast<std::chrono::seconds>(now).count(),
+                  match.getId(), MatchRecording::FILE_SUFFIX);
+  try {
+    recording->save(path);
+  } catch (const Shared::Exceptions::ResourceException &e) {
+    std::cerr << std::format("Worker {}: {}", m_id, e.what()) << std::endl;
+  }
+}
+
+} // namespace Jetpack::Server
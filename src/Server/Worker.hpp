@@ -0,0 +1,375 @@
+/**
+ * @file Worker.hpp
+ * @brief Declaration of the Worker class, a thread running its own event
+ *        loop, tick scheduler and set of matches.
+ */
+
+#pragma once
+
+#include "../Shared/PacketTrace.hpp"
+#include "../Shared/Physics.hpp"
+#include "../Shared/Protocol.hpp"
+#include "Connection.hpp"
+#include "EventLoop.hpp"
+#include "MapImage.hpp"
+#include "Match.hpp"
+#include "Metrics.hpp"
+#include "PacketSink.hpp"
+#include "ServerConfig.hpp"
+#include "TickScheduler.hpp"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Jetpack::Server {
+
+/**
+ * @class Worker
+ * @brief One shard of the server: owns every socket and match pinned to it.
+ *
+ * Nothing owned by a worker is touched by another thread on the hot path.
+ * The only shared state is the handoff queue the acceptor pushes new
+ * sockets into, the map template it swaps on reload, and a few atomics
+ * the acceptor reads to pick a worker.
+ *
+ * As the PacketSink of its matches, the worker queues outbound packets per
+ * connection and flushes each dirty queue once per loop iteration. Frames
+ * are built in an arena that is reset at the end of every iteration, so
+ * steady-state ticks do not allocate.
+ *
+ * Each worker also owns a UDP socket on an ephemeral port. Clients that
+ * ask for it are offered that port and a token; once their datagrams
+ * arrive, the state and input acknowledgements of each tick reach them
+ * in one datagram instead of behind lost TCP segments.
+ */
+class Worker final : public PacketSink {
+public:
+  /**
+   * @brief Creates a worker; the thread is not started yet.
+   * @param workerId     Index of this worker, also its CPU affinity hint.
+   * @param workerCount  Total number of workers (used for match IDs).
+   * @param mapTemplate  Shared, read-only map new matches are played on.
+   * @param config       Server options.
+   * @param listenSocket Optional SO_REUSEPORT listener owned by this
+   *        worker, or -1 when sockets arrive through enqueueClient().
+   * @param trace        Ring this worker traces its packets into, or
+   *        nullptr when tracing is off.
+   * @throws Shared::Exceptions::SocketException on setup failure.
+   */
+  Worker(int workerId, int workerCount,
+         std::shared_ptr<const MapImage> mapTemplate,
+         const ServerConfig &config, int listenSocket = -1,
+         Shared::TraceRing *trace = nullptr);
+
+  /** @brief Stops the thread and closes every socket it owns. */
+  ~Worker() override;
+
+  Worker(const Worker &) = delete;
+  Worker &operator=(const Worker &) = delete;
+  Worker(Worker &&) = delete;
+  Worker &operator=(Worker &&) = delete;
+
+  /** @brief Launches the worker thread. */
+  void start();
+
+  /** @brief Asks the worker thread to exit and waits for it. */
+  void stop();
+
+  /** @brief Blocks until the worker thread exits. */
+  void join();
+
+  /**
+   * @brief Hands an accepted socket to this worker (thread-safe).
+   * @param clientSocket Connected, non-blocking descriptor.
+   */
+  void enqueueClient(int clientSocket);
+
+  /**
+   * @brief Sets the workers a socket accepted on the owned listener may
+   *        be handed to when one of them has a player waiting; call
+   *        before start().
+   * @param peers Every worker of the server, this one included.
+   */
+  void setPeers(std::vector<Worker *> peers);
+
+  /**
+   * @brief Replaces the map new matches are played on (thread-safe);
+   *        running matches keep the map they started with.
+   * @param mapTemplate Newly loaded map.
+   */
+  void setMapTemplate(std::shared_ptr<const MapImage> mapTemplate);
+
+  /**
+   * @brief Queues a frame on a connection owned by this worker; only
+   *        called from the worker thread.
+   * @param clientSocket Destination descriptor.
+   * @param frame        Serialized packet.
+   */
+  void queueFrame(int clientSocket,
+                  const Shared::Protocol::Frame &frame) override;
+
+  /** @return The per-iteration frame arena; worker thread only. */
+  Shared::Arena &getFrameArena() override { return m_frameArena; }
+
+  /** @return Number of client sockets owned or queued (thread-safe). */
+  [[nodiscard]] size_t getConnectionCount() const {
+    return m_connectionCount.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @return Seats taken in this worker's fullest open room, counting
+   *         sockets still in the handoff queue (thread-safe).
+   */
+  [[nodiscard]] int getLobbyOccupancy() const {
+    return m_lobbyPlayers.load(std::memory_order_acquire) +
+           m_pendingClients.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Tick counters; only meaningful when read from the worker
+   *        thread itself or after join().
+   */
+  [[nodiscard]] const TickStats &getTickStats() const {
+    return m_tickScheduler.getStats();
+  }
+
+  /** @return Loop and traffic metrics, readable from any thread. */
+  [[nodiscard]] const WorkerMetrics &getMetrics() const { return m_metrics; }
+
+private:
+  static constexpr int TICK_RATE = Shared::Physics::TICK_RATE;
+
+  /**
+   * Ticks without a datagram from a bound client before its state goes
+   * back to TCP; clients send one every tick.
+   */
+  static constexpr uint64_t DATAGRAM_TIMEOUT_TICKS = TICK_RATE;
+
+  /**
+   * Ticks a seated client has to send CONNECT_REQUEST before its seat is
+   * dropped; the room's game cannot start without it.
+   */
+  static constexpr uint64_t CONNECT_TIMEOUT_TICKS = 5 * TICK_RATE;
+
+  /** @brief Binds the UDP socket and registers it with the event loop. */
+  void openDatagramSocket();
+
+  /** @brief Thread body: wait, dispatch, tick, reap. */
+  void run();
+
+  /** @brief Pins the calling thread to a CPU derived from m_id. */
+  void pinToCore() const;
+
+  /** @brief Seats every socket pushed by enqueueClient(). */
+  void drainHandoffQueue();
+
+  /** @brief Dispatches the events returned by the last wait. */
+  void handleSocketEvents();
+
+  /** @brief Accepts every pending connection on the owned listener. */
+  void acceptNewClients();
+
+  /**
+   * @return A peer whose open room has a player waiting while this
+   *         worker's has none, or nullptr when the socket stays here.
+   */
+  [[nodiscard]] Worker *findWaitingPeer() const;
+
+  /**
+   * @brief Registers a socket with the event loop and seats it.
+   * @param clientSocket The descriptor to adopt.
+   */
+  void adoptClient(int clientSocket);
+
+  /**
+   * @brief Reads available bytes from a client until the socket drains.
+   *
+   * Bytes land directly in the connection's ring buffer; every complete
+   * packet is then dispatched in one pass, and a trailing partial packet
+   * stays buffered until the rest arrives.
+   *
+   * @param clientSocket The descriptor to read from.
+   */
+  void handleClientData(int clientSocket);
+
+  /**
+   * @brief Resumes a short-written send queue once the socket drains.
+   * @param clientSocket The descriptor reported writable.
+   */
+  void handleClientWritable(int clientSocket);
+
+  /**
+   * @brief Flushes every connection that queued packets since the last
+   *        call, closing clients whose backlog overflowed.
+   */
+  void flushConnections();
+
+  /**
+   * @brief Writes a connection's queue and updates its write interest;
+   *        unsent frames are detached from the frame arena.
+   * @param clientSocket The descriptor to flush.
+   * @return False if the client was disconnected.
+   */
+  bool flushConnection(int clientSocket);
+
+  /**
+   * @brief Cleans up after a client hangs up or errors.
+   * @param clientSocket The descriptor to remove.
+   */
+  void handleClientDisconnect(int clientSocket);
+
+  /**
+   * @brief Lobby: seats a new client in the fullest room waiting for
+   *        players, opening a fresh room when none has a free seat.
+   * @param clientSocket Descriptor of the client.
+   */
+  void assignToMatch(int clientSocket);
+
+  /**
+   * @brief Forgets open rooms that stopped accepting players.
+   * @return The open room with the most seated players, or nullptr.
+   */
+  Match *findLobbyMatch();
+
+  /**
+   * @brief Lists a room as open again if a departure freed a seat
+   *        before its game started.
+   * @param match Room a client left.
+   */
+  void reopenMatch(Match &match);
+
+  /**
+   * @brief Drops the seats of clients that never sent CONNECT_REQUEST
+   *        within CONNECT_TIMEOUT_TICKS.
+   */
+  void dropSilentClients();
+
+  /**
+   * @brief Turns a freshly seated client into a spectator: frees its seat,
+   *        listing its room as open again, and has it watch the newest
+   *        match in progress on this worker, or the fullest open room
+   *        until that room starts.
+   * @param clientSocket Client whose CONNECT_REQUEST asked to spectate.
+   * @param capabilities Capabilities of that request.
+   */
+  void spectate(int clientSocket, uint8_t capabilities);
+
+  /**
+   * @brief Sends a client that asked for datagrams the UDP port and a
+   *        fresh token to prove its datagrams with.
+   * @param clientSocket Client whose CONNECT_REQUEST asked for them.
+   */
+  void offerDatagrams(int clientSocket);
+
+  /**
+   * @brief Reads every pending datagram, binds its sender to the client
+   *        its token names, and dispatches the packets it carries.
+   */
+  void receiveDatagrams();
+
+  /**
+   * @brief Sends a connection's pending datagram, if any.
+   * @param connection Client with a bound datagram path.
+   */
+  void sendDatagram(Connection &connection);
+
+  /**
+   * @brief Tells whether a frame should go by datagram, moving the client
+   *        back to TCP once its datagrams have stopped.
+   * @param connection Destination client.
+   * @param frame      Frame being queued.
+   * @return True if the frame fits the client's pending datagram.
+   */
+  bool routesByDatagram(Connection &connection,
+                        const Shared::Protocol::Frame &frame);
+
+  /** @brief Publishes the lobby head-count read by the acceptor. */
+  void publishLobbyOccupancy();
+
+  /** @brief Advances every running match by one tick. */
+  void updateMatches();
+
+  /** @brief Copies the tick stats and the gauges into m_metrics. */
+  void publishMetrics();
+
+  /**
+   * @brief Closes the sockets of finished matches and drops empty rooms.
+   */
+  void reapMatches();
+
+  /**
+   * @brief Writes the recording of a finished match, if it has one.
+   * @param match Match being reaped.
+   */
+  void saveRecording(Match &match);
+
+  /**
+   * @brief Parses a raw packet buffer and dispatches by type.
+   * @param clientSocket Client sending the data.
+   * @param data         Byte buffer pointer.
+   * @param length       Number of valid bytes.
+   */
+  void processPacket(int clientSocket, const uint8_t *data, size_t length);
+
+  /**
+   * @brief Dispatches every complete packet buffered for a connection.
+   * @param clientSocket Client whose receive buffer is drained.
+   * @return False if the client was disconnected while draining.
+   */
+  bool drainReceiveBuffer(int clientSocket);
+
+  int m_id;
+  int m_workerCount;
+  std::mutex m_mapMutex;
+  std::shared_ptr<const MapImage> m_mapTemplate;
+  bool m_debugMode;
+  size_t m_maxSendBacklog;
+  uint16_t m_positionScale;
+  std::string m_recordDirectory;
+  int m_listenSocket;
+  Shared::TraceRing *m_trace;
+  int m_wakeReadFd = -1;
+  int m_wakeWriteFd = -1;
+  int m_datagramSocket = -1;
+  uint16_t m_datagramPort = 0;
+
+  std::unique_ptr<EventLoop> m_eventLoop;
+  std::vector<IoEvent> m_events;
+  TickScheduler m_tickScheduler{TICK_RATE};
+  WorkerMetrics m_metrics;
+
+  std::unordered_map<int, std::unique_ptr<Match>> m_matches;
+  std::unordered_map<int, Connection> m_connections;
+  std::vector<int> m_dirtyConnections;
+  std::vector<int> m_flushScratch;
+  Shared::Arena m_frameArena;
+  /** Rooms waiting for players with a free seat, fullest filled first. */
+  std::vector<Match *> m_openMatches;
+  /** Socket and seating tick of each client, in seating order. */
+  std::deque<std::pair<int, uint64_t>> m_silentClients;
+  int m_nextMatchSequence = 0;
+
+  /** Client socket of each datagram token handed out. */
+  std::unordered_map<uint32_t, int> m_datagramClients;
+  std::mt19937 m_tokenGenerator{std::random_device{}()};
+
+  std::mutex m_handoffMutex;
+  std::vector<int> m_handoffQueue;
+  std::vector<int> m_handoffScratch;
+  std::vector<Worker *> m_peers;
+
+  std::atomic<bool> m_running{false};
+  std::atomic<size_t> m_connectionCount{0};
+  std::atomic<int> m_pendingClients{0};
+  std::atomic<int> m_lobbyPlayers{0};
+  std::thread m_thread;
+};
+
+} // namespace Jetpack::Server
@@ -3,47 +3,208 @@
  * @brief Entry point for the Jetpack server application.
  */
 
+#include "MatchReplay.hpp"
+#include "Relay.hpp"
 #include "Server.hpp"
+#include <chrono>
+#include <filesystem>
+#include <format>
 #include <iostream>
+#include <vector>
+
+/** Finer than this and the widest map no longer fits 32-bit positions. */
+static constexpr int MAX_POSITION_SCALE = 10000;
 
 static void usage(const char *program_name) {
-  std::cerr << "Usage: " << program_name << "-p <port> -m <map> [-d]"
+  std::cerr << "Usage: " << program_name
+            << "-p <port> -m <map> [-d] [-b <poll|epoll>] [-w <workers>] "
+               "[-a <least-loaded|hash|reuseport>] [-q <backlog-bytes>] "
+               "[-c <compiled-map>] [-t <trace.pcap>] [-s <sampling>] "
+               "[-M <metrics-port>] [-r <record-dir>] [-R <recording>]... "
+               "[-P <units-per-tile>]\n"
+               "       "
+            << program_name
+            << " -p <port> -U <upstream-ip:port> [-D <delay-ms>] [-d] "
+               "[-b <poll|epoll>] [-q <backlog-bytes>]"
             << std::endl;
 }
 
 int main(const int argc, char *argv[]) {
-  int port = 8080;
-  std::string map_file;
-  bool debug_mode = false;
+  Jetpack::Server::ServerConfig config;
+  std::string compileOutput;
+  std::vector<std::filesystem::path> replays;
 
   for (int i = 1; i < argc; i++) {
     std::string arg = argv[i];
 
     if (arg == "-p" && i + 1 < argc) {
-      port = std::stoi(argv[++i]);
+      config.port = std::stoi(argv[++i]);
     } else if (arg == "-m" && i + 1 < argc) {
-      map_file = argv[++i];
+      config.mapFile = argv[++i];
     } else if (arg == "-d") {
-      debug_mode = true;
+      config.debugMode = true;
+    } else if (arg == "-b" && i + 1 < argc) {
+      const std::string backend_name = argv[++i];
+      if (backend_name == "poll") {
+        config.backend = Jetpack::Server::EventBackend::POLL;
+      } else if (backend_name == "epoll") {
+        config.backend = Jetpack::Server::EventBackend::EPOLL;
+      } else {
+        std::cerr << "Error: Unknown event backend: " << backend_name
+                  << std::endl;
+        usage(argv[0]);
+        return 1;
+      }
+    } else if (arg == "-w" && i + 1 < argc) {
+      config.workerCount = std::stoi(argv[++i]);
+    } else if (arg == "-a" && i + 1 < argc) {
+      const std::string policy_name = argv[++i];
+      if (policy_name == "least-loaded") {
+        config.dispatchPolicy = Jetpack::Server::DispatchPolicy::LEAST_LOADED;
+      } else if (policy_name == "hash") {
+        config.dispatchPolicy = Jetpack::Server::DispatchPolicy::HASH;
+      } else if (policy_name == "reuseport") {
+        config.dispatchPolicy = Jetpack::Server::DispatchPolicy::REUSEPORT;
+      } else {
+        std::cerr << "Error: Unknown dispatch policy: " << policy_name
+                  << std::endl;
+        usage(argv[0]);
+        return 1;
+      }
+    } else if (arg == "-q" && i + 1 < argc) {
+      const long long backlog = std::stoll(argv[++i]);
+      if (backlog <= 0) {
+        std::cerr << "Error: Invalid send backlog limit" << std::endl;
+        usage(argv[0]);
+        return 1;
+      }
+      config.maxSendBacklog = static_cast<size_t>(backlog);
+    } else if (arg == "-P" && i + 1 < argc) {
+      const int scale = std::stoi(argv[++i]);
+      if (scale < 1 || scale > MAX_POSITION_SCALE) {
+        std::cerr << "Error: Invalid position precision" << std::endl;
+        usage(argv[0]);
+        return 1;
+      }
+      config.positionScale = static_cast<uint16_t>(scale);
+    } else if (arg == "-c" && i + 1 < argc) {
+      compileOutput = argv[++i];
+    } else if (arg == "-r" && i + 1 < argc) {
+      config.recordDirectory = argv[++i];
+    } else if (arg == "-R" && i + 1 < argc) {
+      replays.emplace_back(argv[++i]);
+    } else if (arg == "-U" && i + 1 < argc) {
+      const std::string upstream = argv[++i];
+      const size_t colon = upstream.rfind(':');
+      if (colon == std::string::npos) {
+        std::cerr << "Error: Upstream must be <ip>:<port>" << std::endl;
+        usage(argv[0]);
+        return 1;
+      }
+      config.upstreamHost = upstream.substr(0, colon);
+      config.upstreamPort = std::stoi(upstream.substr(colon + 1));
+    } else if (arg == "-D" && i + 1 < argc) {
+      config.relayDelayMs = std::stoi(argv[++i]);
+    } else if (arg == "-M" && i + 1 < argc) {
+      config.metricsPort = std::stoi(argv[++i]);
+    } else if (arg == "-t" && i + 1 < argc) {
+      config.trace.path = argv[++i];
+    } else if (arg == "-s" && i + 1 < argc) {
+      if (!config.trace.parseSampling(argv[++i])) {
+        std::cerr << "Error: Invalid trace sampling" << std::endl;
+        usage(argv[0]);
+        return 1;
+      }
     } else {
       usage(argv[0]);
       return 1;
     }
   }
 
-  if (map_file.empty()) {
+  if (!config.upstreamHost.empty()) {
+    if (config.port <= 0 || config.port > 65535 ||
+        config.upstreamPort <= 0 || config.upstreamPort > 65535 ||
+        config.relayDelayMs < 0) {
+      std::cerr << "Error: Invalid relay options" << std::endl;
+      usage(argv[0]);
+      return 1;
+    }
+    try {
+      Jetpack::Server::Relay relay(config);
+      relay.run();
+    } catch (const std::exception &e) {
+      std::cerr << "Error: " << e.what() << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  if (config.mapFile.empty()) {
     std::cerr << "Error: Map file is required" << std::endl;
     usage(argv[0]);
     return 1;
   }
-  if (port <= 0 || port > 65535) {
+  if (!compileOutput.empty()) {
+    try {
+      Jetpack::Server::MapImage::compile(config.mapFile, compileOutput);
+    } catch (const std::exception &e) {
+      std::cerr << "Error: " << e.what() << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+  if (!replays.empty()) {
+    try {
+      const Jetpack::Server::Replay::Summary summary =
+          Jetpack::Server::Replay::runAll(
+              replays, Jetpack::Server::MapImage::load(config.mapFile),
+              std::cerr);
+      const double seconds =
+          std::chrono::duration<double>(summary.elapsed).count();
+      std::cout << std::format("Replayed {} matches, {} ticks in {:.3f}s "
+                               "({:.0f} ticks/s): {} mismatched",
+                               summary.replayed, summary.ticks, seconds,
+                               seconds > 0 ? summary.ticks / seconds : 0.0,
+                               summary.mismatches)
+                << std::endl;
+      return summary.mismatches == 0 ? 0 : 1;
+    } catch (const std::exception &e) {
+      std::cerr << "Error: " << e.what() << std::endl;
+      return 1;
+    }
+  }
+
+  if (config.port <= 0 || config.port > 65535) {
     std::cerr << "Error: Invalid port number" << std::endl;
     usage(argv[0]);
     return 1;
   }
 
+  if (config.metricsPort < 0 || config.metricsPort > 65535 ||
+      (config.metricsPort != 0 && config.metricsPort == config.port)) {
+    std::cerr << "Error: Invalid metrics port" << std::endl;
+    usage(argv[0]);
+    return 1;
+  }
+
+  if (config.workerCount < 0) {
+    std::cerr << "Error: Invalid worker count" << std::endl;
+    usage(argv[0]);
+    return 1;
+  }
+
+  if (!config.recordDirectory.empty()) {
+    std::error_code error;
+    std::filesystem::create_directories(config.recordDirectory, error);
+    if (error) {
+      std::cerr << "Error: Cannot create record directory: "
+                << error.message() << std::endl;
+      return 1;
+    }
+  }
+
   try {
-    Jetpack::Server::GameServer server(port, map_file, debug_mode);
+    Jetpack::Server::GameServer server(config);
     server.start();
   } catch (const std::exception &e) {
     std::cerr << "Error: " << e.what() << std::endl;
@@ -0,0 +1,104 @@
+/**
+ * @file Arena.hpp
+ * @brief Bump allocator for memory that only lives until the end of a
+ *        loop iteration or tick.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace Jetpack::Shared {
+
+/**
+ * @class Arena
+ * @brief Linear allocator over blocks that are kept across resets.
+ *
+ * allocate() only bumps an offset; reset() rewinds every block at once.
+ * Blocks are allocated while the arena warms up and then reused, so a
+ * steady-state workload does not touch the heap at all. Nothing is
+ * destroyed on reset: only trivially destructible data belongs here.
+ */
+class Arena {
+public:
+  static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+  /**
+   * @brief Creates an empty arena; no memory is reserved until used.
+   * @param blockSize Size of each block requested from the heap.
+   */
+  explicit Arena(const size_t blockSize = DEFAULT_BLOCK_SIZE)
+      : m_blockSize(std::max<size_t>(blockSize, 1)) {}
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+  Arena(Arena &&) = default;
+  Arena &operator=(Arena &&) = default;
+
+  /**
+   * @brief Returns uninitialized storage valid until the next reset().
+   * @param bytes     Number of bytes requested.
+   * @param alignment Power-of-two alignment of the returned pointer.
+   * @return Pointer to the storage.
+   */
+  void *allocate(const size_t bytes,
+                 const size_t alignment = alignof(std::max_align_t)) {
+    while (m_current < m_blocks.size()) {
+      Block &block = m_blocks[m_current];
+      const size_t aligned = (m_offset + alignment - 1) & ~(alignment - 1);
+      if (aligned + bytes <= block.size) {
+        m_offset = aligned + bytes;
+        m_bytesUsed += bytes;
+        return block.data.get() + aligned;
+      }
+      m_current++;
+      m_offset = 0;
+    }
+
+    const size_t size = std::max(m_blockSize, bytes + alignment);
+    m_blocks.push_back({std::make_unique<std::byte[]>(size), size});
+    m_capacity += size;
+    return allocate(bytes, alignment);
+  }
+
+  /**
+   * @brief Returns an uninitialized byte range valid until reset().
+   * @param bytes Number of bytes requested.
+   * @return The storage as a span.
+   */
+  std::span<std::byte> allocateBytes(const size_t bytes) {
+    return {static_cast<std::byte *>(allocate(bytes, 1)), bytes};
+  }
+
+  /** @brief Releases every allocation at once; blocks are kept. */
+  void reset() {
+    m_current = 0;
+    m_offset = 0;
+    m_bytesUsed = 0;
+  }
+
+  /** @return Bytes handed out since the last reset(). */
+  [[nodiscard]] size_t getBytesUsed() const { return m_bytesUsed; }
+
+  /** @return Bytes reserved from the heap over the arena's lifetime. */
+  [[nodiscard]] size_t getCapacity() const { return m_capacity; }
+
+private:
+  struct Block {
+    std::unique_ptr<std::byte[]> data;
+    size_t size;
+  };
+
+  std::vector<Block> m_blocks;
+  size_t m_blockSize;
+  size_t m_current = 0;
+  size_t m_offset = 0;
+  size_t m_bytesUsed = 0;
+  size_t m_capacity = 0;
+};
+
+} // namespace Jetpack::Shared
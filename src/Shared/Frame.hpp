@@ -0,0 +1,151 @@
+/**
+ * @file Frame.hpp
+ * @brief Immutable wire frames and the builder that serializes a packet
+ *        straight into one.
+ */
+
+#pragma once
+
+#include "Arena.hpp"
+#include "PacketWriter.hpp"
+#include "Protocol.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <utility>
+
+namespace Jetpack::Shared::Protocol {
+
+/**
+ * @class Frame
+ * @brief A complete serialized packet, [type][payload...].
+ *
+ * Frames are never modified once built, so one frame is shared by every
+ * recipient's send queue. A frame either owns its bytes through a shared
+ * reference count, or borrows them from an Arena, in which case it is
+ * only valid until that arena is reset: whoever still holds it by then
+ * must copy the bytes out (see isArenaBacked()).
+ */
+class Frame {
+public:
+  Frame() = default;
+
+  /**
+   * @brief Wraps serialized bytes.
+   * @param owner Keeps heap storage alive, or null for arena storage.
+   * @param bytes The serialized packet.
+   */
+  Frame(std::shared_ptr<const std::byte[]> owner,
+        const std::span<const std::byte> bytes)
+      : m_owner(std::move(owner)), m_bytes(bytes) {}
+
+  /** @return The serialized packet. */
+  [[nodiscard]] std::span<const std::byte> bytes() const { return m_bytes; }
+
+  /** @return Pointer to the type byte. */
+  [[nodiscard]] const std::byte *data() const { return m_bytes.data(); }
+
+  /** @return Size in bytes, type byte included. */
+  [[nodiscard]] size_t size() const { return m_bytes.size(); }
+
+  /** @return True if the frame holds no bytes. */
+  [[nodiscard]] bool empty() const { return m_bytes.empty(); }
+
+  /** @return True if the bytes die with the next reset of their arena. */
+  [[nodiscard]] bool isArenaBacked() const { return m_owner == nullptr; }
+
+private:
+  std::shared_ptr<const std::byte[]> m_owner;
+  std::span<const std::byte> m_bytes;
+};
+
+/**
+ * @class FrameBuilder
+ * @brief Serializes a packet of known size in place, type byte first.
+ *
+ * The storage is sized once up front, either from an Arena (no heap
+ * allocation once the arena has warmed up) or as one shared heap block,
+ * and finish() hands it over without copying.
+ */
+class FrameBuilder {
+public:
+  /**
+   * @brief Starts a heap-backed, reference-counted frame.
+   * @param packetType  Type identifier, written as the first byte.
+   * @param payloadSize Exact number of payload bytes that will be added.
+   */
+  FrameBuilder(const PacketType packetType, const size_t payloadSize)
+      : FrameBuilder(allocateShared(payloadSize + 1), packetType,
+                     payloadSize) {}
+
+  /**
+   * @brief Starts a frame whose bytes live in an arena.
+   * @param arena       Arena providing the storage.
+   * @param packetType  Type identifier, written as the first byte.
+   * @param payloadSize Exact number of payload bytes that will be added.
+   */
+  FrameBuilder(Arena &arena, const PacketType packetType,
+               const size_t payloadSize)
+      : m_writer(arena.allocateBytes(payloadSize + 1), packetType,
+                 payloadSize) {}
+
+  /**
+   * @brief Append an unsigned byte.
+   * @param value Value in [0,255]
+   */
+  void addByte(const uint8_t value) { m_writer.addByte(value); }
+
+  /**
+   * @brief Append a 16‑bit unsigned value (little endian).
+   * @param value Value in [0,65535]
+   */
+  void addShort(const uint16_t value) { m_writer.addShort(value); }
+
+  /**
+   * @brief Append a 32‑bit unsigned value (little endian).
+   * @param value Value in [0,2³²)
+   */
+  void addInt(const uint32_t value) { m_writer.addInt(value); }
+
+  /**
+   * @brief Append an unsigned LEB128 varint.
+   * @param value Value in [0,2³²)
+   */
+  void addVarint(const uint32_t value) { m_writer.addVarint(value); }
+
+  /**
+   * @brief Append raw bytes.
+   * @param bytes Bytes to copy
+   */
+  void addBytes(const std::span<const std::byte> bytes) {
+    m_writer.addBytes(bytes);
+  }
+
+  /** @return The underlying writer, for codecs that take one. */
+  [[nodiscard]] PacketWriter &getWriter() { return m_writer; }
+
+  /**
+   * @brief Seals the frame.
+   * @return The immutable frame over the bytes written.
+   */
+  [[nodiscard]] Frame finish() {
+    return Frame(std::move(m_owner), m_writer.written());
+  }
+
+private:
+  FrameBuilder(std::shared_ptr<std::byte[]> storage,
+               const PacketType packetType, const size_t payloadSize)
+      : m_owner(storage),
+        m_writer(std::span(storage.get(), payloadSize + 1), packetType,
+                 payloadSize) {}
+
+  static std::shared_ptr<std::byte[]> allocateShared(const size_t size) {
+    return std::shared_ptr<std::byte[]>(new std::byte[size]);
+  }
+
+  std::shared_ptr<const std::byte[]> m_owner;
+  PacketWriter m_writer;
+};
+
+} // namespace Jetpack::Shared::Protocol
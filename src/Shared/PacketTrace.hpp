@@ -0,0 +1,377 @@
+/**
+ * @file PacketTrace.hpp
+ * @brief Packet tracing that stays off the hot path: producers copy each
+ *        packet into a per-thread lock-free ring, and a background thread
+ *        formats and writes it.
+ */
+
+#pragma once
+
+#include "Exceptions.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace Jetpack::Shared {
+
+/**
+ * @enum TraceDirection
+ * @brief Which way a traced packet travelled.
+ */
+enum class TraceDirection : uint8_t { RECEIVED = 0, SENT = 1 };
+
+/**
+ * @struct TraceOptions
+ * @brief What to trace and where to write it.
+ */
+struct TraceOptions {
+  /** pcap file to write; empty traces as text to stdout. */
+  std::string path;
+  /**
+   * Keep one packet in this many, per packet type; 0 drops the type.
+   * Counted per producer thread, so the first packet of each type is
+   * always kept.
+   */
+  std::array<uint32_t, 256> sampleEvery = makeSampling(1);
+
+  /**
+   * @brief Applies a sampling specification.
+   *
+   * The specification is a comma-separated list of `type=every`, where
+   * type is a packet type number (decimal or 0x-prefixed hex) or `*` for
+   * every type; later items override earlier ones. `*=0,0x08=1` traces
+   * COIN_COLLECTED only, `0x06=60` one GAME_STATE_UPDATE a second.
+   *
+   * @param spec Specification to apply.
+   * @return False, leaving the sampling unchanged, if it is malformed.
+   */
+  bool parseSampling(std::string_view spec) {
+    std::array<uint32_t, 256> sampling = sampleEvery;
+    while (!spec.empty()) {
+      const size_t comma = spec.find(',');
+      const std::string_view item = spec.substr(0, comma);
+      spec = comma == std::string_view::npos ? std::string_view()
+                                             : spec.substr(comma + 1);
+
+      const size_t equals = item.find('=');
+      if (equals == std::string_view::npos) {
+        return false;
+      }
+      const std::string type(item.substr(0, equals));
+      const std::string every(item.substr(equals + 1));
+
+      size_t parsed = 0;
+      unsigned long value = 0;
+      try {
+        value = std::stoul(every, &parsed, 10);
+      } catch (const std::exception &) {
+        return false;
+      }
+      if (parsed != every.size() || value > UINT32_MAX) {
+        return false;
+      }
+
+      if (type == "*") {
+        sampling.fill(static_cast<uint32_t>(value));
+        continue;
+      }
+      unsigned long typeValue = 0;
+      try {
+        typeValue = std::stoul(type, &parsed, 0);
+      } catch (const std::exception &) {
+        return false;
+      }
+      if (parsed != type.size() || typeValue >= sampling.size()) {
+        return false;
+      }
+      sampling[typeValue] = static_cast<uint32_t>(value);
+    }
+    sampleEvery = sampling;
+    return true;
+  }
+
+private:
+  static std::array<uint32_t, 256> makeSampling(const uint32_t every) {
+    std::array<uint32_t, 256> sampling{};
+    sampling.fill(every);
+    return sampling;
+  }
+};
+
+/**
+ * @struct TraceRecord
+ * @brief One traced packet, truncated to CAPTURE_SIZE bytes.
+ */
+struct TraceRecord {
+  /** Bytes of each packet kept; enough for every packet but map data. */
+  static constexpr size_t CAPTURE_SIZE = 104;
+
+  /** Wall-clock time of the trace, in nanoseconds since the epoch. */
+  int64_t timestampNs = 0;
+  /** Socket the packet went through. */
+  int32_t peer = -1;
+  /** Full length of the packet. */
+  uint32_t length = 0;
+  uint16_t capturedLength = 0;
+  TraceDirection direction = TraceDirection::RECEIVED;
+  std::array<std::byte, CAPTURE_SIZE> bytes{};
+};
+
+/**
+ * @class TraceRing
+ * @brief Single-producer, single-consumer ring of trace records.
+ *
+ * The thread that owns the traffic records into it without locking or
+ * allocating; the tracer's writer thread is the only consumer. When the
+ * writer falls behind, new records are dropped and counted rather than
+ * slowing the producer down.
+ */
+class TraceRing {
+public:
+  /** Records the ring holds; a power of two. */
+  static constexpr size_t CAPACITY = 4096;
+
+  /**
+   * @brief Creates an empty ring.
+   * @param sampleEvery Sampling per packet type, owned by the tracer.
+   */
+  explicit TraceRing(const std::array<uint32_t, 256> &sampleEvery)
+      : m_sampleEvery(sampleEvery),
+        m_records(std::make_unique<TraceRecord[]>(CAPACITY)) {}
+
+  /**
+   * @brief Records a packet, subject to sampling; producer only.
+   * @param direction Which way it travelled.
+   * @param peer      Socket it went through.
+   * @param packet    The whole packet, type byte first.
+   */
+  void record(const TraceDirection direction, const int peer,
+              const std::span<const std::byte> packet) {
+    if (packet.empty()) {
+      return;
+    }
+    const auto type = static_cast<uint8_t>(packet[0]);
+    const uint32_t every = m_sampleEvery[type];
+    if (every == 0 || m_seen[type]++ % every != 0) {
+      return;
+    }
+
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) == CAPACITY) {
+      m_dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    TraceRecord &record = m_records[head & (CAPACITY - 1)];
+    record.timestampNs =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    record.peer = peer;
+    record.length = static_cast<uint32_t>(packet.size());
+    record.capturedLength = static_cast<uint16_t>(
+        std::min(packet.size(), TraceRecord::CAPTURE_SIZE));
+    record.direction = direction;
+    std::memcpy(record.bytes.data(), packet.data(), record.capturedLength);
+    m_head.store(head + 1, std::memory_order_release);
+  }
+
+  /**
+   * @brief Hands every pending record to a callback; consumer only.
+   * @param consume Called with each record, oldest first.
+   */
+  template <typename Consume> void drain(Consume &&consume) {
+    const size_t head = m_head.load(std::memory_order_acquire);
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    for (; tail != head; tail++) {
+      consume(m_records[tail & (CAPACITY - 1)]);
+    }
+    m_tail.store(tail, std::memory_order_release);
+  }
+
+  /** @return Records dropped because the ring was full. */
+  [[nodiscard]] uint64_t getDropped() const {
+    return m_dropped.load(std::memory_order_relaxed);
+  }
+
+private:
+  const std::array<uint32_t, 256> &m_sampleEvery;
+  /** Packets seen per type, for sampling; producer only. */
+  std::array<uint32_t, 256> m_seen{};
+  std::unique_ptr<TraceRecord[]> m_records;
+  alignas(64) std::atomic<size_t> m_head{0};
+  alignas(64) std::atomic<size_t> m_tail{0};
+  std::atomic<uint64_t> m_dropped{0};
+};
+
+/**
+ * @class PacketTracer
+ * @brief Owns the trace rings of every thread and the thread writing them.
+ *
+ * Text traces print one line per packet, as the debug mode always did.
+ * File traces are pcap with nanosecond timestamps and link type USER0;
+ * each packet is preceded by an 8-byte pseudo-header:
+ *
+ *     Direction (1, 0 received, 1 sent) | Reserved (3) | Socket (4)
+ */
+class PacketTracer {
+public:
+  /** How often the writer empties the rings. */
+  static constexpr std::chrono::milliseconds DRAIN_INTERVAL{10};
+
+  /**
+   * @brief Opens the output and starts the writer thread.
+   * @param options What to trace and where to write it.
+   * @throws Exceptions::ResourceException if the file cannot be created.
+   */
+  explicit PacketTracer(TraceOptions options) : m_options(std::move(options)) {
+    if (m_options.path.empty()) {
+      m_output = stdout;
+    } else {
+      m_output = std::fopen(m_options.path.c_str(), "wb");
+      if (m_output == nullptr) {
+        throw Exceptions::ResourceException(m_options.path,
+                                            std::strerror(errno));
+      }
+      writePcapHeader();
+    }
+    m_writer = std::thread(&PacketTracer::writerLoop, this);
+  }
+
+  /** @brief Writes what is left in the rings and closes the output. */
+  ~PacketTracer() {
+    {
+      std::lock_guard lock(m_mutex);
+      m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_writer.join();
+
+    uint64_t dropped = 0;
+    for (const auto &ring : m_rings) {
+      dropped += ring->getDropped();
+    }
+    if (dropped > 0) {
+      std::cerr << std::format("Trace: dropped {} packets", dropped)
+                << std::endl;
+    }
+    if (m_output != stdout) {
+      std::fclose(m_output);
+    }
+  }
+
+  PacketTracer(const PacketTracer &) = delete;
+  PacketTracer &operator=(const PacketTracer &) = delete;
+  PacketTracer(PacketTracer &&) = delete;
+  PacketTracer &operator=(PacketTracer &&) = delete;
+
+  /**
+   * @brief Creates the ring of one producer thread.
+   * @return The ring, valid for the tracer's lifetime.
+   */
+  TraceRing &addRing() {
+    std::lock_guard lock(m_mutex);
+    return *m_rings.emplace_back(
+        std::make_unique<TraceRing>(m_options.sampleEvery));
+  }
+
+private:
+  /** pcap link type for private use; the pseudo-header describes it. */
+  static constexpr uint32_t LINKTYPE_USER0 = 147;
+  static constexpr size_t PSEUDO_HEADER_SIZE = 8;
+
+  /** @brief Empties every ring each DRAIN_INTERVAL until stopped. */
+  void writerLoop() {
+    std::unique_lock lock(m_mutex);
+    while (true) {
+      const bool stopping = m_wake.wait_for(lock, DRAIN_INTERVAL,
+                                            [this] { return m_stopping; });
+      for (const auto &ring : m_rings) {
+        ring->drain([this](const TraceRecord &record) { write(record); });
+      }
+      std::fflush(m_output);
+      if (stopping) {
+        return;
+      }
+    }
+  }
+
+  void write(const TraceRecord &record) {
+    if (m_output == stdout) {
+      writeText(record);
+    } else {
+      writePcap(record);
+    }
+  }
+
+  void writeText(const TraceRecord &record) {
+    const bool sent = record.direction == TraceDirection::SENT;
+    std::string line =
+        std::format("Debug: {} {} bytes {} {}:", sent ? "Sent" : "Received",
+                    record.length, sent ? "to" : "from", record.peer);
+    for (size_t i = 0; i < record.capturedLength; i++) {
+      line += std::format(" {:02X}", static_cast<unsigned>(record.bytes[i]));
+    }
+    if (record.capturedLength < record.length) {
+      line += " ...";
+    }
+    line += '\n';
+    std::fwrite(line.data(), 1, line.size(), m_output);
+  }
+
+  void writePcapHeader() {
+    static_assert(std::endian::native == std::endian::little);
+    const std::array<uint32_t, 6> header = {
+        0xA1B23C4D, // nanosecond-resolution magic
+        0x00040002, // version 2.4
+        0,
+        0,
+        static_cast<uint32_t>(PSEUDO_HEADER_SIZE + TraceRecord::CAPTURE_SIZE),
+        LINKTYPE_USER0};
+    std::fwrite(header.data(), sizeof(uint32_t), header.size(), m_output);
+  }
+
+  void writePcap(const TraceRecord &record) {
+    const std::array<uint32_t, 4> header = {
+        static_cast<uint32_t>(record.timestampNs / 1'000'000'000),
+        static_cast<uint32_t>(record.timestampNs % 1'000'000'000),
+        static_cast<uint32_t>(PSEUDO_HEADER_SIZE + record.capturedLength),
+        static_cast<uint32_t>(PSEUDO_HEADER_SIZE + record.length)};
+    std::array<std::byte, PSEUDO_HEADER_SIZE> pseudoHeader{};
+    pseudoHeader[0] = static_cast<std::byte>(record.direction);
+    std::memcpy(pseudoHeader.data() + 4, &record.peer, sizeof(record.peer));
+
+    std::fwrite(header.data(), sizeof(uint32_t), header.size(), m_output);
+    std::fwrite(pseudoHeader.data(), 1, pseudoHeader.size(), m_output);
+    std::fwrite(record.bytes.data(), 1, record.capturedLength, m_output);
+  }
+
+  const TraceOptions m_options;
+  std::FILE *m_output = nullptr;
+
+  /** Guards m_rings and m_stopping; held by the writer while draining. */
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  bool m_stopping = false;
+  std::vector<std::unique_ptr<TraceRing>> m_rings;
+  std::thread m_writer;
+};
+
+} // namespace Jetpack::Shared
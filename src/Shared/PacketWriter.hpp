@@ -0,0 +1,108 @@
+/**
+ * @file PacketWriter.hpp
+ * @brief Fixed-capacity packet serializer over caller-provided memory.
+ */
+
+#pragma once
+
+#include "Exceptions.hpp"
+#include "Protocol.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <span>
+
+namespace Jetpack::Shared::Protocol {
+
+/**
+ * @class PacketWriter
+ * @brief Writes [type][payload...] into a buffer it does not own.
+ *
+ * The caller states the payload size up front and the buffer is checked
+ * once, in the constructor; the add*() calls then write without any
+ * per-byte capacity check or reallocation. Writing more than the
+ * declared payload is a programming error.
+ */
+class PacketWriter {
+public:
+  /**
+   * @brief Starts a packet in the given buffer.
+   * @param buffer      Destination memory.
+   * @param packetType  Type identifier, written as the first byte.
+   * @param payloadSize Number of payload bytes that will be written.
+   * @throws Exceptions::ProtocolException if the buffer is too small.
+   */
+  PacketWriter(const std::span<std::byte> buffer, const PacketType packetType,
+               const size_t payloadSize)
+      : m_buffer(buffer) {
+    if (buffer.size() < payloadSize + 1) {
+      throw Exceptions::ProtocolException(
+          std::format("Packet of {} bytes does not fit in a {} byte buffer",
+                      payloadSize + 1, buffer.size()));
+    }
+    m_buffer[m_size++] = static_cast<std::byte>(packetType);
+  }
+
+  /**
+   * @brief Append an unsigned byte.
+   * @param value Value in [0,255]
+   */
+  void addByte(const uint8_t value) {
+    m_buffer[m_size++] = static_cast<std::byte>(value);
+  }
+
+  /**
+   * @brief Append a 16‑bit unsigned value (little endian).
+   * @param value Value in [0,65535]
+   */
+  void addShort(const uint16_t value) {
+    m_buffer[m_size++] = static_cast<std::byte>(value & 0xFF);
+    m_buffer[m_size++] = static_cast<std::byte>((value >> 8) & 0xFF);
+  }
+
+  /**
+   * @brief Append a 32‑bit unsigned value (little endian).
+   * @param value Value in [0,2³²)
+   */
+  void addInt(const uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+      m_buffer[m_size++] = static_cast<std::byte>((value >> shift) & 0xFF);
+    }
+  }
+
+  /**
+   * @brief Append an unsigned LEB128 varint, getVarintSize() bytes long.
+   * @param value Value in [0,2³²)
+   */
+  void addVarint(uint32_t value) {
+    while (value >= 0x80) {
+      m_buffer[m_size++] = static_cast<std::byte>((value & 0x7F) | 0x80);
+      value >>= 7;
+    }
+    m_buffer[m_size++] = static_cast<std::byte>(value);
+  }
+
+  /**
+   * @brief Append raw bytes.
+   * @param bytes Bytes to copy.
+   */
+  void addBytes(const std::span<const std::byte> bytes) {
+    std::copy(bytes.begin(), bytes.end(), m_buffer.begin() + m_size);
+    m_size += bytes.size();
+  }
+
+  /** @return Number of bytes written so far, type byte included. */
+  [[nodiscard]] size_t size() const { return m_size; }
+
+  /** @return The bytes written so far. */
+  [[nodiscard]] std::span<const std::byte> written() const {
+    return m_buffer.first(m_size);
+  }
+
+private:
+  std::span<std::byte> m_buffer;
+  size_t m_size = 0;
+};
+
+} // namespace Jetpack::Shared::Protocol
@@ -0,0 +1,221 @@
+/**
+ * @file Physics.hpp
+ * @brief Declaration of the Physics utility class for player movement and
+ *        bounds checking, run by the server and replayed by the client's
+ *        prediction.
+ */
+
+#pragma once
+
+#include "PlayerBatch.hpp"
+#include "Protocol.hpp"
+#include <algorithm>
+#include <cstddef>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace Jetpack::Shared {
+
+/**
+ * @class Physics
+ * @brief Provides static methods to apply gravity/jetpack forces,
+ *        enforce world bounds.
+ *
+ * Both sides step the same code at the same fixed rate, so a client that
+ * replays its own inputs lands where the server will. The batch step runs
+ * the same operations in the same order over SIMD lanes (AVX2 when built
+ * with `make SIMD=avx2`, SSE2 otherwise, scalar for the leftover lanes),
+ * so it produces exactly the results of stepping each player on its own;
+ * the bench's physics/batch_vs_scalar checks that it does.
+ */
+class Physics {
+public:
+  /** Simulation steps per second; one PLAYER_INPUT is sent per step. */
+  static constexpr int TICK_RATE = 60;
+
+  /**
+   * @brief Updates a player's vertical velocity and position.
+   * @param player The player whose physics to update.
+   *
+   * Applies gravity, subtracts jetpack thrust if active,
+   * clamps velocity, and advances horizontal and vertical position.
+   */
+  static void applyPhysics(Protocol::Player &player) {
+    float velocityY = player.getVelocityY() + GRAVITY;
+
+    if (player.isJetpacking()) {
+      velocityY -= JETPACK_FORCE;
+    }
+
+    velocityY = std::clamp(velocityY, -MAX_VELOCITY, MAX_VELOCITY);
+    player.setVelocityY(velocityY);
+
+    const auto pos = player.getPosition();
+    player.setPosition(pos.x + HORIZONTAL_SPEED, pos.y + velocityY);
+  }
+
+  /**
+   * @brief Constrains a player to the vertical bounds of the map.
+   * @param player    The player to clamp.
+   * @param mapHeight Height of the map in tiles.
+   *
+   * If the player is above the ceiling or below the floor,
+   * resets vertical velocity and moves them inside the map.
+   */
+  static void checkBounds(Protocol::Player &player, const int mapHeight) {
+    const auto pos = player.getPosition();
+
+    if (pos.y < 0.0f) {
+      player.setPosition(pos.x, 0.0f);
+      player.setVelocityY(0.0f);
+    } else if (pos.y >= mapHeight - 1.0f) {
+      player.setPosition(pos.x, mapHeight - 1.0f);
+      player.setVelocityY(0.0f);
+    }
+  }
+
+  /**
+   * @brief Runs one full simulation step: forces, then bounds.
+   * @param player    The player to advance.
+   * @param mapHeight Height of the map in tiles.
+   */
+  static void step(Protocol::Player &player, const int mapHeight) {
+    applyPhysics(player);
+    checkBounds(player, mapHeight);
+  }
+
+  /**
+   * @brief Runs one full simulation step for every player of a batch.
+   * @param batch     Players to advance; every lane must be playing.
+   * @param mapHeight Height of the map in tiles.
+   */
+  static void step(PlayerBatch &batch, const int mapHeight) {
+    const size_t count = batch.size();
+    const float floor = mapHeight - 1.0f;
+    size_t lane = 0;
+
+#if defined(__AVX2__)
+    for (; lane + 8 <= count; lane += 8) {
+      stepLanes8(batch, lane, floor);
+    }
+#endif
+#if defined(__SSE2__)
+    for (; lane + 4 <= count; lane += 4) {
+      stepLanes4(batch, lane, floor);
+    }
+#endif
+    for (; lane < count; lane++) {
+      stepLane(batch, lane, floor);
+    }
+  }
+
+private:
+  /**
+   * @brief Scalar step of one lane, the reference for the SIMD kernels.
+   * @param batch Players being stepped.
+   * @param lane  Lane to step.
+   * @param floor Lowest position inside the map, mapHeight - 1.
+   */
+  static void stepLane(PlayerBatch &batch, const size_t lane,
+                       const float floor) {
+    float velocityY = batch.velocityY[lane] + GRAVITY;
+    if (batch.jetpacking[lane] != 0) {
+      velocityY -= JETPACK_FORCE;
+    }
+    velocityY = std::clamp(velocityY, -MAX_VELOCITY, MAX_VELOCITY);
+
+    float y = batch.y[lane] + velocityY;
+    if (y < 0.0f) {
+      y = 0.0f;
+      velocityY = 0.0f;
+    } else if (y >= floor) {
+      y = floor;
+      velocityY = 0.0f;
+    }
+
+    batch.x[lane] += HORIZONTAL_SPEED;
+    batch.y[lane] = y;
+    batch.velocityY[lane] = velocityY;
+  }
+
+#if defined(__SSE2__)
+  /** @brief Steps lanes [lane, lane + 4) with SSE2; see stepLane(). */
+  static void stepLanes4(PlayerBatch &batch, const size_t lane,
+                         const float floor) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128i jetpacking = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(batch.jetpacking.data() + lane));
+    const __m128 thrust =
+        _mm_and_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(jetpacking,
+                                                    _mm_setzero_si128())),
+                   _mm_set1_ps(JETPACK_FORCE));
+
+    __m128 velocityY = _mm_add_ps(_mm_loadu_ps(batch.velocityY.data() + lane),
+                                  _mm_set1_ps(GRAVITY));
+    velocityY = _mm_sub_ps(velocityY, thrust);
+    velocityY = _mm_min_ps(_mm_max_ps(velocityY, _mm_set1_ps(-MAX_VELOCITY)),
+                           _mm_set1_ps(MAX_VELOCITY));
+
+    __m128 y = _mm_add_ps(_mm_loadu_ps(batch.y.data() + lane), velocityY);
+    const __m128 floors = _mm_set1_ps(floor);
+    const __m128 above = _mm_cmplt_ps(y, zero);
+    const __m128 below = _mm_andnot_ps(above, _mm_cmpge_ps(y, floors));
+    y = _mm_or_ps(_mm_andnot_ps(_mm_or_ps(above, below), y),
+                  _mm_and_ps(below, floors));
+    velocityY = _mm_andnot_ps(_mm_or_ps(above, below), velocityY);
+
+    _mm_storeu_ps(batch.x.data() + lane,
+                  _mm_add_ps(_mm_loadu_ps(batch.x.data() + lane),
+                             _mm_set1_ps(HORIZONTAL_SPEED)));
+    _mm_storeu_ps(batch.y.data() + lane, y);
+    _mm_storeu_ps(batch.velocityY.data() + lane, velocityY);
+  }
+#endif
+
+#if defined(__AVX2__)
+  /** @brief Steps lanes [lane, lane + 8) with AVX2; see stepLane(). */
+  static void stepLanes8(PlayerBatch &batch, const size_t lane,
+                         const float floor) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256i jetpacking = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(batch.jetpacking.data() + lane));
+    const __m256 thrust = _mm256_and_ps(
+        _mm256_castsi256_ps(
+            _mm256_cmpgt_epi32(jetpacking, _mm256_setzero_si256())),
+        _mm256_set1_ps(JETPACK_FORCE));
+
+    __m256 velocityY =
+        _mm256_add_ps(_mm256_loadu_ps(batch.velocityY.data() + lane),
+                      _mm256_set1_ps(GRAVITY));
+    velocityY = _mm256_sub_ps(velocityY, thrust);
+    velocityY = _mm256_min_ps(
+        _mm256_max_ps(velocityY, _mm256_set1_ps(-MAX_VELOCITY)),
+        _mm256_set1_ps(MAX_VELOCITY));
+
+    __m256 y =
+        _mm256_add_ps(_mm256_loadu_ps(batch.y.data() + lane), velocityY);
+    const __m256 floors = _mm256_set1_ps(floor);
+    const __m256 above = _mm256_cmp_ps(y, zero, _CMP_LT_OQ);
+    const __m256 below =
+        _mm256_andnot_ps(above, _mm256_cmp_ps(y, floors, _CMP_GE_OQ));
+    y = _mm256_or_ps(_mm256_andnot_ps(_mm256_or_ps(above, below), y),
+                     _mm256_and_ps(below, floors));
+    velocityY = _mm256_andnot_ps(_mm256_or_ps(above, below), velocityY);
+
+    _mm256_storeu_ps(batch.x.data() + lane,
+                     _mm256_add_ps(_mm256_loadu_ps(batch.x.data() + lane),
+                                   _mm256_set1_ps(HORIZONTAL_SPEED)));
+    _mm256_storeu_ps(batch.y.data() + lane, y);
+    _mm256_storeu_ps(batch.velocityY.data() + lane, velocityY);
+  }
+#endif
+
+  static constexpr float GRAVITY = 0.008f;
+  static constexpr float JETPACK_FORCE = 0.013f;
+  static constexpr float MAX_VELOCITY = 0.05f;
+  static constexpr float HORIZONTAL_SPEED = 0.05f;
+};
+
+} // namespace Jetpack::Shared
@@ -0,0 +1,77 @@
+/**
+ * @file PlayerBatch.hpp
+ * @brief Declaration of the PlayerBatch structure, the kinematic state of
+ *        many players laid out as one array per field.
+ */
+
+#pragma once
+
+#include "Protocol.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Jetpack::Shared {
+
+/**
+ * @struct PlayerBatch
+ * @brief Positions, velocities and thrust of a group of players, stored
+ *        structure-of-arrays so Physics can step them in SIMD lanes.
+ *
+ * Lane i of every array belongs to the same player. Players are loaded
+ * with add() and their stepped state written back with store(); the
+ * arrays keep their capacity across clear(), so a batch reused every tick
+ * stops allocating once it has seen its largest group.
+ */
+struct PlayerBatch {
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> velocityY;
+  /** 1 while the player's jetpack is on, 0 otherwise. */
+  std::vector<int32_t> jetpacking;
+
+  /** @return Number of players in the batch. */
+  [[nodiscard]] size_t size() const { return x.size(); }
+
+  /** @brief Empties the batch, keeping its capacity. */
+  void clear() {
+    x.clear();
+    y.clear();
+    velocityY.clear();
+    jetpacking.clear();
+  }
+
+  /**
+   * @brief Reserves room for a number of players.
+   * @param count Players the batch should hold without reallocating.
+   */
+  void reserve(const size_t count) {
+    x.reserve(count);
+    y.reserve(count);
+    velocityY.reserve(count);
+    jetpacking.reserve(count);
+  }
+
+  /**
+   * @brief Appends a player's kinematic state as the next lane.
+   * @param player Player to copy from.
+   */
+  void add(const Protocol::Player &player) {
+    x.push_back(player.getPosition().x);
+    y.push_back(player.getPosition().y);
+    velocityY.push_back(player.getVelocityY());
+    jetpacking.push_back(player.isJetpacking() ? 1 : 0);
+  }
+
+  /**
+   * @brief Writes a lane's position and velocity back to its player.
+   * @param lane   Lane index, below size().
+   * @param player Player the lane was loaded from.
+   */
+  void store(const size_t lane, Protocol::Player &player) const {
+    player.setPosition(x[lane], y[lane]);
+    player.setVelocityY(velocityY[lane]);
+  }
+};
+
+} // namespace Jetpack::Shared
@@ -7,7 +7,10 @@
 #pragma once
 
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
+#include <limits>
+#include <span>
 #include <vector>
 
 namespace Jetpack::Shared::Protocol {
@@ -32,13 +35,47 @@ enum class CoinState : uint8_t {
 /**
  * @struct GameMap
  * @brief Represents the grid of tiles and coin states.
+ *
+ * Both grids are stored row-major in one contiguous buffer each, the
+ * order MAP_DATA uses on the wire, so a map is serialized or loaded with
+ * one bulk copy per grid and a row of cells is a plain span.
  */
 struct GameMap {
   int width = 0;
   int height = 0;
 
-  std::vector<std::vector<TileType>> tiles;
-  std::vector<std::vector<CoinState>> coinStates;
+  /** width * height tiles, row by row. */
+  std::vector<TileType> tiles;
+  /** width * height coin states, row by row. */
+  std::vector<CoinState> coinStates;
+
+  /**
+   * @brief Resets the map to the given size, every cell empty.
+   * @param mapWidth  Number of columns
+   * @param mapHeight Number of rows
+   */
+  void resize(int mapWidth, int mapHeight) {
+    width = mapWidth;
+    height = mapHeight;
+    tiles.assign(getCellCount(), TileType::EMPTY);
+    coinStates.assign(getCellCount(), CoinState::AVAILABLE);
+  }
+
+  /** @return Number of cells, width * height. */
+  [[nodiscard]] size_t getCellCount() const {
+    return static_cast<size_t>(width) * static_cast<size_t>(height);
+  }
+
+  /**
+   * @brief Flat index of a cell; the coordinate must be valid.
+   * @param x Column index
+   * @param y Row index
+   * @return Offset of (x,y) in tiles and coinStates
+   */
+  [[nodiscard]] size_t getIndex(int x, int y) const {
+    return static_cast<size_t>(y) * static_cast<size_t>(width) +
+           static_cast<size_t>(x);
+  }
 
   /**
    * @brief Check if a coordinate lies inside the map bounds.
@@ -57,7 +94,7 @@ struct GameMap {
    * @return TileType at the given cell
    */
   [[nodiscard]] TileType getTileAt(int x, int y) const {
-    return isValidPosition(x, y) ? tiles[y][x] : TileType::EMPTY;
+    return isValidPosition(x, y) ? tiles[getIndex(x, y)] : TileType::EMPTY;
   }
 
   /**
@@ -67,7 +104,35 @@ struct GameMap {
    * @return CoinState at the given cell
    */
   [[nodiscard]] CoinState getCoinStateAt(int x, int y) const {
-    return isValidPosition(x, y) ? coinStates[y][x] : CoinState::AVAILABLE;
+    return isValidPosition(x, y) ? coinStates[getIndex(x, y)]
+                                 : CoinState::AVAILABLE;
+  }
+
+  /**
+   * @brief Set the tile at a valid position.
+   * @param x    Column index
+   * @param y    Row index
+   * @param tile New tile
+   */
+  void setTileAt(int x, int y, TileType tile) { tiles[getIndex(x, y)] = tile; }
+
+  /**
+   * @brief Set the coin state at a valid position.
+   * @param x     Column index
+   * @param y     Row index
+   * @param state New coin state
+   */
+  void setCoinStateAt(int x, int y, CoinState state) {
+    coinStates[getIndex(x, y)] = state;
+  }
+
+  /**
+   * @param y Row index, within [0,height)
+   * @return The tiles of one row, left to right
+   */
+  [[nodiscard]] std::span<const TileType> getTileRow(int y) const {
+    return std::span(tiles).subspan(getIndex(0, y),
+                                    static_cast<size_t>(width));
   }
 };
 
@@ -190,9 +255,174 @@ enum class PacketType : uint8_t {
   COIN_COLLECTED = 0x08,
   PLAYER_DEATH = 0x09,
   GAME_OVER = 0x0A,
-  PLAYER_DISCONNECT = 0x0B
+  PLAYER_DISCONNECT = 0x0B,
+  GAME_STATE_DELTA = 0x0C,
+  STATE_ACK = 0x0D,
+  INPUT_ACK = 0x0E,
+  MAP_INFO = 0x0F,
+  MAP_CHUNK = 0x10,
+  DATAGRAM_OFFER = 0x11,
+  STATE_ENCODING = 0x12,
+  GAME_STATE_PACKED = 0x13,
+  COIN_COLLECTED_PACKED = 0x14
 };
 
+/**
+ * @brief Capability bits a client advertises in the CONNECT_REQUEST
+ *        version byte; servers ignore bits they do not know.
+ */
+inline constexpr uint8_t CAPABILITY_DELTA_STATE = 0x01;
+inline constexpr uint8_t CAPABILITY_INPUT_SEQUENCE = 0x02;
+inline constexpr uint8_t CAPABILITY_MAP_STREAMING = 0x04;
+/**
+ * Watch a match instead of playing it: the server answers with a second
+ * CONNECT_RESPONSE whose player ID is SPECTATOR_ID, then the map, whole
+ * or, with CAPABILITY_MAP_STREAMING, as MAP_INFO and the chunks around
+ * the leading player.
+ */
+inline constexpr uint8_t CAPABILITY_SPECTATE = 0x08;
+
+/**
+ * Carry state and input over UDP as well: the server answers with
+ * DATAGRAM_OFFER, and TCP carries everything until the path is up.
+ */
+inline constexpr uint8_t CAPABILITY_DATAGRAM = 0x10;
+
+/**
+ * Protocol revision 2 for state: the server answers with STATE_ENCODING,
+ * then sends GAME_STATE_PACKED and COIN_COLLECTED_PACKED in place of the
+ * fixed-width state and coin packets.
+ */
+inline constexpr uint8_t CAPABILITY_PACKED_STATE = 0x20;
+
+/** Player ID sent to spectators, which no player ever has. */
+inline constexpr uint8_t SPECTATOR_ID = 0;
+
+/** Type, width, height and chunk width of MAP_INFO. */
+inline constexpr size_t MAP_INFO_SIZE = 7;
+
+/** Type, first column, column count and height of MAP_CHUNK. */
+inline constexpr size_t MAP_CHUNK_HEADER_SIZE = 7;
+
+/** Type, UDP port and token of DATAGRAM_OFFER. */
+inline constexpr size_t DATAGRAM_OFFER_SIZE = 7;
+
+/** Token leading every client datagram, naming its connection. */
+inline constexpr size_t DATAGRAM_TOKEN_SIZE = 4;
+
+/** Sequence number leading every server datagram. */
+inline constexpr size_t DATAGRAM_SEQUENCE_SIZE = 2;
+
+/** Type, units per tile and origin of STATE_ENCODING. */
+inline constexpr size_t STATE_ENCODING_SIZE = 11;
+
+/**
+ * Fixed-point units per tile of GAME_STATE_UPDATE and GAME_STATE_DELTA
+ * positions, and the default precision of GAME_STATE_PACKED.
+ */
+inline constexpr uint16_t LEGACY_POSITION_SCALE = 100;
+
+/** Largest datagram either side sends; below common path MTUs. */
+inline constexpr size_t MAX_DATAGRAM_SIZE = 1200;
+
+/**
+ * @brief Tells which packets may travel in datagrams: the ones a later
+ *        packet of the same type supersedes or repeats. Every other
+ *        packet stays on TCP, which keeps events reliable and ordered.
+ * @param type Packet type.
+ * @return True for state, input and their acknowledgements.
+ */
+constexpr bool isDatagramPacket(const PacketType type) {
+  switch (type) {
+  case PacketType::PLAYER_INPUT:
+  case PacketType::GAME_STATE_UPDATE:
+  case PacketType::GAME_STATE_DELTA:
+  case PacketType::GAME_STATE_PACKED:
+  case PacketType::STATE_ACK:
+  case PacketType::INPUT_ACK:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/**
+ * @brief Bits of the PLAYER_INPUT flags byte. Legacy clients only ever
+ *        send 0 or 1, so the SEQUENCED bit never appears in their input.
+ */
+namespace InputFlag {
+inline constexpr uint8_t JETPACK = 1 << 0;   ///< Jetpack held
+inline constexpr uint8_t SEQUENCED = 1 << 7; ///< Input sequence (2) follows
+} // namespace InputFlag
+
+/** Input sequence meaning "no PLAYER_INPUT applied yet". */
+inline constexpr uint16_t NO_INPUT_SEQUENCE = 0;
+
+/**
+ * @brief Bits of the per-player field mask in GAME_STATE_DELTA; a set bit
+ *        means the field follows, in this order. GAME_STATE_PACKED uses
+ *        the same mask with X, Y and Score as varints.
+ */
+namespace DeltaField {
+inline constexpr uint8_t STATE = 1 << 0;   ///< State (1)
+inline constexpr uint8_t X = 1 << 1;       ///< X-Position (2)
+inline constexpr uint8_t Y = 1 << 2;       ///< Y-Position (2)
+inline constexpr uint8_t SCORE = 1 << 3;   ///< Score (2)
+inline constexpr uint8_t JETPACK = 1 << 4; ///< Jetpack (1)
+inline constexpr uint8_t ALL = STATE | X | Y | SCORE | JETPACK;
+} // namespace DeltaField
+
+/** Baseline sequence of a GAME_STATE_DELTA that is a full keyframe. */
+inline constexpr uint16_t NO_BASELINE = 0;
+
+/** Type, sequence, baseline and player count of GAME_STATE_DELTA. */
+inline constexpr size_t DELTA_HEADER_SIZE = 6;
+
+/**
+ * @brief Size of the fields selected by a GAME_STATE_DELTA field mask.
+ * @param mask Combination of DeltaField bits.
+ * @return Number of bytes following the player's ID and mask.
+ */
+constexpr size_t getDeltaFieldsSize(const uint8_t mask) {
+  return ((mask & DeltaField::STATE) ? 1 : 0) +
+         ((mask & DeltaField::X) ? 2 : 0) + ((mask & DeltaField::Y) ? 2 : 0) +
+         ((mask & DeltaField::SCORE) ? 2 : 0) +
+         ((mask & DeltaField::JETPACK) ? 1 : 0);
+}
+
+/** Type, sequence and baseline of GAME_STATE_PACKED; the count follows. */
+inline constexpr size_t PACKED_HEADER_SIZE = 5;
+
+/** Longest LEB128 encoding of a 32-bit value. */
+inline constexpr size_t MAX_VARINT_SIZE = 5;
+
+/**
+ * @param value Value to encode.
+ * @return Number of bytes of its LEB128 encoding.
+ */
+constexpr size_t getVarintSize(uint32_t value) {
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+/**
+ * @brief Maps signed values to unsigned ones, small magnitudes first, so
+ *        a varint encodes -1 as compactly as 1.
+ */
+constexpr uint32_t zigZagEncode(const int32_t value) {
+  return (static_cast<uint32_t>(value) << 1) ^
+         static_cast<uint32_t>(value >> 31);
+}
+
+/** @brief Inverse of zigZagEncode(). */
+constexpr int32_t zigZagDecode(const uint32_t value) {
+  return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+
 /**
  * @enum GameState
  * @brief Overall game lifecycle on the server.
@@ -283,6 +513,223 @@ struct NetworkPacket {
   }
 };
 
+/**
+ * @brief Marker returned by getPacketSize() for an unknown packet type.
+ */
+inline constexpr size_t INVALID_PACKET_SIZE =
+    std::numeric_limits<size_t>::max();
+
+/**
+ * @brief Decodes a LEB128 varint from a packet that may be incomplete.
+ * @param data    Pointer to the first byte of the packet.
+ * @param maxSize Number of bytes available at data.
+ * @param offset  Position of the varint; advanced past it once complete.
+ * @param value   Receives the decoded value.
+ * @return The varint's size, 0 if more bytes are needed, or
+ *         INVALID_PACKET_SIZE if it is longer than MAX_VARINT_SIZE.
+ */
+inline size_t readVarint(const std::byte *data, const size_t maxSize,
+                         size_t &offset, uint32_t &value) {
+  value = 0;
+  for (size_t i = 0; i < MAX_VARINT_SIZE; i++) {
+    if (offset + i >= maxSize) {
+      return 0;
+    }
+    const auto byte = static_cast<uint8_t>(data[offset + i]);
+    value |= static_cast<uint32_t>(byte & 0x7F) << (7 * i);
+    if ((byte & 0x80) == 0) {
+      offset += i + 1;
+      return i + 1;
+    }
+  }
+  return INVALID_PACKET_SIZE;
+}
+
+/**
+ * @brief Walks the entries of a GAME_STATE_PACKED to find its end.
+ * @param data    Pointer to the first byte of the packet (its type).
+ * @param maxSize Number of bytes available at data.
+ * @return As getPacketSize().
+ */
+inline size_t getPackedStateSize(const std::byte *data,
+                                 const size_t maxSize) {
+  const auto failed = [](const size_t size) {
+    return size == 0 || size == INVALID_PACKET_SIZE;
+  };
+
+  size_t offset = PACKED_HEADER_SIZE;
+  uint32_t value = 0;
+  size_t size = readVarint(data, maxSize, offset, value);
+  if (failed(size)) {
+    return size;
+  }
+
+  const uint32_t entryCount = value;
+  for (uint32_t i = 0; i < entryCount; i++) {
+    if (failed(size = readVarint(data, maxSize, offset, value))) {
+      return size;
+    }
+    if (offset >= maxSize) {
+      return 0;
+    }
+    const auto mask = static_cast<uint8_t>(data[offset++]);
+    offset += (mask & DeltaField::STATE) ? 1 : 0;
+    for (const uint8_t field :
+         {DeltaField::X, DeltaField::Y, DeltaField::SCORE}) {
+      if ((mask & field) != 0 &&
+          failed(size = readVarint(data, maxSize, offset, value))) {
+        return size;
+      }
+    }
+    offset += (mask & DeltaField::JETPACK) ? 1 : 0;
+  }
+
+  return (maxSize >= offset) ? offset : 0;
+}
+
+/**
+ * @brief Determines the size of the packet at the head of a byte stream.
+ *
+ * Shared size table used by both sides to reassemble packets from TCP
+ * segments that may be split or coalesced.
+ *
+ * @param data    Pointer to the first byte of the packet (its type).
+ * @param maxSize Number of bytes available at data.
+ * @return The size of the complete packet, 0 if more bytes are needed,
+ *         or INVALID_PACKET_SIZE if the type byte is unknown.
+ */
+inline size_t getPacketSize(const std::byte *data, const size_t maxSize) {
+  if (maxSize < 1) {
+    return 0;
+  }
+
+  const auto packetType = static_cast<PacketType>(data[0]);
+
+  switch (packetType) {
+  case PacketType::CONNECT_REQUEST:
+    return (maxSize >= 2) ? 2 : 0;
+
+  case PacketType::CONNECT_RESPONSE:
+    return (maxSize >= 3) ? 3 : 0;
+
+  case PacketType::MAP_DATA: {
+    if (maxSize < 5) {
+      return 0;
+    }
+
+    const size_t width = static_cast<unsigned char>(data[1]) |
+                         (static_cast<unsigned char>(data[2]) << 8);
+    const size_t height = static_cast<unsigned char>(data[3]) |
+                          (static_cast<unsigned char>(data[4]) << 8);
+    const size_t expectedSize = 5 + (width * height * 2);
+
+    return (maxSize >= expectedSize) ? expectedSize : 0;
+  }
+
+  case PacketType::GAME_START:
+    return (maxSize >= 3) ? 3 : 0;
+
+  case PacketType::PLAYER_INPUT: {
+    if (maxSize < 2) {
+      return 0;
+    }
+
+    const auto flags = static_cast<uint8_t>(data[1]);
+    const size_t expectedSize = (flags & InputFlag::SEQUENCED) ? 4 : 2;
+
+    return (maxSize >= expectedSize) ? expectedSize : 0;
+  }
+
+  case PacketType::GAME_STATE_UPDATE: {
+    if (maxSize < 2) {
+      return 0;
+    }
+
+    const size_t playerCount = static_cast<unsigned char>(data[1]);
+    constexpr size_t playerDataSize = 10;
+    const size_t expectedSize = 2 + playerCount * playerDataSize;
+
+    return (maxSize >= expectedSize) ? expectedSize : 0;
+  }
+
+  case PacketType::COIN_COLLECTED:
+    return (maxSize >= 6) ? 6 : 0;
+
+  case PacketType::PLAYER_DEATH:
+    return (maxSize >= 2) ? 2 : 0;
+
+  case PacketType::GAME_OVER:
+    return (maxSize >= 3) ? 3 : 0;
+
+  case PacketType::PLAYER_DISCONNECT:
+    return 1;
+
+  case PacketType::GAME_STATE_DELTA: {
+    if (maxSize < DELTA_HEADER_SIZE) {
+      return 0;
+    }
+
+    const size_t playerCount = static_cast<unsigned char>(data[5]);
+    size_t expectedSize = DELTA_HEADER_SIZE;
+    for (size_t i = 0; i < playerCount; i++) {
+      if (maxSize < expectedSize + 2) {
+        return 0;
+      }
+      const auto mask = static_cast<uint8_t>(data[expectedSize + 1]);
+      expectedSize += 2 + getDeltaFieldsSize(mask);
+    }
+
+    return (maxSize >= expectedSize) ? expectedSize : 0;
+  }
+
+  case PacketType::STATE_ACK:
+  case PacketType::INPUT_ACK:
+    return (maxSize >= 3) ? 3 : 0;
+
+  case PacketType::MAP_INFO:
+    return (maxSize >= MAP_INFO_SIZE) ? MAP_INFO_SIZE : 0;
+
+  case PacketType::DATAGRAM_OFFER:
+    return (maxSize >= DATAGRAM_OFFER_SIZE) ? DATAGRAM_OFFER_SIZE : 0;
+
+  case PacketType::STATE_ENCODING:
+    return (maxSize >= STATE_ENCODING_SIZE) ? STATE_ENCODING_SIZE : 0;
+
+  case PacketType::GAME_STATE_PACKED:
+    return getPackedStateSize(data, maxSize);
+
+  case PacketType::COIN_COLLECTED_PACKED: {
+    size_t offset = 1;
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+      const size_t size = readVarint(data, maxSize, offset, value);
+      if (size == 0 || size == INVALID_PACKET_SIZE) {
+        return size;
+      }
+    }
+
+    return (maxSize >= offset + 1) ? offset + 1 : 0;
+  }
+
+  case PacketType::MAP_CHUNK: {
+    if (maxSize < MAP_CHUNK_HEADER_SIZE) {
+      return 0;
+    }
+
+    const size_t columns = static_cast<unsigned char>(data[3]) |
+                           (static_cast<unsigned char>(data[4]) << 8);
+    const size_t height = static_cast<unsigned char>(data[5]) |
+                          (static_cast<unsigned char>(data[6]) << 8);
+    const size_t expectedSize = MAP_CHUNK_HEADER_SIZE + columns * height * 2;
+
+    return (maxSize >= expectedSize) ? expectedSize : 0;
+  }
+
+  default:
+    return INVALID_PACKET_SIZE;
+  }
+}
+
 /**
  * @name Inline Packet Creators
  * Convenience functions to build common packets.
@@ -0,0 +1,156 @@
+/**
+ * @file RingBuffer.hpp
+ * @brief Fixed-capacity byte ring used to reassemble packets from a TCP
+ *        stream on both server and client.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace Jetpack::Shared {
+
+/**
+ * @class RingBuffer
+ * @brief Circular receive buffer handing out zero-copy packet views.
+ *
+ * Bytes are written straight from recv()/readv() into the free regions
+ * and parsed in place. Only a packet straddling the physical end of the
+ * storage forces a linearize(), which rotates the storage once so the
+ * readable bytes become contiguous again.
+ */
+class RingBuffer {
+public:
+  static constexpr size_t DEFAULT_CAPACITY = 4096;
+
+  /**
+   * @brief Creates an empty ring.
+   * @param capacity Number of bytes the ring can hold.
+   */
+  explicit RingBuffer(const size_t capacity = DEFAULT_CAPACITY)
+      : m_storage(std::max<size_t>(capacity, 1)) {}
+
+  /** @return Number of readable bytes. */
+  [[nodiscard]] size_t size() const { return m_size; }
+
+  /** @return Total number of bytes the ring can hold. */
+  [[nodiscard]] size_t capacity() const { return m_storage.size(); }
+
+  /** @return Number of bytes that can still be written. */
+  [[nodiscard]] size_t freeSpace() const { return capacity() - m_size; }
+
+  /** @return True if there is nothing to read. */
+  [[nodiscard]] bool empty() const { return m_size == 0; }
+
+  /**
+   * @brief Free regions in write order, suitable for readv().
+   * @return Up to two spans; the second is empty unless the free space
+   *         wraps around the end of the storage.
+   */
+  [[nodiscard]] std::pair<std::span<std::byte>, std::span<std::byte>>
+  writableRegions() {
+    const size_t tail = (m_head + m_size) % capacity();
+    const size_t free = freeSpace();
+
+    if (tail >= m_head && m_size != capacity()) {
+      const size_t firstLength = std::min(free, capacity() - tail);
+      return {std::span(m_storage).subspan(tail, firstLength),
+              std::span(m_storage).subspan(0, free - firstLength)};
+    }
+    return {std::span(m_storage).subspan(tail, free), {}};
+  }
+
+  /**
+   * @brief Marks bytes written into writableRegions() as readable.
+   * @param bytes Number of bytes written (at most freeSpace()).
+   */
+  void commit(const size_t bytes) { m_size += std::min(bytes, freeSpace()); }
+
+  /**
+   * @brief Copies bytes into the ring.
+   * @param data  Source buffer.
+   * @param bytes Number of bytes to append.
+   * @return Number of bytes actually appended.
+   */
+  size_t write(const std::byte *data, size_t bytes) {
+    bytes = std::min(bytes, freeSpace());
+    auto [first, second] = writableRegions();
+    const size_t firstLength = std::min(bytes, first.size());
+    std::memcpy(first.data(), data, firstLength);
+    std::memcpy(second.data(), data + firstLength, bytes - firstLength);
+    commit(bytes);
+    return bytes;
+  }
+
+  /**
+   * @brief Readable bytes from the head up to the end of the storage.
+   * @return A view that may be shorter than size() if the data wraps.
+   */
+  [[nodiscard]] std::span<const std::byte> frontRegion() const {
+    return std::span<const std::byte>(m_storage)
+        .subspan(m_head, std::min(m_size, capacity() - m_head));
+  }
+
+  /**
+   * @brief Makes every readable byte contiguous.
+   * @return A view over all size() readable bytes.
+   */
+  std::span<const std::byte> linearize() {
+    if (m_head + m_size > capacity()) {
+      std::rotate(m_storage.begin(),
+                  m_storage.begin() + static_cast<std::ptrdiff_t>(m_head),
+                  m_storage.end());
+      m_head = 0;
+    }
+    return frontRegion();
+  }
+
+  /**
+   * @brief Drops bytes from the head once they have been parsed.
+   * @param bytes Number of bytes to release (at most size()).
+   */
+  void consume(size_t bytes) {
+    bytes = std::min(bytes, m_size);
+    m_head = (m_head + bytes) % capacity();
+    m_size -= bytes;
+    if (m_size == 0) {
+      m_head = 0;
+    }
+  }
+
+  /**
+   * @brief Enlarges the storage, keeping the readable bytes.
+   * @param minCapacity Capacity the ring must at least provide.
+   */
+  void grow(const size_t minCapacity) {
+    if (minCapacity <= capacity()) {
+      return;
+    }
+
+    size_t newCapacity = capacity();
+    while (newCapacity < minCapacity) {
+      newCapacity *= 2;
+    }
+
+    linearize();
+    m_storage.resize(newCapacity);
+  }
+
+  /** @brief Discards every readable byte. */
+  void clear() {
+    m_head = 0;
+    m_size = 0;
+  }
+
+private:
+  std::vector<std::byte> m_storage;
+  size_t m_head = 0;
+  size_t m_size = 0;
+};
+
+} // namespace Jetpack::Shared
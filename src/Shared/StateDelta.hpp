@@ -0,0 +1,330 @@
+/**
+ * @file StateDelta.hpp
+ * @brief Quantized player snapshots and the GAME_STATE_DELTA and
+ *        GAME_STATE_PACKED field codecs shared by server and client.
+ */
+
+#pragma once
+
+#include "PacketWriter.hpp"
+#include "Protocol.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Jetpack::Shared::Protocol {
+
+/** Number of sent snapshots either side remembers as delta baselines. */
+inline constexpr size_t STATE_HISTORY_SIZE = 32;
+
+/**
+ * @struct PlayerSnapshot
+ * @brief One player's record, quantized as the match sends it.
+ *
+ * Deltas are computed on these quantized values, so the client rebuilds
+ * bit-identical state from a baseline plus the changed fields. Positions
+ * are in fixed-point units of the match's precision; GAME_STATE_PACKED
+ * sends them as they are and the legacy packets narrow them with
+ * toLegacyPosition().
+ */
+struct PlayerSnapshot {
+  uint16_t id = 0;
+  uint8_t state = 0;
+  int32_t x = 0;
+  int32_t y = 0;
+  uint32_t score = 0;
+  uint8_t jetpack = 0;
+
+  bool operator==(const PlayerSnapshot &) const = default;
+
+  /**
+   * @brief Quantizes a player.
+   * @param player       Authoritative player record.
+   * @param unitsPerTile Fixed-point precision of the positions.
+   * @return The quantized record.
+   */
+  static PlayerSnapshot capture(const Player &player,
+                                const uint16_t unitsPerTile) {
+    return {static_cast<uint16_t>(player.getId()),
+            static_cast<uint8_t>(player.getState()),
+            static_cast<int32_t>(player.getPosition().x * unitsPerTile),
+            static_cast<int32_t>(player.getPosition().y * unitsPerTile),
+            static_cast<uint32_t>(player.getScore()),
+            static_cast<uint8_t>(player.isJetpacking() ? 1 : 0)};
+  }
+
+  /**
+   * @brief Copies the snapshot into a client-side player record.
+   * @param player       Record to update; its ID is left untouched.
+   * @param unitsPerTile Fixed-point precision of the positions.
+   */
+  void applyTo(Player &player, const uint16_t unitsPerTile) const {
+    const auto scale = static_cast<float>(unitsPerTile);
+    player.setState(static_cast<PlayerState>(state));
+    player.setPosition(static_cast<float>(x) / scale,
+                       static_cast<float>(y) / scale);
+    player.setScore(static_cast<int>(score));
+    player.setJetpacking(jetpack != 0);
+  }
+};
+
+/**
+ * @brief Narrows a position to the 16-bit hundredths of GAME_STATE_UPDATE
+ *        and GAME_STATE_DELTA, which wrap past 327 tiles.
+ * @param units        Position in fixed-point units.
+ * @param unitsPerTile Precision of units.
+ * @return The legacy wire value.
+ */
+constexpr int16_t toLegacyPosition(const int32_t units,
+                                   const uint16_t unitsPerTile) {
+  if (unitsPerTile == LEGACY_POSITION_SCALE) {
+    return static_cast<int16_t>(units);
+  }
+  return static_cast<int16_t>(static_cast<int64_t>(units) *
+                              LEGACY_POSITION_SCALE / unitsPerTile);
+}
+
+/**
+ * @struct StateSnapshot
+ * @brief Every player's record for one GAME_STATE_DELTA sequence number.
+ */
+struct StateSnapshot {
+  uint16_t sequence = NO_BASELINE;
+  std::vector<PlayerSnapshot> players;
+
+  /**
+   * @param playerId Player to look up.
+   * @return The player's record, or nullptr if absent.
+   */
+  [[nodiscard]] const PlayerSnapshot *find(const uint16_t playerId) const {
+    for (const PlayerSnapshot &player : players) {
+      if (player.id == playerId) {
+        return &player;
+      }
+    }
+    return nullptr;
+  }
+};
+
+/**
+ * @brief Ring of recent snapshots indexed by sequence number.
+ */
+using StateHistory = std::array<StateSnapshot, STATE_HISTORY_SIZE>;
+
+/**
+ * @brief Looks a sequence up in a history ring.
+ * @param history  Ring to search.
+ * @param sequence Sequence number wanted.
+ * @return The snapshot, or nullptr if it was overwritten or never stored.
+ */
+inline const StateSnapshot *findSnapshot(const StateHistory &history,
+                                         const uint16_t sequence) {
+  if (sequence == NO_BASELINE) {
+    return nullptr;
+  }
+  const StateSnapshot &slot = history[sequence % STATE_HISTORY_SIZE];
+  return slot.sequence == sequence ? &slot : nullptr;
+}
+
+/**
+ * @brief Compares two sequence numbers across 16-bit wrap-around.
+ * @return True if a was sent after b.
+ */
+constexpr bool isSequenceNewer(const uint16_t a, const uint16_t b) {
+  return a != b && static_cast<uint16_t>(a - b) < 0x8000;
+}
+
+/**
+ * @brief Selects the fields that differ from the baseline.
+ * @param baseline Previous record, or nullptr to send every field.
+ * @param current  Record to encode.
+ * @return Combination of DeltaField bits; 0 if nothing changed.
+ */
+inline uint8_t computeDeltaMask(const PlayerSnapshot *baseline,
+                                const PlayerSnapshot &current) {
+  if (baseline == nullptr) {
+    return DeltaField::ALL;
+  }
+
+  uint8_t mask = 0;
+  mask |= (current.state != baseline->state) ? DeltaField::STATE : 0;
+  mask |= (current.x != baseline->x) ? DeltaField::X : 0;
+  mask |= (current.y != baseline->y) ? DeltaField::Y : 0;
+  mask |= (current.score != baseline->score) ? DeltaField::SCORE : 0;
+  mask |= (current.jetpack != baseline->jetpack) ? DeltaField::JETPACK : 0;
+  return mask;
+}
+
+/**
+ * @brief Writes one player entry: ID, mask, then the selected fields.
+ * @param writer       Destination packet.
+ * @param mask         Fields to write.
+ * @param current      Record holding the values.
+ * @param unitsPerTile Precision of the record's positions.
+ */
+inline void writePlayerDelta(PacketWriter &writer, const uint8_t mask,
+                             const PlayerSnapshot &current,
+                             const uint16_t unitsPerTile) {
+  writer.addByte(static_cast<uint8_t>(current.id));
+  writer.addByte(mask);
+  if (mask & DeltaField::STATE) {
+    writer.addByte(current.state);
+  }
+  if (mask & DeltaField::X) {
+    writer.addShort(
+        static_cast<uint16_t>(toLegacyPosition(current.x, unitsPerTile)));
+  }
+  if (mask & DeltaField::Y) {
+    writer.addShort(
+        static_cast<uint16_t>(toLegacyPosition(current.y, unitsPerTile)));
+  }
+  if (mask & DeltaField::SCORE) {
+    writer.addShort(static_cast<uint16_t>(current.score));
+  }
+  if (mask & DeltaField::JETPACK) {
+    writer.addByte(current.jetpack);
+  }
+}
+
+/**
+ * @brief Applies one player entry to a record.
+ *
+ * The packet must already have been validated by getPacketSize().
+ *
+ * @param data   The packet.
+ * @param offset Position of the entry; advanced past it.
+ * @param target Record updated with the fields present.
+ */
+inline void readPlayerDelta(const std::span<const std::byte> data,
+                            size_t &offset, PlayerSnapshot &target) {
+  const auto readByte = [&data, &offset] {
+    return static_cast<uint8_t>(data[offset++]);
+  };
+  const auto readShort = [&readByte] {
+    const uint8_t low = readByte();
+    return static_cast<uint16_t>(low | (readByte() << 8));
+  };
+
+  target.id = readByte();
+  const uint8_t mask = readByte();
+  if (mask & DeltaField::STATE) {
+    target.state = readByte();
+  }
+  if (mask & DeltaField::X) {
+    target.x = static_cast<int16_t>(readShort());
+  }
+  if (mask & DeltaField::Y) {
+    target.y = static_cast<int16_t>(readShort());
+  }
+  if (mask & DeltaField::SCORE) {
+    target.score = readShort();
+  }
+  if (mask & DeltaField::JETPACK) {
+    target.jetpack = readByte();
+  }
+}
+
+/**
+ * @brief Size of one GAME_STATE_PACKED player entry.
+ * @param mask      Fields to write.
+ * @param current   Record holding the values.
+ * @param reference Record the positions are relative to.
+ * @return Number of bytes writePackedDelta() writes.
+ */
+constexpr size_t getPackedDeltaSize(const uint8_t mask,
+                                    const PlayerSnapshot &current,
+                                    const PlayerSnapshot &reference) {
+  return getVarintSize(current.id) + 1 +
+         ((mask & DeltaField::STATE) ? 1 : 0) +
+         ((mask & DeltaField::X)
+              ? getVarintSize(zigZagEncode(current.x - reference.x))
+              : 0) +
+         ((mask & DeltaField::Y)
+              ? getVarintSize(zigZagEncode(current.y - reference.y))
+              : 0) +
+         ((mask & DeltaField::SCORE) ? getVarintSize(current.score) : 0) +
+         ((mask & DeltaField::JETPACK) ? 1 : 0);
+}
+
+/**
+ * @brief Writes one GAME_STATE_PACKED player entry: varint ID, mask, then
+ *        the selected fields, positions as zig-zag varints relative to a
+ *        reference record.
+ *
+ * The reference is the baseline record of the player, or the match
+ * origin for a keyframe or a player the baseline lacks, so a moving
+ * player's coordinates mostly take one byte each.
+ *
+ * @param writer    Destination packet.
+ * @param mask      Fields to write.
+ * @param current   Record holding the values.
+ * @param reference Record the positions are relative to.
+ */
+inline void writePackedDelta(PacketWriter &writer, const uint8_t mask,
+                             const PlayerSnapshot &current,
+                             const PlayerSnapshot &reference) {
+  writer.addVarint(current.id);
+  writer.addByte(mask);
+  if (mask & DeltaField::STATE) {
+    writer.addByte(current.state);
+  }
+  if (mask & DeltaField::X) {
+    writer.addVarint(zigZagEncode(current.x - reference.x));
+  }
+  if (mask & DeltaField::Y) {
+    writer.addVarint(zigZagEncode(current.y - reference.y));
+  }
+  if (mask & DeltaField::SCORE) {
+    writer.addVarint(current.score);
+  }
+  if (mask & DeltaField::JETPACK) {
+    writer.addByte(current.jetpack);
+  }
+}
+
+/**
+ * @brief Applies one GAME_STATE_PACKED player entry to a record.
+ *
+ * The packet must already have been validated by getPacketSize(), and
+ * target must hold the reference the server encoded against: the
+ * baseline record, or the match origin for a new player.
+ *
+ * @param data   The packet.
+ * @param offset Position of the entry; advanced past it.
+ * @param target Record updated with the fields present.
+ */
+inline void readPackedDelta(const std::span<const std::byte> data,
+                            size_t &offset, PlayerSnapshot &target) {
+  const auto readVarintField = [&data, &offset] {
+    uint32_t value = 0;
+    readVarint(data.data(), data.size(), offset, value);
+    return value;
+  };
+  // Offsets wrap rather than overflow, whatever the server sent.
+  const auto addOffset = [](const int32_t position, const uint32_t encoded) {
+    return static_cast<int32_t>(static_cast<uint32_t>(position) +
+                                static_cast<uint32_t>(zigZagDecode(encoded)));
+  };
+
+  target.id = static_cast<uint16_t>(readVarintField());
+  const auto mask = static_cast<uint8_t>(data[offset++]);
+  if (mask & DeltaField::STATE) {
+    target.state = static_cast<uint8_t>(data[offset++]);
+  }
+  if (mask & DeltaField::X) {
+    target.x = addOffset(target.x, readVarintField());
+  }
+  if (mask & DeltaField::Y) {
+    target.y = addOffset(target.y, readVarintField());
+  }
+  if (mask & DeltaField::SCORE) {
+    target.score = readVarintField();
+  }
+  if (mask & DeltaField::JETPACK) {
+    target.jetpack = static_cast<uint8_t>(data[offset++]);
+  }
+}
+
+} // namespace Jetpack::Shared::Protocol